@@ -40,7 +40,6 @@ LogData CreateSampleLogData(int index) {
                    std::to_string(index) + "完成\",\"duration\":" + 
                    std::to_string(50 + index % 100) + 
                    ",\"user_id\":" + std::to_string(1000 + index) + "}";
-        data.metadata["is_json"] = "true";  // 标记为JSON格式
     } else {
         // 生成简单的文本日志
         data.message = "[2023-07-15 10:30:" + std::to_string(index % 60) + 
@@ -69,7 +68,6 @@ LogData CreateErrorLogData(int index) {
         case 0:
             // 不完整JSON
             data.message = "{\"level\":\"ERROR\",\"message\":\"系统崩溃\",\"reason";
-            data.metadata["is_json"] = "true";
             break;
         case 1:
             // 空消息
@@ -84,7 +82,6 @@ LogData CreateErrorLogData(int index) {
         case 3:
             // 包含特殊字符的JSON
             data.message = "{\"level\":\"ERROR\",\"message\":\"错误包含特殊字符：\n\t\r\b\",\"code\":500}";
-            data.metadata["is_json"] = "true";
             break;
     }
     
@@ -124,8 +121,8 @@ public:
     }
     
     bool Parse(const LogData& logData, xumj::analyzer::LogRecord& record) override {
-        // 检查元数据是否指示JSON格式
-        if (logData.metadata.count("is_json") > 0 && logData.metadata.at("is_json") == "true") {
+        // 处理器已解析过消息体，JSON格式交给JsonLogParser处理
+        if (logData.fields.format == PayloadFormat::JSON || logData.fields.format == PayloadFormat::INVALID_JSON) {
             return false;  // 跳过JSON格式，让JsonLogParser处理
         }
         
@@ -6,6 +6,7 @@
 #include <unordered_map>
 #include <string>
 #include <mutex>
+#include "xumj/common/latency_histogram.h"
 
 namespace xumj {
 namespace analyzer {
@@ -18,7 +19,19 @@ struct RuleMetrics {
     std::atomic<uint64_t> matchCount{0};        // 匹配次数
     std::atomic<uint64_t> processTime{0};       // 处理时间（微秒）
     std::atomic<uint64_t> errorCount{0};        // 错误次数
+    std::atomic<uint64_t> timeoutCount{0};      // 超时次数（匹配被中止或耗时超过规则的超时时间）
+    std::atomic<uint64_t> hitLogs{0};           // 命中的原始日志条数，重复日志的汇总记录按repeat_count计
     std::chrono::steady_clock::time_point lastMatchTime;  // 最后匹配时间
+    common::LatencyHistogram latency;           // 处理时间分布（微秒）
+    
+    void Reset() {
+        matchCount = 0;
+        processTime = 0;
+        errorCount = 0;
+        timeoutCount = 0;
+        hitLogs = 0;
+        latency.Reset();
+    }
 };
 
 /*
@@ -27,25 +40,38 @@ struct RuleMetrics {
  */
 struct AnalyzerMetrics {
     std::atomic<uint64_t> totalRecords{0};      // 总处理记录数
+    std::atomic<uint64_t> totalLogs{0};         // 总处理的原始日志条数，重复日志的汇总记录按repeat_count计
     std::atomic<uint64_t> pendingRecords{0};    // 待处理记录数
     std::atomic<uint64_t> errorRecords{0};      // 错误记录数
+    std::atomic<uint64_t> trimmedResults{0};    // 超过MySQL列长度被丢弃字段的规则结果数
     std::atomic<uint64_t> totalProcessTime{0};  // 总处理时间（微秒）
     std::atomic<uint64_t> peakMemoryUsage{0};   // 峰值内存使用（字节）
     
-    // 规则指标
+    // 规则指标，条目只增不删，导出时可以在锁外读取
     std::unordered_map<std::string, RuleMetrics> ruleMetrics;
-    std::mutex metricsMutex;
+    mutable std::mutex metricsMutex;
     
     // 重置所有指标
     void Reset() {
         totalRecords = 0;
+        totalLogs = 0;
         pendingRecords = 0;
         errorRecords = 0;
+        trimmedResults = 0;
         totalProcessTime = 0;
         peakMemoryUsage = 0;
         
         std::lock_guard<std::mutex> lock(metricsMutex);
-        ruleMetrics.clear();
+        for (auto& [name, rule] : ruleMetrics) {
+            rule.Reset();
+        }
+    }
+    
+    // 更新峰值内存
+    void UpdatePeakMemory(uint64_t bytes) {
+        uint64_t current = peakMemoryUsage.load(std::memory_order_relaxed);
+        while (bytes > current && !peakMemoryUsage.compare_exchange_weak(current, bytes, std::memory_order_relaxed)) {
+        }
     }
     
     // 获取规则指标
@@ -0,0 +1,74 @@
+#ifndef XUMJ_ANALYZER_KEYWORD_MATCHER_H
+#define XUMJ_ANALYZER_KEYWORD_MATCHER_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace xumj {
+namespace analyzer {
+
+/*
+ * @brief ASCII小写转换，与"C"区域的std::tolower相同，非ASCII字节不变
+ * @param text 输入
+ * @return 小写副本
+ */
+std::string AsciiLower(std::string_view text);
+
+/*
+ * @class KeywordMatcher
+ * @brief 不区分大小写的多关键字匹配器（Aho-Corasick自动机）
+ *
+ * 关键字添加时转为小写，编译为完整转移表的自动机；字节等价类表把大写字母映射到对应小写字母的类，
+ * 扫描时不需要复制和转换消息。自动机位于根状态时用SSE2跳过不可能开始任何关键字的字节
+ * （关键字首字母不超过4种时），一遍扫描得到所有出现的关键字。
+ * 编译后只读，可以在多个线程中同时调用Match。
+ */
+class KeywordMatcher {
+public:
+    /*
+     * @brief 添加关键字，添加后需要重新调用Compile
+     * @param keyword 关键字
+     * @return 关键字下标；转为小写后相同的关键字返回同一个下标
+     */
+    int Add(const std::string& keyword);
+
+    /*
+     * @brief 编译自动机
+     */
+    void Compile();
+
+    /*
+     * @brief 一遍扫描，得到出现的关键字（不区分大小写）
+     * @param text 输入
+     * @param found 输出，found[i]非0表示关键字i出现，大小为关键字数
+     * @return 出现的关键字数
+     */
+    size_t Match(std::string_view text, std::vector<uint8_t>& found) const;
+
+    // 关键字数（去重后）
+    size_t GetKeywordCount() const { return keywords_.size(); }
+
+    // 自动机状态数
+    size_t GetStateCount() const { return outputStart_.empty() ? 0 : outputStart_.size() - 1; }
+
+private:
+    std::vector<std::string> keywords_;                 // 小写关键字
+    std::unordered_map<std::string, int> ids_;
+    std::array<uint8_t, 256> byteClass_{};              // 字节（折叠大小写后）-> 等价类
+    size_t classCount_{1};
+    std::vector<uint32_t> transitions_;                 // 状态 × 等价类 -> 状态
+    std::vector<uint32_t> outputStart_;                 // 状态在outputs_中的起始位置
+    std::vector<uint32_t> outputs_;                     // 每个状态结束的关键字（含后缀链上的）
+    std::vector<uint32_t> emptyKeywords_;               // 空关键字，总是出现
+    std::vector<uint8_t> skipBytes_;                    // 根状态下可以开始关键字的字节（含大小写），为空时不跳过
+};
+
+} // namespace analyzer
+} // namespace xumj
+
+#endif // XUMJ_ANALYZER_KEYWORD_MATCHER_H
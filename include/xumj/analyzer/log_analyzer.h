@@ -6,15 +6,25 @@
 #include <memory>
 #include <functional>
 #include <unordered_map>
+#include <unordered_set>
 #include <mutex>
+#include <condition_variable>
 #include <thread>
 #include <atomic>
 #include <chrono>
 #include <regex>
+#include <deque>
 #include "xumj/storage/redis_storage.h"
 #include "xumj/storage/mysql_storage.h"
 #include "xumj/common/thread_pool.h"
+#include "xumj/common/concurrency_controller.h"
+#include "xumj/common/record_batch.h"
+#include "xumj/common/prometheus_writer.h"
 #include "xumj/analyzer/analyzer_metrics.h"
+#include "xumj/analyzer/regex_rule_set.h"
+#include "xumj/analyzer/keyword_matcher.h"
+#include "xumj/analyzer/rule_result.h"
+#include "xumj/analyzer/result_writer.h"
 
 namespace xumj {
 namespace analyzer {
@@ -32,6 +42,21 @@ struct LogRecord {
     std::unordered_map<std::string, std::string> fields;  // 解析出的字段
 };
 
+/*
+ * @brief 将记录追加到列式批次
+ * @param batch 批次
+ * @param record 日志记录
+ */
+void AppendRecord(common::RecordBatch& batch, const LogRecord& record);
+
+/*
+ * @brief 从列式批次读出一行
+ * @param batch 批次
+ * @param row 行号
+ * @param record 输出记录，复用其中已分配的字符串
+ */
+void ReadRecord(const common::RecordBatch& batch, size_t row, LogRecord& record);
+
 /*
  * @struct RuleConfig
  * @brief 规则配置
@@ -41,7 +66,8 @@ struct RuleConfig {
     std::string group{"default"};       // 规则分组
     bool enabled{true};                 // 规则是否启用
     size_t maxRetries{3};              // 最大重试次数
-    std::chrono::milliseconds timeout{1000};  // 规则超时时间
+    std::chrono::milliseconds timeout{1000};  // 规则超时时间，单条记录的分析耗时超过时计为超时
+    size_t maxMatchSteps{1000000};     // 正则规则单次std::regex匹配的最大步数（约数十毫秒），超出时中止并计为超时，0表示不限制
 };
 
 /*
@@ -59,6 +85,29 @@ public:
      */
     virtual std::unordered_map<std::string, std::string> Analyze(const LogRecord& record) const = 0;
     
+    /*
+     * @brief 分析日志记录，把结果写入result中本规则的位置，调用方负责跳过禁用的规则
+     *
+     * 命中时调用SetMatched并追加提取的字段，未命中时不应写入任何内容。
+     * 默认实现调用Analyze，把键值对原样保存到result中。
+     * @param record 日志记录
+     * @param rule 本规则在分析器中的序号
+     * @param result 记录的分析结果
+     */
+    virtual void Evaluate(const LogRecord& record, size_t rule, RuleResult& result) const;
+    
+    /*
+     * @brief 批量分析日志记录，结果与逐条调用Evaluate相同
+     *
+     * 分析器每个任务处理一块记录，对每条规则调用一次本函数；需要准备工作的规则可以重写，
+     * 在一块记录之间分摊准备开销。默认实现逐条调用Evaluate。
+     * @param records 日志记录
+     * @param count 记录数量
+     * @param rule 本规则在分析器中的序号
+     * @param results 各记录的分析结果，与records一一对应
+     */
+    virtual void AnalyzeBatch(const LogRecord* records, size_t count, size_t rule, RuleResult* results) const;
+    
     /*
      * @brief 获取规则名称
      * @return 规则名称
@@ -117,12 +166,44 @@ public:
      */
     std::unordered_map<std::string, std::string> Analyze(const LogRecord& record) const override;
     
+    /*
+     * @brief 分析日志记录，写入RuleResult
+     * @param record 日志记录
+     * @param rule 本规则在分析器中的序号
+     * @param result 记录的分析结果
+     */
+    void Evaluate(const LogRecord& record, size_t rule, RuleResult& result) const override;
+    
+    /*
+     * @brief 在已知是否匹配的情况下写入分析结果，与Evaluate的结果相同
+     *
+     * 匹配结果由RegexRuleSet一遍扫描得到，只有匹配且需要提取字段时才调用std::regex_search；
+     * 提取的字段值是指向record.message的视图。
+     * @param record 日志记录
+     * @param matched 消息是否匹配本规则的模式
+     * @param rule 本规则在分析器中的序号
+     * @param result 记录的分析结果
+     */
+    void EvaluateMatched(const LogRecord& record, bool matched, size_t rule, RuleResult& result) const;
+    
     /*
      * @brief 获取规则名称
      * @return 规则名称
      */
     std::string GetName() const override;
     
+    /*
+     * @brief 获取正则表达式模式
+     * @return 正则表达式模式
+     */
+    const std::string& GetPattern() const;
+    
+    /*
+     * @brief 正则表达式是否编译成功
+     * @return 是否编译成功
+     */
+    bool IsCompiled() const;
+    
     /*
      * @brief 获取规则配置
      * @return 规则配置
@@ -182,12 +263,36 @@ public:
      */
     std::unordered_map<std::string, std::string> Analyze(const LogRecord& record) const override;
     
+    /*
+     * @brief 分析日志记录，写入RuleResult
+     * @param record 日志记录
+     * @param rule 本规则在分析器中的序号
+     * @param result 记录的分析结果
+     */
+    void Evaluate(const LogRecord& record, size_t rule, RuleResult& result) const override;
+    
+    /*
+     * @brief 在已知各关键字是否出现的情况下写入分析结果，与Evaluate的结果相同
+     * @param found KeywordMatcher::Match的输出
+     * @param keywordIds 本规则第i个关键字在该匹配器中的下标
+     * @param rule 本规则在分析器中的序号
+     * @param result 记录的分析结果
+     */
+    void EvaluateMatched(const std::vector<uint8_t>& found, const std::vector<int>& keywordIds,
+                         size_t rule, RuleResult& result) const;
+    
     /*
      * @brief 获取规则名称
      * @return 规则名称
      */
     std::string GetName() const override;
     
+    /*
+     * @brief 获取关键字列表
+     * @return 关键字列表
+     */
+    const std::vector<std::string>& GetKeywords() const;
+    
     /*
      * @brief 获取规则配置
      * @return 规则配置
@@ -221,6 +326,8 @@ private:
     std::vector<std::string> keywords_;  // 关键字列表
     bool scoring_;                   // 是否进行打分
     RuleConfig config_;               // 规则配置
+    KeywordMatcher matcher_;          // 本规则关键字的匹配器，单独调用Analyze时使用
+    std::vector<int> keywordIds_;     // 关键字在matcher_中的下标
 };
 
 /*
@@ -228,15 +335,24 @@ private:
  * @brief 日志分析器配置
  */
 struct AnalyzerConfig {
-    size_t threadPoolSize{4};                 // 分析线程池大小
-    std::chrono::seconds analyzeInterval{1};  // 分析间隔时间
-    size_t batchSize{100};                    // 每批分析的日志数量
+    size_t threadPoolSize{4};                 // 分析线程池大小（启用自适应时为初始值）
+    bool adaptiveThreadPool{false};           // 是否根据积压、处理时间和CPU利用率自动调整线程池大小
+    common::ConcurrencyConfig poolConcurrency{};  // 自适应调整的范围和参数
+    std::chrono::seconds analyzeInterval{1};  // 没有待处理记录时的最长等待时间（提交记录时立即唤醒），为0时按1秒
+    size_t batchSize{100};                    // 每个分析任务处理的最大日志数量
+    size_t chunkBytes{64 * 1024};             // 每个分析任务处理的最大消息字节数，使一个任务的数据留在CPU缓存中
     bool storeResults{true};                  // 是否存储分析结果
+    bool storeUnmatched{false};               // 是否也存储未命中的规则结果（默认只存储命中和出错的规则）
+    size_t resultFlushSize{256};              // 结果写入线程每批写入的最大记录数，积累到该数量时立即写入
+    std::chrono::milliseconds resultFlushInterval{200};  // 结果在写入队列中的最长等待时间
+    size_t resultQueueCapacity{10000};        // 结果写入队列容量，满时丢弃新结果
     std::string redisConfigJson{};            // Redis配置JSON
     std::string mysqlConfigJson{};            // MySQL配置JSON
     bool enableMetrics{true};                 // 是否启用性能指标收集
     size_t maxRetries{3};                     // 最大重试次数
     std::chrono::milliseconds ruleTimeout{1000};  // 规则超时时间
+    common::LogLevel minLevel{common::LogLevel::TRACE};  // 低于该级别的记录不分析（无法识别的级别总是分析）
+    std::chrono::milliseconds ruleReorderInterval{1000};  // 按规则的耗时和命中率调整同一优先级内评估顺序的间隔，为0时不调整
 };
 
 /*
@@ -253,6 +369,15 @@ public:
     using AnalysisCallback = std::function<void(const std::string&, 
                                               const std::unordered_map<std::string, std::string>&)>;
     
+    /*
+     * @brief 紧凑分析结果回调函数类型，每条记录调用一次，不生成键值对
+     * @param record 日志记录
+     * @param result 记录在所有规则上的分析结果，下标与rules一致
+     * @param rules 分析时使用的规则（按优先级排序）
+     */
+    using ResultCallback = std::function<void(const LogRecord&, const RuleResult&,
+                                              const std::vector<std::shared_ptr<AnalysisRule>>&)>;
+    
     /*
      * @brief 构造函数
      * @param config 分析器配置
@@ -296,12 +421,27 @@ public:
      */
     size_t SubmitRecords(const std::vector<LogRecord>& records);
     
+    /*
+     * @brief 提交列式批次进行分析，批次整体移入队列
+     * @param batch 日志批次
+     * @return 成功提交的记录数量
+     */
+    size_t SubmitBatch(common::RecordBatch&& batch);
+    
     /*
      * @brief 设置分析完成回调函数
      * @param callback 回调函数
      */
     void SetAnalysisCallback(AnalysisCallback callback);
     
+    /*
+     * @brief 设置紧凑分析结果回调函数
+     *
+     * 只设置本回调且不存储结果时，分析器不为任何规则生成键值对。
+     * @param callback 回调函数
+     */
+    void SetResultCallback(ResultCallback callback);
+    
     /*
      * @brief 启动分析器
      * @return 是否成功启动
@@ -342,6 +482,12 @@ public:
      */
     void ResetMetrics();
     
+    /*
+     * @brief 以Prometheus文本格式写出分析器指标
+     * @param writer 输出
+     */
+    void WritePrometheusMetrics(common::PrometheusWriter& writer) const;
+    
     /*
      * @brief 获取规则组列表
      * @return 规则组列表
@@ -367,20 +513,49 @@ public:
      */
     void DisableGroup(const std::string& group);
     
+    /*
+     * @brief 设置规则组是否短路：一条记录在组内按评估顺序第一条规则命中后，组内其余规则不再分析
+     *
+     * 同一优先级的规则按耗时与命中率之比从小到大评估，短路组内哪条规则先命中取决于评估顺序；
+     * 需要固定顺序时为规则设置不同的优先级。
+     * 所有正则规则共用一遍多模式扫描，所有关键字规则共用一遍关键字扫描，扫描耗时不计入单条规则；
+     * 短路只能跳过逐条分析的自定义规则，以及同类规则全部被跳过时的整遍扫描。
+     * @param group 规则组名
+     * @param enabled 是否短路
+     */
+    void SetGroupShortCircuit(const std::string& group, bool enabled);
+    
+    /*
+     * @brief 检查规则组是否短路
+     * @param group 规则组名
+     * @return 是否短路
+     */
+    bool IsGroupShortCircuit(const std::string& group) const;
+    
+    /*
+     * @brief 获取当前的规则评估顺序：按优先级从高到低，同一优先级内按耗时与命中率之比从小到大
+     * @return 规则列表
+     */
+    std::vector<std::shared_ptr<AnalysisRule>> GetEvaluationOrder();
+    
 private:
     // 分析线程函数
     void AnalyzeThreadFunc();
     
-    // 处理单条日志记录
-    void ProcessRecord(const LogRecord& record);
+    // 分析任务：一个批次中按级别过滤后的部分行
+    struct SelectedRows;
+    
+    // 处理一个批次中的[begin, end)行（下标指向SelectedRows::rows）
+    void ProcessRows(const SelectedRows& selected, size_t begin, size_t end);
     
-    // 存储分析结果到Redis
-    void StoreResultToRedis(const std::string& recordId, 
-                           const std::unordered_map<std::string, std::string>& results);
+    // 分析一块日志记录
+    void AnalyzeRecords(const LogRecord* records, size_t count);
     
-    // 存储分析结果到MySQL
-    void StoreResultToMySQL(const std::string& recordId,
-                           const std::unordered_map<std::string, std::string>& results);
+    // 按行数和消息字节数把一个批次切分为线程池任务
+    void DispatchBatch(common::RecordBatch&& batch);
+    
+    // 把一批记录的结果写入Redis（一次流水线）和MySQL（一个事务），在结果写入线程中调用
+    size_t WriteResults(const std::vector<StoredResult>& results);
     
     // 配置
     AnalyzerConfig config_;
@@ -389,12 +564,35 @@ private:
     std::vector<std::shared_ptr<AnalysisRule>> rules_;
     mutable std::mutex rulesMutex_;
     
-    // 待处理的日志记录队列
-    std::vector<LogRecord> pendingRecords_;
+    // 规则快照：规则列表和所有正则规则合并编译的RegexRuleSet，规则变化后在下一次分析前重建
+    struct RuleSnapshot;
+    std::shared_ptr<const RuleSnapshot> snapshot_;
+    
+    // 取得当前规则快照，必要时重建
+    std::shared_ptr<const RuleSnapshot> GetSnapshot();
+    
+    // 规则的在线耗时和命中统计，跨快照保留
+    struct RuleStats;
+    std::unordered_map<const AnalysisRule*, std::shared_ptr<RuleStats>> ruleStats_;
+    std::unordered_set<std::string> shortCircuitGroups_;   // 短路的规则组
+    
+    // 取得快照的评估顺序，到期时按统计重新排序
+    std::shared_ptr<const std::vector<uint32_t>> GetRuleOrder(const RuleSnapshot& snapshot);
+    
+    // 待处理的日志批次队列
+    std::deque<common::RecordBatch> pendingBatches_;
+    size_t pendingCount_{0};
     mutable std::mutex recordsMutex_;
+    std::condition_variable recordsCond_;   // 提交记录或停止时唤醒分析线程
+    
+    // 结果写入线程，在线程池之后析构，线程池中的任务结束前仍可提交
+    std::unique_ptr<ResultWriter> resultWriter_;
     
     // 线程池
     std::unique_ptr<common::ThreadPool> threadPool_;
+    std::unique_ptr<common::ConcurrencyController> poolController_;  // 自适应线程池大小
+    std::atomic<uint64_t> analyzedRecords_{0};   // 线程池累计分析条数
+    std::atomic<uint64_t> busyMicros_{0};        // 线程池累计分析时间（微秒）
     
     // 存储
     std::shared_ptr<storage::RedisStorage> redisStorage_;
@@ -406,6 +604,7 @@ private:
     
     // 回调函数
     AnalysisCallback analysisCallback_;
+    ResultCallback resultCallback_;
     std::mutex callbackMutex_;
     
     AnalyzerMetrics metrics_;  // 性能指标
@@ -413,7 +612,9 @@ private:
     
     void UpdateMetrics(const std::string& ruleName, 
                       const std::chrono::microseconds& processTime,
-                      bool hasError);
+                      bool hasError,
+                      bool timedOut,
+                      uint64_t hitLogs);
     
     void SortRulesByPriority();
 };
@@ -0,0 +1,136 @@
+#ifndef XUMJ_ANALYZER_REGEX_RULE_SET_H
+#define XUMJ_ANALYZER_REGEX_RULE_SET_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <regex>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace xumj {
+namespace analyzer {
+
+struct RegexNode;   // 模式的语法树，定义在实现文件中
+struct RegexDfa;    // 一组模式合并编译的DFA，定义在实现文件中
+
+/*
+ * @brief 带步数限制的正则搜索结果
+ */
+enum class RegexSearchResult { NO_MATCH, MATCH, ABORTED };
+
+/*
+ * @brief 带步数限制的std::regex_search
+ *
+ * std::regex按回溯实现，病态模式在长消息上可能耗时极长。匹配时输入位置每前进或后退一次计一步，
+ * 超过maxSteps时中止，返回ABORTED。
+ * @param text 输入
+ * @param regex 正则表达式
+ * @param maxSteps 最大步数，0表示不限制
+ * @param groups 不为空时输出各匹配组在text中的(位置, 长度)，下标0为整个匹配，未参与匹配的组为(npos, 0)
+ * @return 搜索结果
+ */
+RegexSearchResult BoundedRegexSearch(std::string_view text, const std::regex& regex, size_t maxSteps,
+                                     std::vector<std::pair<size_t, size_t>>* groups = nullptr);
+
+/*
+ * @class RegexRuleSet
+ * @brief 多个正则表达式合并编译的匹配器，一遍扫描得到所有匹配的模式
+ *
+ * 支持ECMAScript语法的常用子集：字面量、.、字符类[...]（含\d\w\s等）、分组、|、
+ * *+?{n,m}（含非贪婪写法）、^和$。模式先编译为NFA，再按每组最多64个模式合并为DFA，
+ * 按字节等价类查表扫描，每个状态记录已匹配模式的位掩码，耗时与模式数量基本无关。
+ * 一组的DFA状态数超过上限时拆成两组；单个模式也超过上限、或使用了反向引用、
+ * 零宽断言等不支持的语法时，该模式改用std::regex逐个匹配。
+ *
+ * 每个模式还提取一个任何匹配都必须包含的字面量（例如"timeout after (\d+)ms"的"timeout after "），
+ * 扫描前先一遍查找这些字面量：必需字面量不出现的模式直接跳过，一组模式都被跳过时不扫描该组的DFA。
+ * 改用std::regex的模式按添加时指定的步数限制匹配（见BoundedRegexSearch），超出时结果为kAborted。
+ * 编译后只读，可以在多个线程中同时调用Match。
+ */
+class RegexRuleSet {
+public:
+    static constexpr size_t kDefaultMaxStates = 4096;   // 每组DFA状态数上限
+    static constexpr size_t kGroupWidth = 64;           // 每组最多的模式数
+    static constexpr uint8_t kAborted = 2;              // Match输出：超出步数限制，匹配被中止
+
+    /*
+     * @brief 构造函数
+     * @param maxStates 每组DFA的状态数上限
+     */
+    explicit RegexRuleSet(size_t maxStates = kDefaultMaxStates);
+    ~RegexRuleSet();
+
+    RegexRuleSet(RegexRuleSet&&) noexcept;
+    RegexRuleSet& operator=(RegexRuleSet&&) noexcept;
+
+    /*
+     * @brief 添加模式，添加后需要重新调用Compile
+     * @param pattern 正则表达式（ECMAScript语法）
+     * @param maxSteps 改用std::regex时单次匹配的最大步数，0表示不限制；DFA匹配耗时与输入长度成正比，不受限制
+     * @return 模式下标；std::regex也无法编译的模式返回-1，不参与匹配
+     */
+    int Add(const std::string& pattern, size_t maxSteps = 0);
+
+    /*
+     * @brief 编译所有模式
+     */
+    void Compile();
+
+    /*
+     * @brief 一遍扫描，得到匹配的模式（等价于对每个模式调用std::regex_search）
+     * @param text 输入
+     * @param matched 输出，matched[i]为1表示模式i匹配，为kAborted表示匹配被中止，大小为模式数
+     * @return 匹配的模式数（不含被中止的模式）
+     */
+    size_t Match(std::string_view text, std::vector<uint8_t>& matched) const;
+
+    // 模式数
+    size_t GetPatternCount() const { return patterns_.size(); }
+
+    // 是否编译进了DFA（否则用std::regex匹配）
+    bool IsAccelerated(size_t pattern) const;
+
+    // 模式的必需字面量，没有时为空
+    const std::string& GetRequiredLiteral(size_t pattern) const;
+
+    // DFA组数、所有组的状态总数、改用std::regex的模式数
+    size_t GetGroupCount() const;
+    size_t GetStateCount() const;
+    size_t GetFallbackCount() const;
+
+    /*
+     * @brief 检查模式能否编译进DFA
+     * @param pattern 正则表达式
+     * @param literal 输出必需字面量
+     * @return 语法受支持返回true
+     */
+    static bool IsSupported(const std::string& pattern, std::string* literal = nullptr);
+
+private:
+    struct Pattern {
+        std::string text;
+        std::string literal;                    // 必需字面量
+        std::shared_ptr<RegexNode> ast;         // 为空表示不支持DFA
+        std::unique_ptr<std::regex> regex;      // 不支持DFA时使用
+        size_t maxSteps{0};                     // 使用regex时的步数限制
+        int group{-1};                          // 所在DFA组，-1表示使用regex
+    };
+
+    // 把members编译为一个或多个DFA组，返回值为未能编译的模式（状态数超限）
+    std::vector<size_t> BuildGroups(const std::vector<size_t>& members);
+
+    size_t maxStates_;
+    std::vector<Pattern> patterns_;
+    std::vector<std::unique_ptr<RegexDfa>> groups_;
+    std::vector<size_t> fallback_;                          // 使用std::regex的模式
+    std::vector<std::vector<uint32_t>> literalsByByte_;     // 首字节 -> 以它开头的必需字面量所属模式
+    std::vector<size_t> unfiltered_;                        // 没有必需字面量的模式
+};
+
+} // namespace analyzer
+} // namespace xumj
+
+#endif // XUMJ_ANALYZER_REGEX_RULE_SET_H
@@ -0,0 +1,114 @@
+#ifndef XUMJ_ANALYZER_RESULT_WRITER_H
+#define XUMJ_ANALYZER_RESULT_WRITER_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include "xumj/common/non_copyable.h"
+
+namespace xumj {
+namespace analyzer {
+
+/*
+ * @struct StoredRuleResult
+ * @brief 一条规则的待存储结果
+ */
+struct StoredRuleResult {
+    std::string rule;                                      // 规则名称
+    std::unordered_map<std::string, std::string> fields;   // 结果键值对
+};
+
+/*
+ * @struct StoredResult
+ * @brief 一条日志记录的待存储结果，汇总了需要存储的所有规则
+ */
+struct StoredResult {
+    std::string recordId;                  // 日志记录ID
+    std::vector<StoredRuleResult> rules;   // 需要存储的规则结果
+};
+
+/*
+ * @class ResultWriter
+ * @brief 分析结果异步批量写入
+ *
+ * 分析线程只把每条记录汇总后的结果放入有界队列；写入线程在积累到flushSize条，
+ * 或最早的结果等待超过flushInterval时整批取出，调用一次写入函数（一次Redis流水线、一组多行INSERT）。
+ * 队列满时丢弃新结果并计数，存储变慢不会反压到分析流程。
+ */
+class ResultWriter : public common::NonCopyable {
+public:
+    /*
+     * @brief 写入函数，返回成功写入的记录数
+     */
+    using Writer = std::function<size_t(const std::vector<StoredResult>& results)>;
+
+    /*
+     * @brief 构造函数
+     * @param writer 写入函数，在写入线程中调用
+     * @param flushSize 每次写入的最大记录数，积累到该数量时立即写入
+     * @param flushInterval 结果在队列中的最长等待时间
+     * @param capacity 队列容量
+     */
+    ResultWriter(Writer writer, size_t flushSize = 256,
+                 std::chrono::milliseconds flushInterval = std::chrono::milliseconds(200),
+                 size_t capacity = 10000);
+
+    /*
+     * @brief 析构函数，停止写入线程并写完队列中剩余的结果
+     */
+    ~ResultWriter();
+
+    /*
+     * @brief 启动写入线程
+     */
+    void Start();
+
+    /*
+     * @brief 停止写入线程，返回前写完队列中剩余的结果
+     */
+    void Stop();
+
+    /*
+     * @brief 提交一条记录的结果，不阻塞
+     * @param result 汇总后的结果
+     * @return 队列已满或未启动时返回false
+     */
+    bool Submit(StoredResult result);
+
+    uint64_t GetWrittenCount() const { return written_.load(std::memory_order_relaxed); }
+    uint64_t GetDroppedCount() const { return dropped_.load(std::memory_order_relaxed); }
+    uint64_t GetFailedCount() const { return failed_.load(std::memory_order_relaxed); }
+    uint64_t GetFlushCount() const { return flushes_.load(std::memory_order_relaxed); }
+
+private:
+    void Run();
+
+    Writer writer_;
+    const size_t flushSize_;
+    const std::chrono::milliseconds flushInterval_;
+    const size_t capacity_;
+
+    std::vector<StoredResult> pending_;
+    std::chrono::steady_clock::time_point oldest_;   // pending_中最早的结果的提交时间
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    bool running_{false};
+    std::thread thread_;
+
+    std::atomic<uint64_t> written_{0};   // 已写入记录数
+    std::atomic<uint64_t> dropped_{0};   // 队列满丢弃的记录数
+    std::atomic<uint64_t> failed_{0};    // 写入失败的记录数
+    std::atomic<uint64_t> flushes_{0};   // 调用写入函数的次数
+};
+
+} // namespace analyzer
+} // namespace xumj
+
+#endif // XUMJ_ANALYZER_RESULT_WRITER_H
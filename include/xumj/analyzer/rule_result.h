@@ -0,0 +1,127 @@
+#ifndef XUMJ_ANALYZER_RULE_RESULT_H
+#define XUMJ_ANALYZER_RULE_RESULT_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace xumj {
+namespace analyzer {
+
+/*
+ * @class RuleResult
+ * @brief 一条日志记录在所有规则上的分析结果
+ *
+ * 命中的规则记在位集中（下标为规则在分析器中的序号）；规则提取的字段以(规则, 字段名, 值)追加到一个数组，
+ * 字段名和值是视图，指向规则自身的字符串、记录的消息，或复制到结果内部分块缓冲区（arena）的字符串。
+ * 未命中的规则不产生任何分配；Reset后复用数组和缓冲区，稳定运行时命中的规则也不再分配。
+ * 需要键值对形式的消费者调用ToMap按规则生成。
+ */
+class RuleResult {
+public:
+    // 规则提取的一个字段
+    struct Field {
+        uint32_t rule;
+        std::string_view name;
+        std::string_view value;
+    };
+
+    /*
+     * @brief 清空结果，保留已分配的内存
+     * @param ruleCount 规则数
+     */
+    void Reset(size_t ruleCount);
+
+    // 规则数
+    size_t GetRuleCount() const { return ruleCount_; }
+
+    // 标记规则命中
+    void SetMatched(size_t rule) { matched_[rule >> 6] |= uint64_t{1} << (rule & 63); }
+
+    // 规则是否命中
+    bool IsMatched(size_t rule) const { return (matched_[rule >> 6] >> (rule & 63)) & 1; }
+
+    // 命中的规则数
+    size_t GetMatchedCount() const;
+
+    /*
+     * @brief 标记规则的结果为原样保存的键值对，ToMap只输出其字段
+     *
+     * 用于只实现了Analyze的规则和分析出错的规则。
+     */
+    void SetVerbatim(size_t rule) { verbatim_[rule >> 6] |= uint64_t{1} << (rule & 63); }
+
+    // 规则的结果是否为原样保存的键值对
+    bool IsVerbatim(size_t rule) const { return (verbatim_[rule >> 6] >> (rule & 63)) & 1; }
+
+    /*
+     * @brief 标记规则超时：匹配超出步数限制被中止，结果为原样保存的error字段
+     * @param rule 规则序号
+     */
+    void SetTimedOut(size_t rule);
+
+    // 规则是否超时
+    bool IsTimedOut(size_t rule) const { return (timedOut_[rule >> 6] >> (rule & 63)) & 1; }
+
+    /*
+     * @brief 追加字段，不复制
+     * @param rule 规则序号
+     * @param name 字段名，调用方保证在结果使用期间有效
+     * @param value 字段值，调用方保证在结果使用期间有效
+     */
+    void AddField(size_t rule, std::string_view name, std::string_view value) {
+        fields_.push_back({static_cast<uint32_t>(rule), name, value});
+    }
+
+    /*
+     * @brief 把字符串复制到结果的缓冲区，返回的视图在下一次Reset前有效
+     */
+    std::string_view CopyString(std::string_view text);
+
+    // 所有字段，按追加顺序
+    const std::vector<Field>& GetFields() const { return fields_; }
+
+    // 规则是否分析出错（原样保存的结果中有error字段）
+    bool HasError(size_t rule) const;
+
+    /*
+     * @brief 生成规则的键值对结果
+     *
+     * 原样保存的结果只输出字段；否则命中时为字段加matched=true、rule、group，未命中时为matched=false、group。
+     * @param rule 规则序号
+     * @param name 规则名称
+     * @param group 规则分组
+     */
+    std::unordered_map<std::string, std::string> ToMap(size_t rule, const std::string& name,
+                                                       const std::string& group) const;
+
+    // 自上次Reset以来复制到缓冲区的字节数
+    size_t GetArenaBytes() const { return arenaBytes_; }
+
+private:
+    static constexpr size_t kBlockSize = 4096;
+
+    struct Block {
+        std::unique_ptr<char[]> data;
+        size_t size{0};
+    };
+
+    size_t ruleCount_{0};
+    std::vector<uint64_t> matched_;
+    std::vector<uint64_t> verbatim_;
+    std::vector<uint64_t> timedOut_;
+    std::vector<Field> fields_;
+    std::vector<Block> blocks_;
+    size_t block_{0};          // 当前块
+    size_t used_{0};           // 当前块已用字节
+    size_t arenaBytes_{0};
+};
+
+} // namespace analyzer
+} // namespace xumj
+
+#endif // XUMJ_ANALYZER_RULE_RESULT_H
@@ -9,6 +9,8 @@
 #include <chrono>
 #include <functional>
 #include <mutex>
+#include <map>
+#include <condition_variable>
 #include "xumj/common/memory_pool.h"
 #include "xumj/common/lock_free_queue.h"
 #include "xumj/common/thread_pool.h"
@@ -206,6 +208,8 @@ struct CollectorConfig {
     bool enableRetry{true};                   // 是否启用重试机制
     uint32_t maxRetryCount{3};                // 最大重试次数
     std::chrono::milliseconds retryInterval{5000}; // 重试间隔
+    bool enableAck{false};                    // 是否启用确认投递（需设置批次推送回调）
+    size_t maxInFlightBatches{16};            // 已发送未确认的最大批次数（发送窗口）
 };
 
 /*
@@ -217,6 +221,17 @@ struct CollectorConfig {
  */
 class LogCollector {
 public:
+    /*
+     * @brief 批次推送回调
+     * @param seq 批次序号，同一收集器内从1开始单调递增
+     * @param base 发送时已收到的累计确认序号，随批次发给处理器作为该流的起点
+     * @param logs 批次日志
+     * @param retransmit 是否为重连后的重传
+     * @return 是否已交给传输层
+     */
+    using BatchPushCallback = std::function<bool(uint64_t seq, uint64_t base, const std::vector<LogEntry>& logs,
+                                                 bool retransmit)>;
+    
     /*
      * @brief 默认构造函数
      */
@@ -295,6 +310,47 @@ public:
      */
     void SetErrorCallback(std::function<void(const std::string&)> callback);
     
+    /*
+     * @brief 设置批次推送回调，启用确认投递时批次通过该回调发送
+     * @param callback 推送回调
+     */
+    void SetBatchPushCallback(BatchPushCallback callback);
+    
+    /*
+     * @brief 处理来自处理器的累计确认
+     * @param ackedSeq 已存储的最大连续批次序号
+     */
+    void HandleAck(uint64_t ackedSeq);
+    
+    /*
+     * @brief 重传所有未确认的批次，应在与处理器重新建立连接后调用
+     *
+     * 推送失败或连接断开后，新批次只进入发送窗口，等本函数按序号重传完所有批次后才恢复直接推送，
+     * 重连后新批次不会先于未确认的旧批次发出。
+     * @return 重传的批次数
+     */
+    size_t RetransmitUnacked();
+    
+    /*
+     * @brief 与处理器的连接断开，之后的新批次等待重传
+     */
+    void HandleDisconnect();
+    
+    /*
+     * @brief 获取已发送未确认的批次数
+     */
+    size_t GetInFlightBatchCount() const;
+    
+    /*
+     * @brief 获取已确认的最大批次序号
+     */
+    uint64_t GetAckedSequence() const;
+    
+    /*
+     * @brief 获取流标识（收集器ID + 启动时间），处理器按流去重
+     */
+    const std::string& GetStreamId() const { return streamId_; }
+    
     // 新增：从文件采集日志
     bool CollectFromFile(const std::string& filePath, LogLevel level = LogLevel::INFO, size_t intervalMs = 1000, int maxLinesPerRound = 10);
     
@@ -312,6 +368,28 @@ private:
     std::mutex fileCleanMutex_;
     std::streampos lastCleanPos_ = 0;
     
+    // 确认投递
+    BatchPushCallback batchPushCallback_;                        // 批次推送回调
+    std::string streamId_;                                       // 流标识
+    std::map<uint64_t, std::vector<LogEntry>> inFlight_;         // 已发送未确认的批次
+    mutable std::mutex inFlightMutex_;                           // 发送窗口互斥锁
+    std::condition_variable inFlightCv_;                         // 窗口有空位时通知
+    std::mutex sendMutex_;                                       // 保证批次按序号顺序发出
+    uint64_t nextSeq_{1};                                        // 下一个批次序号
+    uint64_t ackedSeq_{0};                                       // 已确认的最大批次序号
+    bool retransmitPending_{false};                              // 是否有批次等待重传（由sendMutex_保护）
+    
+    /*
+     * @brief 是否使用确认投递
+     */
+    bool AckEnabled() const { return config_.enableAck && batchPushCallback_ != nullptr; }
+    
+    /*
+     * @brief 等待发送窗口出现空位
+     * @return 窗口有空位返回true，超时返回false
+     */
+    bool WaitForWindow();
+    
     /*
      * @brief 发送日志批次
      * @param logs 日志条目批次
@@ -0,0 +1,144 @@
+#ifndef XUMJ_COMMON_CONCURRENCY_CONTROLLER_H
+#define XUMJ_COMMON_CONCURRENCY_CONTROLLER_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include "xumj/common/non_copyable.h"
+#include "xumj/common/prometheus_writer.h"
+
+namespace xumj {
+namespace common {
+
+/*
+ * @struct ConcurrencyConfig
+ * @brief 自适应并发控制配置
+ */
+struct ConcurrencyConfig {
+    size_t minThreads{1};                              // 最少线程数
+    size_t maxThreads{0};                              // 最多线程数，0表示CPU核心数的2倍
+    std::chrono::milliseconds interval{1000};          // 采样与调整间隔
+    std::chrono::milliseconds targetQueueDelay{50};    // 估计排队时间超过该值时扩容
+    double lowUtilization{0.3};                        // 线程忙碌比例低于该值且没有积压时缩容
+    double maxCpuUtilization{0.9};                     // 进程CPU利用率超过该值时不扩容，并按比例缩容
+    size_t increaseStep{1};                            // 每次扩容增加的线程数（加性增）
+    double decreaseFactor{0.75};                       // 每次缩容保留的比例（乘性减）
+    size_t cooldownTicks{2};                           // 调整后跳过的采样周期数，等待新线程数生效
+
+    /*
+     * @brief 实际使用的最大线程数
+     */
+    size_t ResolvedMaxThreads() const;
+};
+
+/*
+ * @struct ConcurrencySample
+ * @brief 被控对象的一次采样，计数均为累计值
+ */
+struct ConcurrencySample {
+    size_t queueDepth{0};       // 当前积压条数
+    uint64_t completed{0};      // 累计完成条数
+    uint64_t busyMicros{0};     // 所有线程累计处理时间（微秒）
+};
+
+/*
+ * @class ConcurrencyController
+ * @brief 根据队列积压、单条处理时间和CPU利用率调整线程数（AIMD）
+ *
+ * 每个周期由采样差值估计单条处理时间s和线程忙碌比例u，
+ * 估计排队时间 = 积压 × s / 线程数：
+ *   - 超过targetQueueDelay且CPU未饱和时加性扩容；
+ *   - CPU饱和时乘性缩容，减少线程间的争用；
+ *   - 积压很小且u低于lowUtilization时乘性缩容。
+ * 调整通过回调应用，控制线程与被控对象的处理线程相互独立。
+ */
+class ConcurrencyController : public NonCopyable {
+public:
+    using Sampler = std::function<ConcurrencySample()>;
+    using Applier = std::function<void(size_t)>;
+
+    /*
+     * @brief 构造函数
+     * @param config 控制配置
+     * @param initialThreads 当前线程数
+     * @param sampler 采样函数，在控制线程中调用
+     * @param applier 应用新线程数的函数，在控制线程中调用
+     */
+    ConcurrencyController(const ConcurrencyConfig& config, size_t initialThreads,
+                          Sampler sampler, Applier applier);
+
+    ~ConcurrencyController();
+
+    /*
+     * @brief 启动控制线程
+     */
+    void Start();
+
+    /*
+     * @brief 停止控制线程
+     */
+    void Stop();
+
+    /*
+     * @brief 根据一次采样做出调整决定，控制线程每个周期调用一次
+     * @param sample 采样
+     * @param cpuUtilization 本周期进程CPU利用率（0~1，按核心数归一化）
+     * @param elapsed 距上次采样的时间
+     * @return 新的线程数；与当前值不同时已调用applier
+     */
+    size_t Evaluate(const ConcurrencySample& sample, double cpuUtilization,
+                    std::chrono::microseconds elapsed);
+
+    /*
+     * @brief 当前线程数
+     */
+    size_t GetLimit() const { return limit_.load(std::memory_order_relaxed); }
+
+    /*
+     * @brief 输出控制决策指标
+     * @param writer 指标输出
+     * @param prefix 指标名前缀，例如"xumj_processor_workers"
+     */
+    void WritePrometheusMetrics(PrometheusWriter& writer, const std::string& prefix) const;
+
+private:
+    void ControlLoop();
+    void Apply(size_t limit, std::atomic<uint64_t>& counter);
+
+    ConcurrencyConfig config_;
+    Sampler sampler_;
+    Applier applier_;
+
+    std::atomic<size_t> limit_;
+    std::atomic<uint64_t> increases_{0};
+    std::atomic<uint64_t> decreases_{0};
+    std::atomic<uint64_t> queueDelayMicros_{0};    // 最近一次估计的排队时间
+    std::atomic<uint64_t> utilizationPermille_{0}; // 最近一次的线程忙碌比例（千分比）
+    std::atomic<uint64_t> cpuPermille_{0};         // 最近一次的进程CPU利用率（千分比）
+
+    // 以下只在控制线程中访问
+    bool hasLast_{false};
+    ConcurrencySample last_;
+    double serviceMicros_{0};
+    size_t cooldown_{0};
+
+    std::thread thread_;
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    bool running_{false};
+};
+
+/*
+ * @brief 当前进程已使用的CPU时间（所有线程之和，微秒）
+ */
+uint64_t ProcessCpuMicros();
+
+} // namespace common
+} // namespace xumj
+
+#endif // XUMJ_COMMON_CONCURRENCY_CONTROLLER_H
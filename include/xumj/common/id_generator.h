@@ -0,0 +1,114 @@
+#ifndef XUMJ_COMMON_ID_GENERATOR_H
+#define XUMJ_COMMON_ID_GENERATOR_H
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace xumj {
+namespace common {
+
+/*
+ * @brief 128位日志ID
+ *
+ * 布局：hi = | Unix毫秒(48位) | 节点(16位) |，lo = | 线程槽位(16位) | 计数(48位) |
+ * 按(hi, lo)比较即按时间排序，同一线程内严格递增。
+ */
+struct LogId {
+    uint64_t hi{0};
+    uint64_t lo{0};
+
+    uint64_t TimestampMs() const { return hi >> 16; }
+    uint16_t NodeId() const { return static_cast<uint16_t>(hi & 0xFFFF); }
+
+    bool operator==(const LogId& other) const { return hi == other.hi && lo == other.lo; }
+    bool operator!=(const LogId& other) const { return !(*this == other); }
+    bool operator<(const LogId& other) const {
+        return hi < other.hi || (hi == other.hi && lo < other.lo);
+    }
+};
+
+/*
+ * @class IdGenerator
+ * @brief 按时间递增的日志ID生成器，替代libuuid的随机UUID
+ *
+ * 生成128位ID（ULID风格）：每个线程独立的槽位和计数器，生成时不需要任何同步；
+ * 文本形式为26个字符的Crockford Base32，字典序与数值序一致。
+ * 线程退出时槽位连同最后的时间和计数一起归还，复用槽位的线程从那里继续递增，
+ * 线程池反复扩缩容也不会让两个存活的线程拿到同一个槽位。
+ *
+ * 时间有序的ID作为MySQL主键时新记录总是追加到B+树末尾，避免随机UUID造成的页分裂。
+ * 节点ID默认由主机名和进程号散列得到，多实例部署时应通过SetNodeId显式指定。
+ */
+class IdGenerator {
+public:
+    static constexpr size_t kTextLength = 26;     // 128位ID的文本长度
+
+    /*
+     * @brief 获取进程内的全局实例
+     */
+    static IdGenerator& Instance();
+
+    /*
+     * @brief 设置节点ID，应在生成任何ID之前调用
+     * @param nodeId 节点ID
+     */
+    void SetNodeId(uint16_t nodeId) { nodeId_.store(nodeId, std::memory_order_relaxed); }
+
+    /*
+     * @brief 获取节点ID
+     */
+    uint16_t GetNodeId() const { return nodeId_.load(std::memory_order_relaxed); }
+
+    /*
+     * @brief 生成128位ID
+     */
+    LogId Next();
+
+    /*
+     * @brief 生成128位ID的文本形式（26个字符）
+     */
+    std::string NextString();
+
+    /*
+     * @brief 将128位ID编码为26个字符
+     * @param id ID
+     * @param out 输出缓冲区，至少kTextLength字节，不写入结尾的'\0'
+     */
+    static void Encode(const LogId& id, char* out);
+    static std::string Encode(const LogId& id);
+
+    /*
+     * @brief 解析26个字符的ID文本（不区分大小写）
+     * @param text 文本
+     * @param id 输出ID
+     * @return 格式正确返回true
+     */
+    static bool Decode(const std::string& text, LogId& id);
+
+private:
+    // 线程槽位及该槽位上最后生成的时间和计数
+    struct SlotState {
+        uint16_t slot{0};
+        uint64_t lastMs{0};
+        uint64_t counter{0};
+    };
+    struct ThreadState;   // 每个线程的128位ID状态，线程退出时归还槽位
+
+    IdGenerator();
+
+    SlotState AcquireSlot();
+    void ReleaseSlot(const SlotState& state);
+
+    std::atomic<uint16_t> nodeId_;
+    std::mutex slotMutex_;
+    uint32_t nextThreadSlot_{0};           // 从未分配过的下一个槽位（由slotMutex_保护）
+    std::vector<SlotState> freeSlots_;     // 已退出线程归还的槽位（由slotMutex_保护）
+};
+
+} // namespace common
+} // namespace xumj
+
+#endif // XUMJ_COMMON_ID_GENERATOR_H
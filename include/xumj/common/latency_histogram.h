@@ -0,0 +1,181 @@
+#ifndef XUMJ_COMMON_LATENCY_HISTOGRAM_H
+#define XUMJ_COMMON_LATENCY_HISTOGRAM_H
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+namespace xumj {
+namespace common {
+
+/**
+ * @class LatencyHistogram
+ * @brief HDR风格的对数-线性直方图，用于统计延迟分位数
+ *
+ * 小于128的值每个值一个桶；更大的值按2的幂分段，每段再线性划分为64个桶，
+ * 相对误差不超过1/64（约1.6%）。桶计数使用原子变量，多个线程可以并发Record，
+ * 占用内存固定（约30KB），与样本数量无关。
+ */
+class LatencyHistogram {
+public:
+    LatencyHistogram() { Reset(); }
+
+    LatencyHistogram(const LatencyHistogram&) = delete;
+    LatencyHistogram& operator=(const LatencyHistogram&) = delete;
+
+    /**
+     * @brief 记录一个样本
+     * @param value 样本值（单位由调用方决定，通常为微秒）
+     */
+    void Record(uint64_t value) {
+        buckets_[IndexOf(value)].fetch_add(1, std::memory_order_relaxed);
+        count_.fetch_add(1, std::memory_order_relaxed);
+        sum_.fetch_add(value, std::memory_order_relaxed);
+
+        uint64_t current = min_.load(std::memory_order_relaxed);
+        while (value < current && !min_.compare_exchange_weak(current, value, std::memory_order_relaxed)) {
+        }
+        current = max_.load(std::memory_order_relaxed);
+        while (value > current && !max_.compare_exchange_weak(current, value, std::memory_order_relaxed)) {
+        }
+    }
+
+    /**
+     * @brief 获取分位数
+     * @param percentile 百分位，取值[0, 100]，例如99.9
+     * @return 该分位数所在桶的上界（不超过实际最大值），无样本时返回0
+     */
+    uint64_t Percentile(double percentile) const {
+        uint64_t total = Count();
+        if (total == 0) {
+            return 0;
+        }
+        percentile = std::min(std::max(percentile, 0.0), 100.0);
+        uint64_t target = static_cast<uint64_t>(percentile / 100.0 * static_cast<double>(total) + 0.5);
+        target = std::max<uint64_t>(target, 1);
+
+        uint64_t seen = 0;
+        for (size_t i = 0; i < kBucketCount; ++i) {
+            seen += buckets_[i].load(std::memory_order_relaxed);
+            if (seen >= target) {
+                return std::min(HighestEquivalent(i), Max());
+            }
+        }
+        return Max();
+    }
+
+    uint64_t Count() const { return count_.load(std::memory_order_relaxed); }
+
+    uint64_t Min() const {
+        return Count() == 0 ? 0 : min_.load(std::memory_order_relaxed);
+    }
+
+    uint64_t Max() const { return max_.load(std::memory_order_relaxed); }
+
+    uint64_t Sum() const { return sum_.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief 一次遍历统计不超过各上界的样本数（累计计数），用于导出固定分界的直方图
+     * @param bounds 递增的上界
+     * @param counts 输出，与bounds一一对应；上界所在的桶整体计入，误差与分位数相同
+     * @return 样本总数（按桶求和，与counts在同一次遍历中得到，并发Record时也保持一致）
+     */
+    uint64_t CumulativeCounts(const std::vector<uint64_t>& bounds, std::vector<uint64_t>& counts) const {
+        counts.assign(bounds.size(), 0);
+        uint64_t seen = 0;
+        size_t next = 0;
+        for (size_t i = 0; i < kBucketCount; ++i) {
+            uint64_t lowest = i == 0 ? 0 : HighestEquivalent(i - 1) + 1;
+            while (next < bounds.size() && bounds[next] < lowest) {
+                counts[next++] = seen;
+            }
+            seen += buckets_[i].load(std::memory_order_relaxed);
+        }
+        while (next < bounds.size()) {
+            counts[next++] = seen;
+        }
+        return seen;
+    }
+
+    double Mean() const {
+        uint64_t total = Count();
+        return total == 0 ? 0.0 : static_cast<double>(sum_.load(std::memory_order_relaxed)) / total;
+    }
+
+    /**
+     * @brief 合并另一个直方图的样本
+     */
+    void Merge(const LatencyHistogram& other) {
+        for (size_t i = 0; i < kBucketCount; ++i) {
+            uint64_t n = other.buckets_[i].load(std::memory_order_relaxed);
+            if (n != 0) {
+                buckets_[i].fetch_add(n, std::memory_order_relaxed);
+            }
+        }
+        count_.fetch_add(other.Count(), std::memory_order_relaxed);
+        sum_.fetch_add(other.sum_.load(std::memory_order_relaxed), std::memory_order_relaxed);
+        if (other.Count() != 0) {
+            uint64_t otherMin = other.min_.load(std::memory_order_relaxed);
+            uint64_t current = min_.load(std::memory_order_relaxed);
+            while (otherMin < current && !min_.compare_exchange_weak(current, otherMin, std::memory_order_relaxed)) {
+            }
+            uint64_t otherMax = other.Max();
+            current = max_.load(std::memory_order_relaxed);
+            while (otherMax > current && !max_.compare_exchange_weak(current, otherMax, std::memory_order_relaxed)) {
+            }
+        }
+    }
+
+    /**
+     * @brief 清空所有样本，不应与Record并发调用
+     */
+    void Reset() {
+        for (auto& bucket : buckets_) {
+            bucket.store(0, std::memory_order_relaxed);
+        }
+        count_.store(0, std::memory_order_relaxed);
+        sum_.store(0, std::memory_order_relaxed);
+        min_.store(std::numeric_limits<uint64_t>::max(), std::memory_order_relaxed);
+        max_.store(0, std::memory_order_relaxed);
+    }
+
+private:
+    static constexpr unsigned kSubBucketBits = 7;                        // 精确区间[0, 128)
+    static constexpr uint64_t kSubBucketCount = 1ull << kSubBucketBits;
+    static constexpr uint64_t kHalfCount = kSubBucketCount / 2;
+    static constexpr size_t kBucketCount = (64 - kSubBucketBits + 1) * kHalfCount + kHalfCount;
+
+    // 值 -> 桶下标：段号m为值需要右移的位数，段内下标为右移后的高7位
+    static size_t IndexOf(uint64_t value) {
+        if (value < kSubBucketCount) {
+            return static_cast<size_t>(value);
+        }
+        unsigned msb = 63u - static_cast<unsigned>(__builtin_clzll(value));
+        unsigned shift = msb - (kSubBucketBits - 1);
+        return static_cast<size_t>(shift * kHalfCount + (value >> shift));
+    }
+
+    // 桶下标 -> 桶内最大值
+    static uint64_t HighestEquivalent(size_t index) {
+        if (index < kSubBucketCount) {
+            return index;
+        }
+        uint64_t shift = index / kHalfCount - 1;
+        uint64_t sub = index % kHalfCount + kHalfCount;
+        return ((sub + 1) << shift) - 1;
+    }
+
+    std::array<std::atomic<uint64_t>, kBucketCount> buckets_;
+    std::atomic<uint64_t> count_;
+    std::atomic<uint64_t> sum_;
+    std::atomic<uint64_t> min_;
+    std::atomic<uint64_t> max_;
+};
+
+} // namespace common
+} // namespace xumj
+
+#endif // XUMJ_COMMON_LATENCY_HISTOGRAM_H
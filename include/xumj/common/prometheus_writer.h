@@ -0,0 +1,81 @@
+#ifndef XUMJ_COMMON_PROMETHEUS_WRITER_H
+#define XUMJ_COMMON_PROMETHEUS_WRITER_H
+
+#include <cstdint>
+#include <string>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+#include "xumj/common/latency_histogram.h"
+
+namespace xumj {
+namespace common {
+
+/*
+ * @class PrometheusWriter
+ * @brief 生成Prometheus文本格式（0.0.4）的指标
+ *
+ * 同名指标的样本必须连续写入；每个指标名第一次写入时输出HELP和TYPE行。
+ * 直方图由LatencyHistogram（微秒）转换，分界和总和按秒输出。
+ * 只读取原子计数，不加锁，可以在采集线程中随时调用。
+ */
+class PrometheusWriter {
+public:
+    using Labels = std::vector<std::pair<std::string, std::string>>;
+
+    PrometheusWriter() = default;
+
+    /*
+     * @brief 写入计数器
+     * @param name 指标名，按惯例以_total结尾
+     * @param help 说明
+     * @param value 值
+     * @param labels 标签
+     */
+    void Counter(const std::string& name, const std::string& help, double value, const Labels& labels = {});
+
+    /*
+     * @brief 写入瞬时值
+     */
+    void Gauge(const std::string& name, const std::string& help, double value, const Labels& labels = {});
+
+    /*
+     * @brief 写入延迟直方图
+     * @param name 指标名，按惯例以_seconds结尾
+     * @param help 说明
+     * @param histogram 样本单位为微秒的直方图
+     * @param labels 标签
+     */
+    void Histogram(const std::string& name, const std::string& help, const LatencyHistogram& histogram,
+                   const Labels& labels = {});
+
+    /*
+     * @brief 已生成的文本
+     */
+    const std::string& Text() const { return text_; }
+
+    /*
+     * @brief 直方图的默认分界（微秒），从10微秒到5秒
+     */
+    static const std::vector<uint64_t>& DefaultBounds();
+
+private:
+    void Family(const std::string& name, const std::string& help, const char* type);
+    void Sample(const std::string& name, const Labels& labels, const char* extraName,
+                const std::string& extraValue, double value);
+
+    std::string text_;
+    std::unordered_set<std::string> families_;
+    std::vector<uint64_t> counts_;   // 直方图累计计数的临时缓冲
+};
+
+/*
+ * @brief 读取当前进程的常驻内存（/proc/self/statm）
+ * @return 字节数，读取失败时返回0
+ */
+uint64_t ReadResidentMemoryBytes();
+
+} // namespace common
+} // namespace xumj
+
+#endif // XUMJ_COMMON_PROMETHEUS_WRITER_H
@@ -0,0 +1,216 @@
+#ifndef XUMJ_COMMON_RECORD_BATCH_H
+#define XUMJ_COMMON_RECORD_BATCH_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace xumj {
+namespace common {
+
+/*
+ * @brief 日志级别，按严重程度递增；无法识别的级别为OTHER，原文保存在批次中
+ */
+enum class LogLevel : uint8_t {
+    TRACE = 0,
+    DEBUG,
+    INFO,
+    WARN,
+    ERROR,
+    FATAL,
+    OTHER
+};
+
+/*
+ * @class RecordBatch
+ * @brief 列式日志记录批次，在处理器、分析器和存储之间传递
+ *
+ * 每列一个连续数组：
+ *   - ID和消息：所有行的字节拼接在一个缓冲区中，用偏移量数组定位
+ *   - 时间戳：int64毫秒（墙上时间按UTC规则编码，只用于比较和还原文本）
+ *   - 级别：uint8
+ *   - 来源：字典编码，每行只存字典下标
+ *   - 自定义字段：稀疏列，每列只记录有值的行
+ * 追加一行不会为该行单独分配内存；Clear后保留容量，重复使用同一个批次时几乎没有内存分配。
+ * 列数组可以直接按下标扫描做向量化过滤（见Select*）。
+ */
+class RecordBatch {
+public:
+    static constexpr int64_t kNoTimestamp = INT64_MIN;   // 时间戳无法解析
+
+    RecordBatch() = default;
+
+    /*
+     * @brief 预留容量
+     * @param rows 行数
+     * @param bytes ID和消息的总字节数
+     */
+    void Reserve(size_t rows, size_t bytes);
+
+    /*
+     * @brief 清空批次，保留已分配的容量；这一批没有用到的字段列被删除
+     */
+    void Clear();
+
+    /*
+     * @brief 追加一行
+     * @param id 日志ID
+     * @param timestamp 时间戳文本，无法解析时原样保存
+     * @param level 级别文本，不区分大小写；与标准名称写法不同时另外保存原文
+     * @param source 来源
+     * @param message 消息
+     * @return 行号
+     */
+    size_t Append(std::string_view id, std::string_view timestamp, std::string_view level,
+                  std::string_view source, std::string_view message);
+
+    /*
+     * @brief 追加一行（时间戳和级别已是列的编码）
+     */
+    size_t Append(std::string_view id, int64_t timestampMs, LogLevel level,
+                  std::string_view source, std::string_view message);
+
+    /*
+     * @brief 为最后追加的一行设置自定义字段
+     * @param name 字段名
+     * @param value 字段值
+     */
+    void SetField(std::string_view name, std::string_view value);
+
+    // 行数
+    size_t Size() const { return timestamps_.size(); }
+    bool Empty() const { return timestamps_.empty(); }
+
+    // 按行读取
+    std::string_view Id(size_t row) const { return Slice(ids_, idOffsets_, row); }
+    std::string_view Message(size_t row) const { return Slice(messages_, messageOffsets_, row); }
+    std::string_view Source(size_t row) const { return sourceDictionary_[sourceIds_[row]]; }
+    int64_t Timestamp(size_t row) const { return timestamps_[row]; }
+    LogLevel Level(size_t row) const { return static_cast<LogLevel>(levels_[row]); }
+
+    /*
+     * @brief 时间戳文本，格式为YYYY-MM-DD HH:MM:SS[.mmm]；无法解析的时间戳返回原文
+     */
+    std::string TimestampText(size_t row) const;
+
+    /*
+     * @brief 同上，写入text并复用其已分配的内存
+     */
+    void TimestampText(size_t row, std::string& text) const;
+
+    /*
+     * @brief 级别文本，即写入时的原文
+     */
+    std::string_view LevelText(size_t row) const;
+
+    /*
+     * @brief 读取自定义字段
+     * @return 该行没有此字段时返回false
+     */
+    bool Field(size_t row, std::string_view name, std::string_view& value) const;
+
+    /*
+     * @brief 遍历一行的所有自定义字段
+     * @param visit 回调，参数为字段名和值
+     */
+    template <typename Visitor>
+    void ForEachField(size_t row, Visitor&& visit) const {
+        for (const auto& column : fields_) {
+            if (IsReserved(column.name)) {
+                continue;
+            }
+            std::string_view value;
+            if (column.Find(row, value)) {
+                visit(std::string_view(column.name), value);
+            }
+        }
+    }
+
+    // 列数据，用于按列扫描
+    const std::vector<int64_t>& Timestamps() const { return timestamps_; }
+    const std::vector<uint8_t>& Levels() const { return levels_; }
+    const std::vector<uint32_t>& SourceIds() const { return sourceIds_; }
+    const std::vector<std::string>& SourceDictionary() const { return sourceDictionary_; }
+
+    /*
+     * @brief 选出级别不低于minLevel的行（OTHER总是入选）
+     * @param selection 输出行号
+     * @return 入选行数
+     */
+    size_t SelectLevelAtLeast(LogLevel minLevel, std::vector<uint32_t>& selection) const;
+
+    /*
+     * @brief 选出时间戳在[begin, end)内的行
+     */
+    size_t SelectTimeRange(int64_t begin, int64_t end, std::vector<uint32_t>& selection) const;
+
+    /*
+     * @brief 选出来源为source的行
+     */
+    size_t SelectSource(std::string_view source, std::vector<uint32_t>& selection) const;
+
+    /*
+     * @brief 解析级别文本，不区分大小写，WARNING视为WARN，CRITICAL视为FATAL
+     */
+    static LogLevel ParseLevel(std::string_view text);
+
+    /*
+     * @brief 级别名称
+     */
+    static const char* LevelName(LogLevel level);
+
+    /*
+     * @brief 解析YYYY-MM-DD[T ]HH:MM:SS[.fff]格式的时间戳
+     * @return 格式不符时返回kNoTimestamp
+     */
+    static int64_t ParseTimestamp(std::string_view text);
+
+    /*
+     * @brief 格式化时间戳，毫秒为0时不输出小数部分
+     */
+    static std::string FormatTimestamp(int64_t timestampMs);
+    static void FormatTimestamp(int64_t timestampMs, std::string& text);
+
+private:
+    // 稀疏字段列：rows递增，与offsets一一对应
+    struct FieldColumn {
+        std::string name;
+        std::vector<uint32_t> rows;
+        std::vector<uint32_t> offsets;   // 每个值的结束位置
+        std::string data;
+
+        bool Find(size_t row, std::string_view& value) const;
+    };
+
+    // 保存无法解析的时间戳和非标准写法的级别原文
+    static constexpr const char* kRawTimestamp = "@timestamp";
+    static constexpr const char* kRawLevel = "@level";
+    static bool IsReserved(const std::string& name) { return !name.empty() && name[0] == '@'; }
+
+    static std::string_view Slice(const std::string& data, const std::vector<uint32_t>& ends, size_t row) {
+        uint32_t begin = row == 0 ? 0 : ends[row - 1];
+        return std::string_view(data.data() + begin, ends[row] - begin);
+    }
+
+    uint32_t SourceId(std::string_view source);
+    FieldColumn& Column(std::string_view name);
+
+    std::string ids_;
+    std::vector<uint32_t> idOffsets_;
+    std::vector<int64_t> timestamps_;
+    std::vector<uint8_t> levels_;
+    std::vector<uint32_t> sourceIds_;
+    std::vector<std::string> sourceDictionary_;
+    std::unordered_map<std::string, uint32_t> sourceLookup_;
+    std::string messages_;
+    std::vector<uint32_t> messageOffsets_;
+    std::vector<FieldColumn> fields_;
+};
+
+} // namespace common
+} // namespace xumj
+
+#endif // XUMJ_COMMON_RECORD_BATCH_H
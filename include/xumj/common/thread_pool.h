@@ -72,6 +72,15 @@ public:
      */
     void Reset(size_t numThreads = std::thread::hardware_concurrency());
     
+    /*
+     * @brief 运行时调整线程数量，不丢弃任务，也不中断正在执行的任务
+     * @param numThreads 目标线程数量，至少为1
+     *
+     * 扩容时立即创建新线程；缩容时多余的线程在执行完当前任务后退出，
+     * 已退出的线程在下一次Resize或析构时回收。
+     */
+    void Resize(size_t numThreads);
+    
 private:
     // 工作线程函数
     void WorkerThread();
@@ -82,9 +91,16 @@ private:
     // 线程池是否处于活动状态
     std::atomic<bool> isActive_;
     
-    // 工作线程集合
+    // 工作线程集合（包括已退出、尚未回收的线程）
     std::vector<std::thread> workers_;
     
+    // 目标线程数和仍在运行的线程数，受queueMutex_保护
+    size_t targetThreads_;
+    size_t liveThreads_;
+    
+    // 因缩容退出、等待回收的线程
+    std::vector<std::thread::id> retired_;
+    
     // 任务队列
     std::queue<std::function<void()>> tasks_;
     
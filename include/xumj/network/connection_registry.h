@@ -0,0 +1,150 @@
+#ifndef XUMJ_NETWORK_CONNECTION_REGISTRY_H
+#define XUMJ_NETWORK_CONNECTION_REGISTRY_H
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <muduo/net/TcpConnection.h>
+#include <muduo/net/EventLoop.h>
+#include <xumj/network/shared_payload.h>
+
+namespace xumj {
+namespace network {
+
+/*
+ * @brief 连接表中的一项，发布后不再修改
+ */
+struct ConnectionEntry {
+    uint64_t id{0};                          // 连接ID（包含分片、槽位和代数）
+    muduo::net::TcpConnectionPtr conn;       // 连接对象
+    muduo::net::EventLoop* loop{nullptr};    // 连接所属的IO事件循环
+    std::shared_ptr<OutboundQueue> outbox;   // 待发送队列，只在所属IO线程中访问
+};
+
+using ConnectionEntryPtr = std::shared_ptr<const ConnectionEntry>;
+
+/*
+ * @brief 按IO事件循环分片的连接注册表
+ *
+ * 每个IO线程对应一个分片，新连接在其所属IO线程中注册，因此每个分片只有一个写者。
+ * 槽位以 shared_ptr 原子读写的方式发布，读者（Send/GetConnection等）不加任何锁，
+ * 通过连接ID直接定位到分片和槽位，查找为O(1)。
+ *
+ * 连接ID的布局：| 代数(24位) | 槽位(32位) | 分片(8位) |
+ * 槽位复用时代数递增，旧ID不会误命中新连接。ID永远不为0。
+ */
+class ConnectionRegistry {
+public:
+    using Visitor = std::function<void(const ConnectionEntryPtr&)>;
+
+    static constexpr size_t kMaxShards = 256;
+
+    /*
+     * @brief 构造函数
+     * @param shardCount 分片数量，通常等于IO线程数，取值范围[1, 256]
+     */
+    explicit ConnectionRegistry(size_t shardCount);
+    ~ConnectionRegistry();
+
+    ConnectionRegistry(const ConnectionRegistry&) = delete;
+    ConnectionRegistry& operator=(const ConnectionRegistry&) = delete;
+
+    /*
+     * @brief 将当前线程绑定到指定分片，应在IO线程启动时调用
+     * @param shard 分片下标
+     */
+    void BindCurrentThread(size_t shard);
+
+    /*
+     * @brief 获取当前线程绑定的分片
+     * @return 分片下标，未绑定到本注册表时返回-1
+     */
+    int CurrentShard() const;
+
+    /*
+     * @brief 注册连接，应在连接所属的IO线程中调用
+     * @param conn 连接对象
+     * @param loop 连接所属的事件循环
+     * @return 分配的连接ID
+     */
+    uint64_t Register(const muduo::net::TcpConnectionPtr& conn, muduo::net::EventLoop* loop);
+
+    /*
+     * @brief 注销连接
+     * @param id 连接ID
+     * @return 连接存在并被注销返回true
+     */
+    bool Unregister(uint64_t id);
+
+    /*
+     * @brief 无锁查找连接
+     * @param id 连接ID
+     * @return 连接项，不存在时返回nullptr
+     */
+    ConnectionEntryPtr Find(uint64_t id) const;
+
+    /*
+     * @brief 遍历所有连接，遍历期间不阻塞注册和注销
+     * @param visitor 访问函数
+     */
+    void ForEach(const Visitor& visitor) const;
+
+    /*
+     * @brief 获取当前连接总数
+     */
+    size_t Size() const;
+
+    /*
+     * @brief 获取分片数量
+     */
+    size_t GetShardCount() const { return shards_.size(); }
+
+    /*
+     * @brief 清空所有连接
+     */
+    void Clear();
+
+    /*
+     * @brief 从连接ID中解析分片下标
+     */
+    static size_t ShardOf(uint64_t id) { return static_cast<size_t>(id & 0xFF); }
+
+private:
+    static constexpr size_t kChunkSize = 1024;   // 每个槽位块的槽位数
+    static constexpr size_t kMaxChunks = 4096;   // 每个分片最多的槽位块数
+
+    struct Chunk {
+        std::array<ConnectionEntryPtr, kChunkSize> slots;  // 通过std::atomic_load/atomic_store访问
+    };
+
+    struct Shard {
+        std::array<std::atomic<Chunk*>, kMaxChunks> chunks{};  // 槽位块，只增不减
+        std::atomic<size_t> highWater{0};                      // 已使用过的最大槽位数
+        std::atomic<size_t> count{0};                          // 当前连接数
+
+        // 以下成员只由写者访问；正常情况下只有所属IO线程写入，互斥锁无竞争
+        std::mutex writerMutex;
+        std::vector<uint32_t> generations;   // 每个槽位的代数
+        std::vector<uint32_t> freeSlots;     // 空闲槽位
+    };
+
+    static uint64_t MakeId(uint32_t generation, uint32_t slot, size_t shard) {
+        return (static_cast<uint64_t>(generation & 0xFFFFFF) << 40) |
+               (static_cast<uint64_t>(slot) << 8) |
+               static_cast<uint64_t>(shard & 0xFF);
+    }
+    static uint32_t SlotOf(uint64_t id) { return static_cast<uint32_t>((id >> 8) & 0xFFFFFFFF); }
+
+    size_t ChooseShard(muduo::net::EventLoop* loop) const;
+
+    std::vector<std::unique_ptr<Shard>> shards_;
+};
+
+} // namespace network
+} // namespace xumj
+
+#endif // XUMJ_NETWORK_CONNECTION_REGISTRY_H
@@ -0,0 +1,69 @@
+#ifndef XUMJ_NETWORK_SHARED_PAYLOAD_H
+#define XUMJ_NETWORK_SHARED_PAYLOAD_H
+
+#include <cstddef>
+#include <deque>
+#include <memory>
+#include <string>
+
+namespace xumj {
+namespace network {
+
+/*
+ * @brief 引用计数的不可变消息体
+ *
+ * 广播/多播时所有连接共享同一份数据，入队只增加引用计数，不复制内容。
+ */
+class SharedPayload {
+public:
+    SharedPayload() = default;
+
+    /*
+     * @brief 接管字符串内容构造消息体
+     * @param data 消息内容
+     */
+    explicit SharedPayload(std::string data)
+        : data_(std::make_shared<const std::string>(std::move(data))) {}
+
+    const char* Data() const { return data_ ? data_->data() : nullptr; }
+    size_t Size() const { return data_ ? data_->size() : 0; }
+    bool Empty() const { return Size() == 0; }
+
+    /*
+     * @brief 获取当前引用数，用于调试和测试
+     */
+    long UseCount() const { return data_.use_count(); }
+
+    const std::string& Str() const {
+        static const std::string kEmpty;
+        return data_ ? *data_ : kEmpty;
+    }
+
+private:
+    std::shared_ptr<const std::string> data_;
+};
+
+/*
+ * @brief 慢消费者处理策略
+ */
+enum class SlowConsumerPolicy {
+    DROP,        // 丢弃超出高水位的新消息
+    DISCONNECT   // 断开积压超过高水位的连接
+};
+
+/*
+ * @brief 连接的待发送队列，只在连接所属的IO线程中访问
+ *
+ * 队列中保存的是消息体引用，只有正在写入内核的那一条在未写完时才会被复制进
+ * muduo的输出缓冲区，其余消息在连接可写之前始终只占一份共享内存。
+ */
+struct OutboundQueue {
+    std::deque<SharedPayload> pending;   // 等待发送的消息
+    size_t pendingBytes{0};              // 等待发送的字节数
+    bool closing{false};                 // 已因积压过多被断开
+};
+
+} // namespace network
+} // namespace xumj
+
+#endif // XUMJ_NETWORK_SHARED_PAYLOAD_H
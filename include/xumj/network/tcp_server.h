@@ -2,7 +2,7 @@
 #define XUMJ_NETWORK_TCP_SERVER_H
 
 #include <string>
-#include <map>
+#include <vector>
 #include <functional>
 #include <memory>
 #include <cstdint>
@@ -14,6 +14,8 @@
 #include <muduo/net/EventLoop.h>
 #include <muduo/net/TcpConnection.h>
 #include <muduo/base/Timestamp.h>
+#include <xumj/network/connection_registry.h>
+#include <xumj/network/shared_payload.h>
 
 namespace xumj {
 namespace network {
@@ -25,8 +27,11 @@ class TcpServer {
 public:
     // 回调函数类型
     using MessageCallback = std::function<void(uint64_t, const std::string&, muduo::Timestamp)>;
+    using FrameCallback = std::function<void(uint64_t, std::string&&, muduo::Timestamp)>;
     using ConnectionCallback = std::function<void(uint64_t, const std::string&, bool)>;
     
+    static constexpr size_t kDefaultMaxLineLength = 16 * 1024 * 1024;  // 默认单行最大字节数
+    
     /*
      * @brief 构造函数
      * @param serverName 服务器名称
@@ -62,6 +67,14 @@ public:
      */
     bool Send(uint64_t connectionId, const std::string& message);
     
+    /*
+     * @brief 发送共享消息体给指定的连接，不复制消息内容
+     * @param connectionId 连接ID
+     * @param payload 消息体
+     * @return 成功投递返回true，失败返回false
+     */
+    bool Send(uint64_t connectionId, const SharedPayload& payload);
+    
     /*
      * @brief 广播消息给所有连接
      * @param message 消息内容
@@ -69,6 +82,87 @@ public:
      */
     size_t Broadcast(const std::string& message);
     
+    /*
+     * @brief 广播共享消息体给所有连接，所有连接共享同一份数据
+     * @param payload 消息体
+     * @return 投递的连接数
+     */
+    size_t Broadcast(const SharedPayload& payload);
+    
+    /*
+     * @brief 多播共享消息体给一组连接
+     * @param connectionIds 连接ID列表
+     * @param payload 消息体
+     * @return 投递的连接数
+     */
+    size_t Multicast(const std::vector<uint64_t>& connectionIds, const SharedPayload& payload);
+    
+    /*
+     * @brief 设置慢消费者处理策略，应在Start()之前调用
+     * @param policy 处理策略
+     * @param highWaterMark 每个连接允许积压的最大字节数，0表示不限制
+     */
+    void SetSlowConsumerPolicy(SlowConsumerPolicy policy, size_t highWaterMark) {
+        slowConsumerPolicy_ = policy;
+        highWaterMark_ = highWaterMark;
+    }
+    
+    /*
+     * @brief 设置是否按行分帧，应在Start()之前调用
+     * @param enabled 为true时每个以\n（或\r\n）结尾的完整行触发一次消息回调，
+     *                为false时每次收到的数据整体触发一次消息回调
+     */
+    void SetLineDelimited(bool enabled) {
+        lineDelimited_ = enabled;
+    }
+    
+    /*
+     * @brief 设置按行分帧时单行的最大字节数，应在Start()之前调用
+     * @param maxLength 最大字节数（不含行尾），0表示不限制；
+     *                  超过时断开连接，避免对端不发送换行符使缓冲区无限增长
+     */
+    void SetMaxLineLength(size_t maxLength) {
+        maxLineLength_ = maxLength;
+    }
+    
+    /*
+     * @brief 设置多监听模式，应在Start()之前调用
+     * @param enabled 为true时每个IO循环各自打开一个SO_REUSEPORT监听套接字，
+     *                由内核分配新连接，避免单个acceptor在重连风暴时成为瓶颈
+     */
+    void SetReusePortAcceptors(bool enabled) {
+        reusePortAcceptors_ = enabled;
+    }
+    
+    /*
+     * @brief 设置IO循环的CPU绑定，应在Start()之前调用
+     * @param cpus CPU编号列表，第i个IO循环绑定到cpus[i % cpus.size()]，为空表示不绑定
+     */
+    void SetCpuAffinity(const std::vector<int>& cpus) {
+        cpuAffinity_ = cpus;
+    }
+    
+    /*
+     * @brief 获取因积压过多被丢弃的消息数
+     */
+    uint64_t GetDroppedMessageCount() const {
+        return droppedMessages_.load(std::memory_order_relaxed);
+    }
+    
+    /*
+     * @brief 获取因积压过多被断开的连接数
+     */
+    uint64_t GetSlowConsumerDisconnectCount() const {
+        return slowConsumerDisconnects_.load(std::memory_order_relaxed);
+    }
+    
+    /*
+     * @brief 获取因单行超长被断开的连接数
+     */
+    uint64_t GetOversizedLineCount() const {
+        return oversizedLines_.load(std::memory_order_relaxed);
+    }
+    
     /*
      * @brief 关闭指定连接
      * @param connectionId 连接ID
@@ -97,6 +191,15 @@ public:
         messageCallback_ = callback;
     }
     
+    /*
+     * @brief 设置帧回调函数，消息以右值交付，接收方可以直接移走而不复制；
+     *        设置后优先于消息回调
+     * @param callback 回调函数
+     */
+    void SetFrameCallback(const FrameCallback& callback) {
+        frameCallback_ = callback;
+    }
+    
     /*
      * @brief 设置连接回调函数
      * @param callback 回调函数
@@ -157,7 +260,6 @@ private:
     size_t numThreads_;              // 工作线程数
     
     bool running_;                   // 服务器运行状态（需要与互斥锁一起使用）
-    std::atomic<uint64_t> nextConnectionId_; // 下一个连接ID
     
     // 互斥锁和条件变量，用于安全停止线程
     mutable std::mutex shutdownMutex_;
@@ -168,25 +270,56 @@ private:
     muduo::net::TcpServer* server_;        // TCP服务器指针
     std::unique_ptr<std::thread> loopThread_; // 事件循环线程
 
-    // 连接管理
-    mutable std::mutex connectionsMutex_;    // 连接映射表的互斥锁
-    std::map<uint64_t, muduo::net::TcpConnectionPtr> connections_; // 连接ID到连接对象的映射
+    // 连接管理：按IO线程分片的无锁连接表
+    std::unique_ptr<ConnectionRegistry> registry_;
+    std::atomic<size_t> nextShard_;          // IO线程启动时依次领取分片
+    
+    // 慢消费者控制
+    SlowConsumerPolicy slowConsumerPolicy_;  // 积压超过高水位时的处理策略
+    size_t highWaterMark_;                   // 每个连接允许积压的最大字节数，0表示不限制
+    std::atomic<uint64_t> droppedMessages_;  // 被丢弃的消息数
+    std::atomic<uint64_t> slowConsumerDisconnects_; // 被断开的慢连接数
+    
+    bool lineDelimited_;                     // 是否按行分帧
+    size_t maxLineLength_;                   // 单行最大字节数，0表示不限制
+    std::atomic<uint64_t> oversizedLines_;   // 因单行超长被断开的连接数
+    
+    // 多监听模式（SO_REUSEPORT）
+    bool reusePortAcceptors_;                // 是否每个IO循环一个监听套接字
+    std::vector<int> cpuAffinity_;           // IO循环绑定的CPU列表
+    std::vector<std::unique_ptr<std::thread>> acceptorThreads_; // 监听循环线程
+    std::vector<muduo::net::EventLoop*> acceptorLoops_;          // 监听循环（受shutdownMutex_保护）
+    size_t startedAcceptors_;                // 已启动的监听循环数
+    bool acceptorFailed_;                    // 是否有监听循环启动失败
     
     // 回调函数
     ConnectionCallback connectionCallback_; // 连接回调
     MessageCallback messageCallback_;      // 消息回调
+    FrameCallback frameCallback_;          // 帧回调（右值交付）
     
     // muduo回调处理
     void HandleConnection(const muduo::net::TcpConnectionPtr& conn, bool connected);
     void HandleMessage(const muduo::net::TcpConnectionPtr& conn, 
                        muduo::net::Buffer* buffer,
                        muduo::Timestamp timestamp);
+    void HandleWriteComplete(const muduo::net::TcpConnectionPtr& conn);
+    void DispatchMessage(uint64_t connectionId, std::string&& message, muduo::Timestamp timestamp);
+    void CloseOversizedLine(const muduo::net::TcpConnectionPtr& conn, uint64_t connectionId,
+                            muduo::net::Buffer* buffer, size_t length);
+    void InstallCallbacks(muduo::net::TcpServer& server);
+    
+    // 多监听模式
+    void StartReusePortAcceptors();
+    void RunAcceptorLoop(size_t index);
+    
+    // 在连接所属的IO线程中发送或排队消息体
+    void DeliverInLoop(const ConnectionEntryPtr& entry, const SharedPayload& payload);
+    
+    // 将一组连接按事件循环分组后投递，每个循环只唤醒一次
+    size_t DeliverToEntries(const std::vector<ConnectionEntryPtr>& entries, const SharedPayload& payload);
     
     // 连接管理
-    uint64_t GenerateConnectionId() {
-        return nextConnectionId_++;
-    }
-    void RegisterConnection(uint64_t id, const muduo::net::TcpConnectionPtr& conn);
+    uint64_t RegisterConnection(const muduo::net::TcpConnectionPtr& conn);
     void UnregisterConnection(uint64_t id);
 };
 
@@ -0,0 +1,167 @@
+#ifndef XUMJ_PROCESSOR_ACK_TRACKER_H
+#define XUMJ_PROCESSOR_ACK_TRACKER_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <unordered_map>
+
+namespace xumj {
+namespace processor {
+
+class AckTracker;
+
+/*
+ * @struct BatchTicket
+ * @brief 一个带序号批次的处理凭证，批次内每条日志存储完成后调用一次Complete
+ */
+struct BatchTicket {
+    std::string stream;                 // 发送方的流标识（采集器ID + 启动时间）
+    uint64_t seq{0};                    // 批次序号
+    std::atomic<size_t> remaining{0};   // 尚未完成的日志数
+    std::atomic<bool> failed{false};    // 是否有日志存储失败
+    AckTracker* tracker{nullptr};       // 所属的跟踪器
+
+    /*
+     * @brief 标记批次中的一条日志处理完成
+     * @param stored 是否已成功存储
+     */
+    void Complete(bool stored);
+};
+
+/*
+ * @class AckTracker
+ * @brief 采集器与处理器之间的确认投递跟踪
+ *
+ * 协议（按行分隔的JSON）：
+ *   采集器 -> 处理器: {"type":"batch","stream":"...","seq":N,"base":B,"logs":[...]}
+ *   处理器 -> 采集器: {"type":"ack","stream":"...","seq":M}
+ * 每个流的序号从1开始单调递增；ack为累计确认，表示序号<=M的批次都已存储。
+ * base是采集器发送时已收到的累计确认，处理器第一次见到一个流（重启或流被淘汰后）时以base为起点，
+ * 重连后新批次先于重传到达也不会把前面未存储的批次当作已确认。
+ * 已确认或正在处理中的序号再次到达时视为重复并丢弃，同时重发当前的累计确认。
+ *
+ * 流标识带采集器的启动时间，每次重启都是新的流。没有处理中批次的流在空闲超过idleTtl、
+ * 或所在连接关闭超过closedTtl后淘汰；关闭后保留一段时间，使采集器重连后的重传仍能去重。
+ */
+class AckTracker {
+public:
+    /*
+     * @brief 确认回调
+     * @param connectionId 发送方当前所在的连接
+     * @param stream 流标识
+     * @param ackedSeq 累计确认的序号
+     */
+    using AckCallback = std::function<void(uint64_t connectionId, const std::string& stream, uint64_t ackedSeq)>;
+
+    /*
+     * @brief 存储失败回调，批次不会被确认，发送方需要在重连后重传
+     */
+    using FailureCallback = std::function<void(uint64_t connectionId, const std::string& stream, uint64_t seq)>;
+
+    /*
+     * @brief 构造函数
+     * @param callback 确认回调
+     * @param idleTtl 流空闲多久后淘汰
+     * @param closedTtl 流所在连接关闭多久后淘汰
+     */
+    explicit AckTracker(AckCallback callback,
+                        std::chrono::seconds idleTtl = std::chrono::hours(1),
+                        std::chrono::seconds closedTtl = std::chrono::minutes(5));
+
+    /*
+     * @brief 设置存储失败回调
+     */
+    void SetFailureCallback(FailureCallback callback) { failureCallback_ = std::move(callback); }
+
+    /*
+     * @brief 登记一个新到达的批次
+     * @param connectionId 批次到达的连接
+     * @param stream 流标识
+     * @param seq 批次序号
+     * @param base 发送方已收到的累计确认序号
+     * @param count 批次中的日志数
+     * @return 批次凭证；重复批次返回nullptr（此时已重发累计确认）
+     */
+    std::shared_ptr<BatchTicket> Begin(uint64_t connectionId, const std::string& stream,
+                                       uint64_t seq, uint64_t base, size_t count);
+
+    /*
+     * @brief 连接关闭，该连接上的流开始按closedTtl计时
+     * @param connectionId 连接ID
+     */
+    void OnConnectionClosed(uint64_t connectionId);
+
+    /*
+     * @brief 淘汰过期的流，Begin中每秒最多自动调用一次
+     * @param now 当前时间
+     * @return 淘汰的流数量
+     */
+    size_t Sweep(std::chrono::steady_clock::time_point now);
+
+    /*
+     * @brief 获取跟踪中的流数量
+     */
+    size_t GetStreamCount() const;
+
+    /*
+     * @brief 获取流的累计确认序号
+     */
+    uint64_t GetAckedSequence(const std::string& stream) const;
+
+    /*
+     * @brief 获取被丢弃的重复批次数
+     */
+    uint64_t GetDuplicateCount() const { return duplicates_.load(std::memory_order_relaxed); }
+
+    /*
+     * @brief 获取存储失败未确认的批次数
+     */
+    uint64_t GetFailedCount() const { return failed_.load(std::memory_order_relaxed); }
+
+    /*
+     * @brief 获取被淘汰的流数量
+     */
+    uint64_t GetEvictedCount() const { return evicted_.load(std::memory_order_relaxed); }
+
+private:
+    friend struct BatchTicket;
+
+    struct StreamState {
+        uint64_t acked{0};                // 累计确认序号
+        uint64_t connectionId{0};         // 最近一次收到批次的连接
+        bool closed{false};               // 所在连接是否已关闭
+        std::chrono::steady_clock::time_point lastActive;  // 最近一次收到批次或连接关闭的时间
+        std::set<uint64_t> inProgress;    // 正在处理的序号
+        std::set<uint64_t> completed;     // 已完成但前面还有空洞的序号
+    };
+
+    void Finish(const std::string& stream, uint64_t seq, bool stored);
+
+    // 把累计确认推进到第一个空洞之前，返回是否推进（调用方需持有mutex_）
+    static bool Advance(StreamState& state);
+
+    // 淘汰过期的流（调用方需持有mutex_）
+    size_t SweepLocked(std::chrono::steady_clock::time_point now);
+
+    AckCallback callback_;
+    FailureCallback failureCallback_;
+    mutable std::mutex mutex_;
+    const std::chrono::seconds idleTtl_;
+    const std::chrono::seconds closedTtl_;
+    std::unordered_map<std::string, StreamState> streams_;
+    std::chrono::steady_clock::time_point lastSweep_;
+    std::atomic<uint64_t> duplicates_{0};
+    std::atomic<uint64_t> failed_{0};
+    std::atomic<uint64_t> evicted_{0};
+};
+
+} // namespace processor
+} // namespace xumj
+
+#endif // XUMJ_PROCESSOR_ACK_TRACKER_H
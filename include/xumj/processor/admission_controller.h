@@ -0,0 +1,148 @@
+#ifndef XUMJ_PROCESSOR_ADMISSION_CONTROLLER_H
+#define XUMJ_PROCESSOR_ADMISSION_CONTROLLER_H
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "xumj/common/non_copyable.h"
+#include "xumj/common/prometheus_writer.h"
+#include "xumj/common/record_batch.h"
+
+namespace xumj {
+namespace processor {
+
+constexpr size_t kLogLevelCount = static_cast<size_t>(common::LogLevel::OTHER) + 1;
+
+/*
+ * @struct AdmissionConfig
+ * @brief 按级别和来源的入队准入配置
+ *
+ * 队列容量为C时，低于ERROR的级别最多占用 C × min(levelQuota, 1 - reservedHeadroom)，
+ * 剩余的容量只留给ERROR和FATAL。占用超过本级别上限的sheddingStart比例后按线性增长的概率丢弃，
+ * 级别越低上限越小，越早开始丢弃。
+ */
+struct AdmissionConfig {
+    bool enabled = false;                  // 是否启用；不启用时队列满才拒绝，与级别无关
+    double reservedHeadroom = 0.1;         // 只有ERROR及以上级别可以使用的队列比例
+    double sheddingStart = 0.5;            // 占用达到本级别上限的该比例后开始按概率丢弃
+    std::array<double, kLogLevelCount> levelQuota{{0.5, 0.7, 1.0, 1.0, 1.0, 1.0, 1.0}};  // 各级别（TRACE..OTHER）可占用的队列比例
+    double sourceQuota = 0.0;              // 单个来源的低级别日志最多占用的队列比例，0表示不限制
+    size_t maxTrackedSources = 1000;       // 分来源统计丢弃数的最大来源数，超出的计入"other"
+};
+
+/*
+ * @struct ShedStats
+ * @brief 某个来源某个级别被丢弃的条数
+ */
+struct ShedStats {
+    std::string source;
+    common::LogLevel level;
+    uint64_t count;
+};
+
+/*
+ * @brief 从原始消息中快速判断日志级别，只检查消息开头
+ *
+ * 依次识别syslog的<PRI>、JSON中的"level"字段、以及大写的级别单词（ERROR、WARN等），
+ * 都不符合时返回OTHER。用于入队前的准入判断，不代替解析器。
+ * @param message 原始消息
+ */
+common::LogLevel SniffLogLevel(std::string_view message);
+
+/*
+ * @class AdmissionController
+ * @brief 入队准入控制：队列接近满时先丢弃低级别日志，为ERROR及以上保留容量
+ *
+ * Limit()在提交线程中调用，只读取原子计数；来源占用按来源哈希分槽计数，不加锁。
+ * 只有丢弃时才加锁记录分来源的统计。
+ */
+class AdmissionController : public common::NonCopyable {
+public:
+    /*
+     * @brief 构造函数
+     * @param config 准入配置
+     * @param capacity 队列容量
+     */
+    AdmissionController(const AdmissionConfig& config, size_t capacity);
+
+    /*
+     * @brief 计算一条日志允许入队的队列占用上限
+     * @param level 日志级别
+     * @param sourceHash 来源哈希
+     * @param depth 当前队列占用
+     * @return 占用上限，调用方在不超过该值时入队；返回0表示按概率或来源配额丢弃
+     */
+    size_t Limit(common::LogLevel level, size_t sourceHash, size_t depth) const;
+
+    /*
+     * @brief 记录一条日志已入队
+     */
+    void OnAdmitted(common::LogLevel level, size_t sourceHash);
+
+    /*
+     * @brief 记录一条日志出队
+     */
+    void OnDequeued(size_t sourceHash);
+
+    /*
+     * @brief 记录一条因级别或来源配额被丢弃的日志
+     */
+    void OnShed(const std::string& source, common::LogLevel level);
+
+    /*
+     * @brief 记录一条因队列已满被拒绝的日志（ERROR及以上的保留容量也已用完）
+     */
+    void OnRejected(common::LogLevel level);
+
+    /*
+     * @brief 清空来源占用计数，队列清空时调用
+     */
+    void ClearDepth();
+
+    /*
+     * @brief 是否按来源计数占用
+     */
+    bool TracksSources() const { return sourceLimit_ > 0; }
+
+    uint64_t GetAdmittedCount(common::LogLevel level) const;
+    uint64_t GetShedCount(common::LogLevel level) const;
+    uint64_t GetRejectedCount(common::LogLevel level) const;
+
+    /*
+     * @brief 各来源各级别的丢弃数，按来源排序
+     */
+    std::vector<ShedStats> GetShedStats() const;
+
+    /*
+     * @brief 输出准入指标
+     */
+    void WritePrometheusMetrics(common::PrometheusWriter& writer) const;
+
+private:
+    static constexpr size_t kSourceSlots = 4096;
+
+    AdmissionConfig config_;
+    size_t capacity_;
+    std::array<size_t, kLogLevelCount> levelLimit_{};   // 各级别的占用上限
+    std::array<size_t, kLogLevelCount> shedStart_{};    // 各级别开始概率丢弃的占用
+    size_t sourceLimit_{0};                             // 单个来源的占用上限，0表示不限制
+
+    std::unique_ptr<std::atomic<uint32_t>[]> sourceDepth_;  // 按来源哈希分槽的占用
+    std::array<std::atomic<uint64_t>, kLogLevelCount> admitted_{};
+    std::array<std::atomic<uint64_t>, kLogLevelCount> shed_{};
+    std::array<std::atomic<uint64_t>, kLogLevelCount> rejected_{};
+
+    mutable std::mutex shedMutex_;
+    std::unordered_map<std::string, std::array<uint64_t, kLogLevelCount>> shedBySource_;
+};
+
+} // namespace processor
+} // namespace xumj
+
+#endif // XUMJ_PROCESSOR_ADMISSION_CONTROLLER_H
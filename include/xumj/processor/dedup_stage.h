@@ -0,0 +1,137 @@
+#ifndef XUMJ_PROCESSOR_DEDUP_STAGE_H
+#define XUMJ_PROCESSOR_DEDUP_STAGE_H
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "xumj/analyzer/log_analyzer.h"
+#include "xumj/common/non_copyable.h"
+#include "xumj/common/prometheus_writer.h"
+
+namespace xumj {
+namespace processor {
+
+/*
+ * @struct DedupConfig
+ * @brief 重复日志合并配置
+ */
+struct DedupConfig {
+    bool enabled = false;                          // 是否启用
+    std::chrono::milliseconds window{1000};        // 合并窗口，从某条日志第一次出现开始计时
+    size_t maxMemoryBytes = 16 * 1024 * 1024;      // 合并表占用内存的上限（估算），超出后新日志不再合并
+    bool normalizeNumbers = true;                  // 计算消息哈希时是否把连续数字视为相同
+};
+
+/*
+ * @struct DedupSummary
+ * @brief 一个窗口内被合并的重复日志
+ */
+struct DedupSummary {
+    analyzer::LogRecord record;                            // 第一条被合并的记录，已带repeat_count、first_seen、last_seen字段
+    std::vector<std::function<void(bool)>> callbacks;      // 被合并日志的完成回调，存储汇总记录后调用
+};
+
+/*
+ * @brief 计算消息的哈希，normalizeNumbers为true时连续数字按同一个占位符计算，连续空白视为一个空格
+ * @param message 消息正文
+ * @param normalizeNumbers 是否忽略数字的差别
+ */
+uint64_t NormalizedMessageHash(std::string_view message, bool normalizeNumbers);
+
+/*
+ * @class DedupStage
+ * @brief 存储前合并短时间内重复的日志
+ *
+ * 按(来源, 级别, 消息哈希)分组：一组日志第一次出现时照常存储并开始一个窗口，
+ * 窗口内的重复日志不再存储，只累计条数；窗口结束后存储一条汇总记录，
+ * 其repeat_count为被合并的条数，first_seen和last_seen为第一条和最后一条的时间戳。
+ * 因此所有存储记录的repeat_count（没有该字段按1计）之和等于原始日志条数。
+ * 合并表分段加锁，多个工作线程可以同时使用。
+ */
+class DedupStage : public common::NonCopyable {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    /*
+     * @brief 构造函数
+     * @param config 合并配置
+     */
+    explicit DedupStage(const DedupConfig& config);
+
+    /*
+     * @brief 提交一条已解析的日志
+     * @param record 解析得到的记录
+     * @param onComplete 日志的完成回调；被合并时移入合并表，在汇总记录存储后调用
+     * @param now 当前时间
+     * @return 被合并返回true，调用方不再存储该记录；否则返回false，照常存储
+     */
+    bool Offer(const analyzer::LogRecord& record, std::function<void(bool)>& onComplete, Clock::time_point now);
+
+    /*
+     * @brief 取出窗口已结束的分组，有重复日志的分组生成汇总记录
+     * @param now 当前时间
+     * @param summaries 输出汇总记录（追加）
+     * @return 本次生成的汇总记录数
+     */
+    size_t TakeExpired(Clock::time_point now, std::vector<DedupSummary>& summaries);
+
+    /*
+     * @brief 取出全部分组，停止时调用
+     */
+    size_t TakeAll(std::vector<DedupSummary>& summaries);
+
+    // 统计
+    uint64_t GetAbsorbedCount() const { return absorbed_.load(std::memory_order_relaxed); }
+    uint64_t GetSummaryCount() const { return summaries_.load(std::memory_order_relaxed); }
+    uint64_t GetUntrackedCount() const { return untracked_.load(std::memory_order_relaxed); }
+    size_t GetTrackedCount() const { return tracked_.load(std::memory_order_relaxed); }
+    size_t GetMemoryBytes() const { return memoryBytes_.load(std::memory_order_relaxed); }
+
+    /*
+     * @brief 输出合并指标
+     */
+    void WritePrometheusMetrics(common::PrometheusWriter& writer) const;
+
+private:
+    static constexpr size_t kStripes = 16;
+
+    struct Entry {
+        std::string source;
+        std::string level;
+        Clock::time_point expires;
+        uint64_t repeats{0};
+        std::string lastSeen;
+        size_t bytes{0};                  // 计入内存上限的估算大小
+        DedupSummary summary;             // 第一条被合并的记录和所有回调
+    };
+
+    struct Stripe {
+        std::mutex mutex;
+        std::unordered_map<uint64_t, Entry> entries;
+        std::deque<std::pair<Clock::time_point, uint64_t>> expiry;  // 按开始时间排列，窗口固定所以也按结束时间排列
+    };
+
+    // 从stripe中移除key，有重复日志时生成汇总记录
+    void Retire(Stripe& stripe, uint64_t key, std::vector<DedupSummary>& summaries, size_t& produced);
+    bool Reserve(size_t bytes);
+
+    DedupConfig config_;
+    std::array<Stripe, kStripes> stripes_;
+    std::atomic<size_t> memoryBytes_{0};
+    std::atomic<size_t> tracked_{0};
+    std::atomic<uint64_t> absorbed_{0};
+    std::atomic<uint64_t> summaries_{0};
+    std::atomic<uint64_t> untracked_{0};
+};
+
+} // namespace processor
+} // namespace xumj
+
+#endif // XUMJ_PROCESSOR_DEDUP_STAGE_H
@@ -0,0 +1,182 @@
+#ifndef XUMJ_PROCESSOR_GROK_PARSER_H
+#define XUMJ_PROCESSOR_GROK_PARSER_H
+
+#include <bitset>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "xumj/processor/log_processor.h"
+
+namespace xumj {
+namespace processor {
+
+/*
+ * @class GrokMatcher
+ * @brief grok风格的模式匹配器
+ *
+ * 模式由字面量和%{TYPE:name}字段组成，例如：
+ *   %{TIMESTAMP:timestamp} \[%{LEVEL:level}\] %{WORD:module}: %{GREEDY:message}
+ * 支持的类型：
+ *   WORD       [A-Za-z0-9_]+
+ *   NOTSPACE   非空白字符
+ *   INT        [+-]?[0-9]+
+ *   NUMBER     [+-]?[0-9]+(.[0-9]*)?
+ *   LEVEL      [A-Za-z]+
+ *   IP         [0-9A-Fa-f:.]+
+ *   TIMESTAMP  YYYY-MM-DD[T ]HH:MM:SS，可带.或,开头的小数秒
+ *   DATA       任意字符，到后面字面量第一次出现为止（后面必须是字面量或模式结尾）
+ *   GREEDY     行内剩余的全部字符，只能是最后一个字段
+ * %{TYPE}不捕获；\x表示字面量x。
+ *
+ * 除DATA外的字段都按占有式匹配（尽可能多地匹配且不回溯），因此每个模式本身是确定的；
+ * 字段紧跟的字面量字符不计入该字段，例如%{NOTSPACE:path}"在第一个引号处结束。
+ * 所有模式合并编译为一个DFA，按字节一遍扫描同时确定匹配的模式和字段边界；
+ * 多个模式同时匹配时取添加顺序靠前的模式。
+ */
+class GrokMatcher {
+public:
+    /*
+     * @brief 单次匹配的结果，视图指向输入
+     */
+    struct Result {
+        int pattern{-1};                          // 匹配的模式下标，-1表示未匹配
+        std::vector<std::string_view> values;     // 与该模式的字段名一一对应
+        std::vector<size_t> registers;            // 字段边界，内部使用
+    };
+
+    GrokMatcher() = default;
+
+    /*
+     * @brief 添加模式，添加后需要重新调用Compile
+     * @param pattern 模式
+     * @return 模式语法正确返回true，错误信息输出到std::cerr
+     */
+    bool AddPattern(const std::string& pattern);
+
+    /*
+     * @brief 将所有模式编译为DFA
+     * @return 状态数超过上限时返回false
+     */
+    bool Compile();
+
+    /*
+     * @brief 匹配整行
+     * @param line 输入（不含换行符）
+     * @param result 输出结果，视图在line存活期间有效
+     * @return 有模式匹配返回true
+     */
+    bool Match(std::string_view line, Result& result) const;
+
+    // 获取模式的字段名
+    const std::vector<std::string>& GetFieldNames(size_t pattern) const;
+
+    // 获取模式数
+    size_t GetPatternCount() const { return patterns_.size(); }
+
+    // 获取DFA状态数
+    size_t GetStateCount() const { return acceptPattern_.size(); }
+
+    // 是否已编译且没有新增模式
+    bool IsCompiled() const { return compiled_; }
+
+private:
+    // 寄存器操作：寄存器 = 当前字节位置 + offset
+    struct RegisterOp {
+        uint32_t reg;
+        int32_t offset;
+        bool operator==(const RegisterOp& other) const {
+            return reg == other.reg && offset == other.offset;
+        }
+    };
+
+    // 模式编译后的原子序列，字段边界记录在原子之间
+    struct Atom {
+        enum class Kind { CLASS, DATA, END };
+        Kind kind{Kind::CLASS};
+        std::bitset<256> set;               // CLASS：可匹配的字节
+        uint32_t min{1};                    // CLASS：最少次数
+        uint32_t max{1};                    // CLASS：最多次数，UINT32_MAX表示不限
+        std::vector<RegisterOp> enter;      // 到达本原子时执行，寄存器为模式内编号
+        std::string delimiter;              // DATA：紧随其后的字面量
+        uint32_t endRegister{0};            // DATA：字段结束寄存器
+    };
+
+    struct Pattern {
+        std::string text;
+        std::vector<std::string> fieldNames;
+        std::vector<Atom> atoms;            // 最后一个为END
+    };
+
+    // 单个模式内的状态：原子下标和已匹配次数（DATA为分隔符已匹配的长度）
+    struct LocalState {
+        uint32_t atom;
+        uint32_t count;
+    };
+
+    static bool ParsePattern(const std::string& text, Pattern& pattern);
+    static bool Step(const Pattern& pattern, LocalState& state, uint8_t byte, std::vector<RegisterOp>& ops);
+    static bool Finish(const Pattern& pattern, LocalState state, std::vector<RegisterOp>& ops);
+
+    struct Transition {
+        int32_t next;       // 下一状态，-1表示所有模式都已失配
+        uint32_t ops;       // 寄存器操作列表下标，0表示无操作
+    };
+
+    std::vector<Pattern> patterns_;
+    std::vector<uint32_t> registerBase_;          // 每个模式的第一个寄存器
+    uint32_t registerCount_{0};
+    bool compiled_{false};
+
+    uint8_t byteClass_[256]{};                    // 字节 -> 等价类
+    size_t classCount_{0};
+    std::vector<Transition> transitions_;         // 状态 * classCount_ + 类
+    std::vector<std::vector<RegisterOp>> opLists_;
+    std::vector<RegisterOp> initialOps_;          // 开始扫描前执行
+    std::vector<int32_t> acceptPattern_;          // 输入结束时该状态接受的模式，-1表示不接受
+    std::vector<std::vector<RegisterOp>> finalOps_;   // 输入结束时执行（只含接受模式的操作）
+};
+
+/*
+ * @class GrokLogParser
+ * @brief 基于GrokMatcher的纯文本日志解析器
+ *
+ * 字段timestamp/ts/time、level、message/msg、source分别填入记录的对应字段，
+ * 其他字段放入LogRecord::fields。可以为特定来源配置专用模式，
+ * 这些模式优先于通用模式。所有模式都不匹配时返回false，交给后面的解析器。
+ * 模式需要在解析器注册到处理器之前添加。
+ */
+class GrokLogParser : public LogParser {
+public:
+    GrokLogParser() = default;
+
+    /*
+     * @brief 添加模式
+     * @param pattern 模式
+     * @param source 只用于该来源的日志，为空时用于所有来源
+     * @return 模式语法正确且编译成功返回true；编译失败时不保留该模式，已添加的模式不受影响
+     */
+    bool AddPattern(const std::string& pattern, const std::string& source = "");
+
+    virtual std::string GetType() const override { return "GrokParser"; }
+
+    virtual bool Parse(const LogData& logData, analyzer::LogRecord& record) override;
+
+    // 处理所有非JSON格式的文本
+    virtual bool SupportsFormat(LogFormat format) const override { return format != LogFormat::JSON; }
+
+private:
+    bool Rebuild();
+
+    std::vector<std::string> commonPatterns_;
+    std::unordered_map<std::string, std::vector<std::string>> sourcePatterns_;
+    GrokMatcher commonMatcher_;
+    std::unordered_map<std::string, GrokMatcher> sourceMatchers_;   // 来源专用模式 + 通用模式
+};
+
+} // namespace processor
+} // namespace xumj
+
+#endif // XUMJ_PROCESSOR_GROK_PARSER_H
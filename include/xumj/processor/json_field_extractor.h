@@ -0,0 +1,97 @@
+#ifndef XUMJ_PROCESSOR_JSON_FIELD_EXTRACTOR_H
+#define XUMJ_PROCESSOR_JSON_FIELD_EXTRACTOR_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace xumj {
+namespace processor {
+
+/*
+ * @brief JSON解析后端
+ */
+enum class JsonBackend {
+    NLOHMANN,    // nlohmann::json，构建完整DOM
+    ON_DEMAND    // JsonFieldExtractor，只提取配置的顶层字符串字段
+};
+
+/*
+ * @brief 字符串扫描实现
+ */
+enum class ScanKernel {
+    AUTO,     // 默认实现：x86上为SSE2，其他平台为SCALAR
+    SCALAR,   // 逐字节扫描
+    SSE2,     // 每次16字节
+    AVX2      // 每次32字节
+};
+
+/*
+ * @class JsonFieldExtractor
+ * @brief 按需JSON字段提取器
+ *
+ * 单遍扫描顶层JSON对象：配置的字段如果是字符串，以string_view的形式直接指向消息缓冲区；
+ * 含转义字符的值解码到结果自带的缓冲区中。其余的值只做语法校验后跳过，不构建DOM。
+ * 整个文档仍按JSON语法严格校验，所有字符串（包括跳过的值和字段名）都校验UTF-8编码，
+ * 语法错误或编码不合法时返回false，与完整解析的判定一致。
+ *
+ * 字符串扫描（查找引号、反斜杠和控制字符）是主要开销，支持SSE2/AVX2实现；
+ * 指定的实现CPU不支持时退回SSE2。
+ */
+class JsonFieldExtractor {
+public:
+    /*
+     * @brief 单次提取的结果，视图指向输入缓冲区或本结果的解码缓冲区
+     */
+    struct Result {
+        std::vector<std::string_view> values;   // 与字段列表一一对应
+        std::vector<bool> present;              // 字段是否存在且为字符串
+        std::string decoded;                    // 含转义的字段解码后的内容
+
+        bool Has(size_t index) const { return index < present.size() && present[index]; }
+    };
+
+    /*
+     * @brief 构造函数
+     * @param fields 需要提取的顶层字段名
+     */
+    explicit JsonFieldExtractor(std::vector<std::string> fields);
+
+    /*
+     * @brief 提取字段
+     * @param json 输入（整个JSON文档）
+     * @param result 输出结果，视图在json和result存活期间有效
+     * @return 输入是合法的JSON对象返回true
+     */
+    bool Extract(std::string_view json, Result& result) const;
+
+    /*
+     * @brief 获取字段列表
+     */
+    const std::vector<std::string>& GetFields() const { return fields_; }
+
+    /*
+     * @brief 指定扫描实现，主要用于性能对比
+     */
+    static void SetScanKernel(ScanKernel kernel);
+
+    /*
+     * @brief 获取当前使用的扫描实现
+     */
+    static ScanKernel GetScanKernel();
+
+    /*
+     * @brief 扫描实现的名称
+     */
+    static const char* ScanKernelName(ScanKernel kernel);
+
+private:
+    std::vector<std::string> fields_;
+};
+
+} // namespace processor
+} // namespace xumj
+
+#endif // XUMJ_PROCESSOR_JSON_FIELD_EXTRACTOR_H
@@ -1,6 +1,7 @@
 #ifndef XUMJ_PROCESSOR_LOG_PROCESSOR_H
 #define XUMJ_PROCESSOR_LOG_PROCESSOR_H
 
+#include <cstdint>
 #include <string>
 #include <vector>
 #include <memory>
@@ -15,6 +16,9 @@
 #include <unordered_map>
 #include <sstream>
 #include <iostream>
+#include <optional>
+#include <algorithm>
+#include <string_view>
 
 #include "xumj/analyzer/log_analyzer.h"
 #include "xumj/storage/redis_storage.h"
@@ -22,6 +26,15 @@
 #include "xumj/network/tcp_server.h"
 #include "xumj/common/non_copyable.h"
 #include "xumj/common/thread_pool.h"
+#include "xumj/common/concurrency_controller.h"
+#include "xumj/common/record_batch.h"
+#include "xumj/common/latency_histogram.h"
+#include "xumj/common/prometheus_writer.h"
+#include "xumj/processor/ack_tracker.h"
+#include "xumj/processor/json_field_extractor.h"
+#include "xumj/processor/raw_archiver.h"
+#include "xumj/processor/admission_controller.h"
+#include "xumj/processor/dedup_stage.h"
 
 // 引入Muduo TCP连接相关类型
 #include <muduo/net/TcpConnection.h>
@@ -32,6 +45,31 @@ namespace processor {
 // 使用Muduo网络库的TCP连接类型
 using TcpConnectionPtr = muduo::net::TcpConnectionPtr;
 
+/*
+ * @brief 日志消息体的格式
+ */
+enum class PayloadFormat {
+    UNPARSED,       // 尚未解析
+    JSON,           // JSON对象，字段已提取
+    INVALID_JSON,   // 形似JSON对象但解析失败
+    TEXT            // 普通文本
+};
+
+/*
+ * @struct ParsedFields
+ * @brief 消息体解析一次后得到的结构化字段，解析器直接使用而不再重复解析
+ */
+struct ParsedFields {
+    PayloadFormat format{PayloadFormat::UNPARSED};  // 消息体格式
+    std::optional<std::string> timestamp;           // 时间戳文本
+    std::optional<std::string> level;               // 日志级别
+    std::optional<std::string> message;             // 消息正文
+    std::optional<std::string> source;              // 来源
+    std::optional<std::string> type;                // 日志类型
+    size_t rawOffset{0};                            // 原始消息体在LogData::message中的起始位置
+    size_t rawLength{0};                            // 原始消息体长度（去掉首尾空白）
+};
+
 /*
  * @struct LogData
  * @brief 日志数据结构，包含原始日志信息和元数据
@@ -41,43 +79,137 @@ struct LogData {
     std::string message;                                // 日志消息内容
     std::string source;                                 // 日志来源
     std::chrono::system_clock::time_point timestamp;    // 时间戳
-    std::unordered_map<std::string, std::string> metadata;  // 元数据
+    ParsedFields fields;                                // 解析得到的字段，由处理器在处理前填充一次
+    std::unordered_map<std::string, std::string> metadata;  // 用户自定义元数据，处理流程不读取
+    std::function<void(bool stored)> onComplete;        // 处理完成回调（参数表示是否已成功存储），用于确认投递
+    bool archiveRaw{false};                             // 处理时是否写入原始消息归档
+    
+    /*
+     * @brief 获取原始消息体（不复制）
+     */
+    std::string_view RawPayload() const {
+        return std::string_view(message).substr(std::min(fields.rawOffset, message.size()), fields.rawLength);
+    }
+};
+
+/*
+ * @brief 解析消息体并填充结构化字段，每条消息只应调用一次
+ *
+ * 以'{'开头、'}'结尾的消息按JSON解析，JSON中的字段覆盖fields中已有的值；
+ * 其他消息标记为TEXT，保留fields中已有的值（例如采集器批次中带来的level）。
+ * @param message 消息内容
+ * @param fields 输出字段
+ * @param backend JSON解析后端，两种后端对合法性的判定和提取结果一致
+ * @return 解析得到的格式
+ */
+PayloadFormat ParseLogFields(const std::string& message, ParsedFields& fields,
+                             JsonBackend backend = JsonBackend::ON_DEMAND);
+
+/*
+ * @brief 日志格式，用于把消息直接分派给支持该格式的解析器
+ */
+enum class LogFormat {
+    JSON,        // JSON对象（含解析失败的JSON）
+    SYSLOG,      // 以"<PRI>"开头的syslog消息
+    KEY_VALUE,   // 以key=value开头的消息
+    PLAIN        // 其他文本
 };
 
+/*
+ * @brief 嗅探消息格式，只检查消息开头，不做完整解析
+ * @param message 消息内容
+ * @param format ParseLogFields得到的格式
+ * @return 消息格式
+ */
+LogFormat SniffLogFormat(const std::string& message, PayloadFormat format);
+
 // 处理器指标结构体
 struct ProcessorMetrics {
     std::atomic<uint64_t> totalRecords{0};      // 总处理记录数
     std::atomic<uint64_t> errorRecords{0};      // 错误记录数
     std::atomic<uint64_t> totalProcessTime{0};  // 总处理时间(微秒)
+    std::atomic<uint64_t> jsonParses{0};        // JSON解析次数（含批次信封）
+    std::atomic<uint64_t> totalCpuTime{0};      // 处理线程CPU时间(纳秒)
+    std::atomic<uint64_t> droppedRecords{0};    // 队列满时丢弃的无确认消息数（单条消息和旧格式JSON数组）
+    std::atomic<uint64_t> parserAttempts{0};    // 调用解析器的次数
+    
+    // 各阶段的耗时分布(微秒)；单条消息的解析耗时见parserMetrics["total"]
+    common::LatencyHistogram redisLatency;      // 单条记录写入Redis
+    common::LatencyHistogram mysqlLatency;      // 整批写入MySQL（含重试）
+    common::LatencyHistogram batchLatency;      // 工作线程处理一批消息
     
     // 每个解析器的指标
     struct ParserMetrics {
         std::atomic<uint64_t> successCount{0};  // 成功次数
         std::atomic<uint64_t> failureCount{0};  // 失败次数
         std::atomic<uint64_t> totalTime{0};     // 总处理时间(微秒)
+        common::LatencyHistogram latency;       // 处理时间分布(微秒)
+        
+        void Reset() {
+            successCount = 0;
+            failureCount = 0;
+            totalTime = 0;
+            latency.Reset();
+        }
     };
+    // 条目只增不删（解析器快照持有条目指针），添加时由metricsMutex_保护
     std::unordered_map<std::string, ParserMetrics> parserMetrics;
     
     void Reset() {
         totalRecords = 0;
         errorRecords = 0;
         totalProcessTime = 0;
-        parserMetrics.clear();
+        jsonParses = 0;
+        totalCpuTime = 0;
+        droppedRecords = 0;
+        parserAttempts = 0;
+        redisLatency.Reset();
+        mysqlLatency.Reset();
+        batchLatency.Reset();
+        for (auto& [name, parser] : parserMetrics) {
+            parser.Reset();
+        }
     }
 };
 
+/*
+ * @struct ShardStats
+ * @brief 单个队列分片的统计
+ */
+struct ShardStats {
+    size_t depth{0};               // 当前待处理条数
+    size_t maxDepth{0};            // 历史最大深度
+    uint64_t processed{0};         // 已处理条数
+    uint64_t stolenBatches{0};     // 被非所属工作线程取走处理的批次数
+};
+
 /*
  * @struct LogProcessorConfig
  * @brief 日志处理器配置
  */
 struct LogProcessorConfig {
     bool debug = false;                    // 是否启用调试模式
-    int workerThreads = 4;                 // 工作线程数
+    int workerThreads = 4;                 // 工作线程数（启用自适应时为初始值）
+    bool adaptiveWorkers = false;          // 是否根据队列积压、处理时间和CPU利用率自动调整工作线程数
+    common::ConcurrencyConfig workerConcurrency;  // 自适应调整的范围和参数
     int queueSize = 1000;                  // 队列大小
+    AdmissionConfig admission;             // 按级别和来源的准入控制，队列接近满时先丢弃低级别日志
+    DedupConfig dedup;                     // 存储前合并短时间内重复的日志
+    size_t dequeueBatchSize = 64;          // 工作线程每次唤醒最多取出的日志条数
+    size_t queueShards = 0;                // 队列分片数（按source哈希），0表示每个工作线程4个分片
+    bool enableWorkStealing = false;       // 空闲工作线程是否处理其他线程积压的分片
+    size_t stealThreshold = 256;           // 分片积压达到该条数时允许其他线程处理
     int tcpPort = 8001;                    // TCP监听端口
+    size_t ioThreads = 4;                  // TCP服务器IO线程数
+    size_t maxLineLength = network::TcpServer::kDefaultMaxLineLength;  // 单行（单个批次帧）最大字节数，超过时断开连接
+    bool reusePortAcceptors = false;       // 是否每个IO线程一个SO_REUSEPORT监听套接字
+    std::vector<int> cpuAffinity;          // IO线程绑定的CPU列表，为空表示不绑定
     bool enableRedisStorage = false;       // 是否启用Redis存储
     bool enableMySQLStorage = false;       // 是否启用MySQL存储
     bool enableMetrics = false;            // 是否启用指标收集
+    bool enableRawArchive = false;         // 是否把TCP单条消息的原始内容异步归档到MySQL
+    size_t rawArchiveQueueSize = 10000;    // 归档队列容量，满时丢弃
+    JsonBackend jsonBackend = JsonBackend::ON_DEMAND;  // JSON消息体的解析后端
     std::string metricsOutputPath;         // 指标输出路径
     int metricsFlushInterval = 30;         // 指标刷新间隔（秒）
     storage::MySQLConfig mysqlConfig;      // MySQL连接配置
@@ -102,6 +234,9 @@ public:
     // 解析日志数据
     virtual bool Parse(const LogData& logData, analyzer::LogRecord& record) = 0;
     
+    // 是否处理该格式的消息，处理器只把消息分派给支持其格式的解析器
+    virtual bool SupportsFormat(LogFormat format) const { (void)format; return true; }
+    
     // 设置配置
     void SetConfig(const LogProcessorConfig& config) { config_ = config; }
     
@@ -130,6 +265,13 @@ public:
      * @return 是否成功解析
      */
     virtual bool Parse(const LogData& logData, analyzer::LogRecord& record) override;
+    
+    /*
+     * @brief 支持JSON和普通文本；没有其他解析器支持的格式同样会交给本解析器按文本处理
+     */
+    virtual bool SupportsFormat(LogFormat format) const override {
+        return format == LogFormat::JSON || format == LogFormat::PLAIN;
+    }
 };
 
 /*
@@ -138,6 +280,11 @@ public:
  */
 class LogProcessor : public common::NonCopyable {
 public:
+    /*
+     * @brief 自定义存储回调，返回是否存储成功
+     */
+    using RecordSink = std::function<bool(const analyzer::LogRecord&)>;
+    
     /*
      * @brief 构造函数
      * @param config 日志处理器配置
@@ -173,12 +320,59 @@ public:
      */
     bool SubmitLogData(const LogData& data);
     
+    /*
+     * @brief 提交日志数据（移动语义，不复制消息内容）
+     * @param data 日志数据
+     * @return 是否成功提交
+     */
+    bool SubmitLogData(LogData&& data);
+    
+    /*
+     * @brief 批量提交日志数据，一次加锁入队，按需唤醒工作线程
+     *
+     * 按顺序入队直到队列满：入队的条目从batch中移除，因队列已满未入队的条目
+     * 按原顺序留在batch中，由调用方决定重试或丢弃。
+     * 启用准入控制时，被级别或来源配额丢弃的条目同样从batch中移除，并以false回调onComplete（条目未入库，不能向采集器确认）。
+     * @param batch 日志数据列表
+     * @return 成功提交的条数
+     */
+    size_t SubmitLogDataBatch(std::vector<LogData>& batch);
+    
     /*
      * @brief 获取待处理数据数量
      * @return 待处理数据数量
      */
     size_t GetPendingCount() const;
     
+    /*
+     * @brief 获取当前运行的工作线程数
+     */
+    size_t GetWorkerCount() const { return activeWorkers_.load(std::memory_order_relaxed); }
+    
+    /*
+     * @brief 运行时调整工作线程数，不丢弃队列中的日志，同一来源仍按顺序处理
+     * @param count 目标线程数，限制在[1, 最大工作线程数]内
+     */
+    void SetWorkerCount(size_t count);
+    
+    /*
+     * @brief 获取各队列分片的统计
+     * @return 分片统计，下标为分片编号
+     */
+    std::vector<ShardStats> GetShardStats() const;
+    
+    /*
+     * @brief 获取准入控制器
+     * @return 未启用准入控制时返回nullptr
+     */
+    const AdmissionController* GetAdmissionController() const { return admission_.get(); }
+    
+    /*
+     * @brief 获取重复日志合并阶段
+     * @return 未启用合并时返回nullptr
+     */
+    const DedupStage* GetDedupStage() const { return dedup_.get(); }
+    
     /*
      * @brief 设置日志分析器
      * @param analyzer 日志分析器
@@ -210,6 +404,18 @@ public:
      */
     bool ProcessJsonString(const std::string& jsonStr);
     
+    /*
+     * @brief 设置自定义存储，在Redis/MySQL存储之外调用（性能测试中用作内存存储），应在Start()之前调用
+     * @param sink 存储回调
+     */
+    void SetRecordSink(RecordSink sink) { recordSink_ = std::move(sink); }
+    
+    /*
+     * @brief 获取确认投递跟踪器
+     * @return 跟踪器，TCP服务器未初始化时返回nullptr
+     */
+    const AckTracker* GetAckTracker() const { return ackTracker_.get(); }
+    
     // 获取当前指标
     const ProcessorMetrics& GetMetrics() const;
     
@@ -218,25 +424,51 @@ public:
     
     // 导出指标到文件
     void ExportMetrics();
+    
+    /*
+     * @brief 以Prometheus文本格式写出当前指标（含分析器的指标）
+     *
+     * 只读取原子计数和队列深度，不持有工作线程使用的锁，采集不会阻塞处理。
+     * @param writer 输出
+     */
+    void WritePrometheusMetrics(common::PrometheusWriter& writer) const;
 
 private:
     LogProcessorConfig config_;                         // 配置
     std::atomic<bool> running_{false};                  // 运行状态
     
-    // 日志解析器
-    std::vector<std::shared_ptr<LogParser>> parsers_;   // 日志解析器列表
-    mutable std::mutex parsersMutex_;                   // 解析器互斥锁
-    
-    // 数据队列
-    std::queue<LogData> logQueue_;                      // 日志数据队列
-    mutable std::mutex queueMutex_;                     // 队列互斥锁
-    std::condition_variable queueCondVar_;              // 队列条件变量
-    std::atomic<size_t> dataCount_{0};                  // 数据计数器
+    // 日志解析器：工作线程读取不可变快照，添加解析器时复制后整体替换
+    struct ParserSnapshot;
+    struct ParserAffinity;
+    std::shared_ptr<const ParserSnapshot> parserSnapshot_;  // 当前解析器快照，通过原子操作读写
+    std::mutex parsersMutex_;                           // 串行化添加解析器，读取不加锁
+    
+    // 数据队列：按source哈希分片，同一来源的日志始终进入同一分片，按FIFO顺序处理
+    struct QueueShard;
+    struct WorkerSignal;
+    std::vector<std::unique_ptr<QueueShard>> shards_;   // 队列分片，分片i属于工作线程i % activeWorkers_
+    std::vector<std::unique_ptr<WorkerSignal>> workerSignals_;  // 每个工作线程的唤醒信号，按最大线程数创建
+    std::atomic<size_t> activeWorkers_{0};              // 当前运行的工作线程数
+    std::mutex workersMutex_;                           // 串行化调整线程数
+    std::atomic<size_t> dataCount_{0};                  // 所有分片的待处理条数，读取时不加锁
     
     // 网络
     std::unique_ptr<network::TcpServer> tcpServer_;     // TCP服务器
     std::unordered_map<uint64_t, std::string> connections_;  // 连接列表
     mutable std::mutex connectionsMutex_;               // 连接互斥锁
+    std::unique_ptr<AckTracker> ackTracker_;            // 批次确认跟踪
+    
+    // 自定义存储
+    RecordSink recordSink_;
+    
+    // 原始消息归档
+    std::unique_ptr<RawArchiver> rawArchiver_;
+    
+    // 入队准入控制
+    std::unique_ptr<AdmissionController> admission_;
+    
+    // 重复日志合并
+    std::unique_ptr<DedupStage> dedup_;
     
     // 存储
     std::shared_ptr<storage::RedisStorage> redisStorage_;  // Redis存储
@@ -247,9 +479,14 @@ private:
     
     // 线程池
     std::unique_ptr<common::ThreadPool> threadPool_;    // 工作线程池
+    std::unique_ptr<common::ConcurrencyController> workerController_;  // 自适应线程数控制
+    std::atomic<uint64_t> processedCount_{0};           // 工作线程累计处理条数
+    std::atomic<uint64_t> busyMicros_{0};               // 工作线程累计处理时间（微秒）
     
     // 指标相关
     ProcessorMetrics metrics_;
+    mutable std::mutex metricsMutex_;                   // 保护parserMetrics表的插入和文件导出
+    ProcessorMetrics::ParserMetrics* totalMetrics_;     // parserMetrics["total"]
     std::chrono::steady_clock::time_point lastMetricsFlush_;
     
     /*
@@ -272,11 +509,19 @@ private:
     void HandleTcpConnection(uint64_t connectionId, const std::string& clientAddr, bool connected);
     
     /*
-     * @brief 处理TCP消息
-     * @param conn TCP连接
-     * @param message 消息内容
+     * @brief 处理TCP单条消息：在IO线程中只构造LogData并入队，解析和存储由工作线程完成
+     * @param connectionId 连接ID
+     * @param message 消息内容（移入LogData，不复制）
+     */
+    void HandleTcpMessage(uint64_t connectionId, std::string&& message);
+    
+    /*
+     * @brief 处理采集器发来的批次消息（带序号的批次或旧格式JSON数组）
+     * @param connectionId 连接ID
+     * @param message 一行消息
+     * @return 是批次消息并已处理返回true，否则返回false
      */
-    void HandleTcpMessage(const TcpConnectionPtr& conn, const std::string& message);
+    bool HandleBatchMessage(uint64_t connectionId, const std::string& message);
     
     /*
      * @brief 处理日志数据
@@ -284,29 +529,122 @@ private:
      */
     void ProcessLogData(LogData logData);
     
+    /*
+     * @brief 工作线程主循环
+     * @param workerIndex 工作线程编号
+     */
+    void WorkerLoop(size_t workerIndex);
+    
+    /*
+     * @brief 认领一个分片并处理其中最多dequeueBatchSize条日志
+     * @param shardIndex 分片编号
+     * @param workerIndex 当前工作线程编号
+     * @param batch 复用的批次缓冲区
+     * @param affinity 当前工作线程的来源-解析器关联
+     * @return 处理了日志返回true；分片为空或正被其他线程处理返回false
+     */
+    bool DrainShard(size_t shardIndex, size_t workerIndex, std::vector<LogData>& batch,
+                    ParserAffinity& affinity);
+    
+    /*
+     * @brief 计算日志所属的分片
+     */
+    size_t ShardOf(const LogData& data) const;
+    
+    /*
+     * @brief 计算分片当前所属的工作线程
+     */
+    size_t OwnerOf(size_t shardIndex) const;
+    
+    /*
+     * @brief 在线程池中启动编号为workerIndex的工作线程主循环（已在运行时不重复启动）
+     */
+    void LaunchWorker(size_t workerIndex);
+    
+    /*
+     * @brief 唤醒工作线程
+     */
+    void WakeWorker(size_t workerIndex);
+    
+    /*
+     * @brief 预留队列容量，返回实际预留的条数
+     */
+    size_t ReserveQueueSlots(size_t wanted, size_t limit = SIZE_MAX);
+    
+    /*
+     * @brief 入队结果
+     */
+    enum class EnqueueResult { QUEUED, SHED, FULL };
+    
+    /*
+     * @brief 经准入控制后把一条日志放入所属分片，只有QUEUED时data被移走
+     * @param data 日志数据
+     * @param wake 不为空时只标记需要唤醒的工作线程，由调用方统一唤醒
+     * @return 入队结果：SHED表示被级别或来源配额丢弃，FULL表示队列已满
+     */
+    EnqueueResult EnqueueOne(LogData& data, std::vector<bool>* wake);
+    
+    /*
+     * @brief 批量处理日志数据：逐条解析，解析结果写入列式批次后整批存入MySQL并提交给分析器，
+     *        最后按原顺序回调各条日志的onComplete
+     * @param batch 日志数据列表
+     * @param affinity 调用线程的来源-解析器关联
+     * @param flushDedup 为true时取出全部重复日志分组（停止时），否则只取出窗口已结束的分组
+     */
+    void ProcessLogBatch(std::vector<LogData>& batch, ParserAffinity& affinity, bool flushDedup = false);
+    
+    /*
+     * @brief 解析一条日志并逐条存储（Redis和记录接收器），解析成功且records不为空时把记录追加到records；
+     *        被合并的重复日志不存储，其onComplete移入合并阶段
+     * @param logData 日志数据
+     * @param parsers 解析器快照
+     * @param affinity 调用线程的来源-解析器关联
+     * @param record 解析用的记录，由调用方在整批内复用
+     * @param records 待整批存储和分析的记录
+     * @param stored 输出：逐条存储是否成功
+     * @return 是否解析成功
+     */
+    bool ProcessOne(LogData& logData, const ParserSnapshot& parsers, ParserAffinity& affinity,
+                    analyzer::LogRecord& record, common::RecordBatch* records, bool& stored);
+    
+    /*
+     * @brief 逐条存储一条记录（Redis和记录接收器），records不为空时把记录追加到records
+     * @return 逐条存储是否成功
+     */
+    bool StoreRecord(const analyzer::LogRecord& record, common::RecordBatch* records);
+    
     /*
      * @brief 存储日志记录到Redis
      * @param record 日志记录
+     * @return 是否存储成功
      */
-    void StoreRedisLog(const analyzer::LogRecord& record);
+    bool StoreRedisLog(const analyzer::LogRecord& record);
     
     /*
-     * @brief 存储日志记录到MySQL
-     * @param record 日志记录
+     * @brief 整批存储日志记录到MySQL，失败时重试
+     * @param records 日志批次
+     * @return 是否存储成功
      */
-    void StoreMySQLLog(const analyzer::LogRecord& record);
+    bool StoreMySQLBatch(const common::RecordBatch& records);
+    
+    // 记录一次JSON解析
+    void CountJsonParse() {
+        if (config_.enableMetrics) {
+            metrics_.jsonParses.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
     
     // 更新指标
-    void UpdateMetrics(const std::string& parserName, 
+    void UpdateMetrics(ProcessorMetrics::ParserMetrics& parserMetrics,
                       const std::chrono::microseconds& processTime,
                       bool success);
 };
 
 /*
- * @brief 生成UUID
- * @return UUID字符串
+ * @brief 生成按时间递增的日志ID（common::IdGenerator的26字符文本形式）
+ * @return 日志ID字符串
  */
-std::string GenerateUUID();
+std::string GenerateLogId();
 
 /*
  * @brief 时间戳转字符串
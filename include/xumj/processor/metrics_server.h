@@ -0,0 +1,70 @@
+#ifndef XUMJ_PROCESSOR_METRICS_SERVER_H
+#define XUMJ_PROCESSOR_METRICS_SERVER_H
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include "xumj/common/non_copyable.h"
+#include "xumj/network/tcp_server.h"
+
+namespace xumj {
+namespace processor {
+
+/*
+ * @class MetricsServer
+ * @brief 提供Prometheus采集的HTTP /metrics接口
+ *
+ * 基于独立的TcpServer（一个IO线程），与接收日志的服务器互不影响。
+ * 收到请求行后立即回复并关闭连接（Connection: close），不解析请求头。
+ * 单行超过kMaxRequestLineLength时直接断开连接。
+ * 指标文本由提供函数在IO线程中生成，提供函数不应阻塞。
+ */
+class MetricsServer : public common::NonCopyable {
+public:
+    /*
+     * @brief 指标提供函数，返回Prometheus文本格式的指标
+     */
+    using Provider = std::function<std::string()>;
+
+    /*
+     * @brief 构造函数
+     * @param port 监听端口
+     * @param provider 指标提供函数
+     */
+    MetricsServer(uint16_t port, Provider provider);
+
+    ~MetricsServer();
+
+    /*
+     * @brief 启动服务器
+     */
+    void Start();
+
+    /*
+     * @brief 停止服务器
+     */
+    void Stop();
+
+    /*
+     * @brief 根据请求行生成完整的HTTP响应
+     * @param requestLine 请求行，例如"GET /metrics HTTP/1.1"
+     * @param provider 指标提供函数
+     * @param response 输出响应
+     * @return 是请求行返回true；请求头等其他行返回false，不需要回复
+     */
+    static bool HandleRequestLine(const std::string& requestLine, const Provider& provider, std::string& response);
+
+private:
+    static constexpr size_t kMaxRequestLineLength = 8192;  // 请求行和请求头的最大字节数
+
+    void OnMessage(uint64_t connectionId, const std::string& line);
+
+    Provider provider_;
+    std::unique_ptr<network::TcpServer> server_;
+};
+
+} // namespace processor
+} // namespace xumj
+
+#endif // XUMJ_PROCESSOR_METRICS_SERVER_H
@@ -0,0 +1,98 @@
+#ifndef XUMJ_PROCESSOR_RAW_ARCHIVER_H
+#define XUMJ_PROCESSOR_RAW_ARCHIVER_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "xumj/common/non_copyable.h"
+
+namespace xumj {
+namespace processor {
+
+/*
+ * @struct RawArchiveEntry
+ * @brief 一条待归档的原始消息
+ */
+struct RawArchiveEntry {
+    std::string id;          // 归档ID
+    std::string timestamp;   // 接收时间
+    std::string level;       // 日志级别
+    std::string source;      // 来源
+    std::string message;     // 原始消息（可能已截断）
+};
+
+/*
+ * @class RawArchiver
+ * @brief 原始消息异步归档
+ *
+ * 提交方只把条目放入有界队列，不等待写入；后台线程按批取出后调用写入函数。
+ * 队列满时丢弃新条目并计数，归档变慢不会反压到接收或处理流程。
+ */
+class RawArchiver : public common::NonCopyable {
+public:
+    /*
+     * @brief 写入函数，返回成功写入的条数
+     */
+    using Writer = std::function<size_t(const std::vector<RawArchiveEntry>& entries)>;
+
+    /*
+     * @brief 构造函数
+     * @param writer 写入函数，在归档线程中调用
+     * @param capacity 队列容量
+     * @param batchSize 每次写入的最大条数
+     */
+    RawArchiver(Writer writer, size_t capacity = 10000, size_t batchSize = 256);
+
+    /*
+     * @brief 析构函数，停止归档线程并写完队列中剩余的条目
+     */
+    ~RawArchiver();
+
+    /*
+     * @brief 启动归档线程
+     */
+    void Start();
+
+    /*
+     * @brief 停止归档线程，返回前写完队列中剩余的条目
+     */
+    void Stop();
+
+    /*
+     * @brief 提交一条归档，不阻塞
+     * @param entry 归档条目
+     * @return 队列已满或未启动时返回false
+     */
+    bool Submit(RawArchiveEntry entry);
+
+    uint64_t GetArchivedCount() const { return archived_.load(std::memory_order_relaxed); }
+    uint64_t GetDroppedCount() const { return dropped_.load(std::memory_order_relaxed); }
+    uint64_t GetFailedCount() const { return failed_.load(std::memory_order_relaxed); }
+
+private:
+    void Run();
+
+    Writer writer_;
+    const size_t capacity_;
+    const size_t batchSize_;
+
+    std::vector<RawArchiveEntry> pending_;
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    bool running_{false};
+    std::thread thread_;
+
+    std::atomic<uint64_t> archived_{0};   // 已写入条数
+    std::atomic<uint64_t> dropped_{0};    // 队列满丢弃的条数
+    std::atomic<uint64_t> failed_{0};     // 写入失败的条数
+};
+
+} // namespace processor
+} // namespace xumj
+
+#endif // XUMJ_PROCESSOR_RAW_ARCHIVER_H
@@ -1,13 +1,16 @@
 #ifndef XUMJ_STORAGE_MYSQL_STORAGE_H
 #define XUMJ_STORAGE_MYSQL_STORAGE_H
 
+#include <atomic>
 #include <string>
+#include <string_view>
 #include <vector>
 #include <memory>
 #include <mutex>
 #include <functional>
 #include <unordered_map>
 #include <mysql/mysql.h>
+#include "xumj/common/record_batch.h"
 
 namespace xumj {
 namespace storage {
@@ -96,6 +99,13 @@ public:
      */
     std::string EscapeString(const std::string& str);
     
+    /*
+     * @brief 转义字符串并追加到out末尾，不产生临时字符串
+     * @param out 输出
+     * @param str 原始字符串
+     */
+    void AppendEscaped(std::string& out, std::string_view str);
+    
     /*
      * @brief 检查连接是否有效
      * @return 连接是否有效
@@ -196,6 +206,8 @@ private:
  */
 class MySQLStorage {
 public:
+    static constexpr size_t kMaxAnalysisResultBytes = 65535;   // analysis_results.result列（TEXT）的最大字节数
+    
     /*
      * @struct LogEntry
      * @brief 日志条目结构
@@ -209,6 +221,17 @@ public:
         std::unordered_map<std::string, std::string> fields;  // 自定义字段
     };
     
+    /*
+     * @struct AnalysisResult
+     * @brief 一条日志在一条规则上的分析结果，对应analysis_results表的一行
+     */
+    struct AnalysisResult {
+        std::string logId;              // 日志ID
+        std::string ruleId;             // 规则ID
+        std::string ruleName;           // 规则名称
+        std::string result;             // 分析结果（JSON）
+    };
+    
     /*
      * @brief 构造函数
      * @param config MySQL配置
@@ -240,6 +263,33 @@ public:
      */
     int SaveLogEntries(const std::vector<LogEntry>& entries);
     
+    /*
+     * @brief 保存列式日志批次
+     *
+     * 整批在一个事务中用多行INSERT IGNORE写入日志表和字段表，每条语句约1MB；
+     * 已存在的ID跳过。超出表结构长度的值按UTF-8字符边界截断。
+     * @param batch 日志批次
+     * @return 成功保存的条目数量，失败时整批回滚并返回0
+     */
+    int SaveRecordBatch(const common::RecordBatch& batch);
+    
+    /*
+     * @brief 批量保存分析结果
+     *
+     * 整批在一个事务中用多行INSERT写入analysis_results表，每条语句约1MB，每行生成新的ID。
+     * 结果超过kMaxAnalysisResultBytes的行不写入（截断会得到无效的JSON），跳过的行计数且计入返回值。
+     * @param results 分析结果列表
+     * @return 成功处理的行数，失败时整批回滚并返回0
+     */
+    int SaveAnalysisResults(const std::vector<AnalysisResult>& results);
+    
+    /*
+     * @brief 获取因结果超长被跳过的分析结果行数
+     */
+    uint64_t GetSkippedAnalysisResultCount() const {
+        return skippedAnalysisResults_.load(std::memory_order_relaxed);
+    }
+    
     /*
      * @brief 根据条件查询日志条目
      * @param conditions 查询条件（字段名->值）
@@ -336,6 +386,7 @@ public:
 private:
     MySQLConfig config_;
     std::unique_ptr<MySQLConnectionPool> pool_;  // MySQL连接池
+    std::atomic<uint64_t> skippedAnalysisResults_{0};  // 因结果超长被跳过的分析结果行数
     
     /*
      * @brief 将结果集转换为日志条目
@@ -69,6 +69,13 @@ public:
      */
     redisReply* ExecuteArgv(int argc, const char** argv, const size_t* argvlen);
     
+    /*
+     * @brief 以流水线方式执行多条命令：先全部发送，再依次读取回复，只有一次网络往返
+     * @param commands 命令列表，每条命令为参数数组
+     * @return 成功执行的命令数（返回错误的命令不计入）
+     */
+    size_t ExecutePipeline(const std::vector<std::vector<std::string>>& commands);
+    
     /*
      * @brief 检查连接是否有效
      * @return 连接是否有效
@@ -329,6 +336,15 @@ public:
      */
     int SetSize(const std::string& key);
     
+    //====== 流水线操作 ======
+    
+    /*
+     * @brief 在同一个连接上以流水线方式执行多条命令
+     * @param commands 命令列表，每条命令为参数数组，如{"HSET", key, field, value}
+     * @return 成功执行的命令数
+     */
+    size_t Pipeline(const std::vector<std::vector<std::string>>& commands);
+    
     //====== 事务操作 ======
     
     /*
@@ -24,7 +24,9 @@ CREATE TABLE IF NOT EXISTS analysis_results (
     rule_name VARCHAR(128) NOT NULL,
     result TEXT,
     created_at TIMESTAMP DEFAULT CURRENT_TIMESTAMP,
-    FOREIGN KEY (log_id) REFERENCES logs(id) ON DELETE CASCADE
+    -- 分析的是processor_logs中的日志，结果可能先于日志写入，不设外键
+    INDEX idx_analysis_log_id (log_id),
+    INDEX idx_analysis_rule_id (rule_id)
 ) ENGINE=InnoDB DEFAULT CHARSET=utf8mb4;
 
 -- 创建分析规则表
@@ -5,9 +5,9 @@
 #include <iomanip>
 #include <algorithm>
 #include <chrono>
-#include <uuid/uuid.h>
 #include <nlohmann/json.hpp>
 #include <curl/curl.h>
+#include "xumj/common/id_generator.h"
 
 namespace xumj {
 namespace alert {
@@ -31,13 +31,9 @@ std::string TimePointToString(const std::chrono::system_clock::time_point& tp) {
     return std::string(buffer);
 }
 
-// 辅助函数：生成UUID
-std::string GenerateUUID() {
-    uuid_t uuid;
-    uuid_generate(uuid);
-    char uuid_str[37];
-    uuid_unparse_lower(uuid, uuid_str);
-    return std::string(uuid_str);
+// 辅助函数：生成按时间递增的ID
+std::string GenerateId() {
+    return common::IdGenerator::Instance().NextString();
 }
 
 // 辅助函数：将告警级别转换为字符串
@@ -191,7 +187,7 @@ Alert ThresholdAlertRule::GenerateAlert(
     const std::unordered_map<std::string, std::string>& results) const {
     
     Alert alert;
-    alert.id = GenerateUUID();  // 实际使用时会被替换
+    alert.id = GenerateId();  // 实际使用时会被替换
     alert.name = name_;
     alert.description = description_;
     alert.level = level_;
@@ -306,7 +302,7 @@ Alert KeywordAlertRule::GenerateAlert(
     const std::unordered_map<std::string, std::string>& /* results */) const {
     
     Alert alert;
-    alert.id = GenerateUUID();  // 实际使用时会被替换
+    alert.id = GenerateId();  // 实际使用时会被替换
     alert.name = name_;
     alert.description = description_;
     alert.level = level_;
@@ -1123,7 +1119,7 @@ bool AlertManager::IsDuplicateAlert(const Alert& alert) const {
 }
 
 std::string AlertManager::GenerateAlertId() const {
-    return "alert-" + GenerateUUID();
+    return "alert-" + GenerateId();
 }
 
 } // namespace alert
@@ -0,0 +1,209 @@
+#include "xumj/analyzer/keyword_matcher.h"
+#include <deque>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define XUMJ_KEYWORD_X86 1
+#endif
+
+namespace xumj {
+namespace analyzer {
+
+namespace {
+
+constexpr size_t kMaxSkipLetters = 4;   // 根状态跳过只在关键字首字母不超过4种时启用（含大小写最多8个字节）
+
+unsigned char FoldByte(unsigned char c) {
+    return (c >= 'A' && c <= 'Z') ? static_cast<unsigned char>(c + ('a' - 'A')) : c;
+}
+
+#ifdef XUMJ_KEYWORD_X86
+// 返回[i, length)中第一个属于needles的字节位置，找不到返回length
+size_t SkipSse2(const unsigned char* bytes, size_t i, size_t length, const std::vector<uint8_t>& needles) {
+    __m128i vectors[kMaxSkipLetters * 2];
+    const size_t count = needles.size();
+    for (size_t k = 0; k < count; ++k) {
+        vectors[k] = _mm_set1_epi8(static_cast<char>(needles[k]));
+    }
+    while (length - i >= 16) {
+        __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(bytes + i));
+        __m128i hits = _mm_cmpeq_epi8(chunk, vectors[0]);
+        for (size_t k = 1; k < count; ++k) {
+            hits = _mm_or_si128(hits, _mm_cmpeq_epi8(chunk, vectors[k]));
+        }
+        int mask = _mm_movemask_epi8(hits);
+        if (mask != 0) {
+            return i + static_cast<size_t>(__builtin_ctz(static_cast<unsigned>(mask)));
+        }
+        i += 16;
+    }
+    for (; i < length; ++i) {
+        for (uint8_t needle : needles) {
+            if (bytes[i] == needle) {
+                return i;
+            }
+        }
+    }
+    return length;
+}
+#endif
+
+} // namespace
+
+std::string AsciiLower(std::string_view text) {
+    std::string lower(text);
+    for (auto& c : lower) {
+        c = static_cast<char>(FoldByte(static_cast<unsigned char>(c)));
+    }
+    return lower;
+}
+
+int KeywordMatcher::Add(const std::string& keyword) {
+    std::string lower = AsciiLower(keyword);
+    auto it = ids_.find(lower);
+    if (it != ids_.end()) {
+        return it->second;
+    }
+    int id = static_cast<int>(keywords_.size());
+    ids_.emplace(lower, id);
+    keywords_.push_back(std::move(lower));
+    return id;
+}
+
+void KeywordMatcher::Compile() {
+    // 关键字中出现的每个字节一个等价类，其余字节为类0；大写字母与对应的小写字母同类
+    byteClass_.fill(0);
+    classCount_ = 1;
+    for (const auto& keyword : keywords_) {
+        for (char c : keyword) {
+            auto b = static_cast<unsigned char>(c);
+            if (byteClass_[b] == 0) {
+                byteClass_[b] = static_cast<uint8_t>(classCount_++);
+            }
+        }
+    }
+    for (unsigned char c = 'A'; c <= 'Z'; ++c) {
+        byteClass_[c] = byteClass_[FoldByte(c)];
+    }
+
+    // 字典树，缺失的转移为-1
+    std::vector<int32_t> next(classCount_, -1);
+    std::vector<std::vector<uint32_t>> terminal(1);
+    emptyKeywords_.clear();
+    for (size_t id = 0; id < keywords_.size(); ++id) {
+        if (keywords_[id].empty()) {
+            emptyKeywords_.push_back(static_cast<uint32_t>(id));
+            continue;
+        }
+        size_t state = 0;
+        for (char c : keywords_[id]) {
+            size_t slot = state * classCount_ + byteClass_[static_cast<unsigned char>(c)];
+            if (next[slot] < 0) {
+                next[slot] = static_cast<int32_t>(terminal.size());
+                terminal.emplace_back();
+                next.resize(terminal.size() * classCount_, -1);
+            }
+            state = static_cast<size_t>(next[slot]);
+        }
+        terminal[state].push_back(static_cast<uint32_t>(id));
+    }
+
+    // 按层补全失败转移，每个状态的输出并入其失败状态的输出
+    const size_t states = terminal.size();
+    std::vector<uint32_t> fail(states, 0);
+    transitions_.assign(states * classCount_, 0);
+    std::deque<uint32_t> queue{0};
+    while (!queue.empty()) {
+        uint32_t state = queue.front();
+        queue.pop_front();
+        for (size_t cls = 0; cls < classCount_; ++cls) {
+            int32_t child = next[state * classCount_ + cls];
+            uint32_t fallback = state == 0 ? 0 : transitions_[fail[state] * classCount_ + cls];
+            if (child < 0) {
+                transitions_[state * classCount_ + cls] = fallback;
+                continue;
+            }
+            auto target = static_cast<uint32_t>(child);
+            transitions_[state * classCount_ + cls] = target;
+            fail[target] = fallback;
+            const auto& inherited = terminal[fallback];
+            terminal[target].insert(terminal[target].end(), inherited.begin(), inherited.end());
+            queue.push_back(target);
+        }
+    }
+
+    outputStart_.assign(1, 0);
+    outputs_.clear();
+    for (const auto& ids : terminal) {
+        outputs_.insert(outputs_.end(), ids.begin(), ids.end());
+        outputStart_.push_back(static_cast<uint32_t>(outputs_.size()));
+    }
+
+    // 根状态下能开始关键字的字节种类较少时，用SIMD比较跳过其他字节
+    skipBytes_.clear();
+#ifdef XUMJ_KEYWORD_X86
+    std::vector<uint8_t> letters;
+    for (const auto& keyword : keywords_) {
+        if (keyword.empty()) {
+            continue;
+        }
+        auto first = static_cast<uint8_t>(keyword[0]);
+        bool known = false;
+        for (uint8_t letter : letters) {
+            known = known || letter == first;
+        }
+        if (!known) {
+            letters.push_back(first);
+        }
+    }
+    if (!letters.empty() && letters.size() <= kMaxSkipLetters) {
+        for (uint8_t letter : letters) {
+            skipBytes_.push_back(letter);
+            if (letter >= 'a' && letter <= 'z') {
+                skipBytes_.push_back(static_cast<uint8_t>(letter - ('a' - 'A')));
+            }
+        }
+    }
+#endif
+}
+
+size_t KeywordMatcher::Match(std::string_view text, std::vector<uint8_t>& found) const {
+    found.assign(keywords_.size(), 0);
+    size_t count = 0;
+    for (uint32_t id : emptyKeywords_) {
+        found[id] = 1;
+        ++count;
+    }
+    if (outputStart_.empty() || count == keywords_.size()) {
+        return count;
+    }
+
+    const auto* bytes = reinterpret_cast<const unsigned char*>(text.data());
+    const size_t length = text.size();
+    const uint32_t* transitions = transitions_.data();
+    uint32_t state = 0;
+    for (size_t i = 0; i < length;) {
+#ifdef XUMJ_KEYWORD_X86
+        if (state == 0 && !skipBytes_.empty()) {
+            i = SkipSse2(bytes, i, length, skipBytes_);
+            if (i == length) {
+                break;
+            }
+        }
+#endif
+        state = transitions[state * classCount_ + byteClass_[bytes[i++]]];
+        for (uint32_t k = outputStart_[state]; k < outputStart_[state + 1]; ++k) {
+            uint32_t id = outputs_[k];
+            if (!found[id]) {
+                found[id] = 1;
+                if (++count == keywords_.size()) {
+                    return count;
+                }
+            }
+        }
+    }
+    return count;
+}
+
+} // namespace analyzer
+} // namespace xumj
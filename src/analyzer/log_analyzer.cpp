@@ -1,14 +1,71 @@
 #include "xumj/analyzer/log_analyzer.h"
 #include "xumj/storage/storage_factory.h"
+#include <nlohmann/json.hpp>
 #include <iostream>
 #include <sstream>
 #include <regex>
 #include <algorithm>
 #include <chrono>
+#include <cstdlib>
+#include <numeric>
 
 namespace xumj {
 namespace analyzer {
 
+namespace {
+
+std::string DumpFields(const nlohmann::json& fields) {
+    // 无效的UTF-8替换为U+FFFD
+    return fields.dump(-1, ' ', false, nlohmann::json::error_handler_t::replace);
+}
+
+// 超过maxBytes时从最长的字段开始丢弃，直到放得下；结果仍是完整的JSON，
+// "_dropped_fields"记录丢弃的字段数
+std::string TrimFields(const std::unordered_map<std::string, std::string>& fields, size_t maxBytes) {
+    std::vector<std::pair<size_t, const std::string*>> bySize;
+    bySize.reserve(fields.size());
+    for (const auto& [name, value] : fields) {
+        bySize.emplace_back(name.size() + value.size(), &name);
+    }
+    std::sort(bySize.begin(), bySize.end(), [](const auto& a, const auto& b) { return a.first > b.first; });
+    
+    nlohmann::json json(fields);
+    size_t dropped = 0;
+    std::string text;
+    for (const auto& [size, name] : bySize) {
+        json.erase(*name);
+        json["_dropped_fields"] = ++dropped;
+        text = DumpFields(json);
+        if (text.size() <= maxBytes) {
+            break;
+        }
+    }
+    return text;
+}
+
+} // namespace
+
+// AnalysisRule默认实现
+
+void AnalysisRule::Evaluate(const LogRecord& record, size_t rule, RuleResult& result) const {
+    // 只实现了Analyze的规则：键值对原样保存
+    auto results = Analyze(record);
+    auto matched = results.find("matched");
+    if (matched != results.end() && matched->second == "true") {
+        result.SetMatched(rule);
+    }
+    result.SetVerbatim(rule);
+    for (const auto& [name, value] : results) {
+        result.AddField(rule, result.CopyString(name), result.CopyString(value));
+    }
+}
+
+void AnalysisRule::AnalyzeBatch(const LogRecord* records, size_t count, size_t rule, RuleResult* results) const {
+    for (size_t i = 0; i < count; ++i) {
+        Evaluate(records[i], rule, results[i]);
+    }
+}
+
 // RegexAnalysisRule实现
 
 RegexAnalysisRule::RegexAnalysisRule(const std::string& name,
@@ -27,47 +84,84 @@ std::string RegexAnalysisRule::GetName() const {
     return name_;
 }
 
+const std::string& RegexAnalysisRule::GetPattern() const {
+    return pattern_;
+}
+
+bool RegexAnalysisRule::IsCompiled() const {
+    return regexPattern_ != nullptr;
+}
+
 std::unordered_map<std::string, std::string> RegexAnalysisRule::Analyze(const LogRecord& record) const {
-    std::unordered_map<std::string, std::string> results;
-    
     if (!config_.enabled) {
-        results["enabled"] = "false";
-        return results;
+        return {{"enabled", "false"}};
     }
     
+    RuleResult result;
+    result.Reset(1);
+    Evaluate(record, 0, result);
+    return result.ToMap(0, name_, config_.group);
+}
+
+void RegexAnalysisRule::Evaluate(const LogRecord& record, size_t rule, RuleResult& result) const {
     try {
         if (!regexPattern_) {
             throw std::runtime_error("正则表达式未编译");
         }
         
-        // 匹配日志消息
-        std::smatch matches;
-        if (std::regex_search(record.message, matches, *regexPattern_)) {
-            // 提取匹配组并映射到字段名
-            for (size_t i = 1; i < matches.size() && i - 1 < fieldNames_.size(); ++i) {
-                if (matches[i].matched) {
-                    results[fieldNames_[i - 1]] = matches[i].str();
-                }
-            }
-            
-            results["matched"] = "true";
-            results["rule"] = name_;
-            results["group"] = config_.group;
-            
-            if (pattern_.find("error") != std::string::npos || 
-                pattern_.find("exception") != std::string::npos || 
-                pattern_.find("failed") != std::string::npos) {
-                results["has_error"] = "true";
+        // 匹配日志消息，只在匹配且需要提取字段时保留匹配组
+        if (fieldNames_.empty()) {
+            auto outcome = BoundedRegexSearch(record.message, *regexPattern_, config_.maxMatchSteps);
+            if (outcome == RegexSearchResult::ABORTED) {
+                result.SetTimedOut(rule);
+                return;
             }
+            EvaluateMatched(record, outcome == RegexSearchResult::MATCH, rule, result);
         } else {
-            results["matched"] = "false";
-            results["group"] = config_.group;
+            EvaluateMatched(record, true, rule, result);
         }
     } catch (const std::exception& e) {
-        results["error"] = "分析错误: " + std::string(e.what());
+        result.SetVerbatim(rule);
+        result.AddField(rule, "error", result.CopyString("分析错误: " + std::string(e.what())));
+    }
+}
+
+void RegexAnalysisRule::EvaluateMatched(const LogRecord& record, bool matched, size_t rule,
+                                        RuleResult& result) const {
+    if (!matched) {
+        return;
+    }
+    if (!regexPattern_) {
+        result.SetVerbatim(rule);
+        result.AddField(rule, "error", "分析错误: 正则表达式未编译");
+        return;
     }
     
-    return results;
+    // 有字段需要提取时重新搜索一次，得到匹配组；字段值是指向消息的视图
+    if (!fieldNames_.empty()) {
+        thread_local std::vector<std::pair<size_t, size_t>> groups;
+        auto outcome = BoundedRegexSearch(record.message, *regexPattern_, config_.maxMatchSteps, &groups);
+        if (outcome == RegexSearchResult::ABORTED) {
+            result.SetTimedOut(rule);
+            return;
+        }
+        if (outcome == RegexSearchResult::NO_MATCH) {
+            return;
+        }
+        for (size_t i = 1; i < groups.size() && i - 1 < fieldNames_.size(); ++i) {
+            if (groups[i].first != std::string_view::npos) {
+                result.AddField(rule, fieldNames_[i - 1],
+                                std::string_view(record.message).substr(groups[i].first, groups[i].second));
+            }
+        }
+    }
+    
+    result.SetMatched(rule);
+    if (pattern_.find("error") != std::string::npos || 
+        pattern_.find("exception") != std::string::npos || 
+        pattern_.find("failed") != std::string::npos) {
+        result.AddField(rule, "has_error", "true");
+    }
 }
 
 const RuleConfig& RegexAnalysisRule::GetConfig() const {
@@ -96,67 +190,70 @@ KeywordAnalysisRule::KeywordAnalysisRule(const std::string& name,
                                       const std::vector<std::string>& keywords,
                                       bool scoring)
     : name_(name), keywords_(keywords), scoring_(scoring) {
+    // 关键字在创建时转为小写并编译，匹配时不再转换
+    for (const auto& keyword : keywords_) {
+        keywordIds_.push_back(matcher_.Add(keyword));
+    }
+    matcher_.Compile();
 }
 
 std::string KeywordAnalysisRule::GetName() const {
     return name_;
 }
 
+const std::vector<std::string>& KeywordAnalysisRule::GetKeywords() const {
+    return keywords_;
+}
+
 std::unordered_map<std::string, std::string> KeywordAnalysisRule::Analyze(const LogRecord& record) const {
-    std::unordered_map<std::string, std::string> results;
-    
     if (!config_.enabled) {
-        results["enabled"] = "false";
-        return results;
+        return {{"enabled", "false"}};
     }
     
-    try {
-        // 将日志消息转为小写以进行不区分大小写的匹配
-        std::string lowerMessage = record.message;
-        std::transform(lowerMessage.begin(), lowerMessage.end(), lowerMessage.begin(),
-                      [](unsigned char c) { return std::tolower(c); });
-        
-        // 匹配关键字
-        int matchCount = 0;
-        std::vector<std::string> matchedKeywords;
-        
-        for (const auto& keyword : keywords_) {
-            std::string lowerKeyword = keyword;
-            std::transform(lowerKeyword.begin(), lowerKeyword.end(), lowerKeyword.begin(),
-                          [](unsigned char c) { return std::tolower(c); });
-            
-            if (lowerMessage.find(lowerKeyword) != std::string::npos) {
-                matchCount++;
-                matchedKeywords.push_back(keyword);
-            }
+    RuleResult result;
+    result.Reset(1);
+    Evaluate(record, 0, result);
+    return result.ToMap(0, name_, config_.group);
+}
+
+void KeywordAnalysisRule::Evaluate(const LogRecord& record, size_t rule, RuleResult& result) const {
+    // 一遍扫描消息，不区分大小写
+    thread_local std::vector<uint8_t> found;
+    matcher_.Match(record.message, found);
+    EvaluateMatched(found, keywordIds_, rule, result);
+}
+
+void KeywordAnalysisRule::EvaluateMatched(const std::vector<uint8_t>& found, const std::vector<int>& keywordIds,
+                                          size_t rule, RuleResult& result) const {
+    // 按关键字顺序统计出现的关键字，没有出现时不写入任何内容
+    int matchCount = 0;
+    for (size_t i = 0; i < keywords_.size() && i < keywordIds.size(); ++i) {
+        if (found[static_cast<size_t>(keywordIds[i])]) {
+            matchCount++;
         }
-        
-        if (matchCount > 0) {
-            results["matched"] = "true";
-            results["rule"] = name_;
-            results["group"] = config_.group;
-            results["match_count"] = std::to_string(matchCount);
-            
-            if (scoring_ && !keywords_.empty()) {
-                int score = (matchCount * 100) / static_cast<int>(keywords_.size());
-                results["score"] = std::to_string(score);
-            }
-            
-            std::stringstream ss;
-            for (size_t i = 0; i < matchedKeywords.size(); ++i) {
-                if (i > 0) ss << ", ";
-                ss << matchedKeywords[i];
+    }
+    if (matchCount == 0) {
+        return;
+    }
+    
+    thread_local std::string matchedKeywords;
+    matchedKeywords.clear();
+    for (size_t i = 0; i < keywords_.size() && i < keywordIds.size(); ++i) {
+        if (found[static_cast<size_t>(keywordIds[i])]) {
+            if (!matchedKeywords.empty()) {
+                matchedKeywords += ", ";
             }
-            results["matched_keywords"] = ss.str();
-        } else {
-            results["matched"] = "false";
-            results["group"] = config_.group;
+            matchedKeywords += keywords_[i];
         }
-    } catch (const std::exception& e) {
-        results["error"] = "分析错误: " + std::string(e.what());
     }
     
-    return results;
+    result.SetMatched(rule);
+    result.AddField(rule, "match_count", result.CopyString(std::to_string(matchCount)));
+    if (scoring_ && !keywords_.empty()) {
+        int score = (matchCount * 100) / static_cast<int>(keywords_.size());
+        result.AddField(rule, "score", result.CopyString(std::to_string(score)));
+    }
+    result.AddField(rule, "matched_keywords", result.CopyString(matchedKeywords));
 }
 
 const RuleConfig& KeywordAnalysisRule::GetConfig() const {
@@ -179,6 +276,31 @@ bool KeywordAnalysisRule::IsEnabled() const {
     return config_.enabled;
 }
 
+// 列式批次转换
+
+void AppendRecord(common::RecordBatch& batch, const LogRecord& record) {
+    batch.Append(record.id, record.timestamp, record.level, record.source, record.message);
+    for (const auto& [name, value] : record.fields) {
+        batch.SetField(name, value);
+    }
+}
+
+void ReadRecord(const common::RecordBatch& batch, size_t row, LogRecord& record) {
+    std::string_view id = batch.Id(row);
+    std::string_view level = batch.LevelText(row);
+    std::string_view source = batch.Source(row);
+    std::string_view message = batch.Message(row);
+    record.id.assign(id.data(), id.size());
+    batch.TimestampText(row, record.timestamp);
+    record.level.assign(level.data(), level.size());
+    record.source.assign(source.data(), source.size());
+    record.message.assign(message.data(), message.size());
+    record.fields.clear();
+    batch.ForEachField(row, [&record](std::string_view name, std::string_view value) {
+        record.fields.emplace(std::string(name), std::string(value));
+    });
+}
+
 // LogAnalyzer实现
 
 LogAnalyzer::LogAnalyzer(const AnalyzerConfig& config) 
@@ -202,6 +324,22 @@ bool LogAnalyzer::Initialize(const AnalyzerConfig& config) {
     // 初始化线程池
     threadPool_ = std::make_unique<common::ThreadPool>(config_.threadPoolSize);
     
+    // 自适应线程池：积压包括未取出的记录和已切分、尚未执行的任务
+    poolController_.reset();
+    if (config_.adaptiveThreadPool) {
+        poolController_ = std::make_unique<common::ConcurrencyController>(
+            config_.poolConcurrency, threadPool_->GetThreadCount(),
+            [this]() {
+                common::ConcurrencySample sample;
+                sample.queueDepth = GetPendingCount() +
+                    threadPool_->GetPendingTaskCount() * std::max<size_t>(config_.batchSize, 1);
+                sample.completed = analyzedRecords_.load(std::memory_order_relaxed);
+                sample.busyMicros = busyMicros_.load(std::memory_order_relaxed);
+                return sample;
+            },
+            [this](size_t count) { threadPool_->Resize(count); });
+    }
+    
     // 初始化存储
     if (config_.storeResults) {
         try {
@@ -227,6 +365,14 @@ bool LogAnalyzer::Initialize(const AnalyzerConfig& config) {
         }
     }
     
+    // 结果由写入线程汇总成批后存储
+    resultWriter_.reset();
+    if (config_.storeResults && (redisStorage_ || mysqlStorage_)) {
+        resultWriter_ = std::make_unique<ResultWriter>(
+            [this](const std::vector<StoredResult>& results) { return WriteResults(results); },
+            config_.resultFlushSize, config_.resultFlushInterval, config_.resultQueueCapacity);
+    }
+    
     return true;
 }
 
@@ -241,6 +387,7 @@ void LogAnalyzer::AddRule(std::shared_ptr<AnalysisRule> rule) {
         
         // 按优先级排序
         SortRulesByPriority();
+        snapshot_.reset();
     }
 }
 
@@ -262,6 +409,8 @@ void LogAnalyzer::SortRulesByPriority() {
 void LogAnalyzer::ClearRules() {
     std::lock_guard<std::mutex> lock(rulesMutex_);
     rules_.clear();
+    ruleStats_.clear();
+    snapshot_.reset();
 }
 
 bool LogAnalyzer::SubmitRecord(const LogRecord& record) {
@@ -269,30 +418,47 @@ bool LogAnalyzer::SubmitRecord(const LogRecord& record) {
         return false;
     }
     
-    // 添加记录到待处理队列
+    // 追加到队尾的批次，批次已满时新开一个
     {
         std::lock_guard<std::mutex> lock(recordsMutex_);
-        pendingRecords_.push_back(record);
+        if (pendingBatches_.empty() || pendingBatches_.back().Size() >= config_.batchSize) {
+            pendingBatches_.emplace_back();
+        }
+        AppendRecord(pendingBatches_.back(), record);
+        pendingCount_++;
+        metrics_.pendingRecords = pendingCount_;
     }
+    recordsCond_.notify_one();
     
     return true;
 }
 
 size_t LogAnalyzer::SubmitRecords(const std::vector<LogRecord>& records) {
-    if (!running_) {
+    if (!running_ || records.empty()) {
         return 0;
     }
     
-    size_t count = 0;
+    // 在锁外转换为列式批次
+    common::RecordBatch batch;
+    for (const auto& record : records) {
+        AppendRecord(batch, record);
+    }
+    return SubmitBatch(std::move(batch));
+}
+
+size_t LogAnalyzer::SubmitBatch(common::RecordBatch&& batch) {
+    if (!running_ || batch.Empty()) {
+        return 0;
+    }
     
-    // 添加记录到待处理队列
+    size_t count = batch.Size();
     {
         std::lock_guard<std::mutex> lock(recordsMutex_);
-        for (const auto& record : records) {
-            pendingRecords_.push_back(record);
-            count++;
-        }
+        pendingBatches_.push_back(std::move(batch));
+        pendingCount_ += count;
+        metrics_.pendingRecords = pendingCount_;
     }
+    recordsCond_.notify_one();
     
     return count;
 }
@@ -302,14 +468,26 @@ void LogAnalyzer::SetAnalysisCallback(AnalysisCallback callback) {
     analysisCallback_ = std::move(callback);
 }
 
+void LogAnalyzer::SetResultCallback(ResultCallback callback) {
+    std::lock_guard<std::mutex> lock(callbackMutex_);
+    resultCallback_ = std::move(callback);
+}
+
 bool LogAnalyzer::Start() {
     if (running_) {
         return true;  // 已经在运行
     }
     
+    if (resultWriter_) {
+        resultWriter_->Start();
+    }
+    
     // 启动分析线程
     running_ = true;
     analyzeThread_ = std::thread(&LogAnalyzer::AnalyzeThreadFunc, this);
+    if (poolController_) {
+        poolController_->Start();
+    }
     
     return true;
 }
@@ -319,18 +497,35 @@ void LogAnalyzer::Stop() {
         return;  // 已经停止
     }
     
-    // 停止分析线程
-    running_ = false;
+    // 停止分析线程，在锁内修改使等待中的分析线程不会错过唤醒
+    {
+        std::lock_guard<std::mutex> lock(recordsMutex_);
+        running_ = false;
+    }
+    recordsCond_.notify_all();
+    if (poolController_) {
+        poolController_->Stop();
+    }
     
     // 等待线程结束
     if (analyzeThread_.joinable()) {
         analyzeThread_.join();
     }
     
+    // 等待已切分的任务分析完，之后才能写完剩余的结果、释放规则和指标
+    if (threadPool_) {
+        threadPool_->WaitForTasks();
+    }
+    if (resultWriter_) {
+        resultWriter_->Stop();
+    }
+    
     // 清空待处理队列
     {
         std::lock_guard<std::mutex> lock(recordsMutex_);
-        pendingRecords_.clear();
+        pendingBatches_.clear();
+        pendingCount_ = 0;
+        metrics_.pendingRecords = 0;
     }
 }
 
@@ -345,92 +540,410 @@ size_t LogAnalyzer::GetRuleCount() const {
 
 size_t LogAnalyzer::GetPendingCount() const {
     std::lock_guard<std::mutex> lock(recordsMutex_);
-    return pendingRecords_.size();
+    return pendingCount_;
+}
+
+struct LogAnalyzer::SelectedRows {
+    common::RecordBatch batch;
+    std::vector<uint32_t> rows;   // 通过级别过滤的行
+};
+
+struct LogAnalyzer::RuleStats {
+    std::atomic<uint64_t> costNanos{0};     // 累计分析耗时（纳秒）
+    std::atomic<uint64_t> matches{0};       // 命中次数
+};
+
+struct LogAnalyzer::RuleSnapshot {
+    std::vector<std::shared_ptr<AnalysisRule>> rules;   // 按优先级排序
+    RegexRuleSet regexSet;                              // 所有正则规则的模式
+    std::vector<int> regexIndex;                        // 规则在regexSet中的下标，不是正则规则时为-1
+    KeywordMatcher keywordSet;                          // 所有关键字规则的关键字
+    std::vector<const KeywordAnalysisRule*> keywordRules;   // 关键字规则，其他规则为空
+    std::vector<std::vector<int>> keywordIds;           // 关键字规则各关键字在keywordSet中的下标
+    std::vector<std::shared_ptr<RuleStats>> stats;      // 各规则的在线统计
+    std::vector<uint32_t> groupIndex;                   // 规则所在分组的下标
+    std::vector<uint8_t> shortCircuit;                  // 各分组是否短路
+    std::vector<uint8_t> batchable;                     // 按块调用AnalyzeBatch的规则：正则、关键字规则和短路组以外的规则
+    
+    // 评估顺序（规则下标），按统计定期重排；快照的其他部分不变
+    mutable std::mutex orderMutex;
+    mutable std::shared_ptr<const std::vector<uint32_t>> order;
+    mutable std::chrono::steady_clock::time_point nextReorder;
+};
+
+std::shared_ptr<const LogAnalyzer::RuleSnapshot> LogAnalyzer::GetSnapshot() {
+    std::lock_guard<std::mutex> lock(rulesMutex_);
+    if (snapshot_) {
+        return snapshot_;
+    }
+    
+    // 规则变化后第一次分析时重建，连续添加多条规则只编译一次
+    auto snapshot = std::make_shared<RuleSnapshot>();
+    snapshot->rules = rules_;
+    snapshot->regexIndex.assign(rules_.size(), -1);
+    snapshot->keywordRules.assign(rules_.size(), nullptr);
+    snapshot->keywordIds.resize(rules_.size());
+    std::unordered_map<std::string, uint32_t> groups;
+    for (size_t i = 0; i < rules_.size(); ++i) {
+        auto regexRule = std::dynamic_pointer_cast<RegexAnalysisRule>(rules_[i]);
+        if (regexRule && regexRule->IsCompiled()) {
+            snapshot->regexIndex[i] = snapshot->regexSet.Add(regexRule->GetPattern(),
+                                                             regexRule->GetConfig().maxMatchSteps);
+        }
+        if (auto keywordRule = dynamic_cast<const KeywordAnalysisRule*>(rules_[i].get())) {
+            snapshot->keywordRules[i] = keywordRule;
+            for (const auto& keyword : keywordRule->GetKeywords()) {
+                snapshot->keywordIds[i].push_back(snapshot->keywordSet.Add(keyword));
+            }
+        }
+        
+        auto& stats = ruleStats_[rules_[i].get()];
+        if (!stats) {
+            stats = std::make_shared<RuleStats>();
+        }
+        snapshot->stats.push_back(stats);
+        
+        const std::string& group = rules_[i]->GetConfig().group;
+        auto inserted = groups.emplace(group, static_cast<uint32_t>(groups.size()));
+        if (inserted.second) {
+            snapshot->shortCircuit.push_back(shortCircuitGroups_.count(group) ? 1 : 0);
+        }
+        snapshot->groupIndex.push_back(inserted.first->second);
+        snapshot->batchable.push_back(snapshot->regexIndex[i] < 0 && !snapshot->keywordRules[i] &&
+                                      !snapshot->shortCircuit[inserted.first->second]);
+    }
+    snapshot->regexSet.Compile();
+    snapshot->keywordSet.Compile();
+    
+    // 初始按优先级顺序评估，积累统计后再调整
+    auto order = std::make_shared<std::vector<uint32_t>>(rules_.size());
+    std::iota(order->begin(), order->end(), 0);
+    snapshot->order = std::move(order);
+    snapshot->nextReorder = std::chrono::steady_clock::now() + config_.ruleReorderInterval;
+    snapshot_ = snapshot;
+    return snapshot_;
+}
+
+std::shared_ptr<const std::vector<uint32_t>> LogAnalyzer::GetRuleOrder(const RuleSnapshot& snapshot) {
+    std::lock_guard<std::mutex> lock(snapshot.orderMutex);
+    auto now = std::chrono::steady_clock::now();
+    if (config_.ruleReorderInterval.count() <= 0 || now < snapshot.nextReorder) {
+        return snapshot.order;
+    }
+    snapshot.nextReorder = now + config_.ruleReorderInterval;
+    
+    // 规则在一条记录上的平均耗时为c、命中率为p时，按c/p从小到大评估，短路组到第一条命中为止的期望耗时最小；
+    // c/p即累计耗时/命中次数。统计每个周期减半，反映最近的耗时和命中率。
+    // 正则和关键字规则的c只是查看共用扫描结果的耗时，共用扫描本身不计入：只要还有一条同类规则要分析就必须扫描，
+    // 调整顺序只能省下逐条分析的自定义规则的耗时
+    const size_t ruleCount = snapshot.rules.size();
+    std::vector<double> cost(ruleCount);
+    std::vector<int> priority(ruleCount);
+    for (size_t i = 0; i < ruleCount; ++i) {
+        auto& stats = *snapshot.stats[i];
+        uint64_t nanos = stats.costNanos.load(std::memory_order_relaxed);
+        uint64_t matches = stats.matches.load(std::memory_order_relaxed);
+        cost[i] = static_cast<double>(nanos + 1) / static_cast<double>(matches + 1);
+        priority[i] = snapshot.rules[i]->GetConfig().priority;
+        stats.costNanos.fetch_sub(nanos / 2, std::memory_order_relaxed);
+        stats.matches.fetch_sub(matches / 2, std::memory_order_relaxed);
+    }
+    auto order = std::make_shared<std::vector<uint32_t>>(ruleCount);
+    std::iota(order->begin(), order->end(), 0);
+    std::stable_sort(order->begin(), order->end(), [&](uint32_t a, uint32_t b) {
+        if (priority[a] != priority[b]) {
+            return priority[a] > priority[b];
+        }
+        return cost[a] < cost[b];
+    });
+    snapshot.order = order;
+    return snapshot.order;
+}
+
+std::vector<std::shared_ptr<AnalysisRule>> LogAnalyzer::GetEvaluationOrder() {
+    auto snapshot = GetSnapshot();
+    auto order = GetRuleOrder(*snapshot);
+    std::vector<std::shared_ptr<AnalysisRule>> rules;
+    for (uint32_t i : *order) {
+        rules.push_back(snapshot->rules[i]);
+    }
+    return rules;
 }
 
 void LogAnalyzer::AnalyzeThreadFunc() {
+    auto lastMemorySample = std::chrono::steady_clock::time_point();
+    auto maxWait = config_.analyzeInterval.count() > 0 ? config_.analyzeInterval : std::chrono::seconds(1);
+    std::deque<common::RecordBatch> drained;
     while (running_) {
-        std::vector<LogRecord> batch;
-        
-        // 获取一批待处理记录
-        {
-            std::lock_guard<std::mutex> lock(recordsMutex_);
-            
-            // 从待处理队列中取出批次大小的记录
-            size_t count = std::min(config_.batchSize, pendingRecords_.size());
-            if (count > 0) {
-                batch.insert(batch.end(), pendingRecords_.begin(), pendingRecords_.begin() + count);
-                pendingRecords_.erase(pendingRecords_.begin(), pendingRecords_.begin() + count);
+        // 每秒采样一次常驻内存，记录峰值
+        if (config_.enableMetrics) {
+            auto now = std::chrono::steady_clock::now();
+            if (now - lastMemorySample >= std::chrono::seconds(1)) {
+                metrics_.UpdatePeakMemory(common::ReadResidentMemoryBytes());
+                lastMemorySample = now;
             }
         }
         
-        // 处理当前批次
-        for (const auto& record : batch) {
-            // 在线程池中异步处理每条记录
-            threadPool_->Submit([this, record]() {
-                this->ProcessRecord(record);
-            });
+        // 等待提交或停止，然后交换出整个队列，锁内只做常数时间的操作
+        {
+            std::unique_lock<std::mutex> lock(recordsMutex_);
+            recordsCond_.wait_for(lock, maxWait, [this] { return !pendingBatches_.empty() || !running_; });
+            drained.swap(pendingBatches_);
+            pendingCount_ = 0;
+            metrics_.pendingRecords = 0;
         }
         
-        // 等待指定的分析间隔
-        if (batch.empty()) {
-            std::this_thread::sleep_for(config_.analyzeInterval);
+        for (auto& batch : drained) {
+            DispatchBatch(std::move(batch));
         }
+        drained.clear();
+    }
+}
+
+void LogAnalyzer::DispatchBatch(common::RecordBatch&& batch) {
+    // 按级别列过滤，再按行数和消息字节数切分为线程池任务，各任务共享同一个批次
+    auto selected = std::make_shared<SelectedRows>();
+    selected->batch = std::move(batch);
+    selected->batch.SelectLevelAtLeast(config_.minLevel, selected->rows);
+    
+    const size_t maxRows = std::max<size_t>(config_.batchSize, 1);
+    const size_t rows = selected->rows.size();
+    size_t begin = 0;
+    size_t bytes = 0;
+    for (size_t i = 0; i < rows; ++i) {
+        bytes += selected->batch.Message(selected->rows[i]).size();
+        if (i + 1 - begin >= maxRows || bytes >= config_.chunkBytes || i + 1 == rows) {
+            size_t end = i + 1;
+            threadPool_->Submit([this, selected, begin, end]() {
+                this->ProcessRows(*selected, begin, end);
+            });
+            begin = end;
+            bytes = 0;
+        }
+    }
+}
+
+void LogAnalyzer::ProcessRows(const SelectedRows& selected, size_t begin, size_t end) {
+    // 同一个线程的任务复用记录的内存
+    auto start = std::chrono::steady_clock::now();
+    thread_local std::vector<LogRecord> records;
+    size_t count = end - begin;
+    if (records.size() < count) {
+        records.resize(count);
     }
+    for (size_t i = 0; i < count; ++i) {
+        ReadRecord(selected.batch, selected.rows[begin + i], records[i]);
+    }
+    AnalyzeRecords(records.data(), count);
+    
+    // 处理条数和耗时供自适应线程池估计单条处理时间
+    analyzedRecords_.fetch_add(count, std::memory_order_relaxed);
+    busyMicros_.fetch_add(static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - start).count()), std::memory_order_relaxed);
 }
 
-void LogAnalyzer::ProcessRecord(const LogRecord& record) {
+void LogAnalyzer::AnalyzeRecords(const LogRecord* records, size_t count) {
     auto startTime = std::chrono::steady_clock::now();
-    bool hasError = false;
+    size_t errorRecords = 0;
+    uint64_t totalLogs = 0;
     
-    try {
-        std::vector<std::shared_ptr<AnalysisRule>> rules;
-        {
-            std::lock_guard<std::mutex> lock(rulesMutex_);
-            rules = rules_;  // 复制规则列表以避免处理过程中规则被修改
+    // 快照不可变，处理过程中规则被修改也不受影响
+    auto snapshot = GetSnapshot();
+    const size_t ruleCount = snapshot->rules.size();
+    
+    // 每条记录一个紧凑结果，同一个线程的任务之间复用内存
+    thread_local std::vector<RuleResult> results;
+    if (results.size() < count) {
+        results.resize(count);
+    }
+    for (size_t r = 0; r < count; ++r) {
+        results[r].Reset(ruleCount);
+    }
+    
+    // 本块的耗时和命中统计，结束时累加到规则统计
+    thread_local std::vector<uint64_t> costNanos;
+    thread_local std::vector<uint64_t> matchCount;
+    costNanos.assign(ruleCount, 0);
+    matchCount.assign(ruleCount, 0);
+    auto order = GetRuleOrder(*snapshot);
+    
+    // 正则和关键字以外的规则按块调用AnalyzeBatch，规则可以在一块记录之间分摊准备开销
+    thread_local std::vector<uint8_t> batchEvaluated;
+    batchEvaluated.assign(ruleCount, 0);
+    std::vector<std::chrono::microseconds> ruleTime(ruleCount, std::chrono::microseconds(0));
+    for (size_t i = 0; i < ruleCount; ++i) {
+        const auto& rule = snapshot->rules[i];
+        if (!snapshot->batchable[i] || !rule->IsEnabled()) {
+            continue;
         }
+        auto ruleStartTime = std::chrono::steady_clock::now();
+        try {
+            rule->AnalyzeBatch(records, count, i, results.data());
+        } catch (const std::exception& e) {
+            std::cerr << "处理记录时发生错误: " << e.what() << std::endl;
+            for (size_t r = 0; r < count; ++r) {
+                results[r].SetVerbatim(i);
+                results[r].AddField(i, "error", results[r].CopyString("分析错误: " + std::string(e.what())));
+            }
+        }
+        batchEvaluated[i] = 1;
+        auto elapsed = std::chrono::steady_clock::now() - ruleStartTime;
+        ruleTime[i] = std::chrono::duration_cast<std::chrono::microseconds>(elapsed) / static_cast<int64_t>(count);
+        costNanos[i] += static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+        for (size_t r = 0; r < count; ++r) {
+            matchCount[i] += results[r].IsMatched(i) ? 1 : 0;
+        }
+    }
+    
+    // 存储或键值对回调需要键值对，都没有时不生成
+    ResultCallback resultCallback;
+    bool mapCallback = false;
+    {
+        std::lock_guard<std::mutex> lock(callbackMutex_);
+        resultCallback = resultCallback_;
+        mapCallback = static_cast<bool>(analysisCallback_);
+    }
+    const bool store = config_.storeResults && resultWriter_;
+    const bool needMaps = store || mapCallback;
+    
+    thread_local std::vector<uint8_t> matched;
+    thread_local std::vector<uint8_t> found;
+    for (size_t r = 0; r < count; ++r) {
+        const LogRecord& record = records[r];
+        RuleResult& result = results[r];
         
-        for (const auto& rule : rules) {
-            if (!rule->IsEnabled()) {
+        // 所有正则规则共用一遍扫描，所有关键字规则共用一遍扫描；在第一条用到它的规则之前才扫描，
+        // 用到它的规则都被短路跳过时不扫描。扫描耗时由所有同类规则分摊，不计入单条规则的耗时
+        bool regexScanned = false;
+        bool keywordScanned = false;
+        
+        // 按评估顺序分析，短路组内有规则命中后跳过组内其余规则
+        thread_local std::vector<uint8_t> evaluated;
+        thread_local std::vector<uint8_t> groupDone;
+        evaluated.assign(ruleCount, 0);
+        groupDone.assign(snapshot->shortCircuit.size(), 0);
+        for (uint32_t i : *order) {
+            const auto& rule = snapshot->rules[i];
+            int pattern = snapshot->regexIndex[i];
+            uint32_t group = snapshot->groupIndex[i];
+            if (batchEvaluated[i]) {
+                evaluated[i] = 1;
                 continue;
             }
-            
+            if (!rule->IsEnabled() || groupDone[group]) {
+                continue;
+            }
+            if (pattern >= 0 && !regexScanned) {
+                snapshot->regexSet.Match(record.message, matched);
+                regexScanned = true;
+            } else if (snapshot->keywordRules[i] && !keywordScanned) {
+                snapshot->keywordSet.Match(record.message, found);
+                keywordScanned = true;
+            }
             auto ruleStartTime = std::chrono::steady_clock::now();
-            auto results = rule->Analyze(record);
-            auto ruleEndTime = std::chrono::steady_clock::now();
+            if (pattern >= 0) {
+                if (matched[pattern] == RegexRuleSet::kAborted) {
+                    result.SetTimedOut(i);
+                } else {
+                    static_cast<const RegexAnalysisRule&>(*rule).EvaluateMatched(record, matched[pattern] != 0, i, result);
+                }
+            } else if (snapshot->keywordRules[i]) {
+                snapshot->keywordRules[i]->EvaluateMatched(found, snapshot->keywordIds[i], i, result);
+            } else if (snapshot->batchable[i]) {
+                // 分析这一块之前规则还是禁用的
+                continue;
+            } else {
+                // 短路组内的其他规则逐条分析
+                try {
+                    rule->Evaluate(record, i, result);
+                } catch (const std::exception& e) {
+                    result.SetVerbatim(i);
+                    result.AddField(i, "error", result.CopyString("分析错误: " + std::string(e.what())));
+                }
+            }
+            auto elapsed = std::chrono::steady_clock::now() - ruleStartTime;
+            evaluated[i] = 1;
+            ruleTime[i] = std::chrono::duration_cast<std::chrono::microseconds>(elapsed);
+            costNanos[i] += static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+            if (result.IsMatched(i)) {
+                ++matchCount[i];
+                groupDone[group] = snapshot->shortCircuit[group];
+            }
+        }
+        
+        if (resultCallback) {
+            resultCallback(record, result, snapshot->rules);
+        }
+        
+        bool hasError = false;
+        
+        // 重复日志的汇总记录代表repeat_count条原始日志，命中数按条数累加
+        auto repeat = record.fields.find("repeat_count");
+        uint64_t logs = 1;
+        if (repeat != record.fields.end()) {
+            logs = std::max<uint64_t>(std::strtoull(repeat->second.c_str(), nullptr, 10), 1);
+        }
+        totalLogs += logs;
+        StoredResult stored;
+        for (size_t i = 0; i < ruleCount; ++i) {
+            if (!evaluated[i]) {
+                continue;
+            }
+            const auto& rule = snapshot->rules[i];
+            bool ruleError = result.HasError(i);
+            hasError = hasError || ruleError;
             
             // 更新性能指标
             if (config_.enableMetrics) {
-                auto processTime = std::chrono::duration_cast<std::chrono::microseconds>(
-                    ruleEndTime - ruleStartTime);
-                UpdateMetrics(rule->GetName(), processTime, results.count("error") > 0);
+                bool timedOut = result.IsTimedOut(i) || ruleTime[i] > rule->GetConfig().timeout;
+                UpdateMetrics(rule->GetName(), ruleTime[i], ruleError, timedOut,
+                              result.IsMatched(i) ? logs : 0);
+            }
+            if (!needMaps) {
+                continue;
             }
             
-            // 存储结果
-            if (config_.storeResults) {
-                if (redisStorage_) {
-                    StoreResultToRedis(record.id, results);
-                }
-                if (mysqlStorage_) {
-                    StoreResultToMySQL(record.id, results);
-                }
+            // 默认只存储命中和出错的规则
+            bool storeRule = store && (result.IsMatched(i) || ruleError || config_.storeUnmatched);
+            if (!storeRule && !mapCallback) {
+                continue;
+            }
+            
+            auto ruleResults = result.ToMap(i, rule->GetName(), rule->GetConfig().group);
+            
+            // 重复日志的汇总记录代表多条日志，结果带上条数，按次数统计的下游据此累加
+            if (repeat != record.fields.end()) {
+                ruleResults.emplace("repeat_count", repeat->second);
             }
             
             // 调用回调函数
-            {
+            if (mapCallback) {
                 std::lock_guard<std::mutex> lock(callbackMutex_);
                 if (analysisCallback_) {
-                    analysisCallback_(record.id, results);
+                    analysisCallback_(record.id, ruleResults);
                 }
             }
             
-            if (results.count("error") > 0) {
-                hasError = true;
+            if (storeRule) {
+                stored.rules.push_back({rule->GetName(), std::move(ruleResults)});
             }
         }
-    } catch (const std::exception& e) {
-        hasError = true;
-        std::cerr << "处理记录时发生错误: " << e.what() << std::endl;
+        if (hasError) {
+            ++errorRecords;
+        }
+        
+        // 一条记录的结果汇总后交给写入线程
+        if (!stored.rules.empty()) {
+            stored.recordId = record.id;
+            resultWriter_->Submit(std::move(stored));
+        }
+    }
+    
+    for (size_t i = 0; i < ruleCount; ++i) {
+        if (costNanos[i] > 0 || matchCount[i] > 0) {
+            snapshot->stats[i]->costNanos.fetch_add(costNanos[i], std::memory_order_relaxed);
+            snapshot->stats[i]->matches.fetch_add(matchCount[i], std::memory_order_relaxed);
+        }
     }
     
     // 更新总处理时间
@@ -438,24 +951,30 @@ void LogAnalyzer::ProcessRecord(const LogRecord& record) {
         auto endTime = std::chrono::steady_clock::now();
         auto totalTime = std::chrono::duration_cast<std::chrono::microseconds>(
             endTime - startTime);
+        metrics_.totalRecords += count;
+        metrics_.totalLogs += totalLogs;
         metrics_.totalProcessTime += totalTime.count();
-        
-        if (hasError) {
-            metrics_.errorRecords++;
-        }
+        metrics_.errorRecords += errorRecords;
     }
 }
 
 void LogAnalyzer::UpdateMetrics(const std::string& ruleName,
                               const std::chrono::microseconds& processTime,
-                              bool hasError) {
+                              bool hasError,
+                              bool timedOut,
+                              uint64_t hitLogs) {
     auto& ruleMetrics = metrics_.GetRuleMetrics(ruleName);
     ruleMetrics.processTime += processTime.count();
     ruleMetrics.matchCount++;
+    ruleMetrics.hitLogs += hitLogs;
     if (hasError) {
         ruleMetrics.errorCount++;
     }
+    if (timedOut) {
+        ruleMetrics.timeoutCount++;
+    }
     ruleMetrics.lastMatchTime = std::chrono::steady_clock::now();
+    ruleMetrics.latency.Record(static_cast<uint64_t>(processTime.count()));
 }
 
 const AnalyzerMetrics& LogAnalyzer::GetMetrics() const {
@@ -466,6 +985,74 @@ void LogAnalyzer::ResetMetrics() {
     metrics_.Reset();
 }
 
+void LogAnalyzer::WritePrometheusMetrics(common::PrometheusWriter& writer) const {
+    // 只在复制条目指针时持有锁
+    std::vector<std::pair<std::string, const RuleMetrics*>> rules;
+    {
+        std::lock_guard<std::mutex> lock(metrics_.metricsMutex);
+        for (const auto& [name, ruleMetrics] : metrics_.ruleMetrics) {
+            rules.emplace_back(name, &ruleMetrics);
+        }
+    }
+    std::sort(rules.begin(), rules.end());
+    
+    writer.Counter("xumj_analyzer_records_total", "分析的记录数",
+                   static_cast<double>(metrics_.totalRecords.load()));
+    writer.Counter("xumj_analyzer_logs_total", "分析的原始日志条数，重复日志的汇总记录按repeat_count计",
+                   static_cast<double>(metrics_.totalLogs.load()));
+    writer.Counter("xumj_analyzer_error_records_total", "分析出错的记录数",
+                   static_cast<double>(metrics_.errorRecords.load()));
+    for (const auto& [name, ruleMetrics] : rules) {
+        writer.Counter("xumj_analyzer_rule_calls_total", "各规则的调用次数",
+                       static_cast<double>(ruleMetrics->matchCount.load()), {{"rule", name}});
+    }
+    for (const auto& [name, ruleMetrics] : rules) {
+        writer.Counter("xumj_analyzer_rule_hits_total", "各规则命中的原始日志条数，重复日志的汇总记录按repeat_count计",
+                       static_cast<double>(ruleMetrics->hitLogs.load()), {{"rule", name}});
+    }
+    for (const auto& [name, ruleMetrics] : rules) {
+        writer.Counter("xumj_analyzer_rule_errors_total", "各规则返回错误的次数",
+                       static_cast<double>(ruleMetrics->errorCount.load()), {{"rule", name}});
+    }
+    for (const auto& [name, ruleMetrics] : rules) {
+        writer.Counter("xumj_analyzer_rule_timeouts_total", "各规则匹配被中止或耗时超过超时时间的次数",
+                       static_cast<double>(ruleMetrics->timeoutCount.load()), {{"rule", name}});
+    }
+    
+    if (resultWriter_) {
+        writer.Counter("xumj_analyzer_results_written_total", "写入存储的记录结果数",
+                       static_cast<double>(resultWriter_->GetWrittenCount()));
+        writer.Counter("xumj_analyzer_results_dropped_total", "写入队列满丢弃的记录结果数",
+                       static_cast<double>(resultWriter_->GetDroppedCount()));
+        writer.Counter("xumj_analyzer_results_failed_total", "写入存储失败的记录结果数",
+                       static_cast<double>(resultWriter_->GetFailedCount()));
+        writer.Counter("xumj_analyzer_result_flushes_total", "结果批量写入的次数",
+                       static_cast<double>(resultWriter_->GetFlushCount()));
+        writer.Counter("xumj_analyzer_results_trimmed_total", "超过MySQL列长度被丢弃字段的规则结果数",
+                       static_cast<double>(metrics_.trimmedResults.load()));
+    }
+    if (mysqlStorage_) {
+        writer.Counter("xumj_analyzer_results_skipped_total", "超过MySQL列长度未写入的规则结果数",
+                       static_cast<double>(mysqlStorage_->GetSkippedAnalysisResultCount()));
+    }
+    writer.Gauge("xumj_analyzer_pending_records", "等待分析的记录数",
+                 static_cast<double>(metrics_.pendingRecords.load()));
+    writer.Gauge("xumj_analyzer_pool_threads", "分析线程池的线程数",
+                 static_cast<double>(threadPool_ ? threadPool_->GetThreadCount() : 0));
+    writer.Gauge("xumj_analyzer_pool_pending_tasks", "分析线程池中等待执行的任务数",
+                 static_cast<double>(threadPool_ ? threadPool_->GetPendingTaskCount() : 0));
+    if (poolController_) {
+        poolController_->WritePrometheusMetrics(writer, "xumj_analyzer_pool");
+    }
+    writer.Gauge("xumj_analyzer_peak_memory_bytes", "分析线程观察到的进程常驻内存峰值",
+                 static_cast<double>(metrics_.peakMemoryUsage.load()));
+    
+    for (const auto& [name, ruleMetrics] : rules) {
+        writer.Histogram("xumj_analyzer_rule_latency_seconds", "单次规则分析的耗时",
+                         ruleMetrics->latency, {{"rule", name}});
+    }
+}
+
 std::vector<std::string> LogAnalyzer::GetRuleGroups() const {
     std::vector<std::string> groups;
     std::lock_guard<std::mutex> lock(rulesMutex_);
@@ -505,86 +1092,77 @@ void LogAnalyzer::DisableGroup(const std::string& group) {
     }
 }
 
-void LogAnalyzer::StoreResultToRedis(const std::string& recordId, 
-                                   const std::unordered_map<std::string, std::string>& results) {
-    try {
-        // 使用散列表存储分析结果
-        std::string key = "analysis_result:" + recordId;
-        
-        // 存储每个字段
-        for (const auto& [field, value] : results) {
-            redisStorage_->HashSet(key, field, value);
-        }
-        
-        // 设置过期时间（可根据需要调整）
-        redisStorage_->Expire(key, 86400);  // 24小时
-        
-        // 将ID添加到最近分析结果集
-        redisStorage_->SetAdd("recent_analysis_results", recordId);
-        
-    } catch (const storage::RedisStorageException& e) {
-        std::cerr << "存储分析结果到Redis失败: " << e.what() << std::endl;
+void LogAnalyzer::SetGroupShortCircuit(const std::string& group, bool enabled) {
+    std::lock_guard<std::mutex> lock(rulesMutex_);
+    if (enabled) {
+        shortCircuitGroups_.insert(group);
+    } else {
+        shortCircuitGroups_.erase(group);
     }
+    snapshot_.reset();
 }
 
-void LogAnalyzer::StoreResultToMySQL(const std::string& recordId,
-                                   const std::unordered_map<std::string, std::string>& results) {
-    try {
-        // 创建分析结果日志条目
-        storage::MySQLStorage::LogEntry entry;
-        entry.id = recordId;
-        
-        // 从结果中提取基本字段
-        if (results.count("record.timestamp")) {
-            entry.timestamp = results.at("record.timestamp");
-        } else {
-            // 使用当前时间作为备用
-            auto now = std::chrono::system_clock::now();
-            auto time_t_now = std::chrono::system_clock::to_time_t(now);
-            std::tm tm_now = *std::localtime(&time_t_now);
-            char buffer[30];
-            std::strftime(buffer, sizeof(buffer), "%Y-%m-%d %H:%M:%S", &tm_now);
-            entry.timestamp = buffer;
+bool LogAnalyzer::IsGroupShortCircuit(const std::string& group) const {
+    std::lock_guard<std::mutex> lock(rulesMutex_);
+    return shortCircuitGroups_.count(group) > 0;
+}
+
+size_t LogAnalyzer::WriteResults(const std::vector<StoredResult>& results) {
+    // 每条规则的结果序列化为一个JSON对象
+    std::vector<std::string> json;
+    for (const auto& result : results) {
+        for (const auto& rule : result.rules) {
+            json.push_back(DumpFields(nlohmann::json(rule.fields)));
         }
-        
-        if (results.count("record.level")) {
-            entry.level = results.at("record.level");
-        } else {
-            entry.level = "INFO";
+    }
+    
+    bool ok = true;
+    if (redisStorage_) {
+        // 每条记录一个散列表（字段为规则名称），所有命令在一次流水线中发送
+        std::vector<std::vector<std::string>> commands;
+        commands.reserve(results.size() * 2 + 1);
+        std::vector<std::string> recent{"SADD", "recent_analysis_results"};
+        size_t next = 0;
+        for (const auto& result : results) {
+            std::string key = "analysis_result:" + result.recordId;
+            std::vector<std::string> hset{"HSET", key};
+            for (const auto& rule : result.rules) {
+                hset.push_back(rule.rule);
+                hset.push_back(json[next++]);
+            }
+            commands.push_back(std::move(hset));
+            commands.push_back({"EXPIRE", std::move(key), "86400"});  // 24小时
+            recent.push_back(result.recordId);
         }
-        
-        if (results.count("record.source")) {
-            entry.source = results.at("record.source");
-        } else {
-            entry.source = "LogAnalyzer";
+        commands.push_back(std::move(recent));
+        try {
+            ok = redisStorage_->Pipeline(commands) == commands.size();
+        } catch (const storage::RedisStorageException& e) {
+            std::cerr << "存储分析结果到Redis失败: " << e.what() << std::endl;
+            ok = false;
         }
-        
-        // 构建消息（可根据需要自定义格式）
-        std::stringstream message;
-        message << "分析结果: ";
-        
-        bool firstItem = true;
-        for (const auto& [key, value] : results) {
-            if (key.compare(0, 7, "record.") != 0) {  // 排除基本字段
-                if (!firstItem) {
-                    message << ", ";
+    }
+    
+    if (mysqlStorage_) {
+        // 每条命中的规则一行，整批多行INSERT；规则没有单独的ID，以名称作为rule_id
+        std::vector<storage::MySQLStorage::AnalysisResult> rows;
+        rows.reserve(json.size());
+        size_t next = 0;
+        for (const auto& result : results) {
+            for (const auto& rule : result.rules) {
+                // result列有长度上限，超长时丢弃字段而不是截断JSON；Redis中保留完整结果
+                std::string& text = json[next++];
+                if (text.size() > storage::MySQLStorage::kMaxAnalysisResultBytes) {
+                    text = TrimFields(rule.fields, storage::MySQLStorage::kMaxAnalysisResultBytes);
+                    metrics_.trimmedResults++;
                 }
-                message << key << "=" << value;
-                firstItem = false;
+                rows.push_back({result.recordId, rule.rule, rule.rule, std::move(text)});
             }
-            
-            // 将所有分析结果作为字段存储
-            entry.fields[key] = value;
         }
-        
-        entry.message = message.str();
-        
-        // 保存到MySQL
-        mysqlStorage_->SaveLogEntry(entry);
-        
-    } catch (const storage::MySQLStorageException& e) {
-        std::cerr << "存储分析结果到MySQL失败: " << e.what() << std::endl;
+        ok = mysqlStorage_->SaveAnalysisResults(rows) == static_cast<int>(rows.size()) && ok;
     }
+    
+    return ok ? results.size() : 0;
 }
 
 } // namespace analyzer
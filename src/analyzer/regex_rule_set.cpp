@@ -0,0 +1,1119 @@
+#include "xumj/analyzer/regex_rule_set.h"
+#include <algorithm>
+#include <bitset>
+#include <cstring>
+#include <iterator>
+#include <map>
+#include <unordered_map>
+
+namespace xumj {
+namespace analyzer {
+
+namespace {
+
+struct StepLimitExceeded {};
+
+/*
+ * @brief 计步的输入迭代器，前进或后退超过步数限制时抛出StepLimitExceeded
+ *
+ * std::regex的匹配过程只通过迭代器访问输入，异常从regex_search中传出后匹配即中止。
+ */
+class CountingIterator {
+public:
+    using iterator_category = std::bidirectional_iterator_tag;
+    using value_type = char;
+    using difference_type = std::ptrdiff_t;
+    using pointer = const char*;
+    using reference = const char&;
+
+    struct Budget {
+        size_t steps;   // 剩余步数
+    };
+
+    CountingIterator() = default;
+    CountingIterator(const char* position, Budget* budget) : position_(position), budget_(budget) {}
+
+    reference operator*() const { return *position_; }
+    pointer operator->() const { return position_; }
+
+    CountingIterator& operator++() {
+        Step();
+        ++position_;
+        return *this;
+    }
+    CountingIterator operator++(int) {
+        CountingIterator old = *this;
+        ++*this;
+        return old;
+    }
+    CountingIterator& operator--() {
+        Step();
+        --position_;
+        return *this;
+    }
+    CountingIterator operator--(int) {
+        CountingIterator old = *this;
+        --*this;
+        return old;
+    }
+
+    bool operator==(const CountingIterator& other) const { return position_ == other.position_; }
+    bool operator!=(const CountingIterator& other) const { return position_ != other.position_; }
+
+    const char* Position() const { return position_; }
+
+private:
+    void Step() {
+        if (budget_->steps == 0) {
+            throw StepLimitExceeded{};
+        }
+        --budget_->steps;
+    }
+
+    const char* position_{nullptr};
+    Budget* budget_{nullptr};
+};
+
+} // namespace
+
+RegexSearchResult BoundedRegexSearch(std::string_view text, const std::regex& regex, size_t maxSteps,
+                                     std::vector<std::pair<size_t, size_t>>* groups) {
+    if (groups) {
+        groups->clear();
+    }
+    const char* begin = text.data();
+    const char* end = begin + text.size();
+    if (maxSteps == 0) {
+        if (!groups) {
+            return std::regex_search(begin, end, regex) ? RegexSearchResult::MATCH : RegexSearchResult::NO_MATCH;
+        }
+        std::cmatch match;
+        if (!std::regex_search(begin, end, match, regex)) {
+            return RegexSearchResult::NO_MATCH;
+        }
+        for (size_t i = 0; i < match.size(); ++i) {
+            groups->emplace_back(match[i].matched ? static_cast<size_t>(match[i].first - begin) : std::string_view::npos,
+                                 match[i].matched ? static_cast<size_t>(match[i].length()) : 0);
+        }
+        return RegexSearchResult::MATCH;
+    }
+
+    CountingIterator::Budget budget{maxSteps};
+    std::match_results<CountingIterator> match;
+    try {
+        if (!std::regex_search(CountingIterator(begin, &budget), CountingIterator(end, &budget), match, regex)) {
+            return RegexSearchResult::NO_MATCH;
+        }
+    } catch (const StepLimitExceeded&) {
+        return RegexSearchResult::ABORTED;
+    }
+    if (groups) {
+        for (size_t i = 0; i < match.size(); ++i) {
+            groups->emplace_back(
+                match[i].matched ? static_cast<size_t>(match[i].first.Position() - begin) : std::string_view::npos,
+                match[i].matched ? static_cast<size_t>(match[i].second.Position() - match[i].first.Position()) : 0);
+        }
+    }
+    return RegexSearchResult::MATCH;
+}
+
+/*
+ * @struct RegexNode
+ * @brief 模式语法树的节点
+ */
+struct RegexNode {
+    enum class Kind { EMPTY, SET, CONCAT, ALT, REPEAT, BEGIN, END };
+    Kind kind{Kind::EMPTY};
+    std::bitset<256> set;                               // SET：可匹配的字节
+    std::vector<std::shared_ptr<RegexNode>> children;   // CONCAT/ALT的子节点，REPEAT只有一个
+    uint32_t min{0};                                    // REPEAT：最少次数
+    uint32_t max{0};                                    // REPEAT：最多次数，UINT32_MAX表示不限
+};
+
+/*
+ * @struct RegexDfa
+ * @brief 一组模式合并编译的DFA，状态0为输入开头的状态
+ */
+struct RegexDfa {
+    std::vector<size_t> patterns;            // 组内位 -> 模式下标
+    uint8_t byteClass[256]{};                // 字节 -> 等价类
+    size_t classCount{0};
+    std::vector<uint32_t> transitions;       // 状态 * classCount + 类 -> 下一状态
+    std::vector<uint64_t> accept;            // 到达该状态时已匹配的模式
+    std::vector<uint64_t> endAccept;         // 输入在该状态结束时匹配的模式（含$）
+    uint64_t allMask{0};
+};
+
+namespace {
+
+using NodePtr = std::shared_ptr<RegexNode>;
+
+constexpr uint32_t kUnbounded = UINT32_MAX;
+constexpr uint32_t kMaxRepeat = 1000;        // {n,m}中允许的最大次数
+constexpr size_t kMaxNfaStates = 20000;      // 一组模式的NFA状态数上限
+
+template <typename Pred>
+std::bitset<256> MakeSet(Pred pred) {
+    std::bitset<256> set;
+    for (int c = 0; c < 256; ++c) {
+        if (pred(static_cast<unsigned char>(c))) {
+            set.set(static_cast<size_t>(c));
+        }
+    }
+    return set;
+}
+
+bool IsDigit(unsigned char c) { return c >= '0' && c <= '9'; }
+bool IsWord(unsigned char c) { return IsDigit(c) || (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_'; }
+bool IsSpace(unsigned char c) { return c == ' ' || c == '\t' || c == '\n' || c == '\v' || c == '\f' || c == '\r'; }
+int HexValue(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+NodePtr MakeNode(RegexNode::Kind kind) {
+    auto node = std::make_shared<RegexNode>();
+    node->kind = kind;
+    return node;
+}
+
+NodePtr MakeSetNode(const std::bitset<256>& set) {
+    auto node = MakeNode(RegexNode::Kind::SET);
+    node->set = set;
+    return node;
+}
+
+/*
+ * ECMAScript子集的递归下降解析；遇到不支持的语法时失败，由调用方改用std::regex
+ */
+class RegexParser {
+public:
+    explicit RegexParser(std::string_view text) : text_(text) {}
+
+    NodePtr Parse() {
+        NodePtr node = ParseAlternation();
+        if (!ok_ || pos_ != text_.size()) {
+            return nullptr;
+        }
+        return node;
+    }
+
+private:
+    bool AtEnd() const { return pos_ >= text_.size(); }
+    NodePtr Fail() {
+        ok_ = false;
+        return nullptr;
+    }
+
+    NodePtr ParseAlternation() {
+        std::vector<NodePtr> alternatives{ParseSequence()};
+        while (ok_ && !AtEnd() && text_[pos_] == '|') {
+            ++pos_;
+            alternatives.push_back(ParseSequence());
+        }
+        if (!ok_) {
+            return nullptr;
+        }
+        if (alternatives.size() == 1) {
+            return alternatives.front();
+        }
+        auto node = MakeNode(RegexNode::Kind::ALT);
+        node->children = std::move(alternatives);
+        return node;
+    }
+
+    NodePtr ParseSequence() {
+        auto node = MakeNode(RegexNode::Kind::CONCAT);
+        while (ok_ && !AtEnd() && text_[pos_] != '|' && text_[pos_] != ')') {
+            NodePtr atom = ParseAtom();
+            if (!ok_) {
+                return nullptr;
+            }
+            atom = ParseQuantifier(atom);
+            if (!ok_) {
+                return nullptr;
+            }
+            node->children.push_back(atom);
+        }
+        return node;
+    }
+
+    NodePtr ParseAtom() {
+        char c = text_[pos_++];
+        switch (c) {
+            case '(': {
+                if (!AtEnd() && text_[pos_] == '?') {
+                    // 只支持非捕获分组，零宽断言等改用std::regex
+                    if (pos_ + 1 >= text_.size() || text_[pos_ + 1] != ':') {
+                        return Fail();
+                    }
+                    pos_ += 2;
+                }
+                NodePtr inner = ParseAlternation();
+                if (!ok_ || AtEnd() || text_[pos_] != ')') {
+                    return Fail();
+                }
+                ++pos_;
+                return inner;
+            }
+            case '[':
+                return ParseClass();
+            case '.':
+                return MakeSetNode(MakeSet([](unsigned char ch) { return ch != '\n' && ch != '\r'; }));
+            case '^':
+                return MakeNode(RegexNode::Kind::BEGIN);
+            case '$':
+                return MakeNode(RegexNode::Kind::END);
+            case '\\': {
+                std::bitset<256> set;
+                if (!ParseEscape(false, set)) {
+                    return Fail();
+                }
+                return MakeSetNode(set);
+            }
+            case '*':
+            case '+':
+            case '?':
+            case '{':
+            case ')':
+                return Fail();
+            default: {
+                std::bitset<256> set;
+                set.set(static_cast<unsigned char>(c));
+                return MakeSetNode(set);
+            }
+        }
+    }
+
+    NodePtr ParseQuantifier(NodePtr atom) {
+        if (AtEnd()) {
+            return atom;
+        }
+        uint32_t min = 0;
+        uint32_t max = 0;
+        char c = text_[pos_];
+        if (c == '*') {
+            min = 0;
+            max = kUnbounded;
+            ++pos_;
+        } else if (c == '+') {
+            min = 1;
+            max = kUnbounded;
+            ++pos_;
+        } else if (c == '?') {
+            min = 0;
+            max = 1;
+            ++pos_;
+        } else if (c == '{') {
+            ++pos_;
+            if (!ParseCount(min)) {
+                return Fail();
+            }
+            max = min;
+            if (!AtEnd() && text_[pos_] == ',') {
+                ++pos_;
+                max = kUnbounded;
+                if (!AtEnd() && text_[pos_] != '}' && !ParseCount(max)) {
+                    return Fail();
+                }
+            }
+            if (AtEnd() || text_[pos_] != '}' || max < min) {
+                return Fail();
+            }
+            ++pos_;
+        } else {
+            return atom;
+        }
+        // 非贪婪写法只影响捕获位置，不影响是否匹配
+        if (!AtEnd() && text_[pos_] == '?') {
+            ++pos_;
+        }
+        if (atom->kind == RegexNode::Kind::BEGIN || atom->kind == RegexNode::Kind::END) {
+            return Fail();
+        }
+        auto node = MakeNode(RegexNode::Kind::REPEAT);
+        node->children.push_back(atom);
+        node->min = min;
+        node->max = max;
+        return node;
+    }
+
+    bool ParseCount(uint32_t& value) {
+        size_t begin = pos_;
+        value = 0;
+        while (!AtEnd() && IsDigit(static_cast<unsigned char>(text_[pos_]))) {
+            value = value * 10 + static_cast<uint32_t>(text_[pos_] - '0');
+            if (value > kMaxRepeat) {
+                return false;
+            }
+            ++pos_;
+        }
+        return pos_ > begin;
+    }
+
+    // 解析\之后的转义，结果并入set
+    bool ParseEscape(bool inClass, std::bitset<256>& set) {
+        if (AtEnd()) {
+            return false;
+        }
+        unsigned char c = static_cast<unsigned char>(text_[pos_++]);
+        switch (c) {
+            case 'd': set |= MakeSet(IsDigit); return true;
+            case 'D': set |= ~MakeSet(IsDigit); return true;
+            case 'w': set |= MakeSet(IsWord); return true;
+            case 'W': set |= ~MakeSet(IsWord); return true;
+            case 's': set |= MakeSet(IsSpace); return true;
+            case 'S': set |= ~MakeSet(IsSpace); return true;
+            case 't': set.set('\t'); return true;
+            case 'n': set.set('\n'); return true;
+            case 'r': set.set('\r'); return true;
+            case 'f': set.set('\f'); return true;
+            case 'v': set.set('\v'); return true;
+            case '0':
+                if (!AtEnd() && IsDigit(static_cast<unsigned char>(text_[pos_]))) {
+                    return false;
+                }
+                set.set(0);
+                return true;
+            case 'x': {
+                if (pos_ + 2 > text_.size()) {
+                    return false;
+                }
+                int high = HexValue(text_[pos_]);
+                int low = HexValue(text_[pos_ + 1]);
+                if (high < 0 || low < 0) {
+                    return false;
+                }
+                pos_ += 2;
+                set.set(static_cast<size_t>(high * 16 + low));
+                return true;
+            }
+            case 'b':
+                // 字符类中是退格，其他位置是单词边界（不支持）
+                if (!inClass) {
+                    return false;
+                }
+                set.set('\b');
+                return true;
+            default:
+                // 反向引用、\B、\c、\u等改用std::regex；其他符号按字面量处理
+                if (IsWord(c) || c >= 0x80) {
+                    return false;
+                }
+                set.set(c);
+                return true;
+        }
+    }
+
+    NodePtr ParseClass() {
+        bool negate = false;
+        if (!AtEnd() && text_[pos_] == '^') {
+            negate = true;
+            ++pos_;
+        }
+        if (!AtEnd() && text_[pos_] == ']') {
+            return Fail();   // ECMAScript的空字符类，很少使用
+        }
+        std::bitset<256> set;
+        while (!AtEnd() && text_[pos_] != ']') {
+            int low = -1;
+            if (!ParseClassItem(set, low)) {
+                return Fail();
+            }
+            // 范围a-z：两端都必须是单个字符，'-'在末尾时按字面量处理
+            if (low >= 0 && pos_ + 1 < text_.size() && text_[pos_] == '-' && text_[pos_ + 1] != ']') {
+                ++pos_;
+                std::bitset<256> ignored;
+                int high = -1;
+                if (!ParseClassItem(ignored, high) || high < low) {
+                    return Fail();
+                }
+                for (int b = low; b <= high; ++b) {
+                    set.set(static_cast<size_t>(b));
+                }
+            } else if (low >= 0) {
+                set.set(static_cast<size_t>(low));
+            }
+        }
+        if (AtEnd()) {
+            return Fail();
+        }
+        ++pos_;
+        return MakeSetNode(negate ? ~set : set);
+    }
+
+    // 单个字符写入single，字符集（\d等）并入set
+    bool ParseClassItem(std::bitset<256>& set, int& single) {
+        unsigned char c = static_cast<unsigned char>(text_[pos_++]);
+        if (c >= 0x80) {
+            return false;    // 多字节字符在std::regex中按字节比较，语义容易出错，不编译
+        }
+        if (c == '[' && !AtEnd() && (text_[pos_] == ':' || text_[pos_] == '.' || text_[pos_] == '=')) {
+            return false;
+        }
+        if (c != '\\') {
+            single = c;
+            return true;
+        }
+        std::bitset<256> escaped;
+        if (!ParseEscape(true, escaped)) {
+            return false;
+        }
+        if (escaped.count() == 1) {
+            for (int b = 0; b < 256; ++b) {
+                if (escaped.test(static_cast<size_t>(b))) {
+                    single = b;
+                }
+            }
+        } else {
+            set |= escaped;
+        }
+        return true;
+    }
+
+    std::string_view text_;
+    size_t pos_{0};
+    bool ok_{true};
+};
+
+// 必需字面量分析：exact表示节点只能匹配text这一个字符串，best是任何匹配都包含的最长字面量
+struct LiteralInfo {
+    bool exact{true};
+    std::string text;
+    std::string best;
+};
+
+const std::string& Longer(const std::string& a, const std::string& b) {
+    return b.size() > a.size() ? b : a;
+}
+
+LiteralInfo AnalyzeLiteral(const RegexNode& node) {
+    LiteralInfo info;
+    switch (node.kind) {
+        case RegexNode::Kind::EMPTY:
+        case RegexNode::Kind::BEGIN:
+        case RegexNode::Kind::END:
+            return info;
+        case RegexNode::Kind::SET:
+            if (node.set.count() != 1) {
+                info.exact = false;
+                return info;
+            }
+            for (size_t b = 0; b < 256; ++b) {
+                if (node.set.test(b)) {
+                    info.text.assign(1, static_cast<char>(b));
+                }
+            }
+            info.best = info.text;
+            return info;
+        case RegexNode::Kind::CONCAT: {
+            std::string run;
+            for (const auto& child : node.children) {
+                LiteralInfo sub = AnalyzeLiteral(*child);
+                if (sub.exact) {
+                    run += sub.text;
+                    if (info.exact) {
+                        info.text += sub.text;
+                    }
+                } else {
+                    info.exact = false;
+                    info.text.clear();
+                    info.best = Longer(Longer(info.best, run), sub.best);
+                    run.clear();
+                }
+            }
+            info.best = Longer(info.best, run);
+            return info;
+        }
+        case RegexNode::Kind::ALT: {
+            LiteralInfo first = AnalyzeLiteral(*node.children.front());
+            for (size_t i = 1; i < node.children.size() && first.exact; ++i) {
+                LiteralInfo sub = AnalyzeLiteral(*node.children[i]);
+                first.exact = sub.exact && sub.text == first.text;
+            }
+            if (!first.exact) {
+                info.exact = false;
+                return info;
+            }
+            return first;
+        }
+        case RegexNode::Kind::REPEAT: {
+            LiteralInfo sub = AnalyzeLiteral(*node.children.front());
+            if (node.max == 0) {
+                return info;
+            }
+            info.exact = false;
+            if (node.min == 0) {
+                return info;
+            }
+            if (sub.exact && node.min == node.max && sub.text.size() * node.min <= 256) {
+                info.exact = true;
+                for (uint32_t i = 0; i < node.min; ++i) {
+                    info.text += sub.text;
+                }
+                info.best = info.text;
+                return info;
+            }
+            info.best = sub.exact ? sub.text : sub.best;
+            return info;
+        }
+    }
+    return info;
+}
+
+// Thompson NFA
+struct NfaState {
+    enum class Type : uint8_t { CHAR, SPLIT, EPS, BEGIN, END, MATCH };
+    Type type{Type::EPS};
+    uint32_t out{0};
+    uint32_t out1{0};
+    uint32_t set{0};       // CHAR：字节集合下标
+    uint32_t bit{0};       // MATCH：组内位
+};
+
+class NfaBuilder {
+public:
+    std::vector<NfaState> states;
+    std::vector<std::bitset<256>> sets;
+    bool overflow{false};
+
+    // 编译一个模式，返回起始状态
+    uint32_t AddPattern(const RegexNode& node, uint32_t bit) {
+        Fragment fragment = Build(node);
+        uint32_t match = NewState(NfaState::Type::MATCH);
+        states[match].bit = bit;
+        Patch(fragment.holes, match);
+        return fragment.start;
+    }
+
+private:
+    // 未连接的出边：状态下标和出边（0为out，1为out1）
+    struct Fragment {
+        uint32_t start{0};
+        std::vector<std::pair<uint32_t, int>> holes;
+    };
+
+    uint32_t NewState(NfaState::Type type) {
+        if (states.size() >= kMaxNfaStates) {
+            overflow = true;
+        }
+        NfaState state;
+        state.type = type;
+        states.push_back(state);
+        return static_cast<uint32_t>(states.size() - 1);
+    }
+
+    void Patch(const std::vector<std::pair<uint32_t, int>>& holes, uint32_t target) {
+        for (const auto& [state, which] : holes) {
+            (which == 0 ? states[state].out : states[state].out1) = target;
+        }
+    }
+
+    Fragment Single(NfaState::Type type) {
+        uint32_t state = NewState(type);
+        return {state, {{state, 0}}};
+    }
+
+    Fragment Build(const RegexNode& node) {
+        if (overflow) {
+            return Single(NfaState::Type::EPS);
+        }
+        switch (node.kind) {
+            case RegexNode::Kind::EMPTY:
+                return Single(NfaState::Type::EPS);
+            case RegexNode::Kind::BEGIN:
+                return Single(NfaState::Type::BEGIN);
+            case RegexNode::Kind::END:
+                return Single(NfaState::Type::END);
+            case RegexNode::Kind::SET: {
+                Fragment fragment = Single(NfaState::Type::CHAR);
+                states[fragment.start].set = SetIndex(node.set);
+                return fragment;
+            }
+            case RegexNode::Kind::CONCAT: {
+                if (node.children.empty()) {
+                    return Single(NfaState::Type::EPS);
+                }
+                Fragment result = Build(*node.children.front());
+                for (size_t i = 1; i < node.children.size(); ++i) {
+                    Fragment next = Build(*node.children[i]);
+                    Patch(result.holes, next.start);
+                    result.holes = std::move(next.holes);
+                }
+                return result;
+            }
+            case RegexNode::Kind::ALT: {
+                // 最后一个分支直接作为前一个SPLIT的out1
+                Fragment result = Build(*node.children.back());
+                for (size_t i = node.children.size() - 1; i-- > 0;) {
+                    Fragment branch = Build(*node.children[i]);
+                    uint32_t split = NewState(NfaState::Type::SPLIT);
+                    states[split].out = branch.start;
+                    states[split].out1 = result.start;
+                    branch.holes.insert(branch.holes.end(), result.holes.begin(), result.holes.end());
+                    result = {split, std::move(branch.holes)};
+                }
+                return result;
+            }
+            case RegexNode::Kind::REPEAT:
+                return BuildRepeat(node);
+        }
+        return Single(NfaState::Type::EPS);
+    }
+
+    Fragment BuildRepeat(const RegexNode& node) {
+        const RegexNode& child = *node.children.front();
+        Fragment result = Single(NfaState::Type::EPS);
+        auto append = [&](Fragment next) {
+            Patch(result.holes, next.start);
+            result.holes = std::move(next.holes);
+        };
+        for (uint32_t i = 0; i < node.min && !overflow; ++i) {
+            append(Build(child));
+        }
+        if (node.max == kUnbounded) {
+            Fragment body = Build(child);
+            uint32_t split = NewState(NfaState::Type::SPLIT);
+            states[split].out = body.start;
+            Patch(body.holes, split);
+            append({split, {{split, 1}}});
+        } else {
+            for (uint32_t i = node.min; i < node.max && !overflow; ++i) {
+                Fragment body = Build(child);
+                uint32_t split = NewState(NfaState::Type::SPLIT);
+                states[split].out = body.start;
+                body.holes.emplace_back(split, 1);
+                append({split, std::move(body.holes)});
+            }
+        }
+        return result;
+    }
+
+    uint32_t SetIndex(const std::bitset<256>& set) {
+        for (size_t i = 0; i < sets.size(); ++i) {
+            if (sets[i] == set) {
+                return static_cast<uint32_t>(i);
+            }
+        }
+        sets.push_back(set);
+        return static_cast<uint32_t>(sets.size() - 1);
+    }
+};
+
+// 子集构造
+struct StateSetHash {
+    size_t operator()(const std::vector<uint32_t>& set) const {
+        uint64_t hash = 1469598103934665603ull;
+        for (uint32_t state : set) {
+            hash = (hash ^ state) * 1099511628211ull;
+        }
+        return static_cast<size_t>(hash);
+    }
+};
+
+class DfaBuilder {
+public:
+    DfaBuilder(const NfaBuilder& nfa, const std::vector<uint32_t>& starts, size_t maxStates)
+        : nfa_(nfa), starts_(starts), maxStates_(maxStates), marks_(nfa.states.size(), 0) {}
+
+    bool Build(RegexDfa& dfa) {
+        ComputeClasses(dfa);
+
+        // 非开头位置每一步都重新加入所有模式的起点，所以除初始状态外每个DFA状态都包含起点的闭包。
+        // 状态集合只记录闭包以外的部分，起点的闭包和它的转移只计算一次
+        Closure(starts_, false, false, startClosure_);
+        inStart_.assign(nfa_.states.size(), 0);
+        for (uint32_t state : startClosure_) {
+            inStart_[state] = 1;
+        }
+        std::vector<std::vector<uint32_t>> startMoves(dfa.classCount);
+        Moves(startClosure_, startMoves);
+
+        std::vector<uint32_t> set;
+        Closure(starts_, true, false, set);
+        set.erase(std::remove_if(set.begin(), set.end(), [this](uint32_t state) { return inStart_[state] != 0; }),
+                  set.end());
+        set.push_back(kBolTag);
+        Intern(set);
+
+        std::vector<std::vector<uint32_t>> moves(dfa.classCount);
+        std::vector<uint32_t> current;
+        for (size_t index = 0; index < sets_.size(); ++index) {
+            current = sets_[index];   // Intern会追加sets_
+            for (size_t cls = 0; cls < dfa.classCount; ++cls) {
+                moves[cls].assign(startMoves[cls].begin(), startMoves[cls].end());
+            }
+            Moves(current, moves);
+            for (size_t cls = 0; cls < dfa.classCount; ++cls) {
+                Closure(moves[cls], false, false, set, true);
+                int next = Intern(set);
+                if (next < 0) {
+                    return false;
+                }
+                transitions_.push_back(static_cast<uint32_t>(next));
+            }
+        }
+
+        dfa.transitions = std::move(transitions_);
+        dfa.accept.clear();
+        dfa.endAccept.clear();
+        std::vector<uint32_t> ends;
+        for (const auto& states : sets_) {
+            bool bol = !states.empty() && states.back() == kBolTag;
+            uint64_t accept = 0;
+            ends.clear();
+            for (const auto* part : {&states, static_cast<const std::vector<uint32_t>*>(&startClosure_)}) {
+                for (uint32_t state : *part) {
+                    if (state == kBolTag) {
+                        continue;
+                    }
+                    if (nfa_.states[state].type == NfaState::Type::MATCH) {
+                        accept |= uint64_t{1} << nfa_.states[state].bit;
+                    } else if (nfa_.states[state].type == NfaState::Type::END) {
+                        ends.push_back(state);
+                    }
+                }
+            }
+            uint64_t endAccept = accept;
+            if (!ends.empty()) {
+                Closure(ends, bol, true, set);
+                for (uint32_t state : set) {
+                    if (nfa_.states[state].type == NfaState::Type::MATCH) {
+                        endAccept |= uint64_t{1} << nfa_.states[state].bit;
+                    }
+                }
+            }
+            dfa.accept.push_back(accept);
+            dfa.endAccept.push_back(endAccept);
+        }
+        return true;
+    }
+
+private:
+    static constexpr uint32_t kBolTag = UINT32_MAX;   // 标记输入开头的状态
+
+    // 把states中CHAR状态的转移目标按等价类追加到moves
+    void Moves(const std::vector<uint32_t>& states, std::vector<std::vector<uint32_t>>& moves) const {
+        for (uint32_t state : states) {
+            if (state != kBolTag && nfa_.states[state].type == NfaState::Type::CHAR) {
+                for (uint32_t cls : setClasses_[nfa_.states[state].set]) {
+                    moves[cls].push_back(nfa_.states[state].out);
+                }
+            }
+        }
+    }
+
+    // 按所有字符集把256个字节划分为等价类
+    void ComputeClasses(RegexDfa& dfa) {
+        std::vector<uint32_t> classOf(256, 0);
+        uint32_t count = 1;
+        for (const auto& set : nfa_.sets) {
+            std::map<std::pair<uint32_t, bool>, uint32_t> split;
+            uint32_t next = 0;
+            for (size_t b = 0; b < 256; ++b) {
+                auto key = std::make_pair(classOf[b], set.test(b));
+                auto it = split.find(key);
+                if (it == split.end()) {
+                    it = split.emplace(key, next++).first;
+                }
+                classOf[b] = it->second;
+            }
+            count = next;
+        }
+        dfa.classCount = count;
+        std::vector<size_t> representative(count, 0);
+        for (size_t b = 256; b-- > 0;) {
+            dfa.byteClass[b] = static_cast<uint8_t>(classOf[b]);
+            representative[classOf[b]] = b;
+        }
+
+        // 每个字符集包含的等价类，构造时每个NFA状态只遍历它能接受的类
+        setClasses_.assign(nfa_.sets.size(), {});
+        for (size_t i = 0; i < nfa_.sets.size(); ++i) {
+            for (uint32_t cls = 0; cls < count; ++cls) {
+                if (nfa_.sets[i].test(representative[cls])) {
+                    setClasses_[i].push_back(cls);
+                }
+            }
+        }
+    }
+
+    // ε闭包：保留CHAR、MATCH和未满足的END状态，结果排序；excludeStart时不含起点闭包中的状态
+    void Closure(const std::vector<uint32_t>& seeds, bool bol, bool eol, std::vector<uint32_t>& out,
+                 bool excludeStart = false) {
+        ++generation_;
+        out.clear();
+        stack_.assign(seeds.begin(), seeds.end());
+        while (!stack_.empty()) {
+            uint32_t state = stack_.back();
+            stack_.pop_back();
+            if (marks_[state] == generation_ || (excludeStart && inStart_[state])) {
+                continue;
+            }
+            marks_[state] = generation_;
+            const NfaState& s = nfa_.states[state];
+            switch (s.type) {
+                case NfaState::Type::CHAR:
+                case NfaState::Type::MATCH:
+                    out.push_back(state);
+                    break;
+                case NfaState::Type::SPLIT:
+                    stack_.push_back(s.out1);
+                    stack_.push_back(s.out);
+                    break;
+                case NfaState::Type::EPS:
+                    stack_.push_back(s.out);
+                    break;
+                case NfaState::Type::BEGIN:
+                    if (bol) {
+                        stack_.push_back(s.out);
+                    }
+                    break;
+                case NfaState::Type::END:
+                    if (eol) {
+                        stack_.push_back(s.out);
+                    } else {
+                        out.push_back(state);
+                    }
+                    break;
+            }
+        }
+        std::sort(out.begin(), out.end());
+    }
+
+    int Intern(const std::vector<uint32_t>& set) {
+        auto it = index_.find(set);
+        if (it != index_.end()) {
+            return it->second;
+        }
+        if (sets_.size() >= maxStates_) {
+            return -1;
+        }
+        int id = static_cast<int>(sets_.size());
+        index_.emplace(set, id);
+        sets_.push_back(set);
+        return id;
+    }
+
+    const NfaBuilder& nfa_;
+    const std::vector<uint32_t>& starts_;
+    size_t maxStates_;
+    std::vector<std::vector<uint32_t>> setClasses_;
+    std::vector<uint32_t> startClosure_;
+    std::vector<uint8_t> inStart_;
+    std::vector<uint32_t> marks_;
+    uint32_t generation_{0};
+    std::vector<uint32_t> stack_;
+    std::unordered_map<std::vector<uint32_t>, int, StateSetHash> index_;
+    std::vector<std::vector<uint32_t>> sets_;
+    std::vector<uint32_t> transitions_;
+};
+
+} // namespace
+
+RegexRuleSet::RegexRuleSet(size_t maxStates) : maxStates_(maxStates) {
+}
+
+RegexRuleSet::~RegexRuleSet() = default;
+RegexRuleSet::RegexRuleSet(RegexRuleSet&&) noexcept = default;
+RegexRuleSet& RegexRuleSet::operator=(RegexRuleSet&&) noexcept = default;
+
+bool RegexRuleSet::IsSupported(const std::string& pattern, std::string* literal) {
+    NodePtr ast = RegexParser(pattern).Parse();
+    if (ast && literal) {
+        *literal = AnalyzeLiteral(*ast).best;
+    }
+    return ast != nullptr;
+}
+
+int RegexRuleSet::Add(const std::string& pattern, size_t maxSteps) {
+    Pattern entry;
+    entry.maxSteps = maxSteps;
+    try {
+        entry.regex = std::make_unique<std::regex>(pattern);
+    } catch (const std::regex_error&) {
+        return -1;
+    }
+    entry.text = pattern;
+    entry.ast = RegexParser(pattern).Parse();
+    if (entry.ast) {
+        LiteralInfo info = AnalyzeLiteral(*entry.ast);
+        entry.literal = info.exact ? info.text : info.best;
+    }
+    patterns_.push_back(std::move(entry));
+    return static_cast<int>(patterns_.size() - 1);
+}
+
+std::vector<size_t> RegexRuleSet::BuildGroups(const std::vector<size_t>& members) {
+    if (members.empty()) {
+        return {};
+    }
+    if (members.size() > kGroupWidth) {
+        std::vector<size_t> failed;
+        for (size_t begin = 0; begin < members.size(); begin += kGroupWidth) {
+            size_t end = std::min(begin + kGroupWidth, members.size());
+            auto rest = BuildGroups(std::vector<size_t>(members.begin() + static_cast<std::ptrdiff_t>(begin),
+                                                        members.begin() + static_cast<std::ptrdiff_t>(end)));
+            failed.insert(failed.end(), rest.begin(), rest.end());
+        }
+        return failed;
+    }
+
+    NfaBuilder nfa;
+    std::vector<uint32_t> starts;
+    for (size_t bit = 0; bit < members.size(); ++bit) {
+        starts.push_back(nfa.AddPattern(*patterns_[members[bit]].ast, static_cast<uint32_t>(bit)));
+    }
+    auto dfa = std::make_unique<RegexDfa>();
+    if (!nfa.overflow && DfaBuilder(nfa, starts, maxStates_).Build(*dfa)) {
+        dfa->patterns = members;
+        dfa->allMask = members.size() == 64 ? ~uint64_t{0} : (uint64_t{1} << members.size()) - 1;
+        for (size_t pattern : members) {
+            patterns_[pattern].group = static_cast<int>(groups_.size());
+        }
+        groups_.push_back(std::move(dfa));
+        return {};
+    }
+
+    // 状态数超过上限：拆成两半分别编译，单个模式也超限时改用std::regex
+    if (members.size() == 1) {
+        return members;
+    }
+    size_t half = members.size() / 2;
+    auto failed = BuildGroups(std::vector<size_t>(members.begin(), members.begin() + static_cast<std::ptrdiff_t>(half)));
+    auto rest = BuildGroups(std::vector<size_t>(members.begin() + static_cast<std::ptrdiff_t>(half), members.end()));
+    failed.insert(failed.end(), rest.begin(), rest.end());
+    return failed;
+}
+
+void RegexRuleSet::Compile() {
+    groups_.clear();
+    fallback_.clear();
+    std::vector<size_t> supported;
+    for (size_t i = 0; i < patterns_.size(); ++i) {
+        patterns_[i].group = -1;
+        if (patterns_[i].ast) {
+            supported.push_back(i);
+        } else {
+            fallback_.push_back(i);
+        }
+    }
+    auto failed = BuildGroups(supported);
+    fallback_.insert(fallback_.end(), failed.begin(), failed.end());
+    std::sort(fallback_.begin(), fallback_.end());
+
+    literalsByByte_.assign(256, {});
+    unfiltered_.clear();
+    for (size_t i = 0; i < patterns_.size(); ++i) {
+        const std::string& literal = patterns_[i].literal;
+        if (literal.empty()) {
+            unfiltered_.push_back(i);
+        } else {
+            literalsByByte_[static_cast<unsigned char>(literal[0])].push_back(static_cast<uint32_t>(i));
+        }
+    }
+}
+
+size_t RegexRuleSet::Match(std::string_view text, std::vector<uint8_t>& matched) const {
+    matched.assign(patterns_.size(), 0);
+    if (patterns_.empty() || literalsByByte_.empty()) {
+        return 0;
+    }
+
+    // 必需字面量预过滤：一遍扫描，按首字节找到可能出现的字面量再逐个比较
+    thread_local std::vector<uint8_t> candidate;
+    candidate.assign(patterns_.size(), 0);
+    for (size_t pattern : unfiltered_) {
+        candidate[pattern] = 1;
+    }
+    const size_t length = text.size();
+    for (size_t i = 0; i < length; ++i) {
+        const auto& bucket = literalsByByte_[static_cast<unsigned char>(text[i])];
+        for (uint32_t pattern : bucket) {
+            const std::string& literal = patterns_[pattern].literal;
+            if (!candidate[pattern] && literal.size() <= length - i &&
+                std::memcmp(text.data() + i, literal.data(), literal.size()) == 0) {
+                candidate[pattern] = 1;
+            }
+        }
+    }
+
+    size_t count = 0;
+    const auto* bytes = reinterpret_cast<const unsigned char*>(text.data());
+    for (const auto& group : groups_) {
+        bool any = false;
+        for (size_t pattern : group->patterns) {
+            any = any || candidate[pattern];
+        }
+        if (!any) {
+            continue;
+        }
+
+        // 每个字节一次查表，累计经过的状态已匹配的模式
+        const uint32_t* transitions = group->transitions.data();
+        const uint64_t* accept = group->accept.data();
+        const size_t classes = group->classCount;
+        uint32_t state = 0;
+        uint64_t found = accept[0];
+        for (size_t i = 0; i < length && found != group->allMask; ++i) {
+            state = transitions[state * classes + group->byteClass[bytes[i]]];
+            found |= accept[state];
+        }
+        found |= group->endAccept[state];
+
+        for (size_t bit = 0; bit < group->patterns.size(); ++bit) {
+            size_t pattern = group->patterns[bit];
+            if ((found >> bit & 1) && candidate[pattern]) {
+                matched[pattern] = 1;
+                ++count;
+            }
+        }
+    }
+
+    for (size_t pattern : fallback_) {
+        if (!candidate[pattern]) {
+            continue;
+        }
+        switch (BoundedRegexSearch(text, *patterns_[pattern].regex, patterns_[pattern].maxSteps)) {
+            case RegexSearchResult::MATCH:
+                matched[pattern] = 1;
+                ++count;
+                break;
+            case RegexSearchResult::ABORTED:
+                matched[pattern] = kAborted;
+                break;
+            case RegexSearchResult::NO_MATCH:
+                break;
+        }
+    }
+    return count;
+}
+
+bool RegexRuleSet::IsAccelerated(size_t pattern) const {
+    return patterns_[pattern].group >= 0;
+}
+
+const std::string& RegexRuleSet::GetRequiredLiteral(size_t pattern) const {
+    return patterns_[pattern].literal;
+}
+
+size_t RegexRuleSet::GetGroupCount() const {
+    return groups_.size();
+}
+
+size_t RegexRuleSet::GetStateCount() const {
+    size_t states = 0;
+    for (const auto& group : groups_) {
+        states += group->accept.size();
+    }
+    return states;
+}
+
+size_t RegexRuleSet::GetFallbackCount() const {
+    return fallback_.size();
+}
+
+} // namespace analyzer
+} // namespace xumj
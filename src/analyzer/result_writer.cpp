@@ -0,0 +1,108 @@
+#include "xumj/analyzer/result_writer.h"
+#include <algorithm>
+#include <iostream>
+#include <iterator>
+#include <utility>
+
+namespace xumj {
+namespace analyzer {
+
+ResultWriter::ResultWriter(Writer writer, size_t flushSize, std::chrono::milliseconds flushInterval, size_t capacity)
+    : writer_(std::move(writer)),
+      flushSize_(flushSize == 0 ? 1 : flushSize),
+      flushInterval_(flushInterval),
+      capacity_(capacity) {}
+
+ResultWriter::~ResultWriter() {
+    Stop();
+}
+
+void ResultWriter::Start() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (running_) {
+        return;
+    }
+    running_ = true;
+    thread_ = std::thread(&ResultWriter::Run, this);
+}
+
+void ResultWriter::Stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!running_) {
+            return;
+        }
+        running_ = false;
+    }
+    cv_.notify_one();
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+}
+
+bool ResultWriter::Submit(StoredResult result) {
+    bool wake = false;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!running_ || pending_.size() >= capacity_) {
+            dropped_.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        if (pending_.empty()) {
+            oldest_ = std::chrono::steady_clock::now();
+        }
+        pending_.push_back(std::move(result));
+        // 第一条结果开始计时，满一批时立即写入；其余提交不唤醒写入线程
+        wake = pending_.size() == 1 || pending_.size() == flushSize_;
+    }
+    if (wake) {
+        cv_.notify_one();
+    }
+    return true;
+}
+
+void ResultWriter::Run() {
+    std::vector<StoredResult> taken;
+    std::vector<StoredResult> batch;
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            cv_.wait(lock, [this] { return !running_ || !pending_.empty(); });
+            if (running_ && pending_.size() < flushSize_) {
+                cv_.wait_until(lock, oldest_ + flushInterval_,
+                               [this] { return !running_ || pending_.size() >= flushSize_; });
+            }
+            if (pending_.empty()) {
+                return;   // 已停止且队列已写完
+            }
+            // 整段换出，写入期间提交方不受影响
+            taken.swap(pending_);
+        }
+
+        // 超过flushSize时按flushSize分批写入，剩余的结果已经等待过，紧接着写出
+        for (size_t begin = 0; begin < taken.size(); begin += flushSize_) {
+            size_t end = std::min(begin + flushSize_, taken.size());
+            if (begin == 0 && end == taken.size()) {
+                batch.swap(taken);
+            } else {
+                batch.assign(std::make_move_iterator(taken.begin() + static_cast<std::ptrdiff_t>(begin)),
+                             std::make_move_iterator(taken.begin() + static_cast<std::ptrdiff_t>(end)));
+            }
+            
+            size_t written = 0;
+            try {
+                written = writer_ ? writer_(batch) : 0;
+            } catch (const std::exception& e) {
+                std::cerr << "分析结果写入异常: " << e.what() << std::endl;
+            }
+            flushes_.fetch_add(1, std::memory_order_relaxed);
+            written_.fetch_add(written, std::memory_order_relaxed);
+            failed_.fetch_add(batch.size() - std::min(written, batch.size()), std::memory_order_relaxed);
+            batch.clear();
+        }
+        taken.clear();
+    }
+}
+
+} // namespace analyzer
+} // namespace xumj
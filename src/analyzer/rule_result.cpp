@@ -0,0 +1,94 @@
+#include "xumj/analyzer/rule_result.h"
+#include <algorithm>
+#include <cstring>
+
+namespace xumj {
+namespace analyzer {
+
+void RuleResult::Reset(size_t ruleCount) {
+    ruleCount_ = ruleCount;
+    matched_.assign((ruleCount + 63) / 64, 0);
+    verbatim_.assign((ruleCount + 63) / 64, 0);
+    timedOut_.assign((ruleCount + 63) / 64, 0);
+    fields_.clear();
+    block_ = 0;
+    used_ = 0;
+    arenaBytes_ = 0;
+}
+
+size_t RuleResult::GetMatchedCount() const {
+    size_t count = 0;
+    for (uint64_t word : matched_) {
+        count += static_cast<size_t>(__builtin_popcountll(word));
+    }
+    return count;
+}
+
+void RuleResult::SetTimedOut(size_t rule) {
+    timedOut_[rule >> 6] |= uint64_t{1} << (rule & 63);
+    SetVerbatim(rule);
+    AddField(rule, "error", "分析超时: 超出匹配步数限制");
+}
+
+std::string_view RuleResult::CopyString(std::string_view text) {
+    if (text.empty()) {
+        return {};
+    }
+    // 当前块放不下时使用后面足够大的块，没有时分配新块
+    while (block_ < blocks_.size() && blocks_[block_].size - used_ < text.size()) {
+        ++block_;
+        used_ = 0;
+    }
+    if (block_ == blocks_.size()) {
+        Block block;
+        block.size = std::max(kBlockSize, text.size());
+        block.data.reset(new char[block.size]);
+        blocks_.push_back(std::move(block));
+        used_ = 0;
+    }
+    char* target = blocks_[block_].data.get() + used_;
+    std::memcpy(target, text.data(), text.size());
+    used_ += text.size();
+    arenaBytes_ += text.size();
+    return std::string_view(target, text.size());
+}
+
+bool RuleResult::HasError(size_t rule) const {
+    if (!IsVerbatim(rule)) {
+        return false;
+    }
+    for (const auto& field : fields_) {
+        if (field.rule == rule && field.name == "error") {
+            return true;
+        }
+    }
+    return false;
+}
+
+std::unordered_map<std::string, std::string> RuleResult::ToMap(size_t rule, const std::string& name,
+                                                               const std::string& group) const {
+    std::unordered_map<std::string, std::string> results;
+    bool verbatim = IsVerbatim(rule);
+    bool matched = IsMatched(rule);
+    if (verbatim || matched) {
+        for (const auto& field : fields_) {
+            if (field.rule == rule) {
+                results[std::string(field.name)] = std::string(field.value);
+            }
+        }
+    }
+    if (verbatim) {
+        return results;
+    }
+    if (matched) {
+        results["matched"] = "true";
+        results["rule"] = name;
+    } else {
+        results["matched"] = "false";
+    }
+    results["group"] = group;
+    return results;
+}
+
+} // namespace analyzer
+} // namespace xumj
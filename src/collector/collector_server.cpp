@@ -13,6 +13,7 @@ using namespace xumj::collector;
 
 // 管理每个连接的采集器
 std::unordered_map<uint64_t, std::unique_ptr<LogCollector>> collectors;
+std::unordered_map<std::string, LogCollector*> collectorsByStream; // 流标识 -> 采集器，用于分发确认
 std::mutex collectorsMutex;
 TcpServer* g_server = nullptr; // 用于回调中推送日志
 
@@ -20,9 +21,8 @@ TcpServer* g_server = nullptr; // 用于回调中推送日志
 std::unique_ptr<TcpClient> g_processorClient;
 std::mutex g_processorClientMutex;
 
-// 日志推送回调
-void PushLogToClientAndProcessor(uint64_t connId, const std::vector<LogEntry>& entries) {
-    // 推送给QT客户端（原格式）
+// 推送给QT客户端（原格式）
+void PushLogToClient(uint64_t connId, const std::vector<LogEntry>& entries) {
     json arr_qt = json::array();
     for (const auto& entry : entries) {
         arr_qt.push_back({
@@ -31,24 +31,71 @@ void PushLogToClientAndProcessor(uint64_t connId, const std::vector<LogEntry>& e
             {"content", entry.GetContent()}
         });
     }
-    if (g_server && !arr_qt.empty()) g_server->Send(connId, arr_qt.dump() + "\n");
+    if (g_server && !arr_qt.empty()) g_server->Send(connId, SharedPayload(arr_qt.dump() + "\n"));
+}
 
-    // 推送给processor_server（processor期望格式）
+// 推送给processor_server：带流标识和序号的批次，processor存储后返回累计确认
+bool PushBatchToProcessor(const std::string& stream, uint64_t seq, uint64_t base, const std::vector<LogEntry>& entries) {
     std::lock_guard<std::mutex> lock(g_processorClientMutex);
-    if (g_processorClient && g_processorClient->IsConnected() && !entries.empty()) {
-        json arr_proc = json::array();
-        for (const auto& entry : entries) {
-            arr_proc.push_back({
-                {"timestamp", TimestampToString(entry.GetTimestamp())},
-                {"level", LogLevelToString(entry.GetLevel())},
-                {"message", entry.GetContent()},
-                {"source", "collector"}
-            });
+    if (!g_processorClient || !g_processorClient->IsConnected()) {
+        return false;
+    }
+    json arr_proc = json::array();
+    for (const auto& entry : entries) {
+        arr_proc.push_back({
+            {"timestamp", TimestampToString(entry.GetTimestamp())},
+            {"level", LogLevelToString(entry.GetLevel())},
+            {"message", entry.GetContent()},
+            {"source", "collector"}
+        });
+    }
+    json batch = {
+        {"type", "batch"},
+        {"stream", stream},
+        {"seq", seq},
+        {"base", base},
+        {"logs", std::move(arr_proc)}
+    };
+    return g_processorClient->Send(batch.dump());
+}
+
+// 处理processor返回的确认
+void OnProcessorMessage(const std::string& msg, muduo::Timestamp) {
+    auto j = json::parse(msg, nullptr, false);
+    if (!j.is_object() || j.value("type", "") != "ack") return;
+    std::string stream = j.value("stream", "");
+    uint64_t seq = j.value("seq", static_cast<uint64_t>(0));
+    std::lock_guard<std::mutex> lock(collectorsMutex);
+    auto it = collectorsByStream.find(stream);
+    if (it != collectorsByStream.end()) {
+        it->second->HandleAck(seq);
+    }
+}
+
+// 与processor断开后新批次只进入发送窗口；重新建立连接后按序号重传所有未确认的批次，之后恢复直接推送
+void OnProcessorConnection(bool connected) {
+    std::lock_guard<std::mutex> lock(collectorsMutex);
+    for (auto& [stream, collector] : collectorsByStream) {
+        if (!connected) {
+            collector->HandleDisconnect();
+            continue;
+        }
+        size_t count = collector->RetransmitUnacked();
+        if (count > 0) {
+            std::cout << "采集器 " << stream << " 重传未确认批次: " << count << std::endl;
         }
-        g_processorClient->Send(arr_proc.dump() + "\n");
     }
 }
 
+// 从映射表中移除采集器并关闭（调用方需持有collectorsMutex）
+void RemoveCollectorLocked(uint64_t connId) {
+    auto it = collectors.find(connId);
+    if (it == collectors.end()) return;
+    collectorsByStream.erase(it->second->GetStreamId());
+    it->second->Shutdown();
+    collectors.erase(it);
+}
+
 void OnMessage(uint64_t connId, const std::string& msg, muduo::Timestamp) {
     auto j = json::parse(msg, nullptr, false);
     if (!j.is_object()) return;
@@ -77,45 +124,50 @@ void OnMessage(uint64_t connId, const std::string& msg, muduo::Timestamp) {
         config.flushInterval = std::chrono::milliseconds(interval);
         config.minLevel = level;
         config.compressLogs = compress;
+        config.collectorId = "collector-" + std::to_string(connId);
+        config.enableAck = true;         // 只有processor确认存储后批次才出窗
+        config.maxInFlightBatches = 16;
         collector->Initialize(config);
         // 关键字过滤
         if (!keywords.empty()) {
             collector->AddFilter(std::make_shared<KeywordFilter>(keywords));
         }
-        // 设置推送回调（同时推送给QT和processor）
+        // 设置推送回调（同时推送给QT和processor，重传时只发给processor）
         collector->SetSendCallback([connId](size_t){ /* 统计可选 */ });
+        std::string stream = collector->GetStreamId();
+        collector->SetBatchPushCallback(
+            [connId, stream](uint64_t seq, uint64_t base, const std::vector<LogEntry>& entries, bool retransmit) {
+                if (!retransmit) PushLogToClient(connId, entries);
+                return PushBatchToProcessor(stream, seq, base, entries);
+            });
         collector->CollectFromFile(file, level, interval, maxLines);
         std::lock_guard<std::mutex> lock(collectorsMutex);
+        RemoveCollectorLocked(connId);
+        collectorsByStream[stream] = collector.get();
         collectors[connId] = std::move(collector);
-        // 在OnMessage中，启动采集前动态设置connId
-        RegisterLogPushCallback(PushLogToClientAndProcessor, connId);
     } else if (j["cmd"] == "stop") {
         std::lock_guard<std::mutex> lock(collectorsMutex);
-        if (collectors.count(connId)) {
-            collectors[connId]->Shutdown();
-            collectors.erase(connId);
-        }
+        RemoveCollectorLocked(connId);
     }
 }
 
 void OnConnection(uint64_t connId, const std::string&, bool connected) {
     if (!connected) {
         std::lock_guard<std::mutex> lock(collectorsMutex);
-        if (collectors.count(connId)) {
-            collectors[connId]->Shutdown();
-            collectors.erase(connId);
-        }
+        RemoveCollectorLocked(connId);
     }
 }
 
 int main() {
     // 新增：初始化TcpClient，连接到processor（假设127.0.0.1:9001）
     g_processorClient = std::make_unique<TcpClient>("CollectorToProcessor", "127.0.0.1", 9001);
+    g_processorClient->SetMessageCallback(OnProcessorMessage);
+    g_processorClient->SetConnectionCallback(OnProcessorConnection);
     g_processorClient->Connect();
-    // 注册日志推送回调
-    xumj::collector::RegisterLogPushCallback(PushLogToClientAndProcessor, 0); // connId后续在OnMessage中动态设置
     TcpServer server("CollectorServer", "127.0.0.1", 9000, 4);
     g_server = &server;
+    // QT客户端消费跟不上时丢弃新的推送，避免在服务端无限积压
+    server.SetSlowConsumerPolicy(SlowConsumerPolicy::DROP, 16 * 1024 * 1024);
     server.SetMessageCallback(OnMessage);
     server.SetConnectionCallback(OnConnection);
     server.Start();
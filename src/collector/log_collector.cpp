@@ -84,6 +84,22 @@ bool LogCollector::Initialize(const CollectorConfig& config) {
     // 保存配置
     config_ = config;
     
+    // 流标识带上启动时间，收集器重启后序号从1开始也不会被处理器当作重复批次
+    {
+        auto startMs = std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
+        std::lock_guard<std::mutex> lock(inFlightMutex_);
+        streamId_ = (config_.collectorId.empty() ? std::string("collector") : config_.collectorId) +
+                    "-" + std::to_string(startMs);
+        inFlight_.clear();
+        nextSeq_ = 1;
+        ackedSeq_ = 0;
+    }
+    {
+        std::lock_guard<std::mutex> sendLock(sendMutex_);
+        retransmitPending_ = false;
+    }
+    
     // 初始化内存池
     memoryPool_ = std::make_unique<common::MemoryPool>(
         sizeof(LogEntry), config_.memoryPoolSize);
@@ -165,6 +181,11 @@ void LogCollector::ClearFilters() {
 void LogCollector::Flush() {
     if (!isActive_) return;
     
+    // 确认投递模式下窗口已满时不出队，日志留在队列中等待确认
+    if (AckEnabled() && !WaitForWindow()) {
+        return;
+    }
+    
     std::vector<LogEntry> batch;
     batch.reserve(config_.batchSize);
     
@@ -188,6 +209,7 @@ void LogCollector::Flush() {
 void LogCollector::Shutdown() {
     // 设置状态为非活动
     isActive_ = false;
+    inFlightCv_.notify_all();
     
     // 等待刷新线程结束
     if (flushThread_.joinable()) {
@@ -216,6 +238,42 @@ void LogCollector::SetErrorCallback(std::function<void(const std::string&)> call
 }
 
 bool LogCollector::SendLogBatch(std::vector<LogEntry>& logs) {
+    if (AckEnabled()) {
+        // 批次先进入发送窗口再推送，收到确认之前一直保留，推送失败时等待重连后重传
+        std::lock_guard<std::mutex> sendLock(sendMutex_);
+        uint64_t seq = 0;
+        uint64_t base = 0;
+        {
+            std::lock_guard<std::mutex> lock(inFlightMutex_);
+            seq = nextSeq_++;
+            base = ackedSeq_;
+            inFlight_.emplace(seq, logs);
+        }
+        
+        // 还有批次等待重传时不直接推送，由重传按序号顺序发出
+        if (retransmitPending_) {
+            logs.clear();
+            return true;
+        }
+        
+        bool pushed = false;
+        try {
+            pushed = batchPushCallback_(seq, base, logs, false);
+        } catch (const std::exception& e) {
+            if (errorCallback_) {
+                errorCallback_(std::string("Failed to push batch: ") + e.what());
+            }
+        }
+        if (!pushed) {
+            retransmitPending_ = true;
+            if (errorCallback_) {
+                errorCallback_("Batch " + std::to_string(seq) + " not sent, will retransmit after reconnect");
+            }
+        }
+        logs.clear();
+        return true;
+    }
+    
     try {
         size_t log_size = logs.size();
         if (g_logPushCallback) g_logPushCallback(g_logPushConnId, logs);
@@ -234,6 +292,93 @@ bool LogCollector::SendLogBatch(std::vector<LogEntry>& logs) {
     }
 }
 
+void LogCollector::SetBatchPushCallback(BatchPushCallback callback) {
+    std::lock_guard<std::mutex> sendLock(sendMutex_);
+    batchPushCallback_ = std::move(callback);
+}
+
+bool LogCollector::WaitForWindow() {
+    std::unique_lock<std::mutex> lock(inFlightMutex_);
+    size_t window = std::max<size_t>(config_.maxInFlightBatches, 1);
+    return inFlightCv_.wait_for(lock, config_.flushInterval, [this, window]() {
+        return inFlight_.size() < window || !isActive_;
+    }) && isActive_;
+}
+
+void LogCollector::HandleAck(uint64_t ackedSeq) {
+    size_t ackedLogs = 0;
+    {
+        std::lock_guard<std::mutex> lock(inFlightMutex_);
+        if (ackedSeq <= ackedSeq_) {
+            return;  // 过期或重复的确认
+        }
+        // 累计确认：序号不大于ackedSeq的批次全部出窗
+        auto end = inFlight_.upper_bound(ackedSeq);
+        for (auto it = inFlight_.begin(); it != end; ++it) {
+            ackedLogs += it->second.size();
+        }
+        inFlight_.erase(inFlight_.begin(), end);
+        ackedSeq_ = ackedSeq;
+    }
+    inFlightCv_.notify_all();
+    
+    // 只有被确认的日志才算发送成功
+    if (sendCallback_ && ackedLogs > 0) {
+        sendCallback_(ackedLogs);
+    }
+}
+
+size_t LogCollector::RetransmitUnacked() {
+    if (!AckEnabled()) {
+        return 0;
+    }
+    
+    std::lock_guard<std::mutex> sendLock(sendMutex_);
+    std::vector<std::pair<uint64_t, std::vector<LogEntry>>> pending;
+    uint64_t base = 0;
+    {
+        std::lock_guard<std::mutex> lock(inFlightMutex_);
+        pending.assign(inFlight_.begin(), inFlight_.end());
+        base = ackedSeq_;
+    }
+    
+    // 按序号从小到大重传，处理器会丢弃已经存储过的批次；全部发出后新批次恢复直接推送
+    size_t count = 0;
+    for (const auto& [seq, logs] : pending) {
+        try {
+            if (!batchPushCallback_(seq, base, logs, true)) {
+                return count;  // 连接又断开了，等下一次重连
+            }
+            count++;
+        } catch (const std::exception& e) {
+            if (errorCallback_) {
+                errorCallback_(std::string("Failed to retransmit batch: ") + e.what());
+            }
+            return count;
+        }
+    }
+    retransmitPending_ = false;
+    return count;
+}
+
+void LogCollector::HandleDisconnect() {
+    if (!AckEnabled()) {
+        return;
+    }
+    std::lock_guard<std::mutex> sendLock(sendMutex_);
+    retransmitPending_ = true;
+}
+
+size_t LogCollector::GetInFlightBatchCount() const {
+    std::lock_guard<std::mutex> lock(inFlightMutex_);
+    return inFlight_.size();
+}
+
+uint64_t LogCollector::GetAckedSequence() const {
+    std::lock_guard<std::mutex> lock(inFlightMutex_);
+    return ackedSeq_;
+}
+
 void LogCollector::FlushThreadFunc() {
     while (isActive_) {
         // 定期刷新日志
@@ -0,0 +1,168 @@
+#include "xumj/common/concurrency_controller.h"
+#include <algorithm>
+#include <ctime>
+
+namespace xumj {
+namespace common {
+
+size_t ConcurrencyConfig::ResolvedMaxThreads() const {
+    size_t resolved = maxThreads;
+    if (resolved == 0) {
+        resolved = 2 * static_cast<size_t>(std::max(1u, std::thread::hardware_concurrency()));
+    }
+    return std::max(resolved, std::max<size_t>(minThreads, 1));
+}
+
+ConcurrencyController::ConcurrencyController(const ConcurrencyConfig& config, size_t initialThreads,
+                                             Sampler sampler, Applier applier)
+    : config_(config),
+      sampler_(std::move(sampler)),
+      applier_(std::move(applier)),
+      limit_(std::max<size_t>(initialThreads, 1)) {
+}
+
+ConcurrencyController::~ConcurrencyController() {
+    Stop();
+}
+
+void ConcurrencyController::Start() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (running_) {
+        return;
+    }
+    running_ = true;
+    hasLast_ = false;
+    thread_ = std::thread(&ConcurrencyController::ControlLoop, this);
+}
+
+void ConcurrencyController::Stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!running_) {
+            return;
+        }
+        running_ = false;
+    }
+    cv_.notify_all();
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+}
+
+void ConcurrencyController::ControlLoop() {
+    const double cores = static_cast<double>(std::max(1u, std::thread::hardware_concurrency()));
+    auto lastTime = std::chrono::steady_clock::now();
+    uint64_t lastCpu = ProcessCpuMicros();
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            if (cv_.wait_for(lock, config_.interval, [this] { return !running_; })) {
+                break;
+            }
+        }
+        auto now = std::chrono::steady_clock::now();
+        uint64_t cpu = ProcessCpuMicros();
+        auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(now - lastTime);
+        double wall = static_cast<double>(std::max<int64_t>(elapsed.count(), 1));
+        double cpuUtilization = static_cast<double>(cpu - lastCpu) / (wall * cores);
+        lastTime = now;
+        lastCpu = cpu;
+        Evaluate(sampler_(), cpuUtilization, elapsed);
+    }
+}
+
+size_t ConcurrencyController::Evaluate(const ConcurrencySample& sample, double cpuUtilization,
+                                       std::chrono::microseconds elapsed) {
+    size_t limit = limit_.load(std::memory_order_relaxed);
+    if (!hasLast_) {
+        hasLast_ = true;
+        last_ = sample;
+        return limit;
+    }
+
+    // 计数被重置时按0处理
+    uint64_t completed = sample.completed >= last_.completed ? sample.completed - last_.completed : 0;
+    uint64_t busy = sample.busyMicros >= last_.busyMicros ? sample.busyMicros - last_.busyMicros : 0;
+    last_ = sample;
+
+    // 单条处理时间沿用最近一次有完成的周期
+    if (completed > 0) {
+        serviceMicros_ = static_cast<double>(busy) / static_cast<double>(completed);
+    }
+    double wall = static_cast<double>(std::max<int64_t>(elapsed.count(), 1));
+    double utilization = std::min(1.0, static_cast<double>(busy) / (wall * static_cast<double>(limit)));
+    double queueDelay = serviceMicros_ * static_cast<double>(sample.queueDepth) / static_cast<double>(limit);
+    // 有积压但整个周期都没有完成，说明至少已经排队了一个周期
+    if (completed == 0 && sample.queueDepth > 0) {
+        queueDelay = std::max(queueDelay, wall);
+    }
+    queueDelayMicros_.store(static_cast<uint64_t>(queueDelay), std::memory_order_relaxed);
+    utilizationPermille_.store(static_cast<uint64_t>(utilization * 1000), std::memory_order_relaxed);
+    cpuPermille_.store(static_cast<uint64_t>(std::max(0.0, cpuUtilization) * 1000), std::memory_order_relaxed);
+
+    if (cooldown_ > 0) {
+        --cooldown_;
+        return limit;
+    }
+
+    size_t minThreads = std::max<size_t>(config_.minThreads, 1);
+    size_t maxThreads = config_.ResolvedMaxThreads();
+    double target = static_cast<double>(
+        std::chrono::duration_cast<std::chrono::microseconds>(config_.targetQueueDelay).count());
+    auto decreased = [&]() {
+        size_t scaled = static_cast<size_t>(static_cast<double>(limit) * config_.decreaseFactor);
+        return std::max(minThreads, std::min(limit - 1, scaled));
+    };
+
+    if (limit > maxThreads) {
+        Apply(maxThreads, decreases_);
+    } else if (limit < minThreads) {
+        Apply(minThreads, increases_);
+    } else if (cpuUtilization >= config_.maxCpuUtilization && limit > minThreads) {
+        // CPU已饱和，更多线程只会增加争用
+        Apply(decreased(), decreases_);
+    } else if (queueDelay > target && cpuUtilization < config_.maxCpuUtilization && limit < maxThreads) {
+        Apply(std::min(maxThreads, limit + std::max<size_t>(config_.increaseStep, 1)), increases_);
+    } else if (queueDelay <= target / 4 && utilization < config_.lowUtilization && limit > minThreads) {
+        Apply(decreased(), decreases_);
+    }
+    return limit_.load(std::memory_order_relaxed);
+}
+
+void ConcurrencyController::Apply(size_t limit, std::atomic<uint64_t>& counter) {
+    limit_.store(limit, std::memory_order_relaxed);
+    counter.fetch_add(1, std::memory_order_relaxed);
+    cooldown_ = config_.cooldownTicks;
+    if (applier_) {
+        applier_(limit);
+    }
+}
+
+void ConcurrencyController::WritePrometheusMetrics(PrometheusWriter& writer, const std::string& prefix) const {
+    writer.Gauge(prefix + "_limit", "自适应控制器当前设定的线程数",
+                 static_cast<double>(limit_.load(std::memory_order_relaxed)));
+    writer.Gauge(prefix + "_min", "自适应控制器允许的最少线程数",
+                 static_cast<double>(std::max<size_t>(config_.minThreads, 1)));
+    writer.Gauge(prefix + "_max", "自适应控制器允许的最多线程数",
+                 static_cast<double>(config_.ResolvedMaxThreads()));
+    const std::string adjustments = prefix + "_adjustments_total";
+    writer.Counter(adjustments, "自适应控制器调整线程数的次数",
+                   static_cast<double>(increases_.load(std::memory_order_relaxed)), {{"direction", "up"}});
+    writer.Counter(adjustments, "自适应控制器调整线程数的次数",
+                   static_cast<double>(decreases_.load(std::memory_order_relaxed)), {{"direction", "down"}});
+    writer.Gauge(prefix + "_queue_delay_seconds", "最近一个周期估计的排队时间",
+                 static_cast<double>(queueDelayMicros_.load(std::memory_order_relaxed)) / 1e6);
+    writer.Gauge(prefix + "_utilization", "最近一个周期线程的忙碌比例",
+                 static_cast<double>(utilizationPermille_.load(std::memory_order_relaxed)) / 1000);
+    writer.Gauge(prefix + "_cpu_utilization", "最近一个周期进程的CPU利用率（按核心数归一化）",
+                 static_cast<double>(cpuPermille_.load(std::memory_order_relaxed)) / 1000);
+}
+
+uint64_t ProcessCpuMicros() {
+    timespec ts{};
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+    return static_cast<uint64_t>(ts.tv_sec) * 1000000ull + static_cast<uint64_t>(ts.tv_nsec) / 1000;
+}
+
+} // namespace common
+} // namespace xumj
@@ -0,0 +1,154 @@
+#include "xumj/common/id_generator.h"
+#include <chrono>
+#include <functional>
+#include <iostream>
+#include <unistd.h>
+
+namespace xumj {
+namespace common {
+
+namespace {
+
+constexpr char kEncoding[] = "0123456789ABCDEFGHJKMNPQRSTVWXYZ";   // Crockford Base32
+constexpr uint64_t kMask48 = (1ull << 48) - 1;
+constexpr uint32_t kThreadSlots = 1u << 16;
+
+uint64_t NowMs() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count());
+}
+
+// 取出128位值中从bit位开始的5位
+uint32_t Extract5(const LogId& id, unsigned bit) {
+    uint64_t value;
+    if (bit >= 64) {
+        value = id.hi >> (bit - 64);
+    } else if (bit > 59) {
+        value = (id.lo >> bit) | (id.hi << (64 - bit));
+    } else {
+        value = id.lo >> bit;
+    }
+    return static_cast<uint32_t>(value & 0x1F);
+}
+
+int DecodeChar(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'z') c = static_cast<char>(c - 'a' + 'A');
+    // 兼容Crockford的易混字符
+    if (c == 'O') return 0;
+    if (c == 'I' || c == 'L') return 1;
+    for (int i = 10; i < 32; ++i) {
+        if (kEncoding[i] == c) return i;
+    }
+    return -1;
+}
+
+} // namespace
+
+// 线程内生成不需要同步；线程退出时把槽位和最后的状态还给生成器
+struct IdGenerator::ThreadState {
+    bool initialized{false};
+    SlotState state;
+
+    ~ThreadState() {
+        if (initialized) {
+            IdGenerator::Instance().ReleaseSlot(state);
+        }
+    }
+};
+
+IdGenerator& IdGenerator::Instance() {
+    // 不析构：进程退出时其他线程的ThreadState仍可能归还槽位
+    static IdGenerator* instance = new IdGenerator();
+    return *instance;
+}
+
+IdGenerator::IdGenerator() {
+    // 默认节点ID：主机名与进程号散列，同一台机器上的多个进程也能区分
+    char hostname[256] = {0};
+    ::gethostname(hostname, sizeof(hostname) - 1);
+    size_t hash = std::hash<std::string>()(hostname) ^ (static_cast<size_t>(::getpid()) * 0x9E3779B97F4A7C15ull);
+    nodeId_.store(static_cast<uint16_t>(hash ^ (hash >> 16) ^ (hash >> 32)), std::memory_order_relaxed);
+}
+
+IdGenerator::SlotState IdGenerator::AcquireSlot() {
+    std::lock_guard<std::mutex> lock(slotMutex_);
+    if (!freeSlots_.empty()) {
+        SlotState state = freeSlots_.back();
+        freeSlots_.pop_back();
+        return state;
+    }
+    SlotState state;
+    if (nextThreadSlot_ >= kThreadSlots) {
+        // 同时存活的线程超过65536个，只能共用槽位，ID不再保证唯一
+        std::cerr << "警告: ID生成器的线程槽位已用尽，槽位将被共用" << std::endl;
+    }
+    state.slot = static_cast<uint16_t>(nextThreadSlot_++ % kThreadSlots);
+    return state;
+}
+
+void IdGenerator::ReleaseSlot(const SlotState& state) {
+    std::lock_guard<std::mutex> lock(slotMutex_);
+    freeSlots_.push_back(state);
+}
+
+LogId IdGenerator::Next() {
+    thread_local ThreadState threadState;
+    SlotState& state = threadState.state;
+    if (!threadState.initialized) {
+        state = AcquireSlot();
+        threadState.initialized = true;
+    }
+
+    uint64_t ms = NowMs() & kMask48;
+    if (ms > state.lastMs) {
+        state.lastMs = ms;
+        state.counter = 0;
+    } else if (++state.counter > kMask48) {
+        // 同一毫秒内计数用尽或时钟回拨：借用下一毫秒，保持线程内递增
+        ++state.lastMs;
+        state.counter = 0;
+    }
+
+    LogId id;
+    id.hi = (state.lastMs << 16) | GetNodeId();
+    id.lo = (static_cast<uint64_t>(state.slot) << 48) | state.counter;
+    return id;
+}
+
+std::string IdGenerator::NextString() {
+    return Encode(Next());
+}
+
+void IdGenerator::Encode(const LogId& id, char* out) {
+    // 26个字符共130位，最高字符只使用低3位
+    for (size_t i = 0; i < kTextLength; ++i) {
+        out[i] = kEncoding[Extract5(id, static_cast<unsigned>((kTextLength - 1 - i) * 5))];
+    }
+}
+
+std::string IdGenerator::Encode(const LogId& id) {
+    std::string text(kTextLength, '0');
+    Encode(id, &text[0]);
+    return text;
+}
+
+bool IdGenerator::Decode(const std::string& text, LogId& id) {
+    if (text.size() != kTextLength) {
+        return false;
+    }
+    LogId result;
+    for (size_t i = 0; i < kTextLength; ++i) {
+        int value = DecodeChar(text[i]);
+        if (value < 0 || (i == 0 && value > 7)) {
+            return false;
+        }
+        result.hi = (result.hi << 5) | (result.lo >> 59);
+        result.lo = (result.lo << 5) | static_cast<uint64_t>(value);
+    }
+    id = result;
+    return true;
+}
+
+} // namespace common
+} // namespace xumj
@@ -0,0 +1,143 @@
+#include "xumj/common/prometheus_writer.h"
+#include <cmath>
+#include <cstdio>
+#include <unistd.h>
+
+namespace xumj {
+namespace common {
+
+namespace {
+
+// 整数值按整数输出，其余按最短可还原的精度输出
+void AppendNumber(std::string& out, double value) {
+    char buffer[32];
+    if (std::isnan(value)) {
+        out += "NaN";
+        return;
+    }
+    if (std::isinf(value)) {
+        out += value > 0 ? "+Inf" : "-Inf";
+        return;
+    }
+    if (value == std::floor(value) && std::fabs(value) < 9007199254740992.0) {
+        std::snprintf(buffer, sizeof(buffer), "%lld", static_cast<long long>(value));
+    } else {
+        std::snprintf(buffer, sizeof(buffer), "%.17g", value);
+    }
+    out += buffer;
+}
+
+// 标签值中的反斜杠、双引号和换行需要转义
+void AppendLabelValue(std::string& out, const std::string& value) {
+    for (char c : value) {
+        switch (c) {
+            case '\\': out += "\\\\"; break;
+            case '"': out += "\\\""; break;
+            case '\n': out += "\\n"; break;
+            default: out += c; break;
+        }
+    }
+}
+
+} // namespace
+
+void PrometheusWriter::Counter(const std::string& name, const std::string& help, double value,
+                               const Labels& labels) {
+    Family(name, help, "counter");
+    Sample(name, labels, nullptr, std::string(), value);
+}
+
+void PrometheusWriter::Gauge(const std::string& name, const std::string& help, double value,
+                             const Labels& labels) {
+    Family(name, help, "gauge");
+    Sample(name, labels, nullptr, std::string(), value);
+}
+
+void PrometheusWriter::Histogram(const std::string& name, const std::string& help,
+                                 const LatencyHistogram& histogram, const Labels& labels) {
+    Family(name, help, "histogram");
+    const auto& bounds = DefaultBounds();
+    uint64_t total = histogram.CumulativeCounts(bounds, counts_);
+    const std::string bucketName = name + "_bucket";
+    char le[32];
+    for (size_t i = 0; i < bounds.size(); ++i) {
+        std::snprintf(le, sizeof(le), "%g", static_cast<double>(bounds[i]) / 1e6);
+        Sample(bucketName, labels, "le", le, static_cast<double>(counts_[i]));
+    }
+    Sample(bucketName, labels, "le", "+Inf", static_cast<double>(total));
+    Sample(name + "_sum", labels, nullptr, std::string(), static_cast<double>(histogram.Sum()) / 1e6);
+    Sample(name + "_count", labels, nullptr, std::string(), static_cast<double>(total));
+}
+
+const std::vector<uint64_t>& PrometheusWriter::DefaultBounds() {
+    static const std::vector<uint64_t> bounds = {
+        10, 25, 50, 100, 250, 500, 1000, 2500, 5000, 10000, 25000, 50000,
+        100000, 250000, 500000, 1000000, 2500000, 5000000
+    };
+    return bounds;
+}
+
+void PrometheusWriter::Family(const std::string& name, const std::string& help, const char* type) {
+    if (!families_.insert(name).second) {
+        return;
+    }
+    text_ += "# HELP ";
+    text_ += name;
+    text_ += ' ';
+    text_ += help;
+    text_ += "\n# TYPE ";
+    text_ += name;
+    text_ += ' ';
+    text_ += type;
+    text_ += '\n';
+}
+
+void PrometheusWriter::Sample(const std::string& name, const Labels& labels, const char* extraName,
+                              const std::string& extraValue, double value) {
+    text_ += name;
+    if (!labels.empty() || extraName) {
+        text_ += '{';
+        bool first = true;
+        for (const auto& [key, labelValue] : labels) {
+            if (!first) {
+                text_ += ',';
+            }
+            first = false;
+            text_ += key;
+            text_ += "=\"";
+            AppendLabelValue(text_, labelValue);
+            text_ += '"';
+        }
+        if (extraName) {
+            if (!first) {
+                text_ += ',';
+            }
+            text_ += extraName;
+            text_ += "=\"";
+            text_ += extraValue;
+            text_ += '"';
+        }
+        text_ += '}';
+    }
+    text_ += ' ';
+    AppendNumber(text_, value);
+    text_ += '\n';
+}
+
+uint64_t ReadResidentMemoryBytes() {
+    FILE* file = std::fopen("/proc/self/statm", "r");
+    if (!file) {
+        return 0;
+    }
+    unsigned long long size = 0;
+    unsigned long long resident = 0;
+    int fields = std::fscanf(file, "%llu %llu", &size, &resident);
+    std::fclose(file);
+    if (fields != 2) {
+        return 0;
+    }
+    return static_cast<uint64_t>(resident) * static_cast<uint64_t>(sysconf(_SC_PAGESIZE));
+}
+
+} // namespace common
+} // namespace xumj
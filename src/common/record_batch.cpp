@@ -0,0 +1,343 @@
+#include "xumj/common/record_batch.h"
+#include <algorithm>
+#include <cstdio>
+
+namespace xumj {
+namespace common {
+
+namespace {
+
+constexpr int64_t kMsPerDay = 86400000;
+constexpr size_t kMaxRetainedSources = 4096;
+
+const char* const kLevelNames[] = {"TRACE", "DEBUG", "INFO", "WARN", "ERROR", "FATAL", ""};
+
+// 1970-01-01起的天数（公历，见Howard Hinnant的days_from_civil）
+int64_t DaysFromCivil(int64_t y, unsigned m, unsigned d) {
+    y -= m <= 2;
+    const int64_t era = (y >= 0 ? y : y - 399) / 400;
+    const unsigned yoe = static_cast<unsigned>(y - era * 400);
+    const unsigned doy = (153 * (m > 2 ? m - 3 : m + 9) + 2) / 5 + d - 1;
+    const unsigned doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return era * 146097 + static_cast<int64_t>(doe) - 719468;
+}
+
+void CivilFromDays(int64_t z, int64_t& y, unsigned& m, unsigned& d) {
+    z += 719468;
+    const int64_t era = (z >= 0 ? z : z - 146096) / 146097;
+    const unsigned doe = static_cast<unsigned>(z - era * 146097);
+    const unsigned yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    const unsigned doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    const unsigned mp = (5 * doy + 2) / 153;
+    d = doy - (153 * mp + 2) / 5 + 1;
+    m = mp < 10 ? mp + 3 : mp - 9;
+    y = static_cast<int64_t>(yoe) + era * 400 + (m <= 2);
+}
+
+// 读取固定位数的十进制数
+bool ReadDigits(std::string_view text, size_t pos, size_t count, unsigned& value) {
+    value = 0;
+    for (size_t i = pos; i < pos + count; ++i) {
+        unsigned digit = static_cast<unsigned>(text[i]) - '0';
+        if (digit > 9) {
+            return false;
+        }
+        value = value * 10 + digit;
+    }
+    return true;
+}
+
+bool EqualsIgnoreCase(std::string_view text, const char* upper) {
+    size_t i = 0;
+    for (; i < text.size() && upper[i] != '\0'; ++i) {
+        char c = text[i];
+        if (c >= 'a' && c <= 'z') {
+            c = static_cast<char>(c - 'a' + 'A');
+        }
+        if (c != upper[i]) {
+            return false;
+        }
+    }
+    return i == text.size() && upper[i] == '\0';
+}
+
+} // namespace
+
+void RecordBatch::Reserve(size_t rows, size_t bytes) {
+    idOffsets_.reserve(rows);
+    timestamps_.reserve(rows);
+    levels_.reserve(rows);
+    sourceIds_.reserve(rows);
+    messageOffsets_.reserve(rows);
+    messages_.reserve(bytes);
+    ids_.reserve(rows * 32);
+}
+
+void RecordBatch::Clear() {
+    ids_.clear();
+    idOffsets_.clear();
+    timestamps_.clear();
+    levels_.clear();
+    sourceIds_.clear();
+    messages_.clear();
+    messageOffsets_.clear();
+    // 来源字典和字段列名保留，下一批通常是同样的来源和字段；来源过多时才清空字典
+    if (sourceDictionary_.size() > kMaxRetainedSources) {
+        sourceDictionary_.clear();
+        sourceLookup_.clear();
+    }
+    // 这一批没有用到的字段列删除，字段名不断变化时列数不会无限增长
+    fields_.erase(std::remove_if(fields_.begin(), fields_.end(),
+                                 [](const FieldColumn& column) { return column.rows.empty(); }),
+                  fields_.end());
+    for (auto& column : fields_) {
+        column.rows.clear();
+        column.offsets.clear();
+        column.data.clear();
+    }
+}
+
+size_t RecordBatch::Append(std::string_view id, std::string_view timestamp, std::string_view level,
+                           std::string_view source, std::string_view message) {
+    int64_t timestampMs = ParseTimestamp(timestamp);
+    LogLevel parsedLevel = ParseLevel(level);
+    size_t row = Append(id, timestampMs, parsedLevel, source, message);
+    if (timestampMs == kNoTimestamp && !timestamp.empty()) {
+        SetField(kRawTimestamp, timestamp);
+    }
+    // 与标准名称写法不同（如小写、WARNING）时保留原文，读出的文本与写入的一致
+    if (!level.empty() && level != LevelName(parsedLevel)) {
+        SetField(kRawLevel, level);
+    }
+    return row;
+}
+
+size_t RecordBatch::Append(std::string_view id, int64_t timestampMs, LogLevel level,
+                           std::string_view source, std::string_view message) {
+    size_t row = timestamps_.size();
+    ids_.append(id.data(), id.size());
+    idOffsets_.push_back(static_cast<uint32_t>(ids_.size()));
+    timestamps_.push_back(timestampMs);
+    levels_.push_back(static_cast<uint8_t>(level));
+    sourceIds_.push_back(SourceId(source));
+    messages_.append(message.data(), message.size());
+    messageOffsets_.push_back(static_cast<uint32_t>(messages_.size()));
+    return row;
+}
+
+void RecordBatch::SetField(std::string_view name, std::string_view value) {
+    if (timestamps_.empty()) {
+        return;
+    }
+    uint32_t row = static_cast<uint32_t>(timestamps_.size() - 1);
+    FieldColumn& column = Column(name);
+    if (!column.rows.empty() && column.rows.back() == row) {
+        // 同一行重复设置，覆盖最后一个值
+        column.offsets.pop_back();
+        column.rows.pop_back();
+        column.data.resize(column.offsets.empty() ? 0 : column.offsets.back());
+    }
+    column.data.append(value.data(), value.size());
+    column.rows.push_back(row);
+    column.offsets.push_back(static_cast<uint32_t>(column.data.size()));
+}
+
+std::string RecordBatch::TimestampText(size_t row) const {
+    std::string text;
+    TimestampText(row, text);
+    return text;
+}
+
+void RecordBatch::TimestampText(size_t row, std::string& text) const {
+    if (timestamps_[row] != kNoTimestamp) {
+        FormatTimestamp(timestamps_[row], text);
+        return;
+    }
+    std::string_view raw;
+    if (Field(row, kRawTimestamp, raw)) {
+        text.assign(raw.data(), raw.size());
+    } else {
+        text.clear();
+    }
+}
+
+std::string_view RecordBatch::LevelText(size_t row) const {
+    std::string_view raw;
+    if (Field(row, kRawLevel, raw)) {
+        return raw;
+    }
+    return LevelName(Level(row));
+}
+
+bool RecordBatch::Field(size_t row, std::string_view name, std::string_view& value) const {
+    for (const auto& column : fields_) {
+        if (column.name == name) {
+            return column.Find(row, value);
+        }
+    }
+    return false;
+}
+
+bool RecordBatch::FieldColumn::Find(size_t row, std::string_view& value) const {
+    auto it = std::lower_bound(rows.begin(), rows.end(), static_cast<uint32_t>(row));
+    if (it == rows.end() || *it != row) {
+        return false;
+    }
+    size_t index = static_cast<size_t>(it - rows.begin());
+    uint32_t begin = index == 0 ? 0 : offsets[index - 1];
+    value = std::string_view(data.data() + begin, offsets[index] - begin);
+    return true;
+}
+
+// 过滤函数都是无分支写法：先写入行号，再按条件推进计数，便于编译器向量化
+size_t RecordBatch::SelectLevelAtLeast(LogLevel minLevel, std::vector<uint32_t>& selection) const {
+    const size_t rows = levels_.size();
+    const uint8_t min = static_cast<uint8_t>(minLevel);
+    selection.resize(rows);
+    size_t count = 0;
+    for (size_t i = 0; i < rows; ++i) {
+        selection[count] = static_cast<uint32_t>(i);
+        count += levels_[i] >= min;
+    }
+    selection.resize(count);
+    return count;
+}
+
+size_t RecordBatch::SelectTimeRange(int64_t begin, int64_t end, std::vector<uint32_t>& selection) const {
+    const size_t rows = timestamps_.size();
+    selection.resize(rows);
+    size_t count = 0;
+    for (size_t i = 0; i < rows; ++i) {
+        selection[count] = static_cast<uint32_t>(i);
+        count += (timestamps_[i] >= begin) & (timestamps_[i] < end);
+    }
+    selection.resize(count);
+    return count;
+}
+
+size_t RecordBatch::SelectSource(std::string_view source, std::vector<uint32_t>& selection) const {
+    auto it = sourceLookup_.find(std::string(source));
+    if (it == sourceLookup_.end()) {
+        selection.clear();
+        return 0;
+    }
+    const uint32_t id = it->second;
+    const size_t rows = sourceIds_.size();
+    selection.resize(rows);
+    size_t count = 0;
+    for (size_t i = 0; i < rows; ++i) {
+        selection[count] = static_cast<uint32_t>(i);
+        count += sourceIds_[i] == id;
+    }
+    selection.resize(count);
+    return count;
+}
+
+LogLevel RecordBatch::ParseLevel(std::string_view text) {
+    for (uint8_t i = 0; i < static_cast<uint8_t>(LogLevel::OTHER); ++i) {
+        if (EqualsIgnoreCase(text, kLevelNames[i])) {
+            return static_cast<LogLevel>(i);
+        }
+    }
+    if (EqualsIgnoreCase(text, "WARNING")) {
+        return LogLevel::WARN;
+    }
+    if (EqualsIgnoreCase(text, "CRITICAL")) {
+        return LogLevel::FATAL;
+    }
+    return LogLevel::OTHER;
+}
+
+const char* RecordBatch::LevelName(LogLevel level) {
+    return kLevelNames[static_cast<uint8_t>(level)];
+}
+
+int64_t RecordBatch::ParseTimestamp(std::string_view text) {
+    // 只接受能原样还原的格式：YYYY-MM-DD HH:MM:SS或YYYY-MM-DD HH:MM:SS.mmm
+    if (text.size() != 19 && text.size() != 23) {
+        return kNoTimestamp;
+    }
+    if (text[4] != '-' || text[7] != '-' || text[10] != ' ' || text[13] != ':' || text[16] != ':') {
+        return kNoTimestamp;
+    }
+    unsigned year, month, day, hour, minute, second, millis = 0;
+    if (!ReadDigits(text, 0, 4, year) || !ReadDigits(text, 5, 2, month) || !ReadDigits(text, 8, 2, day) ||
+        !ReadDigits(text, 11, 2, hour) || !ReadDigits(text, 14, 2, minute) || !ReadDigits(text, 17, 2, second)) {
+        return kNoTimestamp;
+    }
+    if (text.size() == 23 && (text[19] != '.' || !ReadDigits(text, 20, 3, millis) || millis == 0)) {
+        return kNoTimestamp;
+    }
+    if (month < 1 || month > 12 || day < 1 || day > 31 || hour > 23 || minute > 59 || second > 59) {
+        return kNoTimestamp;
+    }
+    int64_t days = DaysFromCivil(year, month, day);
+    int64_t y;
+    unsigned m, d;
+    CivilFromDays(days, y, m, d);
+    if (m != month || d != day) {
+        return kNoTimestamp;   // 日期不存在，例如02-30
+    }
+    return days * kMsPerDay + ((hour * 60 + minute) * 60 + second) * 1000LL + millis;
+}
+
+std::string RecordBatch::FormatTimestamp(int64_t timestampMs) {
+    std::string text;
+    FormatTimestamp(timestampMs, text);
+    return text;
+}
+
+void RecordBatch::FormatTimestamp(int64_t timestampMs, std::string& text) {
+    if (timestampMs == kNoTimestamp) {
+        text.clear();
+        return;
+    }
+    int64_t days = timestampMs / kMsPerDay;
+    int64_t rest = timestampMs % kMsPerDay;
+    if (rest < 0) {
+        rest += kMsPerDay;
+        --days;
+    }
+    int64_t year;
+    unsigned month, day;
+    CivilFromDays(days, year, month, day);
+    unsigned millis = static_cast<unsigned>(rest % 1000);
+    unsigned seconds = static_cast<unsigned>(rest / 1000);
+    char buffer[40];
+    int length = std::snprintf(buffer, sizeof(buffer), "%04lld-%02u-%02u %02u:%02u:%02u",
+                               static_cast<long long>(year), month, day,
+                               seconds / 3600, seconds / 60 % 60, seconds % 60);
+    if (millis != 0) {
+        length += std::snprintf(buffer + length, sizeof(buffer) - static_cast<size_t>(length), ".%03u", millis);
+    }
+    text.assign(buffer, static_cast<size_t>(length));
+}
+
+uint32_t RecordBatch::SourceId(std::string_view source) {
+    // 相邻行通常来自同一来源，先和上一行比较，避免每行查哈希表
+    if (!sourceIds_.empty() && sourceDictionary_[sourceIds_.back()] == source) {
+        return sourceIds_.back();
+    }
+    auto it = sourceLookup_.find(std::string(source));
+    if (it != sourceLookup_.end()) {
+        return it->second;
+    }
+    uint32_t id = static_cast<uint32_t>(sourceDictionary_.size());
+    sourceDictionary_.emplace_back(source);
+    sourceLookup_.emplace(sourceDictionary_.back(), id);
+    return id;
+}
+
+RecordBatch::FieldColumn& RecordBatch::Column(std::string_view name) {
+    for (auto& column : fields_) {
+        if (column.name == name) {
+            return column;
+        }
+    }
+    fields_.emplace_back();
+    fields_.back().name.assign(name.data(), name.size());
+    return fields_.back();
+}
+
+} // namespace common
+} // namespace xumj
@@ -1,13 +1,16 @@
 #include "xumj/common/thread_pool.h"
+#include <algorithm>
 #include <chrono>
 
 namespace xumj {
 namespace common {
 
 ThreadPool::ThreadPool(size_t numThreads)
-    : isActive_(true), activeTaskCount_(0) {
+    : isActive_(true), targetThreads_(0), liveThreads_(0), activeTaskCount_(0) {
     // 确保至少有一个线程
     numThreads = numThreads > 0 ? numThreads : 1;
+    targetThreads_ = numThreads;
+    liveThreads_ = numThreads;
     
     // 创建工作线程
     for (size_t i = 0; i < numThreads; ++i) {
@@ -33,7 +36,8 @@ ThreadPool::~ThreadPool() {
 }
 
 size_t ThreadPool::GetThreadCount() const {
-    return workers_.size();
+    std::unique_lock<std::mutex> lock(queueMutex_);
+    return liveThreads_;
 }
 
 size_t ThreadPool::GetPendingTaskCount() const {
@@ -84,11 +88,15 @@ void ThreadPool::Reset(size_t numThreads) {
     workers_.clear();
     
     // 清空任务队列
+    numThreads = numThreads > 0 ? numThreads : 1;
     {
         std::unique_lock<std::mutex> lock(queueMutex_);
         while (!tasks_.empty()) {
             tasks_.pop();
         }
+        retired_.clear();
+        targetThreads_ = numThreads;
+        liveThreads_ = numThreads;
         isActive_ = true;  // 重新激活线程池
     }
     
@@ -96,12 +104,47 @@ void ThreadPool::Reset(size_t numThreads) {
     activeTaskCount_ = 0;
     
     // 创建新的线程
-    numThreads = numThreads > 0 ? numThreads : 1;
     for (size_t i = 0; i < numThreads; ++i) {
         workers_.emplace_back(&ThreadPool::WorkerThread, this);
     }
 }
 
+void ThreadPool::Resize(size_t numThreads) {
+    numThreads = numThreads > 0 ? numThreads : 1;
+    std::vector<std::thread> finished;
+    {
+        std::unique_lock<std::mutex> lock(queueMutex_);
+        if (!isActive_) {
+            return;
+        }
+        targetThreads_ = numThreads;
+        
+        // 取出已经退出的线程，在锁外回收
+        for (auto it = workers_.begin(); it != workers_.end();) {
+            if (std::find(retired_.begin(), retired_.end(), it->get_id()) != retired_.end()) {
+                finished.push_back(std::move(*it));
+                it = workers_.erase(it);
+            } else {
+                ++it;
+            }
+        }
+        retired_.clear();
+        
+        // 扩容：补足线程
+        while (liveThreads_ < targetThreads_) {
+            workers_.emplace_back(&ThreadPool::WorkerThread, this);
+            ++liveThreads_;
+        }
+    }
+    
+    // 缩容：唤醒空闲线程，多余的线程检查到后退出
+    condition_.notify_all();
+    
+    for (auto& worker : finished) {
+        worker.join();
+    }
+}
+
 void ThreadPool::WorkerThread() {
     // 线程循环，不断检查和执行任务
     while (!ShouldStop()) {
@@ -111,11 +154,18 @@ void ThreadPool::WorkerThread() {
             // 获取任务队列的锁
             std::unique_lock<std::mutex> lock(queueMutex_);
             
-            // 等待条件变量，直到有任务或者线程池停止
+            // 等待条件变量，直到有任务、线程池停止或需要缩容
             condition_.wait(lock, [this] {
-                return !isActive_ || !tasks_.empty();
+                return !isActive_ || !tasks_.empty() || liveThreads_ > targetThreads_;
             });
             
+            // 线程数多于目标时当前线程退出，由Resize或析构函数回收
+            if (isActive_ && liveThreads_ > targetThreads_) {
+                --liveThreads_;
+                retired_.push_back(std::this_thread::get_id());
+                return;
+            }
+            
             // 如果线程池已停止且没有任务，则退出
             if (!isActive_ && tasks_.empty()) {
                 return;
@@ -0,0 +1,196 @@
+#include <xumj/network/connection_registry.h>
+#include <algorithm>
+#include <iostream>
+
+namespace xumj {
+namespace network {
+
+namespace {
+// 当前线程绑定的注册表及分片（每个IO线程只服务于一个TcpServer）
+thread_local const ConnectionRegistry* tlsRegistry = nullptr;
+thread_local int tlsShard = -1;
+} // namespace
+
+ConnectionRegistry::ConnectionRegistry(size_t shardCount) {
+    shardCount = std::min(std::max<size_t>(shardCount, 1), kMaxShards);
+    shards_.reserve(shardCount);
+    for (size_t i = 0; i < shardCount; ++i) {
+        shards_.push_back(std::make_unique<Shard>());
+    }
+}
+
+ConnectionRegistry::~ConnectionRegistry() {
+    for (auto& shard : shards_) {
+        for (auto& chunk : shard->chunks) {
+            delete chunk.load(std::memory_order_relaxed);
+        }
+    }
+}
+
+void ConnectionRegistry::BindCurrentThread(size_t shard) {
+    tlsRegistry = this;
+    tlsShard = static_cast<int>(shard % shards_.size());
+}
+
+int ConnectionRegistry::CurrentShard() const {
+    return tlsRegistry == this ? tlsShard : -1;
+}
+
+size_t ConnectionRegistry::ChooseShard(muduo::net::EventLoop* loop) const {
+    int bound = CurrentShard();
+    if (bound >= 0) {
+        return static_cast<size_t>(bound);
+    }
+    // 未绑定的线程（例如外部调用）按事件循环地址散列，保证同一循环落在同一分片
+    return std::hash<const void*>()(loop) % shards_.size();
+}
+
+uint64_t ConnectionRegistry::Register(const muduo::net::TcpConnectionPtr& conn,
+                                      muduo::net::EventLoop* loop) {
+    size_t shardIndex = ChooseShard(loop);
+    Shard& shard = *shards_[shardIndex];
+
+    std::lock_guard<std::mutex> lock(shard.writerMutex);
+
+    uint32_t slot;
+    if (!shard.freeSlots.empty()) {
+        slot = shard.freeSlots.back();
+        shard.freeSlots.pop_back();
+    } else {
+        slot = static_cast<uint32_t>(shard.generations.size());
+        if (slot >= kChunkSize * kMaxChunks) {
+            std::cerr << "错误: 连接注册表分片 " << shardIndex << " 已满" << std::endl;
+            return 0;
+        }
+        shard.generations.push_back(0);
+    }
+
+    size_t chunkIndex = slot / kChunkSize;
+    Chunk* chunk = shard.chunks[chunkIndex].load(std::memory_order_relaxed);
+    if (!chunk) {
+        chunk = new Chunk();
+        shard.chunks[chunkIndex].store(chunk, std::memory_order_release);
+    }
+
+    // 代数从1开始并在24位内回绕，跳过0以保证ID不为0
+    uint32_t generation = (shard.generations[slot] + 1) & 0xFFFFFF;
+    if (generation == 0) {
+        generation = 1;
+    }
+    shard.generations[slot] = generation;
+
+    auto entry = std::make_shared<ConnectionEntry>();
+    entry->id = MakeId(generation, slot, shardIndex);
+    entry->conn = conn;
+    entry->loop = loop;
+    entry->outbox = std::make_shared<OutboundQueue>();
+
+    std::atomic_store_explicit(&chunk->slots[slot % kChunkSize],
+                               ConnectionEntryPtr(std::move(entry)),
+                               std::memory_order_release);
+    if (slot + 1 > shard.highWater.load(std::memory_order_relaxed)) {
+        shard.highWater.store(slot + 1, std::memory_order_release);
+    }
+    shard.count.fetch_add(1, std::memory_order_relaxed);
+
+    return MakeId(generation, slot, shardIndex);
+}
+
+bool ConnectionRegistry::Unregister(uint64_t id) {
+    size_t shardIndex = ShardOf(id);
+    if (shardIndex >= shards_.size()) {
+        return false;
+    }
+    Shard& shard = *shards_[shardIndex];
+    uint32_t slot = SlotOf(id);
+
+    std::lock_guard<std::mutex> lock(shard.writerMutex);
+    if (slot >= shard.generations.size()) {
+        return false;
+    }
+    Chunk* chunk = shard.chunks[slot / kChunkSize].load(std::memory_order_relaxed);
+    if (!chunk) {
+        return false;
+    }
+    auto& cell = chunk->slots[slot % kChunkSize];
+    ConnectionEntryPtr current = std::atomic_load_explicit(&cell, std::memory_order_relaxed);
+    if (!current || current->id != id) {
+        return false;
+    }
+
+    std::atomic_store_explicit(&cell, ConnectionEntryPtr(), std::memory_order_release);
+    shard.freeSlots.push_back(slot);
+    shard.count.fetch_sub(1, std::memory_order_relaxed);
+    return true;
+}
+
+ConnectionEntryPtr ConnectionRegistry::Find(uint64_t id) const {
+    size_t shardIndex = ShardOf(id);
+    if (id == 0 || shardIndex >= shards_.size()) {
+        return nullptr;
+    }
+    const Shard& shard = *shards_[shardIndex];
+    uint32_t slot = SlotOf(id);
+    if (slot / kChunkSize >= kMaxChunks) {
+        return nullptr;
+    }
+    const Chunk* chunk = shard.chunks[slot / kChunkSize].load(std::memory_order_acquire);
+    if (!chunk) {
+        return nullptr;
+    }
+    ConnectionEntryPtr entry = std::atomic_load_explicit(&chunk->slots[slot % kChunkSize],
+                                                         std::memory_order_acquire);
+    // 槽位可能已被新连接复用，必须校验完整ID
+    if (!entry || entry->id != id) {
+        return nullptr;
+    }
+    return entry;
+}
+
+void ConnectionRegistry::ForEach(const Visitor& visitor) const {
+    for (const auto& shardPtr : shards_) {
+        const Shard& shard = *shardPtr;
+        size_t highWater = shard.highWater.load(std::memory_order_acquire);
+        for (size_t slot = 0; slot < highWater; ++slot) {
+            const Chunk* chunk = shard.chunks[slot / kChunkSize].load(std::memory_order_acquire);
+            if (!chunk) {
+                slot += kChunkSize - 1 - slot % kChunkSize;
+                continue;
+            }
+            ConnectionEntryPtr entry = std::atomic_load_explicit(&chunk->slots[slot % kChunkSize],
+                                                                 std::memory_order_acquire);
+            if (entry) {
+                visitor(entry);
+            }
+        }
+    }
+}
+
+size_t ConnectionRegistry::Size() const {
+    size_t total = 0;
+    for (const auto& shard : shards_) {
+        total += shard->count.load(std::memory_order_relaxed);
+    }
+    return total;
+}
+
+void ConnectionRegistry::Clear() {
+    for (auto& shardPtr : shards_) {
+        Shard& shard = *shardPtr;
+        std::lock_guard<std::mutex> lock(shard.writerMutex);
+        size_t used = shard.generations.size();
+        shard.freeSlots.clear();
+        for (size_t slot = 0; slot < used; ++slot) {
+            Chunk* chunk = shard.chunks[slot / kChunkSize].load(std::memory_order_relaxed);
+            if (chunk) {
+                std::atomic_store_explicit(&chunk->slots[slot % kChunkSize],
+                                           ConnectionEntryPtr(), std::memory_order_release);
+            }
+            shard.freeSlots.push_back(static_cast<uint32_t>(used - 1 - slot));
+        }
+        shard.count.store(0, std::memory_order_relaxed);
+    }
+}
+
+} // namespace network
+} // namespace xumj
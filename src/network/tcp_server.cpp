@@ -4,6 +4,9 @@
 #include <mutex>
 #include <thread>
 #include <chrono>
+#include <unordered_map>
+#include <pthread.h>
+#include <sched.h>
 #include <boost/any.hpp>
 
 using namespace muduo;
@@ -12,6 +15,19 @@ using namespace muduo::net;
 namespace xumj {
 namespace network {
 
+namespace {
+// 将当前线程绑定到指定CPU
+void PinCurrentThread(int cpu) {
+    cpu_set_t cpuSet;
+    CPU_ZERO(&cpuSet);
+    CPU_SET(cpu, &cpuSet);
+    int rc = pthread_setaffinity_np(pthread_self(), sizeof(cpuSet), &cpuSet);
+    if (rc != 0) {
+        std::cerr << "警告: 绑定线程到CPU " << cpu << " 失败，错误码: " << rc << std::endl;
+    }
+}
+} // namespace
+
 TcpServer::TcpServer(const std::string& serverName,
                      const std::string& listenAddr,
                      uint16_t port,
@@ -21,9 +37,19 @@ TcpServer::TcpServer(const std::string& serverName,
       port_(port),
       numThreads_(numThreads),
       running_(false),
-      nextConnectionId_(1),
       loop_(nullptr),
-      server_(nullptr) {
+      server_(nullptr),
+      nextShard_(0),
+      slowConsumerPolicy_(SlowConsumerPolicy::DROP),
+      highWaterMark_(0),
+      droppedMessages_(0),
+      slowConsumerDisconnects_(0),
+      lineDelimited_(false),
+      maxLineLength_(kDefaultMaxLineLength),
+      oversizedLines_(0),
+      reusePortAcceptors_(false),
+      startedAcceptors_(0),
+      acceptorFailed_(false) {
     
     // std::cout << "创建TcpServer - " << serverName_ << " 在 " 
     //           << listenAddr_ << ":" << port_ << std::endl;
@@ -31,6 +57,10 @@ TcpServer::TcpServer(const std::string& serverName,
     // 注意：不在构造函数中创建EventLoop，而是在Start()方法中创建
     // 这样可以确保EventLoop在正确的线程中创建和使用
     
+    // 连接表按IO线程分片，线程数为0时与Start()中的取值保持一致
+    size_t shardCount = numThreads_ == 0 ? std::thread::hardware_concurrency() : numThreads_;
+    registry_ = std::make_unique<ConnectionRegistry>(shardCount);
+    
     std::cout << "INFO: TCP Server [" << serverName_ << "] created at " 
               << listenAddr_ << ":" << port_ << " with " 
               << (numThreads_ == 0 ? std::thread::hardware_concurrency() : numThreads_) << " threads." 
@@ -49,6 +79,11 @@ void TcpServer::Start() {
     
     std::cout << "INFO: 开始启动TcpServer - " << serverName_ << std::endl;
     
+    if (reusePortAcceptors_) {
+        StartReusePortAcceptors();
+        return;
+    }
+    
     // 创建并启动事件循环线程
     loopThread_ = std::make_unique<std::thread>([this]() {
         // 在事件循环线程中创建EventLoop
@@ -78,20 +113,19 @@ void TcpServer::Start() {
             }
             server.setThreadNum(numThreads_);
             
-            // 使用Lambda表达式设置回调
-            server.setConnectionCallback(
-                [this](const muduo::net::TcpConnectionPtr& conn) {
-                    this->HandleConnection(conn, conn->connected());
+            // 每个IO线程启动时领取一个分片，之后该线程上的连接只写入自己的分片
+            nextShard_ = 0;
+            server.setThreadInitCallback(
+                [this](muduo::net::EventLoop*) {
+                    size_t shard = nextShard_++;
+                    registry_->BindCurrentThread(shard);
+                    if (!cpuAffinity_.empty()) {
+                        PinCurrentThread(cpuAffinity_[shard % cpuAffinity_.size()]);
+                    }
                 }
             );
             
-            server.setMessageCallback(
-                [this](const muduo::net::TcpConnectionPtr& conn, 
-                       muduo::net::Buffer* buffer,
-                       muduo::Timestamp timestamp) {
-                    this->HandleMessage(conn, buffer, timestamp);
-                }
-            );
+            InstallCallbacks(server);
             
             // 这里将server保存为成员变量，以便在其他线程中访问
             {
@@ -152,10 +186,151 @@ void TcpServer::Start() {
     }
 }
 
+void TcpServer::InstallCallbacks(muduo::net::TcpServer& server) {
+    // 使用Lambda表达式设置回调
+    server.setConnectionCallback(
+        [this](const muduo::net::TcpConnectionPtr& conn) {
+            this->HandleConnection(conn, conn->connected());
+        }
+    );
+    
+    server.setMessageCallback(
+        [this](const muduo::net::TcpConnectionPtr& conn, 
+               muduo::net::Buffer* buffer,
+               muduo::Timestamp timestamp) {
+            this->HandleMessage(conn, buffer, timestamp);
+        }
+    );
+    
+    // 输出缓冲区写空后继续发送排队的共享消息体
+    server.setWriteCompleteCallback(
+        [this](const muduo::net::TcpConnectionPtr& conn) {
+            this->HandleWriteComplete(conn);
+        }
+    );
+}
+
+void TcpServer::StartReusePortAcceptors() {
+    // 每个IO循环一个监听套接字，数量与连接表分片数一致
+    size_t acceptorCount = registry_->GetShardCount();
+    numThreads_ = acceptorCount;
+    
+    {
+        std::lock_guard<std::mutex> lock(shutdownMutex_);
+        acceptorLoops_.assign(acceptorCount, nullptr);
+        startedAcceptors_ = 0;
+        acceptorFailed_ = false;
+    }
+    
+    for (size_t i = 0; i < acceptorCount; ++i) {
+        acceptorThreads_.push_back(std::make_unique<std::thread>([this, i]() {
+            RunAcceptorLoop(i);
+        }));
+    }
+    
+    // 等待所有监听循环启动完成或超时
+    std::unique_lock<std::mutex> lock(shutdownMutex_);
+    shutdownCv_.wait_for(lock, std::chrono::seconds(5), [this, acceptorCount]() {
+        return startedAcceptors_ == acceptorCount || acceptorFailed_;
+    });
+    
+    if (startedAcceptors_ != acceptorCount) {
+        std::cerr << "错误: 多监听模式启动失败，已启动 " << startedAcceptors_
+                  << "/" << acceptorCount << " 个监听循环" << std::endl;
+        // 退出已经启动的循环，由Stop()回收线程；尚未启动完成的循环看到失败标记后不再进入事件循环
+        acceptorFailed_ = true;
+        for (EventLoop* loop : acceptorLoops_) {
+            if (loop) {
+                loop->queueInLoop([loop]() { loop->quit(); });
+            }
+        }
+        running_ = true;  // 让Stop()走正常的回收流程
+        lock.unlock();
+        Stop();
+        return;
+    }
+    
+    std::cout << "TCP Server [" << serverName_ << "] started with " << acceptorCount
+              << " SO_REUSEPORT acceptors." << std::endl;
+}
+
+void TcpServer::RunAcceptorLoop(size_t index) {
+    try {
+        if (!cpuAffinity_.empty()) {
+            PinCurrentThread(cpuAffinity_[index % cpuAffinity_.size()]);
+        }
+        // 本循环接受的连接全部注册到自己的分片
+        registry_->BindCurrentThread(index);
+        
+        EventLoop loop;
+        InetAddress serverAddr(listenAddr_, port_);
+        
+        // 每个循环各自打开一个SO_REUSEPORT监听套接字，由内核在它们之间分配新连接
+        muduo::net::TcpServer server(&loop, serverAddr, serverName_ + "#" + std::to_string(index),
+                                     muduo::net::TcpServer::Option::kReusePort);
+        server.setThreadNum(0);  // 连接直接在接受它的循环中处理
+        InstallCallbacks(server);
+        server.start();
+        
+        {
+            std::lock_guard<std::mutex> lock(shutdownMutex_);
+            if (acceptorFailed_) {
+                return;  // 启动已整体失败
+            }
+            acceptorLoops_[index] = &loop;
+            if (++startedAcceptors_ == acceptorLoops_.size()) {
+                running_ = true;
+            }
+        }
+        shutdownCv_.notify_all();
+        
+        loop.loop();
+        
+        {
+            std::lock_guard<std::mutex> lock(shutdownMutex_);
+            acceptorLoops_[index] = nullptr;
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "异常: 监听循环 " << index << " 执行失败: " << e.what() << std::endl;
+        std::lock_guard<std::mutex> lock(shutdownMutex_);
+        acceptorFailed_ = true;
+        shutdownCv_.notify_all();
+    }
+}
+
 void TcpServer::Stop() {
     // 使用临时变量保存状态，避免多次调用
     bool wasRunning = false;
     
+    if (!acceptorThreads_.empty()) {
+        {
+            std::lock_guard<std::mutex> lock(shutdownMutex_);
+            wasRunning = running_;
+            for (EventLoop* loop : acceptorLoops_) {
+                if (loop) {
+                    loop->queueInLoop([loop]() { loop->quit(); });
+                }
+            }
+        }
+        
+        for (auto& thread : acceptorThreads_) {
+            if (thread->joinable()) {
+                thread->join();
+            }
+        }
+        acceptorThreads_.clear();
+        registry_->Clear();
+        
+        {
+            std::lock_guard<std::mutex> lock(shutdownMutex_);
+            running_ = false;
+        }
+        if (wasRunning) {
+            std::cout << "TCP Server [" << serverName_ << "] stopped." << std::endl;
+        }
+        return;
+    }
+    
     {
         std::lock_guard<std::mutex> lock(shutdownMutex_);
         wasRunning = running_;
@@ -165,11 +340,8 @@ void TcpServer::Stop() {
             loop_->queueInLoop([this]() {
                 std::cout << "DEBUG: 停止TcpServer - " << serverName_ << std::endl;
                 
-                // 清理所有连接 (在事件循环线程中安全进行)
-                {
-                    std::lock_guard<std::mutex> connLock(connectionsMutex_);
-                    connections_.clear();
-                }
+                // 清理所有连接
+                registry_->Clear();
                 
                 // 退出事件循环
                 loop_->quit();
@@ -187,15 +359,17 @@ void TcpServer::Stop() {
 }
 
 bool TcpServer::Send(uint64_t connectionId, const std::string& message) {
-    TcpConnectionPtr conn = GetConnection(connectionId);
+    // 与共享消息体走同一条发送队列，保证同一连接上的消息顺序
+    return Send(connectionId, SharedPayload(message));
+}
+
+bool TcpServer::Send(uint64_t connectionId, const SharedPayload& payload) {
+    ConnectionEntryPtr entry = registry_->Find(connectionId);
     
-    if (conn && conn->connected()) {
-        // 获取连接所属的事件循环
-        EventLoop* connLoop = conn->getLoop();
-        
-        // 在连接所属的线程中执行发送
-        connLoop->runInLoop([conn, message]() {
-            conn->send(message);
+    if (entry && entry->conn->connected()) {
+        // 直接投递到连接所属的事件循环，在IO线程内发送
+        entry->loop->runInLoop([this, entry, payload]() {
+            DeliverInLoop(entry, payload);
         });
         return true;
     }
@@ -204,38 +378,123 @@ bool TcpServer::Send(uint64_t connectionId, const std::string& message) {
 }
 
 size_t TcpServer::Broadcast(const std::string& message) {
-    size_t count = 0;
-    std::vector<TcpConnectionPtr> activeConns;
+    return Broadcast(SharedPayload(message));
+}
+
+size_t TcpServer::Broadcast(const SharedPayload& payload) {
+    std::vector<ConnectionEntryPtr> entries;
+    entries.reserve(registry_->Size());
     
-    // 首先收集所有活跃的连接
-    {
-        std::lock_guard<std::mutex> lock(connectionsMutex_);
-        for (const auto& pair : connections_) {
-            if (pair.second && pair.second->connected()) {
-                activeConns.push_back(pair.second);
-                count++;
-            }
+    // 遍历连接表不需要加锁
+    registry_->ForEach([&entries](const ConnectionEntryPtr& entry) {
+        entries.push_back(entry);
+    });
+    
+    return DeliverToEntries(entries, payload);
+}
+
+size_t TcpServer::Multicast(const std::vector<uint64_t>& connectionIds, const SharedPayload& payload) {
+    std::vector<ConnectionEntryPtr> entries;
+    entries.reserve(connectionIds.size());
+    
+    for (uint64_t id : connectionIds) {
+        ConnectionEntryPtr entry = registry_->Find(id);
+        if (entry) {
+            entries.push_back(std::move(entry));
+        }
+    }
+    
+    return DeliverToEntries(entries, payload);
+}
+
+size_t TcpServer::DeliverToEntries(const std::vector<ConnectionEntryPtr>& entries,
+                                   const SharedPayload& payload) {
+    // 按事件循环分组，每个IO线程只投递一个任务，任务中共享同一份消息体
+    std::unordered_map<EventLoop*, std::vector<ConnectionEntryPtr>> byLoop;
+    size_t count = 0;
+    for (const auto& entry : entries) {
+        if (entry->conn && entry->conn->connected()) {
+            byLoop[entry->loop].push_back(entry);
+            count++;
         }
     }
     
-    // 对每个连接执行发送操作
-    for (const auto& conn : activeConns) {
-        // 在连接所属的线程中执行发送
-        EventLoop* connLoop = conn->getLoop();
-        connLoop->runInLoop([conn, message]() {
-            conn->send(message);
+    for (auto& group : byLoop) {
+        auto loopEntries = std::make_shared<std::vector<ConnectionEntryPtr>>(std::move(group.second));
+        group.first->runInLoop([this, loopEntries, payload]() {
+            for (const auto& entry : *loopEntries) {
+                DeliverInLoop(entry, payload);
+            }
         });
     }
     
     return count;
 }
 
+void TcpServer::DeliverInLoop(const ConnectionEntryPtr& entry, const SharedPayload& payload) {
+    const TcpConnectionPtr& conn = entry->conn;
+    OutboundQueue& outbox = *entry->outbox;
+    if (!conn->connected() || outbox.closing || payload.Empty()) {
+        return;
+    }
+    
+    size_t buffered = conn->outputBuffer()->readableBytes() + outbox.pendingBytes;
+    
+    // 已有积压且再加入会超过高水位，视为慢消费者
+    if (highWaterMark_ > 0 && buffered > 0 && buffered + payload.Size() > highWaterMark_) {
+        if (slowConsumerPolicy_ == SlowConsumerPolicy::DISCONNECT) {
+            outbox.closing = true;
+            outbox.pending.clear();
+            outbox.pendingBytes = 0;
+            slowConsumerDisconnects_++;
+            std::cerr << "警告: 连接 [" << entry->id << "] 积压 " << buffered
+                      << " 字节，超过高水位，断开连接" << std::endl;
+            conn->forceClose();
+        } else {
+            droppedMessages_++;
+        }
+        return;
+    }
+    
+    if (outbox.pending.empty() && conn->outputBuffer()->readableBytes() == 0) {
+        // 输出缓冲区为空时muduo直接从共享内存写入内核，只有未写完的尾部会被复制
+        conn->send(payload.Data(), static_cast<int>(payload.Size()));
+    } else {
+        // 否则只保存引用，等待输出缓冲区写空后再发送
+        outbox.pending.push_back(payload);
+        outbox.pendingBytes += payload.Size();
+    }
+}
+
+void TcpServer::HandleWriteComplete(const muduo::net::TcpConnectionPtr& conn) {
+    uint64_t connectionId = 0;
+    try {
+        connectionId = boost::any_cast<uint64_t>(conn->getContext());
+    } catch (const boost::bad_any_cast&) {
+        return;
+    }
+    
+    ConnectionEntryPtr entry = registry_->Find(connectionId);
+    if (!entry) {
+        return;
+    }
+    
+    // 每次只把一条消息交给muduo，写不完的部分留在输出缓冲区，等待下一次写完成回调
+    OutboundQueue& outbox = *entry->outbox;
+    while (!outbox.pending.empty() && conn->outputBuffer()->readableBytes() == 0) {
+        SharedPayload next = std::move(outbox.pending.front());
+        outbox.pending.pop_front();
+        outbox.pendingBytes -= next.Size();
+        conn->send(next.Data(), static_cast<int>(next.Size()));
+    }
+}
+
 bool TcpServer::CloseConnection(uint64_t connectionId) {
-    auto conn = GetConnection(connectionId);
-    if (conn) {
+    ConnectionEntryPtr entry = registry_->Find(connectionId);
+    if (entry) {
         // 在连接所属的线程中执行关闭操作
-        EventLoop* connLoop = conn->getLoop();
-        connLoop->runInLoop([conn]() {
+        TcpConnectionPtr conn = entry->conn;
+        entry->loop->runInLoop([conn]() {
             conn->shutdown();
         });
         return true;
@@ -244,17 +503,12 @@ bool TcpServer::CloseConnection(uint64_t connectionId) {
 }
 
 size_t TcpServer::GetConnectionCount() const {
-    std::lock_guard<std::mutex> lock(connectionsMutex_);
-    return connections_.size();
+    return registry_->Size();
 }
 
 muduo::net::TcpConnectionPtr TcpServer::GetConnection(uint64_t id) {
-    std::lock_guard<std::mutex> lock(connectionsMutex_);
-    auto it = connections_.find(id);
-    if (it != connections_.end()) {
-        return it->second;
-    }
-    return nullptr;
+    ConnectionEntryPtr entry = registry_->Find(id);
+    return entry ? entry->conn : nullptr;
 }
 
 void TcpServer::HandleConnection(const muduo::net::TcpConnectionPtr& conn, bool connected) {
@@ -268,17 +522,19 @@ void TcpServer::HandleConnection(const muduo::net::TcpConnectionPtr& conn, bool
     std::cout << "- 连接状态: " << (connected ? "已建立" : "已断开") << std::endl;
     
     if (connected) {
-        // 新连接建立
-        uint64_t connectionId = nextConnectionId_++;
+        // 新连接建立：在所属IO线程中注册到本线程的分片并分配ID
+        uint64_t connectionId = RegisterConnection(conn);
+        if (connectionId == 0) {
+            std::cerr << "错误: 连接表已满，拒绝连接 " << clientAddr << std::endl;
+            conn->forceClose();
+            return;
+        }
         
         std::cout << "- 分配连接ID: " << connectionId << std::endl;
         
         // 在连接上存储ID
         conn->setContext(connectionId);
         
-        // 注册连接
-        RegisterConnection(connectionId, conn);
-        
         // 调用用户回调
         if (connectionCallback_) {
             std::cout << "===== 新TCP连接 =====" << std::endl;
@@ -343,8 +599,7 @@ void TcpServer::HandleConnection(const muduo::net::TcpConnectionPtr& conn, bool
 void TcpServer::HandleMessage(const muduo::net::TcpConnectionPtr& conn, 
                              muduo::net::Buffer* buffer,
                              muduo::Timestamp timestamp) {
-    // 打印调试信息
-    std::cout << "收到数据，大小：" << buffer->readableBytes() << " 字节" << std::endl;
+    // 每次读事件都会进入这里，不在热路径上输出日志
     
     // 调试：打印当前buffer内容的十六进制表示
     // const char* data = buffer->peek();
@@ -373,51 +628,81 @@ void TcpServer::HandleMessage(const muduo::net::TcpConnectionPtr& conn,
         connectionId = 0;
     }
     
-    // 如果找不到connectionId，通过连接对象查找
-    if (connectionId == 0) {
-        std::lock_guard<std::mutex> lock(connectionsMutex_);
-        for (const auto& kv : connections_) {
-            if (kv.second.get() == conn.get()) {
-                connectionId = kv.first;
-                break;
+    // 连接建立时总会设置上下文，取不到ID说明连接已注销，不再遍历连接表查找
+    
+    // 按行分帧：只交付完整的行，不完整的部分留在缓冲区等待后续数据
+    if (lineDelimited_) {
+        const char* eol = nullptr;
+        while ((eol = buffer->findEOL()) != nullptr) {
+            size_t lineLength = static_cast<size_t>(eol - buffer->peek());
+            if (lineLength > 0 && buffer->peek()[lineLength - 1] == '\r') {
+                lineLength--;
             }
+            if (maxLineLength_ > 0 && lineLength > maxLineLength_) {
+                CloseOversizedLine(conn, connectionId, buffer, lineLength);
+                return;
+            }
+            std::string line(buffer->peek(), lineLength);
+            buffer->retrieveUntil(eol + 1);
+            
+            if (!line.empty()) {
+                DispatchMessage(connectionId, std::move(line), timestamp);
+            }
+        }
+        // 剩余的不完整行已经超长，不再等待换行符（多留1字节给\r）
+        if (maxLineLength_ > 0 && buffer->readableBytes() > maxLineLength_ + 1) {
+            CloseOversizedLine(conn, connectionId, buffer, buffer->readableBytes());
         }
+        return;
     }
     
     // 简化处理逻辑：尝试获取整个消息
     if (buffer->readableBytes() > 0) {
         std::string allData(buffer->peek(), buffer->readableBytes());
-        std::cout << "收到完整消息: [" << (allData.size() <= 1024 ? allData : allData.substr(0, 1024) + "...") 
-                 << "]" << std::endl;
         
         // 移除所有数据
         buffer->retrieveAll();
         
-        // 如果有回调，调用它
-        if (connectionId > 0 && messageCallback_) {
-            try {
-                messageCallback_(connectionId, allData, timestamp);
-            } catch (const std::exception& e) {
-                std::cerr << "错误: 执行消息回调时异常: " << e.what() << std::endl;
-            } catch (...) {
-                std::cerr << "错误: 执行消息回调时未知异常" << std::endl;
+        DispatchMessage(connectionId, std::move(allData), timestamp);
+    }
+}
+
+void TcpServer::CloseOversizedLine(const muduo::net::TcpConnectionPtr& conn, uint64_t connectionId,
+                                   muduo::net::Buffer* buffer, size_t length) {
+    oversizedLines_.fetch_add(1, std::memory_order_relaxed);
+    std::cerr << "警告: 连接 [" << connectionId << "] 单行长度 " << length
+              << " 字节，超过上限 " << maxLineLength_ << " 字节，断开连接" << std::endl;
+    buffer->retrieveAll();
+    conn->forceClose();
+}
+
+void TcpServer::DispatchMessage(uint64_t connectionId, std::string&& message, muduo::Timestamp timestamp) {
+    // 如果有回调，调用它
+    if (connectionId > 0 && (frameCallback_ || messageCallback_)) {
+        try {
+            if (frameCallback_) {
+                frameCallback_(connectionId, std::move(message), timestamp);
+            } else {
+                messageCallback_(connectionId, message, timestamp);
             }
-        } else {
-            std::cerr << "TcpServer - 消息回调失败: " 
-                    << (connectionId <= 0 ? "找不到连接ID" : "未设置回调函数")
-                    << std::endl;
+        } catch (const std::exception& e) {
+            std::cerr << "错误: 执行消息回调时异常: " << e.what() << std::endl;
+        } catch (...) {
+            std::cerr << "错误: 执行消息回调时未知异常" << std::endl;
         }
+    } else {
+        std::cerr << "TcpServer - 消息回调失败: " 
+                << (connectionId <= 0 ? "找不到连接ID" : "未设置回调函数")
+                << std::endl;
     }
 }
 
-void TcpServer::RegisterConnection(uint64_t id, const muduo::net::TcpConnectionPtr& conn) {
-    std::lock_guard<std::mutex> lock(connectionsMutex_);
-    connections_[id] = conn;
+uint64_t TcpServer::RegisterConnection(const muduo::net::TcpConnectionPtr& conn) {
+    return registry_->Register(conn, conn->getLoop());
 }
 
 void TcpServer::UnregisterConnection(uint64_t id) {
-    std::lock_guard<std::mutex> lock(connectionsMutex_);
-    connections_.erase(id);
+    registry_->Unregister(id);
 }
 
 } // namespace network
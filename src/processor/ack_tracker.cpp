@@ -0,0 +1,178 @@
+#include "xumj/processor/ack_tracker.h"
+#include <iostream>
+
+namespace xumj {
+namespace processor {
+
+void BatchTicket::Complete(bool stored) {
+    if (!stored) {
+        failed = true;
+    }
+    // 最后一条日志完成时结束整个批次
+    if (remaining.fetch_sub(1, std::memory_order_acq_rel) == 1 && tracker) {
+        tracker->Finish(stream, seq, !failed.load(std::memory_order_acquire));
+    }
+}
+
+AckTracker::AckTracker(AckCallback callback, std::chrono::seconds idleTtl, std::chrono::seconds closedTtl)
+    : callback_(std::move(callback)),
+      idleTtl_(idleTtl),
+      closedTtl_(closedTtl),
+      lastSweep_(std::chrono::steady_clock::now()) {
+}
+
+std::shared_ptr<BatchTicket> AckTracker::Begin(uint64_t connectionId, const std::string& stream,
+                                               uint64_t seq, uint64_t base, size_t count) {
+    std::shared_ptr<BatchTicket> ticket;
+    uint64_t reAck = 0;
+    bool sendAck = false;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto now = std::chrono::steady_clock::now();
+        if (now - lastSweep_ >= std::chrono::seconds(1)) {
+            SweepLocked(now);
+        }
+        
+        // 第一次见到该流时以发送方的累计确认为起点，不能以先到达的序号为起点：
+        // 重连后新批次可能先于重传到达，中间的批次还没有存储
+        auto [it, created] = streams_.try_emplace(stream);
+        StreamState& state = it->second;
+        if (created) {
+            state.acked = base;
+        } else if (base > state.acked) {
+            // 发送方已收到更大的确认（由淘汰前的状态或其他处理器实例发出），这些批次不会再到达
+            state.acked = base;
+            state.completed.erase(state.completed.begin(), state.completed.upper_bound(base));
+            sendAck = Advance(state);
+        }
+        state.connectionId = connectionId;
+        state.closed = false;
+        state.lastActive = now;
+
+        bool duplicate = seq <= state.acked ||
+                         state.inProgress.count(seq) > 0 ||
+                         state.completed.count(seq) > 0;
+        if (!duplicate) {
+            if (count == 0) {
+                // 空批次直接视为完成
+                state.completed.insert(seq);
+                sendAck = Advance(state) || sendAck;
+            } else {
+                state.inProgress.insert(seq);
+                ticket = std::make_shared<BatchTicket>();
+                ticket->stream = stream;
+                ticket->seq = seq;
+                ticket->remaining = count;
+                ticket->tracker = this;
+            }
+        } else {
+            duplicates_++;
+            // 已确认的批次重发累计确认；正在处理中的批次完成后会自然确认，无需重发
+            sendAck = sendAck || state.inProgress.count(seq) == 0;
+        }
+        reAck = state.acked;
+    }
+
+    if (sendAck && callback_) {
+        callback_(connectionId, stream, reAck);
+    }
+    return ticket;
+}
+
+bool AckTracker::Advance(StreamState& state) {
+    // 累计确认只能推进到第一个空洞之前
+    bool advanced = false;
+    while (!state.completed.empty() && *state.completed.begin() == state.acked + 1) {
+        state.completed.erase(state.completed.begin());
+        state.acked++;
+        advanced = true;
+    }
+    return advanced;
+}
+
+void AckTracker::Finish(const std::string& stream, uint64_t seq, bool stored) {
+    uint64_t connectionId = 0;
+    uint64_t acked = 0;
+    bool advanced = false;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = streams_.find(stream);
+        if (it == streams_.end()) {
+            return;
+        }
+        StreamState& state = it->second;
+        state.inProgress.erase(seq);
+        connectionId = state.connectionId;
+
+        if (stored) {
+            // 处理期间起点可能已被base推进到该序号之后
+            if (seq > state.acked) {
+                state.completed.insert(seq);
+                advanced = Advance(state);
+            }
+        } else {
+            failed_++;
+        }
+        acked = state.acked;
+    }
+
+    if (!stored) {
+        std::cerr << "警告: 流 " << stream << " 的批次 " << seq << " 存储失败，等待重传" << std::endl;
+        if (failureCallback_) {
+            failureCallback_(connectionId, stream, seq);
+        }
+        return;
+    }
+
+    if (advanced && callback_) {
+        callback_(connectionId, stream, acked);
+    }
+}
+
+void AckTracker::OnConnectionClosed(uint64_t connectionId) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto now = std::chrono::steady_clock::now();
+    for (auto& [stream, state] : streams_) {
+        if (state.connectionId == connectionId && !state.closed) {
+            state.closed = true;
+            state.lastActive = now;
+        }
+    }
+}
+
+size_t AckTracker::Sweep(std::chrono::steady_clock::time_point now) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return SweepLocked(now);
+}
+
+size_t AckTracker::SweepLocked(std::chrono::steady_clock::time_point now) {
+    lastSweep_ = now;
+    size_t count = 0;
+    for (auto it = streams_.begin(); it != streams_.end();) {
+        const StreamState& state = it->second;
+        auto ttl = state.closed ? closedTtl_ : idleTtl_;
+        // 有处理中批次的流完成后还要发确认，不能淘汰
+        if (state.inProgress.empty() && now - state.lastActive >= ttl) {
+            it = streams_.erase(it);
+            count++;
+        } else {
+            ++it;
+        }
+    }
+    evicted_.fetch_add(count, std::memory_order_relaxed);
+    return count;
+}
+
+size_t AckTracker::GetStreamCount() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return streams_.size();
+}
+
+uint64_t AckTracker::GetAckedSequence(const std::string& stream) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = streams_.find(stream);
+    return it != streams_.end() ? it->second.acked : 0;
+}
+
+} // namespace processor
+} // namespace xumj
@@ -0,0 +1,242 @@
+#include "xumj/processor/admission_controller.h"
+#include <algorithm>
+#include <chrono>
+#include <thread>
+
+namespace xumj {
+namespace processor {
+
+namespace {
+
+// 每个提交线程独立的xorshift随机数，丢弃判断不需要高质量随机数
+double NextUniform() {
+    thread_local uint64_t state = [] {
+        uint64_t seed = static_cast<uint64_t>(
+            std::chrono::steady_clock::now().time_since_epoch().count());
+        seed ^= std::hash<std::thread::id>{}(std::this_thread::get_id()) * 0x9E3779B97F4A7C15ull;
+        return seed ? seed : 0x2545F4914F6CDD1Dull;
+    }();
+    state ^= state >> 12;
+    state ^= state << 25;
+    state ^= state >> 27;
+    return static_cast<double>((state * 0x2545F4914F6CDD1Dull) >> 11) * (1.0 / 9007199254740992.0);
+}
+
+bool IsUpper(char c) { return c >= 'A' && c <= 'Z'; }
+bool IsAlpha(char c) { return IsUpper(c) || (c >= 'a' && c <= 'z'); }
+
+// syslog严重性：0~2紧急/告警/严重，3错误，4警告，5~6通知/信息，7调试
+common::LogLevel SyslogLevel(unsigned severity) {
+    static const common::LogLevel levels[8] = {
+        common::LogLevel::FATAL, common::LogLevel::FATAL, common::LogLevel::FATAL, common::LogLevel::ERROR,
+        common::LogLevel::WARN, common::LogLevel::INFO, common::LogLevel::INFO, common::LogLevel::DEBUG
+    };
+    return levels[severity & 7];
+}
+
+} // namespace
+
+common::LogLevel SniffLogLevel(std::string_view message) {
+    std::string_view head = message.substr(0, 256);
+    size_t begin = head.find_first_not_of(" \t\r\n");
+    if (begin == std::string_view::npos) {
+        return common::LogLevel::OTHER;
+    }
+    head.remove_prefix(begin);
+
+    // syslog：<PRI>，PRI = facility × 8 + severity
+    if (head[0] == '<') {
+        unsigned pri = 0;
+        size_t i = 1;
+        while (i < head.size() && i <= 4 && head[i] >= '0' && head[i] <= '9') {
+            pri = pri * 10 + static_cast<unsigned>(head[i] - '0');
+            ++i;
+        }
+        if (i > 1 && i < head.size() && head[i] == '>') {
+            return SyslogLevel(pri);
+        }
+    }
+
+    // JSON："level" : "X"
+    if (head[0] == '{') {
+        size_t key = head.find("\"level\"");
+        if (key != std::string_view::npos) {
+            size_t pos = head.find_first_not_of(" \t", key + 7);
+            if (pos != std::string_view::npos && head[pos] == ':') {
+                pos = head.find_first_not_of(" \t", pos + 1);
+                if (pos != std::string_view::npos && head[pos] == '"') {
+                    size_t end = head.find('"', pos + 1);
+                    if (end != std::string_view::npos) {
+                        return common::RecordBatch::ParseLevel(head.substr(pos + 1, end - pos - 1));
+                    }
+                }
+            }
+        }
+        return common::LogLevel::OTHER;
+    }
+
+    // 文本：第一个全大写的级别单词，例如"[ERROR]"或" WARN "
+    for (size_t i = 0; i < head.size();) {
+        if (!IsAlpha(head[i])) {
+            ++i;
+            continue;
+        }
+        size_t end = i;
+        bool upper = true;
+        while (end < head.size() && IsAlpha(head[end])) {
+            upper = upper && IsUpper(head[end]);
+            ++end;
+        }
+        size_t length = end - i;
+        if (upper && length >= 4 && length <= 8) {
+            common::LogLevel level = common::RecordBatch::ParseLevel(head.substr(i, length));
+            if (level != common::LogLevel::OTHER) {
+                return level;
+            }
+        }
+        i = end;
+    }
+    return common::LogLevel::OTHER;
+}
+
+AdmissionController::AdmissionController(const AdmissionConfig& config, size_t capacity)
+    : config_(config), capacity_(capacity) {
+    double headroom = std::clamp(config_.reservedHeadroom, 0.0, 1.0);
+    double start = std::clamp(config_.sheddingStart, 0.0, 1.0);
+    for (size_t i = 0; i < kLogLevelCount; ++i) {
+        auto level = static_cast<common::LogLevel>(i);
+        if (level == common::LogLevel::ERROR || level == common::LogLevel::FATAL) {
+            // ERROR及以上可以使用全部容量，不做概率丢弃
+            levelLimit_[i] = capacity_;
+            shedStart_[i] = capacity_;
+            continue;
+        }
+        double quota = std::min(std::clamp(config_.levelQuota[i], 0.0, 1.0), 1.0 - headroom);
+        levelLimit_[i] = static_cast<size_t>(static_cast<double>(capacity_) * quota);
+        shedStart_[i] = static_cast<size_t>(static_cast<double>(levelLimit_[i]) * start);
+    }
+    if (config_.sourceQuota > 0) {
+        sourceLimit_ = std::max<size_t>(1, static_cast<size_t>(static_cast<double>(capacity_) *
+                                                               std::min(config_.sourceQuota, 1.0)));
+        sourceDepth_.reset(new std::atomic<uint32_t>[kSourceSlots]());
+    }
+}
+
+size_t AdmissionController::Limit(common::LogLevel level, size_t sourceHash, size_t depth) const {
+    size_t index = static_cast<size_t>(level);
+    size_t limit = levelLimit_[index];
+    if (limit >= capacity_) {
+        return capacity_;
+    }
+
+    // 单个来源的低级别日志不能占满队列
+    if (sourceLimit_ > 0 &&
+        sourceDepth_[sourceHash % kSourceSlots].load(std::memory_order_relaxed) >= sourceLimit_) {
+        return 0;
+    }
+
+    // 超过开始点后丢弃概率从0线性增长到上限处的1
+    size_t start = shedStart_[index];
+    if (depth > start && limit > start) {
+        double probability = static_cast<double>(depth - start) / static_cast<double>(limit - start);
+        if (NextUniform() < probability) {
+            return 0;
+        }
+    }
+    return limit;
+}
+
+void AdmissionController::OnAdmitted(common::LogLevel level, size_t sourceHash) {
+    admitted_[static_cast<size_t>(level)].fetch_add(1, std::memory_order_relaxed);
+    if (sourceLimit_ > 0) {
+        sourceDepth_[sourceHash % kSourceSlots].fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+void AdmissionController::OnDequeued(size_t sourceHash) {
+    if (sourceLimit_ == 0) {
+        return;
+    }
+    // 清空后出队的条目不再减，避免下溢
+    auto& slot = sourceDepth_[sourceHash % kSourceSlots];
+    uint32_t current = slot.load(std::memory_order_relaxed);
+    while (current > 0 && !slot.compare_exchange_weak(current, current - 1, std::memory_order_relaxed)) {
+    }
+}
+
+void AdmissionController::OnShed(const std::string& source, common::LogLevel level) {
+    size_t index = static_cast<size_t>(level);
+    shed_[index].fetch_add(1, std::memory_order_relaxed);
+
+    std::lock_guard<std::mutex> lock(shedMutex_);
+    auto it = shedBySource_.find(source);
+    if (it == shedBySource_.end()) {
+        const std::string& key = shedBySource_.size() < config_.maxTrackedSources ? source : std::string("other");
+        it = shedBySource_.try_emplace(key).first;
+    }
+    it->second[index]++;
+}
+
+void AdmissionController::OnRejected(common::LogLevel level) {
+    rejected_[static_cast<size_t>(level)].fetch_add(1, std::memory_order_relaxed);
+}
+
+void AdmissionController::ClearDepth() {
+    if (sourceLimit_ == 0) {
+        return;
+    }
+    for (size_t i = 0; i < kSourceSlots; ++i) {
+        sourceDepth_[i].store(0, std::memory_order_relaxed);
+    }
+}
+
+uint64_t AdmissionController::GetAdmittedCount(common::LogLevel level) const {
+    return admitted_[static_cast<size_t>(level)].load(std::memory_order_relaxed);
+}
+
+uint64_t AdmissionController::GetShedCount(common::LogLevel level) const {
+    return shed_[static_cast<size_t>(level)].load(std::memory_order_relaxed);
+}
+
+uint64_t AdmissionController::GetRejectedCount(common::LogLevel level) const {
+    return rejected_[static_cast<size_t>(level)].load(std::memory_order_relaxed);
+}
+
+std::vector<ShedStats> AdmissionController::GetShedStats() const {
+    std::vector<ShedStats> stats;
+    {
+        std::lock_guard<std::mutex> lock(shedMutex_);
+        for (const auto& [source, counts] : shedBySource_) {
+            for (size_t i = 0; i < kLogLevelCount; ++i) {
+                if (counts[i] > 0) {
+                    stats.push_back({source, static_cast<common::LogLevel>(i), counts[i]});
+                }
+            }
+        }
+    }
+    std::sort(stats.begin(), stats.end(), [](const ShedStats& a, const ShedStats& b) {
+        return a.source != b.source ? a.source < b.source : a.level < b.level;
+    });
+    return stats;
+}
+
+void AdmissionController::WritePrometheusMetrics(common::PrometheusWriter& writer) const {
+    for (size_t i = 0; i < kLogLevelCount; ++i) {
+        writer.Counter("xumj_processor_admitted_total", "准入入队的日志数",
+                       static_cast<double>(admitted_[i].load(std::memory_order_relaxed)),
+                       {{"level", common::RecordBatch::LevelName(static_cast<common::LogLevel>(i))}});
+    }
+    for (size_t i = 0; i < kLogLevelCount; ++i) {
+        writer.Counter("xumj_processor_admission_rejected_total", "保留容量也已用完而拒绝的日志数",
+                       static_cast<double>(rejected_[i].load(std::memory_order_relaxed)),
+                       {{"level", common::RecordBatch::LevelName(static_cast<common::LogLevel>(i))}});
+    }
+    for (const auto& stat : GetShedStats()) {
+        writer.Counter("xumj_processor_shed_total", "按级别和来源配额主动丢弃的日志数",
+                       static_cast<double>(stat.count),
+                       {{"source", stat.source}, {"level", common::RecordBatch::LevelName(stat.level)}});
+    }
+}
+
+} // namespace processor
+} // namespace xumj
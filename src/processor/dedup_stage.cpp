@@ -0,0 +1,183 @@
+#include "xumj/processor/dedup_stage.h"
+#include <string>
+
+namespace xumj {
+namespace processor {
+
+namespace {
+
+constexpr uint64_t kFnvOffset = 1469598103934665603ull;
+constexpr uint64_t kFnvPrime = 1099511628211ull;
+
+uint64_t Combine(uint64_t seed, uint64_t value) {
+    return seed ^ (value + 0x9E3779B97F4A7C15ull + (seed << 6) + (seed >> 2));
+}
+
+// 一条被合并记录占用的内存（估算）
+size_t RecordBytes(const analyzer::LogRecord& record) {
+    size_t bytes = sizeof(analyzer::LogRecord) + record.id.size() + record.timestamp.size() * 2 +
+                   record.level.size() + record.source.size() + record.message.size();
+    for (const auto& [name, value] : record.fields) {
+        bytes += name.size() + value.size() + 64;
+    }
+    return bytes;
+}
+
+} // namespace
+
+uint64_t NormalizedMessageHash(std::string_view message, bool normalizeNumbers) {
+    uint64_t hash = kFnvOffset;
+    auto mix = [&hash](unsigned char c) {
+        hash ^= c;
+        hash *= kFnvPrime;
+    };
+    for (size_t i = 0; i < message.size();) {
+        unsigned char c = static_cast<unsigned char>(message[i]);
+        if (c == ' ' || c == '\t' || c == '\r' || c == '\n') {
+            while (i < message.size() && (message[i] == ' ' || message[i] == '\t' ||
+                                          message[i] == '\r' || message[i] == '\n')) {
+                ++i;
+            }
+            mix(' ');
+        } else if (normalizeNumbers && c >= '0' && c <= '9') {
+            while (i < message.size() && message[i] >= '0' && message[i] <= '9') {
+                ++i;
+            }
+            mix('#');
+        } else {
+            mix(c);
+            ++i;
+        }
+    }
+    return hash;
+}
+
+DedupStage::DedupStage(const DedupConfig& config) : config_(config) {
+}
+
+bool DedupStage::Reserve(size_t bytes) {
+    size_t current = memoryBytes_.load(std::memory_order_relaxed);
+    do {
+        if (current + bytes > config_.maxMemoryBytes) {
+            return false;
+        }
+    } while (!memoryBytes_.compare_exchange_weak(current, current + bytes, std::memory_order_relaxed));
+    return true;
+}
+
+bool DedupStage::Offer(const analyzer::LogRecord& record, std::function<void(bool)>& onComplete,
+                       Clock::time_point now) {
+    uint64_t key = NormalizedMessageHash(record.message, config_.normalizeNumbers);
+    key = Combine(key, std::hash<std::string>{}(record.source));
+    key = Combine(key, std::hash<std::string>{}(record.level));
+    Stripe& stripe = stripes_[key % kStripes];
+
+    std::lock_guard<std::mutex> lock(stripe.mutex);
+    auto it = stripe.entries.find(key);
+    if (it == stripe.entries.end()) {
+        // 第一次出现：照常存储，开始一个窗口
+        size_t bytes = sizeof(Entry) + record.source.size() + record.level.size() + 64;
+        if (!Reserve(bytes)) {
+            untracked_.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        Entry& entry = stripe.entries[key];
+        entry.source = record.source;
+        entry.level = record.level;
+        entry.expires = now + config_.window;
+        entry.bytes = bytes;
+        stripe.expiry.emplace_back(entry.expires, key);
+        tracked_.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    // 哈希冲突或窗口已结束（等待下一次TakeExpired取出）时照常存储
+    Entry& entry = it->second;
+    if (entry.source != record.source || entry.level != record.level || now >= entry.expires) {
+        return false;
+    }
+
+    size_t bytes = sizeof(std::function<void(bool)>) + (entry.repeats == 0 ? RecordBytes(record) : 0);
+    if (!Reserve(bytes)) {
+        untracked_.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    entry.bytes += bytes;
+    if (entry.repeats == 0) {
+        entry.summary.record = record;
+    }
+    entry.lastSeen = record.timestamp;
+    if (onComplete) {
+        entry.summary.callbacks.push_back(std::move(onComplete));
+        onComplete = nullptr;
+    }
+    entry.repeats++;
+    absorbed_.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
+void DedupStage::Retire(Stripe& stripe, uint64_t key, std::vector<DedupSummary>& summaries, size_t& produced) {
+    auto it = stripe.entries.find(key);
+    if (it == stripe.entries.end()) {
+        return;
+    }
+    Entry& entry = it->second;
+    if (entry.repeats > 0) {
+        auto& fields = entry.summary.record.fields;
+        fields["repeat_count"] = std::to_string(entry.repeats);
+        fields["first_seen"] = entry.summary.record.timestamp;
+        fields["last_seen"] = entry.lastSeen;
+        summaries.push_back(std::move(entry.summary));
+        ++produced;
+        summaries_.fetch_add(1, std::memory_order_relaxed);
+    }
+    memoryBytes_.fetch_sub(entry.bytes, std::memory_order_relaxed);
+    tracked_.fetch_sub(1, std::memory_order_relaxed);
+    stripe.entries.erase(it);
+}
+
+size_t DedupStage::TakeExpired(Clock::time_point now, std::vector<DedupSummary>& summaries) {
+    size_t produced = 0;
+    for (auto& stripe : stripes_) {
+        std::lock_guard<std::mutex> lock(stripe.mutex);
+        while (!stripe.expiry.empty() && stripe.expiry.front().first <= now) {
+            auto [expires, key] = stripe.expiry.front();
+            stripe.expiry.pop_front();
+            // 同一个键可能已被取出并重新开始了新窗口，只取出与该条目对应的窗口
+            auto it = stripe.entries.find(key);
+            if (it != stripe.entries.end() && it->second.expires == expires) {
+                Retire(stripe, key, summaries, produced);
+            }
+        }
+    }
+    return produced;
+}
+
+size_t DedupStage::TakeAll(std::vector<DedupSummary>& summaries) {
+    size_t produced = 0;
+    for (auto& stripe : stripes_) {
+        std::lock_guard<std::mutex> lock(stripe.mutex);
+        for (const auto& [expires, key] : stripe.expiry) {
+            (void)expires;
+            Retire(stripe, key, summaries, produced);
+        }
+        stripe.expiry.clear();
+    }
+    return produced;
+}
+
+void DedupStage::WritePrometheusMetrics(common::PrometheusWriter& writer) const {
+    writer.Counter("xumj_processor_dedup_absorbed_total", "合并到汇总记录中、未单独存储的重复日志数",
+                   static_cast<double>(GetAbsorbedCount()));
+    writer.Counter("xumj_processor_dedup_summaries_total", "存储的重复日志汇总记录数",
+                   static_cast<double>(GetSummaryCount()));
+    writer.Counter("xumj_processor_dedup_untracked_total", "因合并表内存已满而未参与合并的日志数",
+                   static_cast<double>(GetUntrackedCount()));
+    writer.Gauge("xumj_processor_dedup_tracked_keys", "合并表中正在计时的分组数",
+                 static_cast<double>(GetTrackedCount()));
+    writer.Gauge("xumj_processor_dedup_memory_bytes", "合并表占用内存（估算）",
+                 static_cast<double>(GetMemoryBytes()));
+}
+
+} // namespace processor
+} // namespace xumj
@@ -0,0 +1,576 @@
+#include "xumj/processor/grok_parser.h"
+#include <iostream>
+#include <map>
+#include <utility>
+
+namespace xumj {
+namespace processor {
+
+namespace {
+
+constexpr uint32_t kUnbounded = UINT32_MAX;     // 原子次数不限
+constexpr uint32_t kNoRegister = UINT32_MAX;    // 不捕获的字段
+constexpr uint64_t kDead = UINT64_MAX;          // 模式已失配
+constexpr size_t kMaxStates = 10000;            // DFA状态数上限
+
+template <typename Pred>
+std::bitset<256> MakeSet(Pred pred) {
+    std::bitset<256> set;
+    for (int c = 0; c < 256; ++c) {
+        if (pred(static_cast<unsigned char>(c))) {
+            set.set(static_cast<size_t>(c));
+        }
+    }
+    return set;
+}
+
+bool IsDigit(unsigned char c) { return c >= '0' && c <= '9'; }
+bool IsAlpha(unsigned char c) { return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z'); }
+bool IsSpace(unsigned char c) { return c == ' ' || c == '\t' || c == '\r' || c == '\n' || c == '\f' || c == '\v'; }
+
+// 分隔符已匹配j个字符时读入c后已匹配的长度（KMP）
+uint32_t DelimiterNext(const std::string& delimiter, uint32_t j, unsigned char c) {
+    for (;;) {
+        if (static_cast<unsigned char>(delimiter[j]) == c) {
+            return j + 1;
+        }
+        if (j == 0) {
+            return 0;
+        }
+        // 回退到delimiter[0, j)的最长真前后缀
+        uint32_t k = j - 1;
+        while (k > 0 && delimiter.compare(0, k, delimiter, j - k, k) != 0) {
+            --k;
+        }
+        j = k;
+    }
+}
+
+uint64_t Encode(uint32_t atom, uint32_t count) {
+    return (static_cast<uint64_t>(atom) << 32) | count;
+}
+
+} // namespace
+
+bool GrokMatcher::ParsePattern(const std::string& text, Pattern& pattern) {
+    pattern.text = text;
+    pattern.fieldNames.clear();
+    pattern.atoms.clear();
+
+    std::vector<RegisterOp> pending;   // 加到下一个原子上的字段边界
+    bool greedy = false;
+    auto push = [&](Atom atom) {
+        atom.enter = std::move(pending);
+        pending.clear();
+        pattern.atoms.push_back(std::move(atom));
+    };
+    auto pushClass = [&](const std::bitset<256>& set, uint32_t min, uint32_t max) {
+        Atom atom;
+        atom.set = set;
+        atom.min = min;
+        atom.max = max;
+        push(std::move(atom));
+    };
+    auto pushLiteral = [&](unsigned char c) {
+        std::bitset<256> set;
+        set.set(c);
+        pushClass(set, 1, 1);
+    };
+
+    static const std::bitset<256> digit = MakeSet(IsDigit);
+    static const std::bitset<256> sign = MakeSet([](unsigned char c) { return c == '+' || c == '-'; });
+
+    for (size_t i = 0; i < text.size();) {
+        if (greedy) {
+            std::cerr << "grok模式错误: GREEDY只能是最后一个字段: " << text << std::endl;
+            return false;
+        }
+        unsigned char c = static_cast<unsigned char>(text[i]);
+        if (c == '\\') {
+            if (i + 1 >= text.size()) {
+                std::cerr << "grok模式错误: 末尾的转义符: " << text << std::endl;
+                return false;
+            }
+            pushLiteral(static_cast<unsigned char>(text[i + 1]));
+            i += 2;
+            continue;
+        }
+        if (c != '%' || i + 1 >= text.size() || text[i + 1] != '{') {
+            pushLiteral(c);
+            ++i;
+            continue;
+        }
+
+        size_t close = text.find('}', i + 2);
+        if (close == std::string::npos) {
+            std::cerr << "grok模式错误: 字段缺少'}': " << text << std::endl;
+            return false;
+        }
+        std::string spec = text.substr(i + 2, close - i - 2);
+        i = close + 1;
+        size_t colon = spec.find(':');
+        std::string type = spec.substr(0, colon);
+        std::string name = colon == std::string::npos ? "" : spec.substr(colon + 1);
+
+        uint32_t field = kNoRegister;
+        if (!name.empty()) {
+            field = static_cast<uint32_t>(pattern.fieldNames.size());
+            pattern.fieldNames.push_back(name);
+            pending.push_back({2 * field, 0});
+        }
+
+        if (type == "WORD") {
+            pushClass(MakeSet([](unsigned char ch) { return IsAlpha(ch) || IsDigit(ch) || ch == '_'; }), 1, kUnbounded);
+        } else if (type == "NOTSPACE") {
+            pushClass(MakeSet([](unsigned char ch) { return !IsSpace(ch); }), 1, kUnbounded);
+        } else if (type == "INT") {
+            pushClass(sign, 0, 1);
+            pushClass(digit, 1, kUnbounded);
+        } else if (type == "NUMBER") {
+            pushClass(sign, 0, 1);
+            pushClass(digit, 1, kUnbounded);
+            pushClass(MakeSet([](unsigned char ch) { return ch == '.'; }), 0, 1);
+            pushClass(digit, 0, kUnbounded);
+        } else if (type == "LEVEL") {
+            pushClass(MakeSet(IsAlpha), 1, kUnbounded);
+        } else if (type == "IP") {
+            pushClass(MakeSet([](unsigned char ch) {
+                return IsDigit(ch) || (ch >= 'a' && ch <= 'f') || (ch >= 'A' && ch <= 'F') || ch == ':' || ch == '.';
+            }), 1, kUnbounded);
+        } else if (type == "TIMESTAMP") {
+            pushClass(digit, 4, 4);
+            pushLiteral('-');
+            pushClass(digit, 2, 2);
+            pushLiteral('-');
+            pushClass(digit, 2, 2);
+            pushClass(MakeSet([](unsigned char ch) { return ch == 'T' || ch == ' '; }), 1, 1);
+            pushClass(digit, 2, 2);
+            pushLiteral(':');
+            pushClass(digit, 2, 2);
+            pushLiteral(':');
+            pushClass(digit, 2, 2);
+            pushClass(MakeSet([](unsigned char ch) { return ch == '.' || ch == ','; }), 0, 1);
+            pushClass(digit, 0, kUnbounded);
+        } else if (type == "DATA") {
+            Atom atom;
+            atom.kind = Atom::Kind::DATA;
+            atom.endRegister = field == kNoRegister ? kNoRegister : 2 * field + 1;
+            push(std::move(atom));
+            continue;   // 结束边界由分隔符决定
+        } else if (type == "GREEDY") {
+            pushClass(MakeSet([](unsigned char) { return true; }), 0, kUnbounded);
+            greedy = true;
+        } else {
+            std::cerr << "grok模式错误: 未知的字段类型 " << type << ": " << text << std::endl;
+            return false;
+        }
+        if (field != kNoRegister) {
+            pending.push_back({2 * field + 1, 0});
+        }
+    }
+    Atom end;
+    end.kind = Atom::Kind::END;
+    push(std::move(end));
+
+    auto& atoms = pattern.atoms;
+    auto isLiteral = [](const Atom& atom) {
+        return atom.kind == Atom::Kind::CLASS && atom.min == 1 && atom.max == 1 && atom.set.count() == 1;
+    };
+    for (size_t k = 0; k + 1 < atoms.size(); ++k) {
+        // 次数不限的原子不吞掉紧随其后的字面量字符，例如%{NOTSPACE:path}"在第一个引号处结束
+        if (atoms[k].kind == Atom::Kind::CLASS && atoms[k].max == kUnbounded && isLiteral(atoms[k + 1])) {
+            atoms[k].set &= ~atoms[k + 1].set;
+        }
+    }
+
+    // DATA的分隔符是紧随其后、中间没有字段边界的字面量
+    for (size_t k = 0; k < atoms.size(); ++k) {
+        if (atoms[k].kind != Atom::Kind::DATA) {
+            continue;
+        }
+        if (atoms[k + 1].kind == Atom::Kind::END) {
+            // 模式末尾的DATA等价于GREEDY
+            atoms[k].kind = Atom::Kind::CLASS;
+            atoms[k].set.set();
+            atoms[k].min = 0;
+            atoms[k].max = kUnbounded;
+            if (atoms[k].endRegister != kNoRegister) {
+                atoms[k + 1].enter.insert(atoms[k + 1].enter.begin(), {atoms[k].endRegister, 0});
+            }
+            continue;
+        }
+        std::string delimiter;
+        for (size_t j = k + 1; j < atoms.size(); ++j) {
+            const Atom& next = atoms[j];
+            if (!isLiteral(next) || !next.enter.empty()) {
+                break;
+            }
+            for (size_t c = 0; c < 256; ++c) {
+                if (next.set.test(c)) {
+                    delimiter.push_back(static_cast<char>(c));
+                    break;
+                }
+            }
+        }
+        if (delimiter.empty()) {
+            std::cerr << "grok模式错误: DATA字段后面必须是字面量: " << text << std::endl;
+            return false;
+        }
+        atoms[k].delimiter = std::move(delimiter);
+    }
+    return true;
+}
+
+bool GrokMatcher::Step(const Pattern& pattern, LocalState& state, uint8_t byte, std::vector<RegisterOp>& ops) {
+    for (;;) {
+        const Atom& atom = pattern.atoms[state.atom];
+        if (atom.kind == Atom::Kind::END) {
+            return false;
+        }
+        if (atom.kind == Atom::Kind::DATA) {
+            uint32_t length = static_cast<uint32_t>(atom.delimiter.size());
+            uint32_t matched = DelimiterNext(atom.delimiter, state.count, byte);
+            if (matched < length) {
+                state.count = matched;
+                return true;
+            }
+            // 分隔符匹配完成：字段在分隔符开始处结束，越过分隔符后到达下一个原子
+            if (atom.endRegister != kNoRegister) {
+                ops.push_back({atom.endRegister, 1 - static_cast<int32_t>(length)});
+            }
+            state.atom += 1 + length;
+            state.count = 0;
+            for (const auto& op : pattern.atoms[state.atom].enter) {
+                ops.push_back({op.reg, op.offset + 1});
+            }
+            return true;
+        }
+        if (atom.set.test(byte) && state.count < atom.max) {
+            ++state.count;
+            // 次数不限时达到最少次数后的状态都等价
+            if (atom.max == kUnbounded && state.count > atom.min) {
+                state.count = atom.min;
+            }
+            return true;
+        }
+        if (state.count < atom.min) {
+            return false;
+        }
+        ++state.atom;
+        state.count = 0;
+        ops.insert(ops.end(), pattern.atoms[state.atom].enter.begin(), pattern.atoms[state.atom].enter.end());
+    }
+}
+
+bool GrokMatcher::Finish(const Pattern& pattern, LocalState state, std::vector<RegisterOp>& ops) {
+    for (;;) {
+        const Atom& atom = pattern.atoms[state.atom];
+        if (atom.kind == Atom::Kind::END) {
+            return true;
+        }
+        if (atom.kind == Atom::Kind::DATA || state.count < atom.min) {
+            return false;
+        }
+        ++state.atom;
+        state.count = 0;
+        ops.insert(ops.end(), pattern.atoms[state.atom].enter.begin(), pattern.atoms[state.atom].enter.end());
+    }
+}
+
+bool GrokMatcher::AddPattern(const std::string& pattern) {
+    Pattern compiled;
+    if (!ParsePattern(pattern, compiled)) {
+        return false;
+    }
+    patterns_.push_back(std::move(compiled));
+    compiled_ = false;
+    return true;
+}
+
+const std::vector<std::string>& GrokMatcher::GetFieldNames(size_t pattern) const {
+    return patterns_.at(pattern).fieldNames;
+}
+
+bool GrokMatcher::Compile() {
+    compiled_ = false;
+    transitions_.clear();
+    opLists_.assign(1, {});
+    initialOps_.clear();
+    acceptPattern_.clear();
+    finalOps_.clear();
+    registerBase_.clear();
+    registerCount_ = 0;
+    for (const auto& pattern : patterns_) {
+        registerBase_.push_back(registerCount_);
+        registerCount_ += static_cast<uint32_t>(2 * pattern.fieldNames.size());
+    }
+
+    // 字节等价类：所有原子和分隔符都无法区分的字节归为一类
+    std::vector<std::bitset<256>> sets;
+    for (const auto& pattern : patterns_) {
+        for (const auto& atom : pattern.atoms) {
+            if (atom.kind == Atom::Kind::CLASS) {
+                sets.push_back(atom.set);
+            }
+            for (char c : atom.delimiter) {
+                std::bitset<256> single;
+                single.set(static_cast<unsigned char>(c));
+                sets.push_back(single);
+            }
+        }
+    }
+    std::map<std::vector<bool>, uint8_t> classes;
+    std::vector<uint8_t> representative;
+    for (int b = 0; b < 256; ++b) {
+        std::vector<bool> signature(sets.size());
+        for (size_t s = 0; s < sets.size(); ++s) {
+            signature[s] = sets[s].test(static_cast<size_t>(b));
+        }
+        auto it = classes.find(signature);
+        if (it == classes.end()) {
+            it = classes.emplace(std::move(signature), static_cast<uint8_t>(representative.size())).first;
+            representative.push_back(static_cast<uint8_t>(b));
+        }
+        byteClass_[b] = it->second;
+    }
+    classCount_ = representative.size();
+
+    // 模式内寄存器编号换算为全局编号
+    auto appendOps = [this](size_t p, const std::vector<RegisterOp>& local, std::vector<RegisterOp>& global) {
+        for (const auto& op : local) {
+            global.push_back({registerBase_[p] + op.reg, op.offset});
+        }
+    };
+    std::map<std::vector<uint64_t>, uint32_t> opIndex;
+    auto intern = [this, &opIndex](std::vector<RegisterOp>&& ops) -> uint32_t {
+        if (ops.empty()) {
+            return 0;
+        }
+        std::vector<uint64_t> key;
+        for (const auto& op : ops) {
+            key.push_back((static_cast<uint64_t>(op.reg) << 32) | static_cast<uint32_t>(op.offset));
+        }
+        auto it = opIndex.find(key);
+        if (it != opIndex.end()) {
+            return it->second;
+        }
+        uint32_t index = static_cast<uint32_t>(opLists_.size());
+        opLists_.push_back(std::move(ops));
+        opIndex.emplace(std::move(key), index);
+        return index;
+    };
+
+    // 子集构造：DFA状态为各模式的局部状态组合，每个模式在任一时刻最多一个局部状态
+    std::map<std::vector<uint64_t>, int32_t> ids;
+    std::vector<std::vector<uint64_t>> states;
+    std::vector<uint64_t> initial;
+    for (size_t p = 0; p < patterns_.size(); ++p) {
+        initial.push_back(Encode(0, 0));
+        appendOps(p, patterns_[p].atoms[0].enter, initialOps_);
+    }
+    ids.emplace(initial, 0);
+    states.push_back(std::move(initial));
+
+    std::vector<RegisterOp> local;
+    for (size_t s = 0; s < states.size(); ++s) {
+        const std::vector<uint64_t> current = states[s];
+
+        // 输入在此结束时接受的模式
+        int32_t accept = -1;
+        std::vector<RegisterOp> finalOps;
+        for (size_t p = 0; p < patterns_.size() && accept < 0; ++p) {
+            if (current[p] == kDead) {
+                continue;
+            }
+            local.clear();
+            LocalState state{static_cast<uint32_t>(current[p] >> 32), static_cast<uint32_t>(current[p])};
+            if (Finish(patterns_[p], state, local)) {
+                accept = static_cast<int32_t>(p);
+                appendOps(p, local, finalOps);
+            }
+        }
+        acceptPattern_.push_back(accept);
+        finalOps_.push_back(std::move(finalOps));
+
+        transitions_.resize((s + 1) * classCount_);
+        for (size_t c = 0; c < classCount_; ++c) {
+            std::vector<uint64_t> next(patterns_.size(), kDead);
+            std::vector<RegisterOp> ops;
+            bool alive = false;
+            for (size_t p = 0; p < patterns_.size(); ++p) {
+                if (current[p] == kDead) {
+                    continue;
+                }
+                local.clear();
+                LocalState state{static_cast<uint32_t>(current[p] >> 32), static_cast<uint32_t>(current[p])};
+                if (Step(patterns_[p], state, representative[c], local)) {
+                    next[p] = Encode(state.atom, state.count);
+                    appendOps(p, local, ops);
+                    alive = true;
+                }
+            }
+
+            int32_t target = -1;
+            if (alive) {
+                auto it = ids.find(next);
+                if (it == ids.end()) {
+                    if (states.size() >= kMaxStates) {
+                        std::cerr << "grok模式编译失败: DFA状态数超过" << kMaxStates << std::endl;
+                        return false;
+                    }
+                    it = ids.emplace(next, static_cast<int32_t>(states.size())).first;
+                    states.push_back(std::move(next));
+                }
+                target = it->second;
+            }
+            transitions_[s * classCount_ + c] = {target, intern(std::move(ops))};
+        }
+    }
+    compiled_ = true;
+    return true;
+}
+
+bool GrokMatcher::Match(std::string_view line, Result& result) const {
+    result.pattern = -1;
+    result.values.clear();
+    if (!compiled_ || patterns_.empty()) {
+        return false;
+    }
+    result.registers.resize(registerCount_);
+    size_t* registers = result.registers.data();
+    for (const auto& op : initialOps_) {
+        registers[op.reg] = static_cast<size_t>(op.offset);
+    }
+
+    const auto* data = reinterpret_cast<const unsigned char*>(line.data());
+    const size_t length = line.size();
+    int32_t state = 0;
+    for (size_t i = 0; i < length; ++i) {
+        const Transition& t = transitions_[static_cast<size_t>(state) * classCount_ + byteClass_[data[i]]];
+        if (t.next < 0) {
+            return false;
+        }
+        if (t.ops != 0) {
+            for (const auto& op : opLists_[t.ops]) {
+                registers[op.reg] = static_cast<size_t>(static_cast<int64_t>(i) + op.offset);
+            }
+        }
+        state = t.next;
+    }
+
+    int32_t pattern = acceptPattern_[static_cast<size_t>(state)];
+    if (pattern < 0) {
+        return false;
+    }
+    for (const auto& op : finalOps_[static_cast<size_t>(state)]) {
+        registers[op.reg] = static_cast<size_t>(static_cast<int64_t>(length) + op.offset);
+    }
+    uint32_t base = registerBase_[static_cast<size_t>(pattern)];
+    size_t fieldCount = patterns_[static_cast<size_t>(pattern)].fieldNames.size();
+    for (size_t f = 0; f < fieldCount; ++f) {
+        size_t begin = registers[base + 2 * f];
+        size_t end = registers[base + 2 * f + 1];
+        result.values.emplace_back(line.data() + begin, end - begin);
+    }
+    result.pattern = pattern;
+    return true;
+}
+
+// GrokLogParser实现
+bool GrokLogParser::AddPattern(const std::string& pattern, const std::string& source) {
+    GrokMatcher probe;
+    if (!probe.AddPattern(pattern)) {
+        return false;
+    }
+    if (source.empty()) {
+        commonPatterns_.push_back(pattern);
+    } else {
+        sourcePatterns_[source].push_back(pattern);
+    }
+    if (Rebuild()) {
+        return true;
+    }
+    
+    // 加入新模式后编译失败（DFA状态过多），撤销该模式并按原来的模式重新编译，已有模式照常匹配
+    if (source.empty()) {
+        commonPatterns_.pop_back();
+    } else {
+        auto it = sourcePatterns_.find(source);
+        it->second.pop_back();
+        if (it->second.empty()) {
+            sourcePatterns_.erase(it);
+        }
+    }
+    Rebuild();
+    return false;
+}
+
+bool GrokLogParser::Rebuild() {
+    bool ok = true;
+    commonMatcher_ = GrokMatcher();
+    for (const auto& pattern : commonPatterns_) {
+        commonMatcher_.AddPattern(pattern);
+    }
+    ok = commonMatcher_.Compile() && ok;
+
+    sourceMatchers_.clear();
+    for (const auto& [source, patterns] : sourcePatterns_) {
+        GrokMatcher& matcher = sourceMatchers_[source];
+        for (const auto& pattern : patterns) {
+            matcher.AddPattern(pattern);
+        }
+        for (const auto& pattern : commonPatterns_) {
+            matcher.AddPattern(pattern);
+        }
+        ok = matcher.Compile() && ok;
+    }
+    return ok;
+}
+
+bool GrokLogParser::Parse(const LogData& logData, analyzer::LogRecord& record) {
+    const GrokMatcher* matcher = &commonMatcher_;
+    if (!sourceMatchers_.empty()) {
+        auto it = sourceMatchers_.find(logData.fields.source.value_or(logData.source));
+        if (it != sourceMatchers_.end()) {
+            matcher = &it->second;
+        }
+    }
+
+    std::string_view line(logData.message);
+    while (!line.empty() && (line.back() == '\n' || line.back() == '\r')) {
+        line.remove_suffix(1);
+    }
+    thread_local GrokMatcher::Result result;
+    if (!matcher->Match(line, result)) {
+        if (config_.debug) {
+            std::cout << "GrokLogParser: 没有匹配的模式，ID=" << logData.id << std::endl;
+        }
+        return false;
+    }
+
+    record.id = logData.id;
+    record.timestamp = TimestampToString(logData.timestamp);
+    record.level = logData.fields.level.value_or("INFO");
+    record.source = logData.source;
+    record.message = logData.message;
+    const auto& names = matcher->GetFieldNames(static_cast<size_t>(result.pattern));
+    for (size_t f = 0; f < names.size(); ++f) {
+        const std::string& name = names[f];
+        std::string_view value = result.values[f];
+        if (name == "timestamp" || name == "ts" || name == "time") {
+            record.timestamp.assign(value);
+        } else if (name == "level") {
+            record.level.assign(value);
+        } else if (name == "message" || name == "msg") {
+            record.message.assign(value);
+        } else if (name == "source") {
+            record.source.assign(value);
+        } else {
+            record.fields[name] = std::string(value);
+        }
+    }
+    return true;
+}
+
+} // namespace processor
+} // namespace xumj
@@ -0,0 +1,512 @@
+#include "xumj/processor/json_field_extractor.h"
+#include <atomic>
+#include <cstring>
+#include <utility>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define XUMJ_JSON_X86 1
+#endif
+
+namespace xumj {
+namespace processor {
+
+namespace {
+
+constexpr int kMaxDepth = 256;   // 嵌套深度上限，防止恶意输入导致栈溢出
+
+// 返回[p, end)中第一个引号、反斜杠或控制字符的位置，找不到返回end
+using ScanFn = const char* (*)(const char* p, const char* end);
+
+const char* ScanScalar(const char* p, const char* end) {
+    while (p < end) {
+        unsigned char c = static_cast<unsigned char>(*p);
+        if (c == '"' || c == '\\' || c < 0x20) {
+            return p;
+        }
+        ++p;
+    }
+    return end;
+}
+
+#ifdef XUMJ_JSON_X86
+const char* ScanSse2(const char* p, const char* end) {
+    const __m128i quote = _mm_set1_epi8('"');
+    const __m128i backslash = _mm_set1_epi8('\\');
+    const __m128i control = _mm_set1_epi8(0x1F);
+    while (end - p >= 16) {
+        __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        // max(c, 0x1F) == 0x1F 等价于 c <= 0x1F（无符号）
+        __m128i hits = _mm_or_si128(
+            _mm_or_si128(_mm_cmpeq_epi8(chunk, quote), _mm_cmpeq_epi8(chunk, backslash)),
+            _mm_cmpeq_epi8(_mm_max_epu8(chunk, control), control));
+        int mask = _mm_movemask_epi8(hits);
+        if (mask != 0) {
+            return p + __builtin_ctz(static_cast<unsigned>(mask));
+        }
+        p += 16;
+    }
+    return ScanScalar(p, end);
+}
+
+__attribute__((target("avx2")))
+const char* ScanAvx2(const char* p, const char* end) {
+    const __m256i quote = _mm256_set1_epi8('"');
+    const __m256i backslash = _mm256_set1_epi8('\\');
+    const __m256i control = _mm256_set1_epi8(0x1F);
+    while (end - p >= 32) {
+        __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+        __m256i hits = _mm256_or_si256(
+            _mm256_or_si256(_mm256_cmpeq_epi8(chunk, quote), _mm256_cmpeq_epi8(chunk, backslash)),
+            _mm256_cmpeq_epi8(_mm256_max_epu8(chunk, control), control));
+        unsigned mask = static_cast<unsigned>(_mm256_movemask_epi8(hits));
+        if (mask != 0) {
+            return p + __builtin_ctz(mask);
+        }
+        p += 32;
+    }
+    return ScanSse2(p, end);
+}
+#endif
+
+ScanKernel ResolveKernel(ScanKernel kernel) {
+#ifdef XUMJ_JSON_X86
+    // 日志字段的字符串大多短于32字节，实测AVX2并不比SSE2快，默认使用SSE2
+    if (kernel == ScanKernel::AUTO) {
+        return ScanKernel::SSE2;
+    }
+    if (kernel == ScanKernel::AVX2 && !__builtin_cpu_supports("avx2")) {
+        return ScanKernel::SSE2;
+    }
+    return kernel;
+#else
+    (void)kernel;
+    return ScanKernel::SCALAR;
+#endif
+}
+
+ScanFn KernelFunction(ScanKernel kernel) {
+    switch (kernel) {
+#ifdef XUMJ_JSON_X86
+        case ScanKernel::AVX2: return ScanAvx2;
+        case ScanKernel::SSE2: return ScanSse2;
+#endif
+        default: return ScanScalar;
+    }
+}
+
+std::atomic<ScanKernel> gKernel{ResolveKernel(ScanKernel::AUTO)};
+std::atomic<ScanFn> gScan{KernelFunction(gKernel.load())};
+
+int HexValue(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+// 读取\u后的4位十六进制，p指向第一位
+bool ReadHex4(const char* p, const char* end, uint32_t& value) {
+    if (end - p < 4) {
+        return false;
+    }
+    value = 0;
+    for (int i = 0; i < 4; ++i) {
+        int h = HexValue(p[i]);
+        if (h < 0) {
+            return false;
+        }
+        value = (value << 4) | static_cast<uint32_t>(h);
+    }
+    return true;
+}
+
+void AppendUtf8(uint32_t cp, std::string& out) {
+    if (cp < 0x80) {
+        out.push_back(static_cast<char>(cp));
+    } else if (cp < 0x800) {
+        out.push_back(static_cast<char>(0xC0 | (cp >> 6)));
+        out.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+    } else if (cp < 0x10000) {
+        out.push_back(static_cast<char>(0xE0 | (cp >> 12)));
+        out.push_back(static_cast<char>(0x80 | ((cp >> 6) & 0x3F)));
+        out.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+    } else {
+        out.push_back(static_cast<char>(0xF0 | (cp >> 18)));
+        out.push_back(static_cast<char>(0x80 | ((cp >> 12) & 0x3F)));
+        out.push_back(static_cast<char>(0x80 | ((cp >> 6) & 0x3F)));
+        out.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+    }
+}
+
+// 校验UTF-8（RFC 3629）：拒绝截断的序列、超长编码、代理区和超过U+10FFFF的码点，与nlohmann一致
+bool IsValidUtf8(const char* p, const char* end) {
+    while (p < end) {
+        // 日志大多是ASCII，每次检查8字节的最高位
+        if (end - p >= 8) {
+            uint64_t word;
+            std::memcpy(&word, p, sizeof(word));
+            if ((word & 0x8080808080808080ull) == 0) {
+                p += 8;
+                continue;
+            }
+        }
+        unsigned char c = static_cast<unsigned char>(*p);
+        if (c < 0x80) {
+            ++p;
+            continue;
+        }
+        size_t length;
+        unsigned char low = 0x80;    // 第二个字节的范围
+        unsigned char high = 0xBF;
+        if (c >= 0xC2 && c <= 0xDF) {
+            length = 2;
+        } else if (c >= 0xE0 && c <= 0xEF) {
+            length = 3;
+            if (c == 0xE0) low = 0xA0;
+            if (c == 0xED) high = 0x9F;
+        } else if (c >= 0xF0 && c <= 0xF4) {
+            length = 4;
+            if (c == 0xF0) low = 0x90;
+            if (c == 0xF4) high = 0x8F;
+        } else {
+            return false;
+        }
+        if (static_cast<size_t>(end - p) < length) {
+            return false;
+        }
+        unsigned char second = static_cast<unsigned char>(p[1]);
+        if (second < low || second > high) {
+            return false;
+        }
+        for (size_t i = 2; i < length; ++i) {
+            if ((static_cast<unsigned char>(p[i]) & 0xC0) != 0x80) {
+                return false;
+            }
+        }
+        p += length;
+    }
+    return true;
+}
+
+// 解码已通过校验的转义字符串（不含两端引号）
+void DecodeString(std::string_view raw, std::string& out) {
+    const char* p = raw.data();
+    const char* end = p + raw.size();
+    while (p < end) {
+        if (*p != '\\') {
+            out.push_back(*p++);
+            continue;
+        }
+        ++p;
+        char e = *p++;
+        switch (e) {
+            case 'b': out.push_back('\b'); break;
+            case 'f': out.push_back('\f'); break;
+            case 'n': out.push_back('\n'); break;
+            case 'r': out.push_back('\r'); break;
+            case 't': out.push_back('\t'); break;
+            case 'u': {
+                uint32_t cp = 0;
+                ReadHex4(p, end, cp);
+                p += 4;
+                if (cp >= 0xD800 && cp <= 0xDBFF) {
+                    uint32_t low = 0;
+                    ReadHex4(p + 2, end, low);
+                    p += 6;
+                    cp = 0x10000 + ((cp - 0xD800) << 10) + (low - 0xDC00);
+                }
+                AppendUtf8(cp, out);
+                break;
+            }
+            default: out.push_back(e); break;   // " \ /
+        }
+    }
+}
+
+// 单次提取的解析状态
+class Parser {
+public:
+    Parser(std::string_view json, ScanFn scan)
+        : p_(json.data()), end_(json.data() + json.size()), scan_(scan) {}
+
+    void SkipWhitespace() {
+        while (p_ < end_ && (*p_ == ' ' || *p_ == '\t' || *p_ == '\n' || *p_ == '\r')) {
+            ++p_;
+        }
+    }
+
+    bool Peek(char c) const { return p_ < end_ && *p_ == c; }
+    bool AtEnd() const { return p_ == end_; }
+    void Advance() { ++p_; }
+
+    // p_指向开头的引号；输出引号之间的原始内容
+    bool ScanString(std::string_view& raw, bool& escaped) {
+        ++p_;
+        const char* start = p_;
+        escaped = false;
+        for (;;) {
+            p_ = scan_(p_, end_);
+            if (p_ == end_) {
+                return false;
+            }
+            char c = *p_;
+            if (c == '"') {
+                // 转义序列都是ASCII，整段一起校验
+                if (!IsValidUtf8(start, p_)) {
+                    return false;
+                }
+                raw = std::string_view(start, static_cast<size_t>(p_ - start));
+                ++p_;
+                return true;
+            }
+            if (c != '\\') {
+                return false;   // 未转义的控制字符
+            }
+            escaped = true;
+            if (++p_ == end_) {
+                return false;
+            }
+            char e = *p_++;
+            if (e == 'u') {
+                uint32_t cp = 0;
+                if (!ReadHex4(p_, end_, cp)) {
+                    return false;
+                }
+                p_ += 4;
+                if (cp >= 0xDC00 && cp <= 0xDFFF) {
+                    return false;   // 单独的低位代理
+                }
+                if (cp >= 0xD800 && cp <= 0xDBFF) {
+                    uint32_t low = 0;
+                    if (end_ - p_ < 6 || p_[0] != '\\' || p_[1] != 'u' ||
+                        !ReadHex4(p_ + 2, end_, low) || low < 0xDC00 || low > 0xDFFF) {
+                        return false;
+                    }
+                    p_ += 6;
+                }
+            } else if (e != '"' && e != '\\' && e != '/' && e != 'b' &&
+                       e != 'f' && e != 'n' && e != 'r' && e != 't') {
+                return false;
+            }
+        }
+    }
+
+    bool SkipValue(int depth) {
+        if (p_ == end_ || depth > kMaxDepth) {
+            return false;
+        }
+        std::string_view raw;
+        bool escaped;
+        switch (*p_) {
+            case '"': return ScanString(raw, escaped);
+            case '{': return SkipContainer(depth, '}', true);
+            case '[': return SkipContainer(depth, ']', false);
+            case 't': return SkipLiteral("true", 4);
+            case 'f': return SkipLiteral("false", 5);
+            case 'n': return SkipLiteral("null", 4);
+            default: return SkipNumber();
+        }
+    }
+
+private:
+    bool SkipContainer(int depth, char close, bool isObject) {
+        ++p_;
+        SkipWhitespace();
+        if (Peek(close)) {
+            ++p_;
+            return true;
+        }
+        for (;;) {
+            if (isObject) {
+                std::string_view key;
+                bool escaped;
+                if (!Peek('"') || !ScanString(key, escaped)) {
+                    return false;
+                }
+                SkipWhitespace();
+                if (!Peek(':')) {
+                    return false;
+                }
+                ++p_;
+                SkipWhitespace();
+            }
+            if (!SkipValue(depth + 1)) {
+                return false;
+            }
+            SkipWhitespace();
+            if (Peek(',')) {
+                ++p_;
+                SkipWhitespace();
+                continue;
+            }
+            if (Peek(close)) {
+                ++p_;
+                return true;
+            }
+            return false;
+        }
+    }
+
+    bool SkipLiteral(const char* literal, size_t length) {
+        if (static_cast<size_t>(end_ - p_) < length) {
+            return false;
+        }
+        for (size_t i = 0; i < length; ++i) {
+            if (p_[i] != literal[i]) {
+                return false;
+            }
+        }
+        p_ += length;
+        return true;
+    }
+
+    // -?(0|[1-9][0-9]*)(\.[0-9]+)?([eE][+-]?[0-9]+)?
+    bool SkipNumber() {
+        auto isDigit = [this]() { return p_ < end_ && *p_ >= '0' && *p_ <= '9'; };
+        if (Peek('-')) {
+            ++p_;
+        }
+        if (Peek('0')) {
+            ++p_;
+        } else if (isDigit()) {
+            while (isDigit()) ++p_;
+        } else {
+            return false;
+        }
+        if (Peek('.')) {
+            ++p_;
+            if (!isDigit()) return false;
+            while (isDigit()) ++p_;
+        }
+        if (Peek('e') || Peek('E')) {
+            ++p_;
+            if (Peek('+') || Peek('-')) ++p_;
+            if (!isDigit()) return false;
+            while (isDigit()) ++p_;
+        }
+        return true;
+    }
+
+    const char* p_;
+    const char* end_;
+    ScanFn scan_;
+};
+
+} // namespace
+
+JsonFieldExtractor::JsonFieldExtractor(std::vector<std::string> fields)
+    : fields_(std::move(fields)) {}
+
+bool JsonFieldExtractor::Extract(std::string_view json, Result& result) const {
+    result.values.assign(fields_.size(), std::string_view());
+    result.present.assign(fields_.size(), false);
+    result.decoded.clear();
+    // 解码后的长度不会超过原文，预留后视图不会因扩容失效
+    result.decoded.reserve(json.size());
+
+    Parser parser(json, gScan.load(std::memory_order_relaxed));
+    parser.SkipWhitespace();
+    if (!parser.Peek('{')) {
+        return false;
+    }
+    parser.Advance();
+    parser.SkipWhitespace();
+    if (parser.Peek('}')) {
+        parser.Advance();
+        parser.SkipWhitespace();
+        return parser.AtEnd();
+    }
+
+    std::string keyBuffer;
+    for (;;) {
+        std::string_view key;
+        bool keyEscaped;
+        if (!parser.Peek('"') || !parser.ScanString(key, keyEscaped)) {
+            return false;
+        }
+        if (keyEscaped) {
+            keyBuffer.clear();
+            DecodeString(key, keyBuffer);
+            key = keyBuffer;
+        }
+        parser.SkipWhitespace();
+        if (!parser.Peek(':')) {
+            return false;
+        }
+        parser.Advance();
+        parser.SkipWhitespace();
+
+        size_t index = fields_.size();
+        for (size_t i = 0; i < fields_.size(); ++i) {
+            if (key == fields_[i]) {
+                index = i;
+                break;
+            }
+        }
+
+        if (parser.Peek('"')) {
+            std::string_view raw;
+            bool escaped;
+            if (!parser.ScanString(raw, escaped)) {
+                return false;
+            }
+            if (index < fields_.size()) {
+                // 重复的键以最后一次出现为准
+                if (escaped) {
+                    size_t offset = result.decoded.size();
+                    DecodeString(raw, result.decoded);
+                    raw = std::string_view(result.decoded).substr(offset);
+                }
+                result.values[index] = raw;
+                result.present[index] = true;
+            }
+        } else {
+            if (!parser.SkipValue(1)) {
+                return false;
+            }
+            if (index < fields_.size()) {
+                result.values[index] = std::string_view();
+                result.present[index] = false;
+            }
+        }
+
+        parser.SkipWhitespace();
+        if (parser.Peek(',')) {
+            parser.Advance();
+            parser.SkipWhitespace();
+            continue;
+        }
+        if (parser.Peek('}')) {
+            parser.Advance();
+            break;
+        }
+        return false;
+    }
+
+    parser.SkipWhitespace();
+    return parser.AtEnd();
+}
+
+void JsonFieldExtractor::SetScanKernel(ScanKernel kernel) {
+    ScanKernel resolved = ResolveKernel(kernel);
+    gKernel.store(resolved, std::memory_order_relaxed);
+    gScan.store(KernelFunction(resolved), std::memory_order_relaxed);
+}
+
+ScanKernel JsonFieldExtractor::GetScanKernel() {
+    return gKernel.load(std::memory_order_relaxed);
+}
+
+const char* JsonFieldExtractor::ScanKernelName(ScanKernel kernel) {
+    switch (kernel) {
+        case ScanKernel::AUTO: return "auto";
+        case ScanKernel::SCALAR: return "scalar";
+        case ScanKernel::SSE2: return "sse2";
+        case ScanKernel::AVX2: return "avx2";
+    }
+    return "unknown";
+}
+
+} // namespace processor
+} // namespace xumj
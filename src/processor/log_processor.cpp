@@ -1,45 +1,282 @@
 #include "xumj/processor/log_processor.h"
 #include "xumj/storage/storage_factory.h"
+#include <bit>
 #include <iostream>
 #include <sstream>
 #include <regex>
 #include <iomanip>
 #include <fstream>
+#include <iterator>
+#include <deque>
 #include <nlohmann/json.hpp>
 #include <zlib.h>
-#include <uuid/uuid.h>
+#include "xumj/common/id_generator.h"
 #include "xumj/network/tcp_server.h"
 
 namespace xumj {
 namespace processor {
 
-// 生成UUID
-std::string GenerateUUID() {
-    uuid_t uuid;
-    uuid_generate(uuid);
-    char uuid_str[37];
-    uuid_unparse_lower(uuid, uuid_str);
-    return std::string(uuid_str);
+// 生成按时间递增的日志ID
+std::string GenerateLogId() {
+    return common::IdGenerator::Instance().NextString();
 }
 
 // 时间戳转字符串
 std::string TimestampToString(const std::chrono::system_clock::time_point& tp) {
     auto time_t_now = std::chrono::system_clock::to_time_t(tp);
-    std::tm tm_now = *std::localtime(&time_t_now);
+    std::tm tm_now{};
+    localtime_r(&time_t_now, &tm_now);   // 多个工作线程并发调用，不能使用std::localtime的静态缓冲区
     char buffer[30];
     std::strftime(buffer, sizeof(buffer), "%Y-%m-%d %H:%M:%S", &tm_now);
     return std::string(buffer);
 }
 
+namespace {
+
+// 将采集器发来的一条JSON日志转换为LogData
+LogData BuildLogData(const nlohmann::json& log) {
+    // 优先读取新字段
+    std::string msgStr = log.value("message", "");
+    std::string timeStr = log.value("timestamp", "");
+    std::string levelStr = log.value("level", "");
+    std::string sourceStr = log.value("source", "collector");
+
+    // 兼容老字段
+    if (msgStr.empty()) msgStr = log.value("content", "");
+    if (timeStr.empty()) timeStr = log.value("time", "");
+
+    LogData data;
+    data.message = msgStr;
+    data.id = log.contains("id") ? log.value("id", "") : GenerateLogId();
+    data.source = sourceStr;
+
+    // 解析时间
+    std::tm tm = {};
+    std::istringstream ss(timeStr);
+    ss >> std::get_time(&tm, "%Y-%m-%d %H:%M:%S");
+    if (!ss.fail()) {
+        data.timestamp = std::chrono::system_clock::from_time_t(std::mktime(&tm));
+    } else {
+        data.timestamp = std::chrono::system_clock::now();
+    }
+
+    // 信封中的字段已经解析过；正文本身不是JSON时无需再解析
+    if (!levelStr.empty()) {
+        data.fields.level = levelStr;
+    }
+    data.fields.source = sourceStr;
+    if (!timeStr.empty()) {
+        data.fields.timestamp = timeStr;
+    }
+    if (msgStr.empty() || msgStr.front() != '{') {
+        data.fields.format = PayloadFormat::TEXT;
+        data.fields.rawLength = msgStr.size();
+    }
+    return data;
+}
+
+// 当前线程已使用的CPU时间（纳秒）
+uint64_t ThreadCpuTimeNs() {
+    timespec ts{};
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return static_cast<uint64_t>(ts.tv_sec) * 1000000000ull + static_cast<uint64_t>(ts.tv_nsec);
+}
+
+// 取出JSON对象中的字符串字段
+std::optional<std::string> StringField(const nlohmann::json& j, const char* key) {
+    auto it = j.find(key);
+    if (it != j.end() && it->is_string()) {
+        return it->get<std::string>();
+    }
+    return std::nullopt;
+}
+
+uint64_t MicrosecondsSince(std::chrono::steady_clock::time_point start) {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - start).count());
+}
+
+// 批内每条日志的处理结果
+constexpr uint8_t kRowUnparsed = 0;      // 无法解析
+constexpr uint8_t kRowStored = 1;        // 已解析，逐条存储成功
+constexpr uint8_t kRowStoreFailed = 2;   // 已解析，逐条存储失败
+
+// 清空复用的记录，保留字符串已分配的内存
+void ResetRecord(analyzer::LogRecord& record) {
+    record.id.clear();
+    record.timestamp.clear();
+    record.level.clear();
+    record.source.clear();
+    record.message.clear();
+    record.fields.clear();
+}
+
+} // namespace
+
+// 队列分片：多个IO线程写入，同一时刻最多一个工作线程处理（claimed），保证分片内FIFO
+struct LogProcessor::QueueShard {
+    std::mutex mutex;
+    std::deque<LogData> queue;
+    std::atomic<bool> claimed{false};
+    std::atomic<size_t> depth{0};
+    std::atomic<size_t> maxDepth{0};
+    std::atomic<uint64_t> processed{0};
+    std::atomic<uint64_t> stolenBatches{0};
+};
+
+// 工作线程的唤醒信号，pending避免在检查分片与开始等待之间丢失通知
+struct LogProcessor::WorkerSignal {
+    std::mutex mutex;
+    std::condition_variable cv;
+    bool pending{false};
+    bool running{false};   // 主循环是否在运行
+};
+
+// 解析器快照：创建后不再修改，工作线程持有shared_ptr读取，无需加锁
+struct LogProcessor::ParserSnapshot {
+    static constexpr size_t kFormatCount = 4;
+    
+    std::vector<std::shared_ptr<LogParser>> parsers;     // 按添加顺序
+    std::vector<ProcessorMetrics::ParserMetrics*> metrics;   // 与parsers一一对应，更新时不查表不加锁
+    std::vector<size_t> candidates[kFormatCount];         // 每种格式依次尝试的解析器下标
+    
+    // 根据解析器声明的格式建立候选列表；没有解析器声明的格式尝试全部解析器
+    void BuildIndex() {
+        for (size_t f = 0; f < kFormatCount; ++f) {
+            candidates[f].clear();
+            for (size_t i = 0; i < parsers.size(); ++i) {
+                if (parsers[i]->SupportsFormat(static_cast<LogFormat>(f))) {
+                    candidates[f].push_back(i);
+                }
+            }
+            if (candidates[f].empty()) {
+                for (size_t i = 0; i < parsers.size(); ++i) {
+                    candidates[f].push_back(i);
+                }
+            }
+        }
+    }
+};
+
+// 每个工作线程记录各来源上次解析成功的解析器，只在本线程内访问
+struct LogProcessor::ParserAffinity {
+    static constexpr size_t kMaxSources = 4096;
+    
+    const ParserSnapshot* snapshot{nullptr};              // 下标所属的快照，快照变化时清空
+    std::unordered_map<std::string, size_t> bySource;     // 来源 -> 解析器下标
+    
+    void Bind(const ParserSnapshot& current) {
+        if (snapshot != &current) {
+            snapshot = &current;
+            bySource.clear();
+        }
+    }
+    
+    void Remember(const std::string& source, size_t parserIndex) {
+        if (bySource.size() >= kMaxSources && bySource.find(source) == bySource.end()) {
+            bySource.clear();
+        }
+        bySource[source] = parserIndex;
+    }
+};
+
+LogFormat SniffLogFormat(const std::string& message, PayloadFormat format) {
+    if (format == PayloadFormat::JSON || format == PayloadFormat::INVALID_JSON) {
+        return LogFormat::JSON;
+    }
+    size_t pos = message.find_first_not_of(" \t\r\n");
+    if (pos == std::string::npos) {
+        return LogFormat::PLAIN;
+    }
+    
+    // syslog：<PRI>，PRI为1到3位数字
+    if (message[pos] == '<') {
+        size_t i = pos + 1;
+        while (i < message.size() && i - pos <= 3 && message[i] >= '0' && message[i] <= '9') {
+            ++i;
+        }
+        if (i > pos + 1 && i < message.size() && message[i] == '>') {
+            return LogFormat::SYSLOG;
+        }
+        return LogFormat::PLAIN;
+    }
+    
+    // key=value：第一个词由字母、数字、'_'、'.'、'-'组成，后面紧跟'='
+    size_t i = pos;
+    while (i < message.size()) {
+        char c = message[i];
+        bool keyChar = (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') ||
+                       c == '_' || c == '.' || c == '-';
+        if (!keyChar) {
+            break;
+        }
+        ++i;
+    }
+    if (i > pos && i < message.size() && message[i] == '=') {
+        return LogFormat::KEY_VALUE;
+    }
+    return LogFormat::PLAIN;
+}
+
+PayloadFormat ParseLogFields(const std::string& message, ParsedFields& fields, JsonBackend backend) {
+    // 去掉首尾空白，记录原始消息体的位置
+    size_t begin = message.find_first_not_of(" \t\r\n");
+    size_t end = message.find_last_not_of(" \t\r\n");
+    if (begin == std::string::npos) {
+        fields.rawOffset = 0;
+        fields.rawLength = 0;
+        fields.format = PayloadFormat::TEXT;
+        return fields.format;
+    }
+    fields.rawOffset = begin;
+    fields.rawLength = end - begin + 1;
+    
+    if (message[begin] != '{' || message[end] != '}') {
+        fields.format = PayloadFormat::TEXT;
+        return fields.format;
+    }
+    
+    if (backend == JsonBackend::ON_DEMAND) {
+        // 字段顺序与下面的赋值顺序对应；LogData要跨线程排队，视图在这里复制为自有字符串
+        static const JsonFieldExtractor extractor({"timestamp", "level", "message", "source", "type"});
+        thread_local JsonFieldExtractor::Result result;
+        if (!extractor.Extract(std::string_view(message).substr(begin, fields.rawLength), result)) {
+            fields.format = PayloadFormat::INVALID_JSON;
+            return fields.format;
+        }
+        std::optional<std::string>* targets[] = {
+            &fields.timestamp, &fields.level, &fields.message, &fields.source, &fields.type
+        };
+        for (size_t i = 0; i < 5; ++i) {
+            if (result.Has(i)) {
+                targets[i]->emplace(result.values[i]);
+            }
+        }
+        fields.format = PayloadFormat::JSON;
+        return fields.format;
+    }
+    
+    auto j = nlohmann::json::parse(message.begin() + begin, message.begin() + end + 1, nullptr, false);
+    if (!j.is_object()) {
+        fields.format = PayloadFormat::INVALID_JSON;
+        return fields.format;
+    }
+    
+    if (auto v = StringField(j, "timestamp")) fields.timestamp = std::move(v);
+    if (auto v = StringField(j, "level")) fields.level = std::move(v);
+    if (auto v = StringField(j, "message")) fields.message = std::move(v);
+    if (auto v = StringField(j, "source")) fields.source = std::move(v);
+    if (auto v = StringField(j, "type")) fields.type = std::move(v);
+    fields.format = PayloadFormat::JSON;
+    return fields.format;
+}
+
 // JsonLogParser实现
 bool JsonLogParser::Parse(const LogData& logData, analyzer::LogRecord& record) {
-    using json = nlohmann::json;
-    
     if (config_.debug) {
     std::cout << "JsonLogParser: 尝试解析日志数据，ID=" << logData.id << std::endl;
     std::cout << "  源: " << logData.source << std::endl;
     std::cout << "  消息内容: " << (logData.message.length() > 50 ? logData.message.substr(0, 47) + "..." : logData.message) << std::endl;
-    std::cout << "  元数据数量: " << logData.metadata.size() << std::endl;
     }
     
     // 设置基本字段
@@ -47,46 +284,36 @@ bool JsonLogParser::Parse(const LogData& logData, analyzer::LogRecord& record) {
     record.timestamp = TimestampToString(logData.timestamp);
     record.source = logData.source;
     
-    // 优先用metadata里的level
-    if (logData.metadata.count("level")) {
-        record.level = logData.metadata.at("level");
-    }
-    
-    // 检查是否为JSON格式
-    bool isJsonFormat = false;
-    if (logData.metadata.count("is_json") && logData.metadata.at("is_json") == "true") {
-        isJsonFormat = true;
-    } else if (logData.message.length() > 1 && logData.message[0] == '{' && logData.message.back() == '}') {
-        isJsonFormat = true;
+    // 处理器在调用解析器前已经解析过消息体；单独使用解析器时在这里解析一次
+    ParsedFields localFields;
+    const ParsedFields* fields = &logData.fields;
+    if (fields->format == PayloadFormat::UNPARSED) {
+        localFields = logData.fields;
+        ParseLogFields(logData.message, localFields, config_.jsonBackend);
+        fields = &localFields;
     }
     
-    if (isJsonFormat) {
-        try {
-            json j = json::parse(logData.message);
-            if (j.contains("timestamp") && j["timestamp"].is_string())
-                record.timestamp = j["timestamp"].get<std::string>();
-            if (j.contains("level") && j["level"].is_string())
-                record.level = j["level"].get<std::string>();
-            if (j.contains("message") && j["message"].is_string())
-                record.message = j["message"].get<std::string>();
-            if (j.contains("source") && j["source"].is_string())
-                record.source = j["source"].get<std::string>();
-            // 其他字段略
+    switch (fields->format) {
+        case PayloadFormat::JSON:
+            if (fields->timestamp) record.timestamp = *fields->timestamp;
+            if (fields->level) record.level = *fields->level;
+            if (fields->source) record.source = *fields->source;
+            if (fields->message) {
+                record.message = *fields->message;
+            } else {
+                record.message = logData.message;
+            }
             if (config_.debug) std::cout << "JsonLogParser: 解析成功(JSON)" << std::endl;
             return true;
-        } catch (...) {
+        case PayloadFormat::INVALID_JSON:
             if (config_.debug) std::cout << "  JSON解析异常" << std::endl;
             return false;
-        }
-    } else {
-        // 普通文本日志，直接填充
-        record.message = logData.message;
-        if (record.level.empty() && logData.metadata.count("level"))
-            record.level = logData.metadata.at("level");
-        if (record.level.empty())
-            record.level = "INFO";
-        if (config_.debug) std::cout << "JsonLogParser: 兼容普通文本日志解析成功" << std::endl;
-        return true;
+        default:
+            // 普通文本日志，直接填充
+            record.message = logData.message;
+            record.level = fields->level ? *fields->level : "INFO";
+            if (config_.debug) std::cout << "JsonLogParser: 兼容普通文本日志解析成功" << std::endl;
+            return true;
     }
 }
 
@@ -100,6 +327,7 @@ LogProcessor::LogProcessor(const LogProcessorConfig& config)
     
     // 初始化指标
     metrics_.Reset();
+    totalMetrics_ = &metrics_.parserMetrics["total"];
     
     // 初始化存储
     if (config_.enableRedisStorage) {
@@ -116,8 +344,62 @@ LogProcessor::LogProcessor(const LogProcessorConfig& config)
         }
     }
     
+    // 原始消息归档写入MySQL，在独立线程中进行
+    if (config_.enableRawArchive && mysqlStorage_) {
+        auto mysql = mysqlStorage_;
+        rawArchiver_ = std::make_unique<RawArchiver>(
+            [mysql](const std::vector<RawArchiveEntry>& entries) {
+                common::RecordBatch batch;
+                for (const auto& raw : entries) {
+                    batch.Append(raw.id, raw.timestamp, raw.level, raw.source, raw.message);
+                }
+                return static_cast<size_t>(mysql->SaveRecordBatch(batch));
+            },
+            config_.rawArchiveQueueSize);
+    }
+    
+    // 入队准入控制
+    if (config_.admission.enabled) {
+        admission_ = std::make_unique<AdmissionController>(
+            config_.admission, static_cast<size_t>(std::max(config_.queueSize, 0)));
+    }
+    
+    // 重复日志合并
+    if (config_.dedup.enabled) {
+        dedup_ = std::make_unique<DedupStage>(config_.dedup);
+    }
+    
+    // 初始化队列分片；自适应时唤醒信号按最大线程数创建
+    size_t workers = static_cast<size_t>(std::max(config_.workerThreads, 1));
+    size_t maxWorkers = workers;
+    if (config_.adaptiveWorkers) {
+        maxWorkers = std::max(workers, config_.workerConcurrency.ResolvedMaxThreads());
+    }
+    size_t shardCount = config_.queueShards > 0 ? config_.queueShards : maxWorkers * 4;
+    for (size_t i = 0; i < shardCount; ++i) {
+        shards_.push_back(std::make_unique<QueueShard>());
+    }
+    for (size_t i = 0; i < maxWorkers; ++i) {
+        workerSignals_.push_back(std::make_unique<WorkerSignal>());
+    }
+    activeWorkers_ = workers;
+    
     // 初始化线程池
-    threadPool_ = std::make_unique<common::ThreadPool>(config_.workerThreads);
+    threadPool_ = std::make_unique<common::ThreadPool>(workers);
+    
+    // 自适应调整工作线程数：按积压和单条处理时间估计排队时间，Start()后开始调整
+    if (config_.adaptiveWorkers) {
+        workerController_ = std::make_unique<common::ConcurrencyController>(
+            config_.workerConcurrency, workers,
+            [this]() {
+                common::ConcurrencySample sample;
+                sample.queueDepth = dataCount_.load(std::memory_order_relaxed);
+                sample.completed = processedCount_.load(std::memory_order_relaxed);
+                sample.busyMicros = busyMicros_.load(std::memory_order_relaxed);
+                return sample;
+            },
+            [this](size_t count) { SetWorkerCount(count); });
+    }
 }
 
 LogProcessor::~LogProcessor() {
@@ -144,48 +426,198 @@ bool LogProcessor::Start() {
         analyzer_->Start();
     }
     
+    if (rawArchiver_) {
+        rawArchiver_->Start();
+    }
+    
     // 启动处理
     running_ = true;
     
     // 启动工作线程
-    for (int i = 0; i < config_.workerThreads; ++i) {
-        threadPool_->Submit([this]() {
-            while (running_) {
-                LogData data;
-                bool hasData = false;
-                
-                // 获取一个任务
-                {
-                    std::unique_lock<std::mutex> lock(queueMutex_);
-                    
-                    // 等待任务或停止信号
-                    queueCondVar_.wait(lock, [this] {
-                        return !running_ || !logQueue_.empty();
-                    });
-                    
-                    // 检查是否应该退出
-                    if (!running_ && logQueue_.empty()) {
-                        break;
-                    }
-                    
-                    // 获取任务
-                    if (!logQueue_.empty()) {
-                        data = std::move(logQueue_.front());
-                        logQueue_.pop();
-                        dataCount_--;
-                        hasData = true;
-                    }
-                }
-                
-                // 处理任务
-                if (hasData) {
-                    ProcessLogData(std::move(data));
+    size_t workers = activeWorkers_.load();
+    for (size_t i = 0; i < workers; ++i) {
+        LaunchWorker(i);
+    }
+    
+    if (workerController_) {
+        workerController_->Start();
+    }
+    
+    return true;
+}
+
+void LogProcessor::LaunchWorker(size_t workerIndex) {
+    WorkerSignal& signal = *workerSignals_[workerIndex];
+    {
+        std::lock_guard<std::mutex> lock(signal.mutex);
+        if (signal.running) {
+            return;  // 缩容后尚未退出的主循环会继续运行
+        }
+        signal.running = true;
+    }
+    threadPool_->Submit([this, workerIndex]() { WorkerLoop(workerIndex); });
+}
+
+void LogProcessor::SetWorkerCount(size_t count) {
+    std::lock_guard<std::mutex> lock(workersMutex_);
+    count = std::clamp<size_t>(count, 1, workerSignals_.size());
+    size_t current = activeWorkers_.load();
+    if (count == current || !threadPool_) {
+        return;
+    }
+    
+    if (count > current) {
+        // 先扩充线程池，再启动新的主循环
+        threadPool_->Resize(count);
+        activeWorkers_.store(count);
+        if (running_) {
+            for (size_t i = current; i < count; ++i) {
+                LaunchWorker(i);
+            }
+        }
+    } else {
+        // 编号不小于count的主循环处理完当前批次后退出，所在线程随后由线程池回收；
+        // 分片改由剩余线程处理，分片认领标记保证同一来源仍按顺序处理
+        activeWorkers_.store(count);
+        for (size_t i = 0; i < workerSignals_.size(); ++i) {
+            WakeWorker(i);
+        }
+        threadPool_->Resize(count);
+    }
+}
+
+void LogProcessor::WorkerLoop(size_t workerIndex) {
+    std::vector<LogData> batch;
+    batch.reserve(std::max<size_t>(1, config_.dequeueBatchSize));
+    WorkerSignal& signal = *workerSignals_[workerIndex];
+    ParserAffinity affinity;
+    
+    while (true) {
+        size_t workers = activeWorkers_.load();
+        if (!running_ || workerIndex >= workers) {
+            // 持有信号锁确认退出，与LaunchWorker互斥，避免退出时恰好又被扩容而没有重新启动
+            std::lock_guard<std::mutex> lock(signal.mutex);
+            if (running_ && workerIndex < activeWorkers_.load()) {
+                continue;
+            }
+            signal.running = false;
+            return;
+        }
+        
+        // 轮流处理自己的分片，每个分片每轮最多一批，避免热点分片饿死其他分片
+        bool didWork = false;
+        for (size_t shard = workerIndex; shard < shards_.size(); shard += workers) {
+            didWork = DrainShard(shard, workerIndex, batch, affinity) || didWork;
+        }
+        
+        // 自己的分片都空闲时，处理其他线程积压的分片
+        if (!didWork && config_.enableWorkStealing) {
+            for (size_t shard = 0; shard < shards_.size(); ++shard) {
+                if (shard % workers != workerIndex &&
+                    shards_[shard]->depth.load(std::memory_order_relaxed) >= config_.stealThreshold) {
+                    didWork = DrainShard(shard, workerIndex, batch, affinity) || didWork;
                 }
             }
-        });
+        }
+        if (didWork) {
+            continue;
+        }
+        
+        // 没有新数据时也要按时存储窗口已结束的重复日志汇总
+        if (dedup_) {
+            ProcessLogBatch(batch, affinity);
+        }
+        
+        // 等待新数据或停止信号；启用窃取时定期醒来检查其他分片，启用合并时定期醒来取出汇总
+        std::unique_lock<std::mutex> lock(signal.mutex);
+        auto ready = [this, &signal, workerIndex] {
+            return signal.pending || !running_ || workerIndex >= activeWorkers_.load();
+        };
+        if (config_.enableWorkStealing) {
+            signal.cv.wait_for(lock, std::chrono::milliseconds(5), ready);
+        } else if (dedup_) {
+            signal.cv.wait_for(lock, std::max(config_.dedup.window / 4, std::chrono::milliseconds(1)), ready);
+        } else {
+            signal.cv.wait(lock, ready);
+        }
+        signal.pending = false;
+    }
+}
+
+bool LogProcessor::DrainShard(size_t shardIndex, size_t workerIndex, std::vector<LogData>& batch,
+                              ParserAffinity& affinity) {
+    QueueShard& shard = *shards_[shardIndex];
+    if (shard.depth.load(std::memory_order_relaxed) == 0 ||
+        shard.claimed.exchange(true, std::memory_order_acquire)) {
+        return false;
     }
     
-    return true;
+    // 认领期间取出一段并处理完，下一段要等本段处理完成后才能被取出，保证分片内顺序
+    {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        size_t take = std::min(std::max<size_t>(1, config_.dequeueBatchSize), shard.queue.size());
+        auto last = shard.queue.begin() + static_cast<std::ptrdiff_t>(take);
+        std::move(shard.queue.begin(), last, std::back_inserter(batch));
+        shard.queue.erase(shard.queue.begin(), last);
+        shard.depth.fetch_sub(take, std::memory_order_relaxed);
+    }
+    dataCount_.fetch_sub(batch.size(), std::memory_order_relaxed);
+    if (admission_ && admission_->TracksSources()) {
+        for (const auto& data : batch) {
+            admission_->OnDequeued(std::hash<std::string>{}(data.source));
+        }
+    }
+    
+    bool processed = !batch.empty();
+    if (processed) {
+        shard.processed.fetch_add(batch.size(), std::memory_order_relaxed);
+        size_t owner = OwnerOf(shardIndex);
+        if (owner != workerIndex) {
+            shard.stolenBatches.fetch_add(1, std::memory_order_relaxed);
+        }
+        ProcessLogBatch(batch, affinity);
+        batch.clear();
+        shard.claimed.store(false, std::memory_order_release);
+        
+        // 非所属线程处理完后分片仍有积压，唤醒所属线程继续处理
+        if (owner != workerIndex && shard.depth.load(std::memory_order_relaxed) > 0) {
+            WakeWorker(owner);
+        }
+    } else {
+        shard.claimed.store(false, std::memory_order_release);
+    }
+    return processed;
+}
+
+size_t LogProcessor::ShardOf(const LogData& data) const {
+    return std::hash<std::string>{}(data.source) % shards_.size();
+}
+
+size_t LogProcessor::OwnerOf(size_t shardIndex) const {
+    return shardIndex % activeWorkers_.load(std::memory_order_relaxed);
+}
+
+void LogProcessor::WakeWorker(size_t workerIndex) {
+    WorkerSignal& signal = *workerSignals_[workerIndex];
+    {
+        std::lock_guard<std::mutex> lock(signal.mutex);
+        signal.pending = true;
+    }
+    signal.cv.notify_one();
+}
+
+size_t LogProcessor::ReserveQueueSlots(size_t wanted, size_t limit) {
+    size_t capacity = std::min(static_cast<size_t>(std::max(config_.queueSize, 0)), limit);
+    size_t current = dataCount_.load(std::memory_order_relaxed);
+    size_t granted = 0;
+    do {
+        size_t room = current < capacity ? capacity - current : 0;
+        granted = std::min(room, wanted);
+        if (granted == 0) {
+            return 0;
+        }
+    } while (!dataCount_.compare_exchange_weak(current, current + granted, std::memory_order_relaxed));
+    return granted;
 }
 
 void LogProcessor::Stop() {
@@ -193,9 +625,16 @@ void LogProcessor::Stop() {
         return;  // 已经停止
     }
     
+    // 先停止自适应控制，避免停止过程中调整线程数
+    if (workerController_) {
+        workerController_->Stop();
+    }
+    
     // 停止处理线程
     running_ = false;
-    queueCondVar_.notify_all();
+    for (size_t i = 0; i < workerSignals_.size(); ++i) {
+        WakeWorker(i);
+    }
     
     // 等待线程池中的任务完成
     if (threadPool_) {
@@ -203,142 +642,228 @@ void LogProcessor::Stop() {
         threadPool_.reset();  // 释放线程池，这会触发析构函数
     }
     
+    // 存储尚未结束窗口的重复日志汇总，之后才停止分析器
+    if (dedup_) {
+        std::vector<LogData> none;
+        ParserAffinity affinity;
+        ProcessLogBatch(none, affinity, true);
+    }
+    
     // 停止分析器
     if (analyzer_) {
         analyzer_->Stop();
     }
     
+    // 写完已提交的归档
+    if (rawArchiver_) {
+        rawArchiver_->Stop();
+    }
+    
     // 停止TCP服务器
     if (tcpServer_) {
         tcpServer_->Stop();
     }
     
     // 清空待处理队列
-    {
-        std::lock_guard<std::mutex> lock(queueMutex_);
-        std::queue<LogData> empty;
-        std::swap(logQueue_, empty);
-        dataCount_ = 0;
+    for (auto& shard : shards_) {
+        std::lock_guard<std::mutex> lock(shard->mutex);
+        shard->queue.clear();
+        shard->depth = 0;
+    }
+    dataCount_ = 0;
+    if (admission_) {
+        admission_->ClearDepth();
     }
 }
 
 bool LogProcessor::SubmitLogData(const LogData& data) {
+    return SubmitLogData(LogData(data));
+}
+
+bool LogProcessor::SubmitLogData(LogData&& data) {
     if (!running_) {
         return false;
     }
+    return EnqueueOne(data, nullptr) == EnqueueResult::QUEUED;
+}
+
+LogProcessor::EnqueueResult LogProcessor::EnqueueOne(LogData& data, std::vector<bool>* wake) {
+    size_t sourceHash = std::hash<std::string>{}(data.source);
+    common::LogLevel level = common::LogLevel::OTHER;
+    size_t limit = SIZE_MAX;
+    if (admission_) {
+        // 采集器信封中带了级别时直接使用，否则只看消息开头判断级别
+        level = data.fields.level ? common::RecordBatch::ParseLevel(*data.fields.level)
+                                  : SniffLogLevel(data.message);
+        limit = admission_->Limit(level, sourceHash, dataCount_.load(std::memory_order_relaxed));
+    }
     
     // 检查队列大小
-    if (GetPendingCount() >= static_cast<size_t>(config_.queueSize)) {
-        return false;  // 队列已满
+    if (ReserveQueueSlots(1, limit) == 0) {
+        if (admission_) {
+            if (limit < static_cast<size_t>(std::max(config_.queueSize, 0))) {
+                admission_->OnShed(data.source, level);
+                return EnqueueResult::SHED;
+            }
+            admission_->OnRejected(level);
+        }
+        return EnqueueResult::FULL;  // 队列已满
+    }
+    if (admission_) {
+        admission_->OnAdmitted(level, sourceHash);
     }
     
-    // 添加数据到待处理队列
+    // 添加数据到所属分片
+    size_t shardIndex = sourceHash % shards_.size();
+    QueueShard& shard = *shards_[shardIndex];
     {
-        std::lock_guard<std::mutex> lock(queueMutex_);
-        logQueue_.push(data);
-        dataCount_++;
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        shard.queue.push_back(std::move(data));
+        size_t depth = shard.depth.fetch_add(1, std::memory_order_relaxed) + 1;
+        if (depth > shard.maxDepth.load(std::memory_order_relaxed)) {
+            shard.maxDepth.store(depth, std::memory_order_relaxed);
+        }
     }
     
-    // 通知工作线程
-    queueCondVar_.notify_one();
+    // 通知分片所属的工作线程
+    if (wake) {
+        (*wake)[OwnerOf(shardIndex)] = true;
+    } else {
+        WakeWorker(OwnerOf(shardIndex));
+    }
+    return EnqueueResult::QUEUED;
+}
+
+size_t LogProcessor::SubmitLogDataBatch(std::vector<LogData>& batch) {
+    if (!running_ || batch.empty()) {
+        return 0;
+    }
     
-    return true;
+    std::vector<bool> wake(workerSignals_.size(), false);
+    if (admission_) {
+        // 准入控制逐条判断级别；主动丢弃的条目没有入库，按失败确认，不能当作已存储回执给采集器
+        size_t accepted = 0;
+        size_t consumed = 0;
+        for (; consumed < batch.size(); ++consumed) {
+            EnqueueResult result = EnqueueOne(batch[consumed], &wake);
+            if (result == EnqueueResult::FULL) {
+                break;
+            }
+            if (result == EnqueueResult::QUEUED) {
+                ++accepted;
+            } else if (batch[consumed].onComplete) {
+                batch[consumed].onComplete(false);
+            }
+        }
+        batch.erase(batch.begin(), batch.begin() + static_cast<std::ptrdiff_t>(consumed));
+        for (size_t w = 0; w < wake.size(); ++w) {
+            if (wake[w]) {
+                WakeWorker(w);
+            }
+        }
+        return accepted;
+    }
+    
+    size_t accepted = ReserveQueueSlots(batch.size());
+    if (accepted == 0) {
+        return 0;
+    }
+    
+    // 同一批次通常来自同一来源，连续属于同一分片的条目只加一次锁
+    size_t i = 0;
+    size_t shardIndex = ShardOf(batch[0]);
+    while (i < accepted) {
+        QueueShard& shard = *shards_[shardIndex];
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        size_t added = 0;
+        size_t next = shardIndex;
+        do {
+            shard.queue.push_back(std::move(batch[i]));
+            ++added;
+            ++i;
+        } while (i < accepted && (next = ShardOf(batch[i])) == shardIndex);
+        size_t depth = shard.depth.fetch_add(added, std::memory_order_relaxed) + added;
+        if (depth > shard.maxDepth.load(std::memory_order_relaxed)) {
+            shard.maxDepth.store(depth, std::memory_order_relaxed);
+        }
+        wake[OwnerOf(shardIndex)] = true;
+        shardIndex = next;
+    }
+    
+    // 已入队的条目移出列表，剩余未入队的留给调用方
+    batch.erase(batch.begin(), batch.begin() + static_cast<std::ptrdiff_t>(accepted));
+    
+    for (size_t w = 0; w < wake.size(); ++w) {
+        if (wake[w]) {
+            WakeWorker(w);
+        }
+    }
+    return accepted;
 }
 
 void LogProcessor::AddLogParser(std::shared_ptr<LogParser> parser) {
+    // 复制当前快照并追加，发布新快照；正在处理的批次继续使用旧快照
     std::lock_guard<std::mutex> lock(parsersMutex_);
-    parsers_.push_back(parser);
+    auto current = std::atomic_load_explicit(&parserSnapshot_, std::memory_order_acquire);
+    auto next = std::make_shared<ParserSnapshot>();
+    if (current) {
+        next->parsers = current->parsers;
+        next->metrics = current->metrics;
+    }
+    {
+        std::lock_guard<std::mutex> metricsLock(metricsMutex_);
+        next->metrics.push_back(&metrics_.parserMetrics[parser->GetName()]);
+    }
+    next->parsers.push_back(std::move(parser));
+    next->BuildIndex();
+    std::atomic_store_explicit(&parserSnapshot_, std::shared_ptr<const ParserSnapshot>(std::move(next)),
+                               std::memory_order_release);
 }
 
 size_t LogProcessor::GetPendingCount() const {
-    std::lock_guard<std::mutex> lock(queueMutex_);
-    return dataCount_;
+    return dataCount_.load(std::memory_order_relaxed);
+}
+
+std::vector<ShardStats> LogProcessor::GetShardStats() const {
+    std::vector<ShardStats> stats;
+    stats.reserve(shards_.size());
+    for (const auto& shard : shards_) {
+        ShardStats s;
+        s.depth = shard->depth.load(std::memory_order_relaxed);
+        s.maxDepth = shard->maxDepth.load(std::memory_order_relaxed);
+        s.processed = shard->processed.load(std::memory_order_relaxed);
+        s.stolenBatches = shard->stolenBatches.load(std::memory_order_relaxed);
+        stats.push_back(s);
+    }
+    return stats;
 }
 
 bool LogProcessor::InitializeTcpServer() {
     try {
         // 创建TCP服务器，监听特定端口
-        tcpServer_ = std::make_unique<network::TcpServer>("LogServer", "0.0.0.0", config_.tcpPort, 4);
+        tcpServer_ = std::make_unique<network::TcpServer>("LogServer", "0.0.0.0", config_.tcpPort, config_.ioThreads);
+        tcpServer_->SetReusePortAcceptors(config_.reusePortAcceptors);
+        tcpServer_->SetCpuAffinity(config_.cpuAffinity);
+        // 每行一条消息（采集器的批次也是一行）
+        tcpServer_->SetLineDelimited(true);
+        tcpServer_->SetMaxLineLength(config_.maxLineLength);
         
-        // 设置消息回调
-        tcpServer_->SetMessageCallback([this](uint64_t connectionId, const std::string& message, muduo::Timestamp) {
-            (void)connectionId;
-            // 直接处理消息，无需查找连接
-            std::cout << "接收到来自连接 " << connectionId << " 的消息" << std::endl;
-            
-            // 获取连接对象
-            auto conn = tcpServer_->GetConnection(connectionId);
-            if (conn) {
-                // 使用真实连接对象
-                HandleTcpMessage(conn, message);
-            } else {
-                std::cerr << "警告: 收到消息但找不到对应的连接，connectionId=" << connectionId << std::endl;
-                
-                // 创建一个临时的LogData，不依赖于连接对象
-                LogData logData;
-                logData.timestamp = std::chrono::system_clock::now();
-                logData.message = message;
-                logData.id = GenerateUUID();
-                logData.source = "unknown:" + std::to_string(connectionId);
-                
-                // 检查是否为JSON格式
-                bool isJson = false;
-                try {
-                    if (message.find("{") == 0 && message.rfind("}") == message.length() - 1) {
-                        nlohmann::json json = nlohmann::json::parse(message);
-                        isJson = true;
-                        std::cout << "成功解析JSON消息，来源未知" << std::endl;
-                        
-                        // 提取基本元数据
-                        if (json.contains("timestamp") && json["timestamp"].is_string()) {
-                            logData.metadata["timestamp"] = json["timestamp"].get<std::string>();
-                        }
-                        
-                        if (json.contains("level") && json["level"].is_string()) {
-                            logData.metadata["level"] = json["level"].get<std::string>();
-                        }
-                        
-                        if (json.contains("message") && json["message"].is_string()) {
-                            logData.metadata["message"] = json["message"].get<std::string>();
-                        }
-                        
-                        if (json.contains("source") && json["source"].is_string()) {
-                            logData.source = json["source"].get<std::string>();
-                        }
-                    }
-                } catch (...) {
-                    std::cerr << "JSON解析失败" << std::endl;
-                }
-                
-                // 设置JSON标记
-                logData.metadata["is_json"] = isJson ? "true" : "false";
-                
-                // 尝试直接保存到MySQL
-                if (mysqlStorage_) {
-                    try {
-                        std::cout << "尝试直接将未知连接的消息保存到MySQL，ID=" << logData.id << std::endl;
-                        
-                        storage::MySQLStorage::LogEntry directEntry;
-                        directEntry.id = "direct-" + logData.id;
-                        directEntry.timestamp = TimestampToString(logData.timestamp);
-                        directEntry.level = logData.metadata.count("level") > 0 ? logData.metadata.at("level") : "INFO";
-                        directEntry.source = logData.source;
-                        directEntry.message = message.length() > 1000 ? message.substr(0, 997) + "..." : message;
-                        
-                        bool saved = mysqlStorage_->SaveLogEntry(directEntry);
-                        if (saved) {
-                            std::cout << "成功直接保存未知连接的消息到MySQL，ID=" << directEntry.id << std::endl;
-                        } else {
-                            std::cerr << "直接保存未知连接的消息到MySQL失败" << std::endl;
-                        }
-                    } catch (const std::exception& e) {
-                        std::cerr << "未知连接消息直接保存MySQL异常: " << e.what() << std::endl;
-                    }
-                }
-                
-                // 处理日志数据
-                ProcessLogData(std::move(logData));
+        // 批次存储完成后向采集器回送累计确认；存储失败时断开连接，让采集器重连后重传
+        ackTracker_ = std::make_unique<AckTracker>(
+            [this](uint64_t connectionId, const std::string& stream, uint64_t seq) {
+                nlohmann::json ack = {{"type", "ack"}, {"stream", stream}, {"seq", seq}};
+                tcpServer_->Send(connectionId, ack.dump() + "\r\n");
+            });
+        ackTracker_->SetFailureCallback([this](uint64_t connectionId, const std::string&, uint64_t) {
+            tcpServer_->CloseConnection(connectionId);
+        });
+        
+        // IO线程只分帧和入队：采集器批次展开后入队，其余消息移入LogData后入队，解析和存储都在工作线程
+        tcpServer_->SetFrameCallback([this](uint64_t connectionId, std::string&& message, muduo::Timestamp) {
+            if (HandleBatchMessage(connectionId, message)) {
+                return;
             }
+            HandleTcpMessage(connectionId, std::move(message));
         });
         
         // 设置连接回调
@@ -356,6 +881,78 @@ bool LogProcessor::InitializeTcpServer() {
     }
 }
 
+bool LogProcessor::HandleBatchMessage(uint64_t connectionId, const std::string& message) {
+    // 先按首字符判断格式；对象只用按需提取器读取顶层的type，单条日志不在这里构建DOM
+    size_t begin = message.find_first_not_of(" \t\r\n");
+    if (begin == std::string::npos) {
+        return false;
+    }
+    bool isArray = message[begin] == '[';
+    if (!isArray) {
+        if (message[begin] != '{') {
+            return false;
+        }
+        static const JsonFieldExtractor extractor({"type"});
+        thread_local JsonFieldExtractor::Result result;
+        if (!extractor.Extract(std::string_view(message).substr(begin), result) ||
+            !result.Has(0) || result.values[0] != "batch") {
+            return false;
+        }
+    }
+    
+    auto j = nlohmann::json::parse(message, nullptr, false);
+    CountJsonParse();
+    
+    // 带序号的批次：{"type":"batch","stream":"...","seq":N,"base":B,"logs":[...]}
+    if (j.is_object() && j.value("type", "") == "batch") {
+        const auto logsIt = j.find("logs");
+        if (logsIt == j.end() || !logsIt->is_array()) {
+            return true;
+        }
+        std::string stream = j.value("stream", "");
+        uint64_t seq = j.value("seq", static_cast<uint64_t>(0));
+        uint64_t base = j.value("base", static_cast<uint64_t>(0));
+        
+        auto ticket = ackTracker_->Begin(connectionId, stream, seq, base, logsIt->size());
+        if (!ticket) {
+            return true;  // 重复批次，已丢弃
+        }
+        
+        std::vector<LogData> batch;
+        batch.reserve(logsIt->size());
+        for (const auto& log : *logsIt) {
+            batch.push_back(BuildLogData(log));
+            batch.back().onComplete = [ticket](bool stored) { ticket->Complete(stored); };
+        }
+        SubmitLogDataBatch(batch);
+        // 队列已满未入队的日志，批次不确认，等待重传
+        for (auto& data : batch) {
+            data.onComplete(false);
+        }
+        return true;
+    }
+    
+    // 兼容旧格式：不带确认的JSON数组
+    if (j.is_array()) {
+        std::vector<LogData> batch;
+        batch.reserve(j.size());
+        for (const auto& log : j) {
+            batch.push_back(BuildLogData(log));
+        }
+        SubmitLogDataBatch(batch);
+        // 旧格式没有确认，队列满未入队的日志无法重传，与单条消息一样按丢弃计数
+        if (!batch.empty()) {
+            uint64_t before = metrics_.droppedRecords.fetch_add(batch.size(), std::memory_order_relaxed);
+            uint64_t dropped = before + batch.size();
+            if (std::bit_width(dropped) != std::bit_width(before)) {
+                std::cerr << "处理队列已满，已丢弃 " << dropped << " 条TCP消息" << std::endl;
+            }
+        }
+        return true;
+    }
+    return false;
+}
+
 void LogProcessor::HandleTcpConnection(uint64_t connectionId, const std::string& clientAddr, bool connected) {
     std::cout << "\n========== TCP 连接事件 ==========" << std::endl;
     std::cout << "连接ID: " << connectionId << std::endl;
@@ -369,195 +966,211 @@ void LogProcessor::HandleTcpConnection(uint64_t connectionId, const std::string&
         connections_[connectionId] = clientAddr;
     } else {
         // 连接断开
-        std::lock_guard<std::mutex> lock(connectionsMutex_);
-        connections_.erase(connectionId);
+        {
+            std::lock_guard<std::mutex> lock(connectionsMutex_);
+            connections_.erase(connectionId);
+        }
+        if (ackTracker_) {
+            ackTracker_->OnConnectionClosed(connectionId);
+        }
     }
 }
 
-void LogProcessor::HandleTcpMessage(const TcpConnectionPtr& conn, const std::string& message) {
-    try {
-        if (config_.debug) {
-            std::cout << "收到TCP消息，连接ID: " << conn->name() << std::endl;
-            std::cout << "  消息内容: " << (message.length() > 50 ? message.substr(0, 47) + "..." : message) << std::endl;
+void LogProcessor::HandleTcpMessage(uint64_t connectionId, std::string&& message) {
+    if (message.empty()) {
+        return;
+    }
+    
+    LogData logData;
+    logData.timestamp = std::chrono::system_clock::now();
+    logData.id = GenerateLogId();
+    
+    // 使用连接名称作为源信息
+    auto conn = tcpServer_->GetConnection(connectionId);
+    logData.source = conn ? conn->name() : "unknown:" + std::to_string(connectionId);
+    logData.message = std::move(message);
+    logData.archiveRaw = rawArchiver_ != nullptr;
+    
+    if (config_.debug) {
+        std::cout << "收到TCP消息，连接ID: " << connectionId << "，日志ID: " << logData.id << std::endl;
+    }
+    
+    // 单条消息没有确认机制，队列满时只能丢弃并计数；准入控制主动丢弃的由准入控制器按来源和级别计数
+    if (!running_ || EnqueueOne(logData, nullptr) == EnqueueResult::FULL) {
+        uint64_t dropped = metrics_.droppedRecords.fetch_add(1, std::memory_order_relaxed) + 1;
+        if ((dropped & (dropped - 1)) == 0) {
+            std::cerr << "处理队列已满，已丢弃 " << dropped << " 条TCP消息" << std::endl;
         }
-        
-        if (message.empty()) {
-            if (config_.debug) {
-                std::cout << "  消息为空，已忽略" << std::endl;
-            }
-            return;
+    }
+}
+
+void LogProcessor::ProcessLogData(LogData logData) {
+    std::vector<LogData> batch;
+    batch.push_back(std::move(logData));
+    ParserAffinity affinity;
+    ProcessLogBatch(batch, affinity);
+}
+
+void LogProcessor::ProcessLogBatch(std::vector<LogData>& batch, ParserAffinity& affinity, bool flushDedup) {
+    // 先取出窗口已结束的重复日志分组，汇总记录排在本批日志之前
+    thread_local std::vector<DedupSummary> summaries;
+    summaries.clear();
+    if (dedup_ && (flushDedup || dedup_->GetTrackedCount() > 0)) {
+        if (flushDedup) {
+            dedup_->TakeAll(summaries);
+        } else {
+            dedup_->TakeExpired(std::chrono::steady_clock::now(), summaries);
         }
-        
-        // 创建日志数据对象
-        LogData logData;
-        logData.timestamp = std::chrono::system_clock::now();
-        logData.message = message;
-        logData.id = GenerateUUID();
-        
-        // 使用连接名称作为源信息
-        logData.source = conn->name();
-        
-        // 直接保存原始消息到MySQL（测试用）
-        if (mysqlStorage_) {
-            try {
-                std::cout << "尝试直接将消息保存到MySQL，ID=" << logData.id << std::endl;
-                
-                storage::MySQLStorage::LogEntry directEntry;
-                directEntry.id = "direct-" + logData.id;
-                directEntry.timestamp = TimestampToString(logData.timestamp);
-                directEntry.level = "INFO";
-                directEntry.source = logData.source;
-                directEntry.message = message.length() > 1000 ? message.substr(0, 997) + "..." : message;
-                
-                bool saved = mysqlStorage_->SaveLogEntry(directEntry);
-                if (saved) {
-                    std::cout << "成功直接保存消息到MySQL，ID=" << directEntry.id << std::endl;
-                } else {
-                    std::cerr << "直接保存消息到MySQL失败" << std::endl;
-                }
-            } catch (const std::exception& e) {
-                std::cerr << "直接保存MySQL异常: " << e.what() << std::endl;
-            }
+    }
+    if (batch.empty() && summaries.empty()) {
+        return;
+    }
+    
+    uint64_t cpuStart = config_.enableMetrics ? ThreadCpuTimeNs() : 0;
+    auto batchStart = std::chrono::steady_clock::now();
+    
+    // 每批只取一次解析器快照，不加锁；批次处理期间快照不会被释放
+    auto parsers = std::atomic_load_explicit(&parserSnapshot_, std::memory_order_acquire);
+    static const ParserSnapshot emptySnapshot{};
+    const ParserSnapshot& snapshot = parsers ? *parsers : emptySnapshot;
+    affinity.Bind(snapshot);
+    
+    // 每个线程复用同一份解析记录和列式批次；批次移交给分析器后重新开始
+    thread_local analyzer::LogRecord record;
+    thread_local common::RecordBatch records;
+    thread_local std::vector<uint8_t> outcomes;
+    records.Clear();
+    outcomes.assign(batch.size(), kRowUnparsed);
+    
+    bool mysqlBatch = config_.enableMySQLStorage && mysqlStorage_;
+    common::RecordBatch* columns = (mysqlBatch || analyzer_) ? &records : nullptr;
+    thread_local std::vector<uint8_t> summaryStored;
+    summaryStored.assign(summaries.size(), 0);
+    for (size_t i = 0; i < summaries.size(); ++i) {
+        summaryStored[i] = StoreRecord(summaries[i].record, columns) ? 1 : 0;
+    }
+    for (size_t i = 0; i < batch.size(); ++i) {
+        bool stored = true;
+        if (ProcessOne(batch[i], snapshot, affinity, record, columns, stored)) {
+            outcomes[i] = stored ? kRowStored : kRowStoreFailed;
         }
-        
-        if (config_.debug) {
-            std::cout << "  创建日志数据: ID=" << logData.id << ", 来源=" << logData.source << std::endl;
+    }
+    
+    // 整批写入MySQL，批次内的记录共享同一个结果
+    bool batchStored = true;
+    if (mysqlBatch && !records.Empty()) {
+        auto storeStart = std::chrono::steady_clock::now();
+        batchStored = StoreMySQLBatch(records);
+        if (config_.enableMetrics) {
+            metrics_.mysqlLatency.Record(MicrosecondsSince(storeStart));
         }
-        
-        // 检查是否为JSON格式，并进行预处理
-        bool isJson = false;
-        try {
-            if (message.find("{") == 0 && message.rfind("}") == message.length() - 1) {
-                if (config_.debug) {
-                    std::cout << "  消息包含花括号，尝试JSON解析" << std::endl;
-                }
-                
-                // 尝试解析为JSON
-                nlohmann::json json = nlohmann::json::parse(message);
-                isJson = true;
-                
-                if (config_.debug) {
-                    std::cout << "  JSON解析成功" << std::endl;
-                }
-                
-                // 提取元数据
-                if (json.contains("timestamp") && json["timestamp"].is_string()) {
-                    logData.metadata["timestamp"] = json["timestamp"].get<std::string>();
-                    
-                    if (config_.debug) {
-                        std::cout << "  提取到timestamp: " << logData.metadata["timestamp"] << std::endl;
-                    }
-                }
-                
-                if (json.contains("level") && json["level"].is_string()) {
-                    logData.metadata["level"] = json["level"].get<std::string>();
-                    
-                    if (config_.debug) {
-                        std::cout << "  提取到level: " << logData.metadata["level"] << std::endl;
-                    }
-                }
-                
-                if (json.contains("message") && json["message"].is_string()) {
-                    logData.metadata["message"] = json["message"].get<std::string>();
-                    
-                    if (config_.debug) {
-                        std::cout << "  提取到message: " << logData.metadata["message"] << std::endl;
-                    }
-                }
-                
-                if (json.contains("type") && json["type"].is_string()) {
-                    logData.metadata["type"] = json["type"].get<std::string>();
-                    
-                    if (config_.debug) {
-                        std::cout << "  提取到type: " << logData.metadata["type"] << std::endl;
-                    }
-                }
-                
-                if (json.contains("source") && json["source"].is_string()) {
-                    logData.metadata["source"] = json["source"].get<std::string>();
-                    
-                    if (config_.debug) {
-                        std::cout << "  提取到source: " << logData.metadata["source"] << std::endl;
-                    }
-                }
-            } else {
-                if (config_.debug) {
-                    std::cout << "  消息不符合JSON格式（缺少花括号）" << std::endl;
-                }
-            }
-        } catch (const nlohmann::json::exception& e) {
-            if (config_.debug) {
-                std::cout << "  JSON解析失败: " << e.what() << std::endl;
-            }
-            // 不是有效的JSON，继续使用原始消息
+    }
+    
+    // 整批解析结果一次提交给分析器
+    if (analyzer_ && !records.Empty()) {
+        analyzer_->SubmitBatch(std::move(records));
+        records = common::RecordBatch();
+    }
+    
+    // 通知发送方存储结果；无法解析的日志不会被重传修复，视为已处理
+    for (size_t i = 0; i < batch.size(); ++i) {
+        if (batch[i].onComplete) {
+            batch[i].onComplete(outcomes[i] == kRowUnparsed || (outcomes[i] == kRowStored && batchStored));
         }
-        
-        // 设置JSON标记
-        logData.metadata["is_json"] = isJson ? "true" : "false";
-        
-        if (config_.debug) {
-            std::cout << "  设置消息metadata: is_json = " << (isJson ? "true" : "false") << std::endl;
-            std::cout << "  最终元数据数量: " << logData.metadata.size() << std::endl;
-            for (const auto& [key, value] : logData.metadata) {
-                std::cout << "    " << key << " = " << value << std::endl;
-            }
+    }
+    for (size_t i = 0; i < summaries.size(); ++i) {
+        for (auto& callback : summaries[i].callbacks) {
+            callback(summaryStored[i] && batchStored);
         }
+    }
+    summaries.clear();
+    
+    // 处理条数和耗时供自适应线程数控制估计单条处理时间
+    uint64_t batchMicros = MicrosecondsSince(batchStart);
+    processedCount_.fetch_add(batch.size(), std::memory_order_relaxed);
+    busyMicros_.fetch_add(batchMicros, std::memory_order_relaxed);
+    
+    if (config_.enableMetrics) {
+        metrics_.totalCpuTime.fetch_add(ThreadCpuTimeNs() - cpuStart, std::memory_order_relaxed);
+        metrics_.batchLatency.Record(batchMicros);
         
-        // 处理日志数据
-        ProcessLogData(std::move(logData));
-        
-        if (config_.debug) {
-            std::cout << "TCP消息处理完成" << std::endl;
+        // 检查是否需要刷新指标
+        auto now = std::chrono::steady_clock::now();
+        auto elapsed = std::chrono::duration_cast<std::chrono::seconds>(
+            now - lastMetricsFlush_).count();
+            
+        if (elapsed >= config_.metricsFlushInterval) {
+            ExportMetrics();
+            lastMetricsFlush_ = now;
         }
-    } catch (const std::exception& e) {
-        std::cerr << "处理TCP消息时出错: " << e.what() << std::endl;
-    } catch (...) {
-        std::cerr << "处理TCP消息时出现未知错误" << std::endl;
     }
 }
 
-void LogProcessor::ProcessLogData(LogData logData) {
+bool LogProcessor::ProcessOne(LogData& logData, const ParserSnapshot& parsers, ParserAffinity& affinity,
+                              analyzer::LogRecord& record, common::RecordBatch* records, bool& stored) {
     auto startTime = std::chrono::steady_clock::now();
     bool success = false;
     
-    // 尝试使用所有解析器解析日志
-    {
-        std::lock_guard<std::mutex> lock(parsersMutex_);
-        for (const auto& parser : parsers_) {
-            analyzer::LogRecord record;
-            auto parserStartTime = std::chrono::steady_clock::now();
+    // 每条消息只解析一次，解析器直接使用解析结果
+    if (logData.fields.format == PayloadFormat::UNPARSED &&
+        ParseLogFields(logData.message, logData.fields, config_.jsonBackend) != PayloadFormat::TEXT) {
+        CountJsonParse();
+    }
+    
+    // 原始消息归档只入队，由归档线程写入
+    if (logData.archiveRaw && rawArchiver_) {
+        RawArchiveEntry entry;
+        entry.id = "direct-" + logData.id;
+        entry.timestamp = TimestampToString(logData.timestamp);
+        entry.level = logData.fields.level.value_or("INFO");
+        entry.source = logData.fields.source.value_or(logData.source);
+        entry.message = logData.message.length() > 1000 ? logData.message.substr(0, 997) + "..." : logData.message;
+        rawArchiver_->Submit(std::move(entry));
+    }
+    
+    // 先尝试该来源上次成功的解析器，再按添加顺序尝试支持该格式的解析器
+    LogFormat format = SniffLogFormat(logData.message, logData.fields.format);
+    const std::vector<size_t>& candidates = parsers.candidates[static_cast<size_t>(format)];
+    size_t preferred = candidates.empty() ? 0 : candidates.front();
+    auto learned = affinity.bySource.find(logData.source);
+    if (learned != affinity.bySource.end() &&
+        parsers.parsers[learned->second]->SupportsFormat(format)) {
+        preferred = learned->second;
+    }
+    
+    // 第0次尝试preferred，之后按顺序尝试其余候选
+    for (size_t attempt = 0; !candidates.empty() && attempt <= candidates.size() && !success; ++attempt) {
+        size_t index = attempt == 0 ? preferred : candidates[attempt - 1];
+        if (attempt > 0 && index == preferred) {
+            continue;
+        }
+        const auto& parser = parsers.parsers[index];
+        ResetRecord(record);
+        auto parserStartTime = std::chrono::steady_clock::now();
+        if (config_.enableMetrics) {
+            metrics_.parserAttempts.fetch_add(1, std::memory_order_relaxed);
+        }
+        
+        if (parser->Parse(logData, record)) {
+            success = true;
+            affinity.Remember(logData.source, index);
             
-            if (parser->Parse(logData, record)) {
-                success = true;
-                
-                // 更新解析器指标
-                auto parserEndTime = std::chrono::steady_clock::now();
-                auto parserProcessTime = std::chrono::duration_cast<std::chrono::microseconds>(
-                    parserEndTime - parserStartTime);
-                UpdateMetrics(parser->GetName(), parserProcessTime, true);
-                
-                // 存储日志记录
-                if (config_.enableRedisStorage && redisStorage_) {
-                    StoreRedisLog(record);
-                }
-                
-                if (config_.enableMySQLStorage && mysqlStorage_) {
-                    StoreMySQLLog(record);
-                }
-                
-                // 分析日志
-                if (analyzer_) {
-                    analyzer_->SubmitRecord(record);
-                }
-                
-                break;
-            } else {
-                // 更新解析器失败指标
-                auto parserEndTime = std::chrono::steady_clock::now();
-                auto parserProcessTime = std::chrono::duration_cast<std::chrono::microseconds>(
-                    parserEndTime - parserStartTime);
-                UpdateMetrics(parser->GetName(), parserProcessTime, false);
+            // 更新解析器指标
+            auto parserEndTime = std::chrono::steady_clock::now();
+            auto parserProcessTime = std::chrono::duration_cast<std::chrono::microseconds>(
+                parserEndTime - parserStartTime);
+            UpdateMetrics(*parsers.metrics[index], parserProcessTime, true);
+            
+            // 窗口内的重复日志只累计条数，由窗口结束后的汇总记录代表
+            if (!dedup_ || !dedup_->Offer(record, logData.onComplete, parserEndTime)) {
+                stored = StoreRecord(record, records) && stored;
             }
+        } else {
+            // 更新解析器失败指标
+            auto parserEndTime = std::chrono::steady_clock::now();
+            auto parserProcessTime = std::chrono::duration_cast<std::chrono::microseconds>(
+                parserEndTime - parserStartTime);
+            UpdateMetrics(*parsers.metrics[index], parserProcessTime, false);
         }
     }
     
@@ -565,22 +1178,32 @@ void LogProcessor::ProcessLogData(LogData logData) {
     auto endTime = std::chrono::steady_clock::now();
     auto totalTime = std::chrono::duration_cast<std::chrono::microseconds>(
         endTime - startTime);
-    UpdateMetrics("total", totalTime, success);
-    
-    // 检查是否需要刷新指标
-    if (config_.enableMetrics) {
-        auto now = std::chrono::steady_clock::now();
-        auto elapsed = std::chrono::duration_cast<std::chrono::seconds>(
-            now - lastMetricsFlush_).count();
-            
-        if (elapsed >= config_.metricsFlushInterval) {
-            ExportMetrics();
-            lastMetricsFlush_ = now;
+    UpdateMetrics(*totalMetrics_, totalTime, success);
+    return success;
+}
+
+bool LogProcessor::StoreRecord(const analyzer::LogRecord& record, common::RecordBatch* records) {
+    bool stored = true;
+    if (config_.enableRedisStorage && redisStorage_) {
+        auto storeStart = std::chrono::steady_clock::now();
+        stored = StoreRedisLog(record);
+        if (config_.enableMetrics) {
+            metrics_.redisLatency.Record(MicrosecondsSince(storeStart));
         }
     }
+    
+    if (recordSink_) {
+        stored = recordSink_(record) && stored;
+    }
+    
+    // MySQL存储和分析由批处理统一进行
+    if (records) {
+        analyzer::AppendRecord(*records, record);
+    }
+    return stored;
 }
 
-void LogProcessor::UpdateMetrics(const std::string& parserName,
+void LogProcessor::UpdateMetrics(ProcessorMetrics::ParserMetrics& parserMetrics,
                                const std::chrono::microseconds& processTime,
                                bool success) {
     if (!config_.enableMetrics) {
@@ -598,14 +1221,14 @@ void LogProcessor::UpdateMetrics(const std::string& parserName,
     // 更新总处理时间
     metrics_.totalProcessTime += processTime.count();
     
-    // 更新解析器指标
-    auto& parserMetrics = metrics_.parserMetrics[parserName];
+    // 更新解析器指标，条目由解析器快照持有，不需要加锁
     if (success) {
         parserMetrics.successCount++;
     } else {
         parserMetrics.failureCount++;
     }
     parserMetrics.totalTime += processTime.count();
+    parserMetrics.latency.Record(static_cast<uint64_t>(processTime.count()));
 }
 
 void LogProcessor::ExportMetrics() {
@@ -622,10 +1245,38 @@ void LogProcessor::ExportMetrics() {
     auto now = std::chrono::system_clock::now();
     auto timeStr = TimestampToString(now);
     
+    std::lock_guard<std::mutex> lock(metricsMutex_);
     file << "\n=== 指标导出时间: " << timeStr << " ===\n";
     file << "总处理记录数: " << metrics_.totalRecords << "\n";
     file << "错误记录数: " << metrics_.errorRecords << "\n";
     file << "总处理时间(微秒): " << metrics_.totalProcessTime << "\n";
+    file << "JSON解析次数: " << metrics_.jsonParses << "\n";
+    file << "处理CPU时间(纳秒): " << metrics_.totalCpuTime << "\n";
+    file << "队列满丢弃消息数: " << metrics_.droppedRecords << "\n";
+    file << "解析器调用次数: " << metrics_.parserAttempts << "\n";
+    if (rawArchiver_) {
+        file << "原始消息归档(已写入/丢弃/失败): " << rawArchiver_->GetArchivedCount() << "/"
+             << rawArchiver_->GetDroppedCount() << "/" << rawArchiver_->GetFailedCount() << "\n";
+    }
+    file << "队列分片(深度/最大深度/已处理/被窃取批次):";
+    for (const auto& shard : GetShardStats()) {
+        file << " " << shard.depth << "/" << shard.maxDepth << "/" << shard.processed
+             << "/" << shard.stolenBatches;
+    }
+    file << "\n";
+    // "total"项每条消息记录一次
+    auto totalIt = metrics_.parserMetrics.find("total");
+    if (totalIt != metrics_.parserMetrics.end()) {
+        uint64_t messages = totalIt->second.successCount + totalIt->second.failureCount;
+        if (messages > 0) {
+            file << "每条消息解析次数: " << std::fixed << std::setprecision(3)
+                 << static_cast<double>(metrics_.jsonParses) / messages << "\n";
+            file << "每条消息解析器调用次数: " << std::fixed << std::setprecision(3)
+                 << static_cast<double>(metrics_.parserAttempts) / messages << "\n";
+            file << "每条消息CPU时间(纳秒): " << std::fixed << std::setprecision(0)
+                 << static_cast<double>(metrics_.totalCpuTime) / messages << "\n";
+        }
+    }
     
     file << "\n解析器指标:\n";
     for (const auto& [name, parserMetrics] : metrics_.parserMetrics) {
@@ -645,9 +1296,93 @@ void LogProcessor::ExportMetrics() {
     file.close();
 }
 
-void LogProcessor::StoreRedisLog(const analyzer::LogRecord& record) {
+void LogProcessor::WritePrometheusMetrics(common::PrometheusWriter& writer) const {
+    // 只在复制条目指针时持有锁，工作线程更新指标不需要这个锁
+    std::vector<std::pair<std::string, const ProcessorMetrics::ParserMetrics*>> parsers;
+    {
+        std::lock_guard<std::mutex> lock(metricsMutex_);
+        for (const auto& [name, parserMetrics] : metrics_.parserMetrics) {
+            if (&parserMetrics != totalMetrics_) {
+                parsers.emplace_back(name, &parserMetrics);
+            }
+        }
+    }
+    std::sort(parsers.begin(), parsers.end());
+    
+    const auto& total = *totalMetrics_;
+    writer.Counter("xumj_processor_messages_total", "工作线程处理的消息数",
+                   static_cast<double>(total.successCount.load()), {{"result", "parsed"}});
+    writer.Counter("xumj_processor_messages_total", "工作线程处理的消息数",
+                   static_cast<double>(total.failureCount.load()), {{"result", "unparsed"}});
+    writer.Counter("xumj_processor_json_parses_total", "JSON解析次数（含批次信封）",
+                   static_cast<double>(metrics_.jsonParses.load()));
+    writer.Counter("xumj_processor_parser_attempts_total", "调用解析器的次数",
+                   static_cast<double>(metrics_.parserAttempts.load()));
+    writer.Counter("xumj_processor_dropped_messages_total", "队列满时丢弃的消息数",
+                   static_cast<double>(metrics_.droppedRecords.load()));
+    writer.Counter("xumj_processor_cpu_seconds_total", "工作线程处理消息的CPU时间",
+                   static_cast<double>(metrics_.totalCpuTime.load()) / 1e9);
+    for (const auto& [name, parserMetrics] : parsers) {
+        writer.Counter("xumj_processor_parser_calls_total", "各解析器的调用次数",
+                       static_cast<double>(parserMetrics->successCount.load()),
+                       {{"parser", name}, {"result", "success"}});
+        writer.Counter("xumj_processor_parser_calls_total", "各解析器的调用次数",
+                       static_cast<double>(parserMetrics->failureCount.load()),
+                       {{"parser", name}, {"result", "failure"}});
+    }
+    if (rawArchiver_) {
+        const char* help = "原始消息归档条数";
+        writer.Counter("xumj_processor_raw_archive_total", help,
+                       static_cast<double>(rawArchiver_->GetArchivedCount()), {{"result", "archived"}});
+        writer.Counter("xumj_processor_raw_archive_total", help,
+                       static_cast<double>(rawArchiver_->GetDroppedCount()), {{"result", "dropped"}});
+        writer.Counter("xumj_processor_raw_archive_total", help,
+                       static_cast<double>(rawArchiver_->GetFailedCount()), {{"result", "failed"}});
+    }
+    if (tcpServer_) {
+        writer.Counter("xumj_processor_oversized_lines_total", "单行超过长度上限被断开的连接数",
+                       static_cast<double>(tcpServer_->GetOversizedLineCount()));
+    }
+    if (admission_) {
+        admission_->WritePrometheusMetrics(writer);
+    }
+    if (dedup_) {
+        dedup_->WritePrometheusMetrics(writer);
+    }
+    
+    writer.Gauge("xumj_processor_queue_depth", "所有队列分片的待处理消息数",
+                 static_cast<double>(dataCount_.load(std::memory_order_relaxed)));
+    for (size_t i = 0; i < shards_.size(); ++i) {
+        writer.Gauge("xumj_processor_shard_queue_depth", "各队列分片的待处理消息数",
+                     static_cast<double>(shards_[i]->depth.load(std::memory_order_relaxed)),
+                     {{"shard", std::to_string(i)}});
+    }
+    writer.Gauge("xumj_processor_worker_threads", "运行中的工作线程数",
+                 static_cast<double>(activeWorkers_.load(std::memory_order_relaxed)));
+    if (workerController_) {
+        workerController_->WritePrometheusMetrics(writer, "xumj_processor_workers");
+    }
+    writer.Gauge("xumj_process_resident_memory_bytes", "进程常驻内存",
+                 static_cast<double>(common::ReadResidentMemoryBytes()));
+    
+    const char* stageHelp = "各处理阶段的耗时";
+    writer.Histogram("xumj_processor_stage_latency_seconds", stageHelp, total.latency, {{"stage", "parse"}});
+    writer.Histogram("xumj_processor_stage_latency_seconds", stageHelp, metrics_.redisLatency, {{"stage", "redis"}});
+    writer.Histogram("xumj_processor_stage_latency_seconds", stageHelp, metrics_.mysqlLatency, {{"stage", "mysql"}});
+    writer.Histogram("xumj_processor_stage_latency_seconds", stageHelp, metrics_.batchLatency, {{"stage", "batch"}});
+    for (const auto& [name, parserMetrics] : parsers) {
+        writer.Histogram("xumj_processor_parser_latency_seconds", "单次解析器调用的耗时",
+                         parserMetrics->latency, {{"parser", name}});
+    }
+    
+    if (analyzer_) {
+        analyzer_->WritePrometheusMetrics(writer);
+    }
+}
+
+bool LogProcessor::StoreRedisLog(const analyzer::LogRecord& record) {
     if (!redisStorage_) {
-        return;
+        return false;
     }
     
     try {
@@ -677,101 +1412,39 @@ void LogProcessor::StoreRedisLog(const analyzer::LogRecord& record) {
         if (config_.debug) {
             std::cout << "Redis存储成功: 日志ID = " << record.id << std::endl;
         }
+        return true;
     } catch (const std::exception& e) {
         std::cerr << "Redis存储日志时出错: " << e.what() << std::endl;
+        return false;
     }
 }
 
-void LogProcessor::StoreMySQLLog(const analyzer::LogRecord& record) {
+bool LogProcessor::StoreMySQLBatch(const common::RecordBatch& records) {
     if (!mysqlStorage_) {
-        return;
+        return false;
     }
     
-    try {
-        // 确保ID不为空
-        std::string id = record.id;
-        if (id.empty()) {
-            id = GenerateUUID();
-        }
-        
-        // 准备时间戳
-        std::string timestamp = record.timestamp;
-        if (timestamp.empty()) {
-            timestamp = TimestampToString(std::chrono::system_clock::now());
-        }
-        
-        // 截断过长的消息
-        std::string message = record.message;
-        if (message.length() > 1024) {
-            message = message.substr(0, 1021) + "...";
-        }
-        
-        // 准备源标识
-        std::string source = record.source;
-        if (source.length() > 128) {
-            source = source.substr(0, 125) + "...";
-        }
-        
-        // 准备级别
-        std::string level = record.level;
-        if (level.length() > 16) {
-            level = level.substr(0, 16);
-        }
-        
-        // 调试输出
-        if (config_.debug) {
-            std::cout << "准备存储日志到MySQL: " << std::endl;
-            std::cout << "  ID: " << id << std::endl;
-            std::cout << "  时间戳: " << timestamp << std::endl;
-            std::cout << "  级别: " << level << std::endl;
-            std::cout << "  源: " << source << std::endl;
-            std::cout << "  消息: " << (message.length() > 30 ? message.substr(0, 27) + "..." : message) << std::endl;
-        }
-        
-        // 准备MySQL日志条目
-        storage::MySQLStorage::LogEntry entry;
-        entry.id = id;
-        entry.timestamp = timestamp;
-        entry.level = level;
-        entry.source = source;
-        entry.message = message;
-        
-        // 准备字段和元数据，限制字段数量和大小
-        int fieldCount = 0;
-        const int MAX_FIELDS = 20;  // 限制字段数量
-        
-        for (const auto& [key, value] : record.fields) {
-            if (fieldCount >= MAX_FIELDS) break;
-            
-            // 限制键和值的长度
-            std::string k = (key.length() > 64) ? key.substr(0, 61) + "..." : key;
-            std::string v = (value.length() > 255) ? value.substr(0, 252) + "..." : value;
-            
-            entry.fields[k] = v;
-            fieldCount++;
+    // 长度限制和缺省值由SaveRecordBatch按表结构处理
+    bool success = false;
+    for (int attempt = 0; attempt < 3 && !success; attempt++) {
+        try {
+            success = mysqlStorage_->SaveRecordBatch(records) > 0;
+        } catch (const std::exception& e) {
+            std::cerr << "MySQL存储尝试 " << (attempt + 1) << " 失败: " << e.what() << std::endl;
         }
-        
-        // 尝试保存日志条目
-        bool success = false;
-        for (int attempt = 0; attempt < 3 && !success; attempt++) {
-            try {
-                success = mysqlStorage_->SaveLogEntry(entry);
-                
-                if (success && config_.debug) {
-                    std::cout << "MySQL存储成功: 日志ID = " << id << std::endl;
-                }
-            } catch (const std::exception& e) {
-                std::cerr << "MySQL存储尝试 " << (attempt + 1) << " 失败: " << e.what() << std::endl;
-                std::this_thread::sleep_for(std::chrono::milliseconds(200));
-            }
+        if (!success && attempt < 2) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(200));
         }
-        
-        if (!success && config_.debug) {
-            std::cerr << "所有MySQL存储尝试都失败: 日志ID = " << id << std::endl;
+    }
+    
+    if (config_.debug) {
+        if (success) {
+            std::cout << "MySQL存储成功: " << records.Size() << " 条日志" << std::endl;
+        } else {
+            std::cerr << "所有MySQL存储尝试都失败: " << records.Size() << " 条日志" << std::endl;
         }
-    } catch (const std::exception& e) {
-        std::cerr << "MySQL存储日志时出错: " << e.what() << std::endl;
     }
+    return success;
 }
 
 // 直接处理JSON字符串
@@ -784,36 +1457,24 @@ bool LogProcessor::ProcessJsonString(const std::string& jsonStr) {
     try {
         std::cout << "直接处理JSON字符串: " << jsonStr.substr(0, 100) << (jsonStr.length() > 100 ? "..." : "") << std::endl;
         
-        // 解析JSON
-        nlohmann::json json = nlohmann::json::parse(jsonStr);
-        
-        // 创建日志数据
+        // 创建日志数据，消息体只解析一次
         LogData logData;
         logData.timestamp = std::chrono::system_clock::now();
         logData.message = jsonStr;
-        logData.id = GenerateUUID();
+        logData.id = GenerateLogId();
         logData.source = "direct-json";
-        logData.metadata["is_json"] = "true";
-        
-        // 提取基本字段
-        if (json.contains("timestamp") && json["timestamp"].is_string()) {
-            logData.metadata["timestamp"] = json["timestamp"].get<std::string>();
-        }
         
-        if (json.contains("level") && json["level"].is_string()) {
-            logData.metadata["level"] = json["level"].get<std::string>();
+        PayloadFormat format = ParseLogFields(jsonStr, logData.fields, config_.jsonBackend);
+        if (format != PayloadFormat::TEXT) {
+            CountJsonParse();
         }
-        
-        if (json.contains("source") && json["source"].is_string()) {
-            logData.source = json["source"].get<std::string>();
-        }
-        
-        if (json.contains("message") && json["message"].is_string()) {
-            logData.metadata["message"] = json["message"].get<std::string>();
+        if (format != PayloadFormat::JSON) {
+            std::cerr << "解析JSON字符串失败: 不是有效的JSON对象" << std::endl;
+            return false;
         }
-        
-        if (json.contains("type") && json["type"].is_string()) {
-            logData.metadata["type"] = json["type"].get<std::string>();
+        const ParsedFields& fields = logData.fields;
+        if (fields.source) {
+            logData.source = *fields.source;
         }
         
         // 直接保存到MySQL
@@ -823,18 +1484,10 @@ bool LogProcessor::ProcessJsonString(const std::string& jsonStr) {
                 
                 storage::MySQLStorage::LogEntry entry;
                 entry.id = logData.id;
-                entry.timestamp = json.contains("timestamp") && json["timestamp"].is_string() 
-                    ? json["timestamp"].get<std::string>() 
-                    : TimestampToString(logData.timestamp);
-                entry.level = json.contains("level") && json["level"].is_string() 
-                    ? json["level"].get<std::string>() 
-                    : "INFO";
-                entry.source = json.contains("source") && json["source"].is_string() 
-                    ? json["source"].get<std::string>() 
-                    : "json-direct";
-                entry.message = json.contains("message") && json["message"].is_string() 
-                    ? json["message"].get<std::string>() 
-                    : jsonStr;
+                entry.timestamp = fields.timestamp.value_or(TimestampToString(logData.timestamp));
+                entry.level = fields.level.value_or("INFO");
+                entry.source = fields.source.value_or("json-direct");
+                entry.message = fields.message.value_or(jsonStr);
                 
                 bool success = mysqlStorage_->SaveLogEntry(entry);
                 if (success) {
@@ -850,9 +1503,6 @@ bool LogProcessor::ProcessJsonString(const std::string& jsonStr) {
         
         // 如果直接保存失败，尝试通过正常流程处理
         return ProcessLogData(std::move(logData)), true;
-    } catch (const nlohmann::json::exception& e) {
-        std::cerr << "解析JSON字符串失败: " << e.what() << std::endl;
-        return false;
     } catch (const std::exception& e) {
         std::cerr << "处理JSON字符串异常: " << e.what() << std::endl;
         return false;
@@ -866,6 +1516,7 @@ const ProcessorMetrics& LogProcessor::GetMetrics() const {
 
 // 重置指标
 void LogProcessor::ResetMetrics() {
+    std::lock_guard<std::mutex> lock(metricsMutex_);
     metrics_.Reset();
 }
 
@@ -905,7 +1556,7 @@ void LogProcessor::ResetMetrics() {
 //         if (!logs.is_array()) return;
 //         for (const auto& log : logs) {
 //             LogData data;
-//             data.id = log.value("id", GenerateUUID());
+//             data.id = log.value("id", GenerateLogId());
 //             data.message = log.value("content", "");
 //             data.source = log.value("source", "collector");
 //             // 解析时间
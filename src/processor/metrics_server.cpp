@@ -0,0 +1,91 @@
+#include "xumj/processor/metrics_server.h"
+#include <iostream>
+
+namespace xumj {
+namespace processor {
+
+namespace {
+
+std::string BuildResponse(const char* status, const char* contentType, const std::string& body) {
+    std::string response;
+    response.reserve(body.size() + 160);
+    response += "HTTP/1.1 ";
+    response += status;
+    response += "\r\nContent-Type: ";
+    response += contentType;
+    response += "\r\nContent-Length: ";
+    response += std::to_string(body.size());
+    response += "\r\nConnection: close\r\n\r\n";
+    response += body;
+    return response;
+}
+
+} // namespace
+
+MetricsServer::MetricsServer(uint16_t port, Provider provider)
+    : provider_(std::move(provider)),
+      server_(std::make_unique<network::TcpServer>("MetricsServer", "0.0.0.0", port, 1)) {
+    // 按行分帧：第一行是请求行，其余请求头忽略
+    server_->SetLineDelimited(true);
+    server_->SetMaxLineLength(kMaxRequestLineLength);
+    server_->SetMessageCallback([this](uint64_t connectionId, const std::string& line, muduo::Timestamp) {
+        OnMessage(connectionId, line);
+    });
+}
+
+MetricsServer::~MetricsServer() {
+    Stop();
+}
+
+void MetricsServer::Start() {
+    server_->Start();
+}
+
+void MetricsServer::Stop() {
+    if (server_) {
+        server_->Stop();
+    }
+}
+
+bool MetricsServer::HandleRequestLine(const std::string& requestLine, const Provider& provider,
+                                      std::string& response) {
+    // 请求行：METHOD SP target SP HTTP/x.y
+    size_t methodEnd = requestLine.find(' ');
+    size_t targetEnd = methodEnd == std::string::npos ? std::string::npos : requestLine.find(' ', methodEnd + 1);
+    if (targetEnd == std::string::npos || requestLine.compare(targetEnd + 1, 5, "HTTP/") != 0) {
+        return false;
+    }
+    std::string method = requestLine.substr(0, methodEnd);
+    std::string target = requestLine.substr(methodEnd + 1, targetEnd - methodEnd - 1);
+    size_t query = target.find('?');
+    if (query != std::string::npos) {
+        target.resize(query);
+    }
+
+    if (method != "GET") {
+        response = BuildResponse("405 Method Not Allowed", "text/plain; charset=utf-8", "only GET is supported\n");
+    } else if (target != "/metrics") {
+        response = BuildResponse("404 Not Found", "text/plain; charset=utf-8", "not found\n");
+    } else {
+        response = BuildResponse("200 OK", "text/plain; version=0.0.4; charset=utf-8", provider ? provider() : "");
+    }
+    return true;
+}
+
+void MetricsServer::OnMessage(uint64_t connectionId, const std::string& line) {
+    std::string response;
+    try {
+        if (!HandleRequestLine(line, provider_, response)) {
+            return;
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "生成指标失败: " << e.what() << std::endl;
+        response = BuildResponse("500 Internal Server Error", "text/plain; charset=utf-8", "error\n");
+    }
+    server_->Send(connectionId, response);
+    // shutdown在发送缓冲区写完后关闭写端
+    server_->CloseConnection(connectionId);
+}
+
+} // namespace processor
+} // namespace xumj
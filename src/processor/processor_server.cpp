@@ -1,19 +1,24 @@
 #include "xumj/processor/log_processor.h"
-#include "xumj/network/tcp_server.h"
+#include "xumj/processor/grok_parser.h"
+#include "xumj/processor/metrics_server.h"
+#include "xumj/common/id_generator.h"
 #include <nlohmann/json.hpp>
 #include <iostream>
-#include <sstream>
-#include <iomanip>
 #include <thread>
 #include <fstream>
 #include <regex>
+#include <map>
 
-using namespace xumj::network;
 using namespace xumj::processor;
 
 int main() {
     // 读取配置文件
     LogProcessorConfig config;
+    config.workerThreads = 4;
+    config.queueSize = 1000;
+    std::vector<std::string> grokPatterns;
+    std::map<std::string, std::vector<std::string>> grokSourcePatterns;
+    int metricsPort = 0;
     try {
         std::ifstream configFile("../src/processor/config/config.json");
         if (configFile) {
@@ -37,6 +42,78 @@ int main() {
                 if (r.contains("password")) config.redisConfig.password = r["password"].get<std::string>();
                 if (r.contains("database")) config.redisConfig.database = r["database"].get<int>();
             }
+            // 网络配置
+            if (j.contains("server")) {
+                const auto& srv = j["server"];
+                if (srv.contains("ioThreads")) config.ioThreads = srv["ioThreads"].get<size_t>();
+                if (srv.contains("maxLineLength")) config.maxLineLength = srv["maxLineLength"].get<size_t>();
+                if (srv.contains("reusePortAcceptors")) config.reusePortAcceptors = srv["reusePortAcceptors"].get<bool>();
+                if (srv.contains("cpuAffinity")) config.cpuAffinity = srv["cpuAffinity"].get<std::vector<int>>();
+            }
+            // 工作线程配置，启用adaptiveWorkers时按积压和CPU利用率在[min, max]内自动调整
+            if (j.contains("processor")) {
+                const auto& pr = j["processor"];
+                if (pr.contains("workerThreads")) config.workerThreads = pr["workerThreads"].get<int>();
+                if (pr.contains("queueSize")) config.queueSize = pr["queueSize"].get<int>();
+                // 日志ID中的节点号，多实例部署时每个实例必须不同，否则ID可能重复，重复的行被INSERT IGNORE跳过
+                if (pr.contains("nodeId")) {
+                    xumj::common::IdGenerator::Instance().SetNodeId(pr["nodeId"].get<uint16_t>());
+                }
+                if (pr.contains("adaptiveWorkers")) config.adaptiveWorkers = pr["adaptiveWorkers"].get<bool>();
+                auto& wc = config.workerConcurrency;
+                if (pr.contains("minWorkerThreads")) wc.minThreads = pr["minWorkerThreads"].get<size_t>();
+                if (pr.contains("maxWorkerThreads")) wc.maxThreads = pr["maxWorkerThreads"].get<size_t>();
+                if (pr.contains("targetQueueDelayMs")) {
+                    wc.targetQueueDelay = std::chrono::milliseconds(pr["targetQueueDelayMs"].get<int>());
+                }
+            }
+            // 准入控制：队列接近满时先丢弃低级别日志，为ERROR及以上保留容量
+            if (j.contains("admission")) {
+                const auto& ad = j["admission"];
+                auto& admission = config.admission;
+                if (ad.contains("enabled")) admission.enabled = ad["enabled"].get<bool>();
+                if (ad.contains("reservedHeadroom")) admission.reservedHeadroom = ad["reservedHeadroom"].get<double>();
+                if (ad.contains("sheddingStart")) admission.sheddingStart = ad["sheddingStart"].get<double>();
+                if (ad.contains("sourceQuota")) admission.sourceQuota = ad["sourceQuota"].get<double>();
+                if (ad.contains("levelQuota")) {
+                    for (const auto& [name, quota] : ad["levelQuota"].items()) {
+                        auto level = xumj::common::RecordBatch::ParseLevel(name);
+                        admission.levelQuota[static_cast<size_t>(level)] = quota.get<double>();
+                    }
+                }
+            }
+            // 重复日志合并
+            if (j.contains("dedup")) {
+                const auto& dd = j["dedup"];
+                auto& dedup = config.dedup;
+                if (dd.contains("enabled")) dedup.enabled = dd["enabled"].get<bool>();
+                if (dd.contains("windowMs")) dedup.window = std::chrono::milliseconds(dd["windowMs"].get<int>());
+                if (dd.contains("maxMemoryMB")) dedup.maxMemoryBytes = dd["maxMemoryMB"].get<size_t>() * 1024 * 1024;
+                if (dd.contains("normalizeNumbers")) dedup.normalizeNumbers = dd["normalizeNumbers"].get<bool>();
+            }
+            // 解析配置
+            if (j.contains("parser")) {
+                const auto& ps = j["parser"];
+                if (ps.contains("jsonBackend")) {
+                    config.jsonBackend = ps["jsonBackend"].get<std::string>() == "nlohmann"
+                                             ? JsonBackend::NLOHMANN : JsonBackend::ON_DEMAND;
+                }
+                if (ps.contains("grokPatterns")) grokPatterns = ps["grokPatterns"].get<std::vector<std::string>>();
+                if (ps.contains("grokSourcePatterns")) {
+                    grokSourcePatterns = ps["grokSourcePatterns"].get<std::map<std::string, std::vector<std::string>>>();
+                }
+            }
+            // 原始消息归档
+            if (j.contains("archive")) {
+                const auto& ar = j["archive"];
+                if (ar.contains("enabled")) config.enableRawArchive = ar["enabled"].get<bool>();
+                if (ar.contains("queueSize")) config.rawArchiveQueueSize = ar["queueSize"].get<size_t>();
+            }
+            // Prometheus指标接口，端口为0表示不启用
+            if (j.contains("metrics")) {
+                const auto& mt = j["metrics"];
+                if (mt.contains("port")) metricsPort = mt["port"].get<int>();
+            }
             config.enableMySQLStorage = true;
             config.enableRedisStorage = true;
         } else {
@@ -47,16 +124,29 @@ int main() {
     }
     // 其他参数可按需从配置文件读取或用默认值
     config.debug = true;
-    config.workerThreads = 4;
-    config.queueSize = 1000;
     config.tcpPort = 9001;
     // 输出配置信息
     std::cout << "【配置文件加载成功】MySQL: " << config.mysqlConfig.host << ":" << config.mysqlConfig.port
               << " 用户: " << config.mysqlConfig.username << " 数据库: " << config.mysqlConfig.database << std::endl;
     std::cout << "【配置文件加载成功】Redis: " << config.redisConfig.host << ":" << config.redisConfig.port << std::endl;
     std::cout << "main: config.mysqlConfig.table = " << config.mysqlConfig.table << std::endl;
+    std::cout << "日志ID节点号: " << xumj::common::IdGenerator::Instance().GetNodeId() << std::endl;
+    config.enableMetrics = config.enableMetrics || metricsPort > 0;
     LogProcessor processor(config);
-    // 添加解析器
+    // 添加解析器：grok模式解析器在前，未匹配的文本日志由JSON解析器按普通文本处理
+    if (!grokPatterns.empty() || !grokSourcePatterns.empty()) {
+        auto grokParser = std::make_shared<GrokLogParser>();
+        grokParser->SetConfig(config);
+        for (const auto& pattern : grokPatterns) {
+            grokParser->AddPattern(pattern);
+        }
+        for (const auto& [source, patterns] : grokSourcePatterns) {
+            for (const auto& pattern : patterns) {
+                grokParser->AddPattern(pattern, source);
+            }
+        }
+        processor.AddLogParser(grokParser);
+    }
     auto jsonParser = std::make_shared<JsonLogParser>();
     jsonParser->SetConfig(config);
     processor.AddLogParser(jsonParser);
@@ -65,49 +155,19 @@ int main() {
         std::cerr << "LogProcessor启动失败" << std::endl;
         return 1;
     }
+    // 指标接口使用独立的TcpServer，生成指标只读取原子计数，不阻塞日志处理
+    std::unique_ptr<MetricsServer> metricsServer;
+    if (metricsPort > 0) {
+        metricsServer = std::make_unique<MetricsServer>(static_cast<uint16_t>(metricsPort), [&processor]() {
+            xumj::common::PrometheusWriter writer;
+            processor.WritePrometheusMetrics(writer);
+            return writer.Text();
+        });
+        metricsServer->Start();
+        std::cout << "指标接口已启动: http://0.0.0.0:" << metricsPort << "/metrics" << std::endl;
+    }
+    // LogProcessor内部的TcpServer负责接收采集器批次并回送确认
     std::cout << "【MySQL/Redis连接成功】LogProcessor已启动！" << std::endl;
-    // 启动TcpServer
-    TcpServer server("ProcessorServer", "0.0.0.0", 9001, 4);
-    server.SetMessageCallback([&processor](uint64_t connId, const std::string& msg, muduo::Timestamp){
-        (void)connId;
-        // 反序列化JSON数组
-        auto logs = nlohmann::json::parse(msg, nullptr, false);
-        if (!logs.is_array()) return;
-        for (const auto& log : logs) {
-            // 优先读取新字段
-            std::string msgStr = log.value("message", "");
-            std::string timeStr = log.value("timestamp", "");
-            std::string levelStr = log.value("level", "");
-            std::string sourceStr = log.value("source", "collector");
-
-            // 兼容老字段
-            if (msgStr.empty()) msgStr = log.value("content", "");
-            if (timeStr.empty()) timeStr = log.value("time", "");
-
-            LogData data;
-            data.message = msgStr;
-            data.id = log.value("id", GenerateUUID());
-            data.source = sourceStr;
-
-            // 解析时间
-            std::tm tm = {};
-            std::istringstream ss(timeStr);
-            ss >> std::get_time(&tm, "%Y-%m-%d %H:%M:%S");
-            if (!ss.fail()) {
-                data.timestamp = std::chrono::system_clock::from_time_t(std::mktime(&tm));
-            } else {
-                data.timestamp = std::chrono::system_clock::now();
-            }
-
-            // level写入metadata，便于解析器使用
-            if (!levelStr.empty()) {
-                data.metadata["level"] = levelStr;
-            }
-
-            processor.SubmitLogData(data);
-        }
-    });
-    server.Start();
     std::cout << "ProcessorServer已启动，监听9001端口..." << std::endl;
     while (true) std::this_thread::sleep_for(std::chrono::seconds(10));
     return 0;
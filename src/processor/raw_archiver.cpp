@@ -0,0 +1,87 @@
+#include "xumj/processor/raw_archiver.h"
+#include <algorithm>
+#include <iostream>
+#include <iterator>
+#include <utility>
+
+namespace xumj {
+namespace processor {
+
+RawArchiver::RawArchiver(Writer writer, size_t capacity, size_t batchSize)
+    : writer_(std::move(writer)),
+      capacity_(capacity),
+      batchSize_(batchSize == 0 ? 1 : batchSize) {}
+
+RawArchiver::~RawArchiver() {
+    Stop();
+}
+
+void RawArchiver::Start() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (running_) {
+        return;
+    }
+    running_ = true;
+    thread_ = std::thread(&RawArchiver::Run, this);
+}
+
+void RawArchiver::Stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!running_) {
+            return;
+        }
+        running_ = false;
+    }
+    cv_.notify_one();
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+}
+
+bool RawArchiver::Submit(RawArchiveEntry entry) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!running_ || pending_.size() >= capacity_) {
+            dropped_.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        pending_.push_back(std::move(entry));
+    }
+    cv_.notify_one();
+    return true;
+}
+
+void RawArchiver::Run() {
+    std::vector<RawArchiveEntry> batch;
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            cv_.wait(lock, [this] { return !running_ || !pending_.empty(); });
+            if (pending_.empty()) {
+                return;   // 已停止且队列已写完
+            }
+            // 整段换出，写入期间提交方不受影响
+            if (pending_.size() <= batchSize_) {
+                batch.swap(pending_);
+            } else {
+                auto last = pending_.begin() + static_cast<std::ptrdiff_t>(batchSize_);
+                batch.assign(std::make_move_iterator(pending_.begin()), std::make_move_iterator(last));
+                pending_.erase(pending_.begin(), last);
+            }
+        }
+
+        size_t written = 0;
+        try {
+            written = writer_ ? writer_(batch) : 0;
+        } catch (const std::exception& e) {
+            std::cerr << "原始消息归档写入异常: " << e.what() << std::endl;
+        }
+        archived_.fetch_add(written, std::memory_order_relaxed);
+        failed_.fetch_add(batch.size() - std::min(written, batch.size()), std::memory_order_relaxed);
+        batch.clear();
+    }
+}
+
+} // namespace processor
+} // namespace xumj
@@ -6,20 +6,52 @@
 #include <chrono>
 #include <iomanip>
 #include <cstring>
-#include <uuid/uuid.h>
+#include "xumj/common/id_generator.h"
 
 namespace xumj {
 namespace storage {
 
-// 生成UUID
-std::string GenerateUUID() {
-    uuid_t uuid;
-    uuid_generate(uuid);
-    char uuid_str[37];
-    uuid_unparse_lower(uuid, uuid_str);
-    return std::string(uuid_str);
+namespace {
+
+constexpr size_t kMaxStatementBytes = 1 << 20;   // 多行INSERT单条语句的大致上限
+
+// 按字节截断，不截断在UTF-8多字节字符中间
+std::string_view TruncateUtf8(std::string_view text, size_t maxBytes) {
+    if (text.size() <= maxBytes) {
+        return text;
+    }
+    size_t end = maxBytes;
+    while (end > 0 && (static_cast<unsigned char>(text[end]) & 0xC0) == 0x80) {
+        --end;
+    }
+    return text.substr(0, end);
+}
+
+std::string LocalTimeString(std::time_t time) {
+    std::tm tm{};
+    localtime_r(&time, &tm);   // 多个写入线程并发调用，不能使用std::localtime的静态缓冲区
+    std::stringstream ss;
+    ss << std::put_time(&tm, "%Y-%m-%d %H:%M:%S");
+    return ss.str();
 }
 
+// 与SaveLogEntry相同的时间戳规则：空值用当前时间，纯数字视为Unix秒
+std::string SafeTimestamp(const std::string& timestamp) {
+    if (timestamp.empty()) {
+        return LocalTimeString(std::chrono::system_clock::to_time_t(std::chrono::system_clock::now()));
+    }
+    if (timestamp.find('-') == std::string::npos || timestamp.find(':') == std::string::npos) {
+        try {
+            return LocalTimeString(static_cast<std::time_t>(std::stoul(timestamp)));
+        } catch (...) {
+            return LocalTimeString(std::chrono::system_clock::to_time_t(std::chrono::system_clock::now()));
+        }
+    }
+    return timestamp;
+}
+
+} // namespace
+
 // ---------- MySQLConnection 实现 ----------
 
 MySQLConnection::MySQLConnection(const MySQLConfig& config)
@@ -166,6 +198,13 @@ std::string MySQLConnection::EscapeString(const std::string& str) {
     return escaped_str;
 }
 
+void MySQLConnection::AppendEscaped(std::string& out, std::string_view str) {
+    size_t offset = out.size();
+    out.resize(offset + str.size() * 2 + 1);
+    unsigned long length = mysql_real_escape_string(mysql_, &out[offset], str.data(), str.size());
+    out.resize(offset + length);
+}
+
 bool MySQLConnection::IsValid() const {
     return mysql_ != nullptr && mysql_ping(mysql_) == 0;
 }
@@ -336,6 +375,20 @@ bool MySQLStorage::Initialize() {
             ") ENGINE=InnoDB DEFAULT CHARSET=utf8mb4;"
         );
         
+        // 创建分析结果表（分析结果可能先于日志写入，不设外键）
+        conn->Execute(
+            "CREATE TABLE IF NOT EXISTS analysis_results ("
+            "    id VARCHAR(64) PRIMARY KEY,"
+            "    log_id VARCHAR(64) NOT NULL,"
+            "    rule_id VARCHAR(64) NOT NULL,"
+            "    rule_name VARCHAR(128) NOT NULL,"
+            "    result TEXT,"
+            "    created_at TIMESTAMP DEFAULT CURRENT_TIMESTAMP,"
+            "    INDEX idx_analysis_log_id (log_id),"
+            "    INDEX idx_analysis_rule_id (rule_id)"
+            ") ENGINE=InnoDB DEFAULT CHARSET=utf8mb4;"
+        );
+        
         return true;
     } catch (const MySQLStorageException& e) {
         std::cerr << "初始化数据库表结构失败: " << e.what() << std::endl;
@@ -368,7 +421,7 @@ bool MySQLStorage::SaveLogEntry(const LogEntry& entry) {
             conn->BeginTransaction();
             
             // 生成UUID作为日志ID（如果没有提供）
-            std::string id = entry.id.empty() ? GenerateUUID() : entry.id;
+            std::string id = entry.id.empty() ? common::IdGenerator::Instance().NextString() : entry.id;
             
             // 检查ID是否已存在
             std::stringstream check_sql;
@@ -398,7 +451,8 @@ bool MySQLStorage::SaveLogEntry(const LogEntry& entry) {
                 // 使用当前时间
                 auto now = std::chrono::system_clock::now();
                 auto now_time_t = std::chrono::system_clock::to_time_t(now);
-                std::tm now_tm = *std::localtime(&now_time_t);
+                std::tm now_tm{};
+                localtime_r(&now_time_t, &now_tm);
                 
                 std::stringstream ss;
                 ss << std::put_time(&now_tm, "%Y-%m-%d %H:%M:%S");
@@ -407,7 +461,8 @@ bool MySQLStorage::SaveLogEntry(const LogEntry& entry) {
                 // 尝试将时间戳转换为标准格式
                 try {
                     std::time_t timestamp = std::stoul(safeTimestamp);
-                    std::tm now_tm = *std::localtime(&timestamp);
+                    std::tm now_tm{};
+                    localtime_r(&timestamp, &now_tm);
 
                     std::stringstream ss;
                     ss<<std::put_time(&now_tm, "%Y-%m-%d %H:%M:%S");
@@ -416,7 +471,8 @@ bool MySQLStorage::SaveLogEntry(const LogEntry& entry) {
                     // 转换失败，使用当前时间
                     auto now = std::chrono::system_clock::now();
                     auto now_time_t = std::chrono::system_clock::to_time_t(now);
-                    std::tm now_tm = *std::localtime(&now_time_t);
+                    std::tm now_tm{};
+                    localtime_r(&now_time_t, &now_tm);
                     
                     std::stringstream ss;
                     ss << std::put_time(&now_tm, "%Y-%m-%d %H:%M:%S");
@@ -577,7 +633,7 @@ int MySQLStorage::SaveLogEntries(const std::vector<LogEntry>& entries) {
         // 批量插入日志条目
         for (const auto& entry : entries) {
             // 生成UUID作为日志ID（如果没有提供）
-            std::string id = entry.id.empty() ? GenerateUUID() : entry.id;
+            std::string id = entry.id.empty() ? common::IdGenerator::Instance().NextString() : entry.id;
             
             // 插入日志条目
             std::stringstream sql;
@@ -620,6 +676,176 @@ int MySQLStorage::SaveLogEntries(const std::vector<LogEntry>& entries) {
     }
 }
 
+int MySQLStorage::SaveRecordBatch(const common::RecordBatch& batch) {
+    if (batch.Empty()) {
+        return 0;
+    }
+    
+    auto conn = pool_->GetConnection();
+    if (!conn) {
+        std::cerr << "批量保存日志批次失败: 无法获取数据库连接" << std::endl;
+        return 0;
+    }
+    
+    const std::string logPrefix = "INSERT IGNORE INTO " + config_.table +
+                                  " (id, timestamp, level, source, message) VALUES ";
+    const std::string fieldPrefix = "INSERT IGNORE INTO log_fields (log_id, field_name, field_value) VALUES ";
+    std::string logSql;
+    std::string fieldSql;
+    std::string generatedId;
+    std::string timestamp;
+    
+    // 追加一个值元组，第一个元组前加语句头
+    auto beginTuple = [](std::string& sql, const std::string& prefix) {
+        if (sql.empty()) {
+            sql.reserve(kMaxStatementBytes + kMaxStatementBytes / 4);
+            sql += prefix;
+        } else {
+            sql += ',';
+        }
+        sql += "('";
+    };
+    auto appendValue = [&conn](std::string& sql, std::string_view value, bool last) {
+        conn->AppendEscaped(sql, value);
+        sql += last ? "')" : "','";
+    };
+    // 字段表有外键，先写日志表
+    auto flush = [&conn, &logSql, &fieldSql]() {
+        if (!logSql.empty()) {
+            conn->Execute(logSql);
+            logSql.clear();
+        }
+        if (!fieldSql.empty()) {
+            conn->Execute(fieldSql);
+            fieldSql.clear();
+        }
+    };
+    
+    try {
+        conn->BeginTransaction();
+        
+        for (size_t row = 0; row < batch.Size(); ++row) {
+            std::string_view id = batch.Id(row);
+            if (id.empty()) {
+                generatedId = common::IdGenerator::Instance().NextString();
+                id = generatedId;
+            }
+            id = TruncateUtf8(id, 36);
+            
+            batch.TimestampText(row, timestamp);
+            if (batch.Timestamp(row) == common::RecordBatch::kNoTimestamp) {
+                timestamp = SafeTimestamp(timestamp);
+            }
+            std::string_view level = batch.LevelText(row);
+            std::string_view source = batch.Source(row);
+            
+            beginTuple(logSql, logPrefix);
+            appendValue(logSql, id, false);
+            appendValue(logSql, timestamp, false);
+            appendValue(logSql, TruncateUtf8(level.empty() ? std::string_view("INFO") : level, 20), false);
+            appendValue(logSql, TruncateUtf8(source.empty() ? std::string_view("unknown") : source, 100), false);
+            appendValue(logSql, TruncateUtf8(batch.Message(row), 65535), true);
+            
+            int fieldCount = 0;
+            const int maxFields = 20;   // 与SaveLogEntry相同的字段数量限制
+            batch.ForEachField(row, [&](std::string_view name, std::string_view value) {
+                if (fieldCount++ >= maxFields) {
+                    return;
+                }
+                beginTuple(fieldSql, fieldPrefix);
+                appendValue(fieldSql, id, false);
+                appendValue(fieldSql, TruncateUtf8(name, 50), false);
+                appendValue(fieldSql, TruncateUtf8(value, 65535), true);
+            });
+            
+            if (logSql.size() >= kMaxStatementBytes || fieldSql.size() >= kMaxStatementBytes) {
+                flush();
+            }
+        }
+        flush();
+        
+        conn->Commit();
+        return static_cast<int>(batch.Size());
+    } catch (const std::exception& e) {
+        try {
+            conn->Rollback();
+        } catch (...) {
+            // 忽略回滚错误
+        }
+        
+        std::cerr << "批量保存日志批次失败: " << e.what() << std::endl;
+        return 0;
+    }
+}
+
+int MySQLStorage::SaveAnalysisResults(const std::vector<AnalysisResult>& results) {
+    if (results.empty()) {
+        return 0;
+    }
+    
+    auto conn = pool_->GetConnection();
+    if (!conn) {
+        std::cerr << "批量保存分析结果失败: 无法获取数据库连接" << std::endl;
+        return 0;
+    }
+    
+    const std::string prefix = "INSERT INTO analysis_results (id, log_id, rule_id, rule_name, result) VALUES ";
+    std::string sql;
+    auto appendValue = [&conn, &sql](std::string_view value, bool last) {
+        conn->AppendEscaped(sql, value);
+        sql += last ? "')" : "','";
+    };
+    
+    try {
+        conn->BeginTransaction();
+        
+        size_t skipped = 0;
+        for (const auto& result : results) {
+            if (result.result.size() > kMaxAnalysisResultBytes) {
+                skipped++;
+                continue;
+            }
+            if (sql.empty()) {
+                sql.reserve(kMaxStatementBytes + kMaxStatementBytes / 4);
+                sql += prefix;
+            } else {
+                sql += ',';
+            }
+            sql += "('";
+            appendValue(common::IdGenerator::Instance().NextString(), false);
+            appendValue(TruncateUtf8(result.logId, 64), false);
+            appendValue(TruncateUtf8(result.ruleId, 64), false);
+            appendValue(TruncateUtf8(result.ruleName, 128), false);
+            appendValue(result.result, true);
+            
+            if (sql.size() >= kMaxStatementBytes) {
+                conn->Execute(sql);
+                sql.clear();
+            }
+        }
+        if (!sql.empty()) {
+            conn->Execute(sql);
+        }
+        
+        conn->Commit();
+        if (skipped > 0) {
+            skippedAnalysisResults_.fetch_add(skipped, std::memory_order_relaxed);
+            std::cerr << "警告: " << skipped << " 条分析结果超过 " << kMaxAnalysisResultBytes
+                      << " 字节，未写入MySQL" << std::endl;
+        }
+        return static_cast<int>(results.size());
+    } catch (const std::exception& e) {
+        try {
+            conn->Rollback();
+        } catch (...) {
+            // 忽略回滚错误
+        }
+        
+        std::cerr << "批量保存分析结果失败: " << e.what() << std::endl;
+        return 0;
+    }
+}
+
 std::vector<MySQLStorage::LogEntry> MySQLStorage::QueryLogEntries(
     const std::unordered_map<std::string, std::string>& conditions,
     int limit,
@@ -129,6 +129,43 @@ redisReply* RedisConnection::ExecuteArgv(int argc, const char** argv, const size
     return reply;
 }
 
+size_t RedisConnection::ExecutePipeline(const std::vector<std::vector<std::string>>& commands) {
+    if (!IsValid()) {
+        if (!Reconnect()) {
+            throw RedisStorageException("Redis连接已断开且无法重连");
+        }
+    }
+    
+    // 命令先写入输出缓冲区，读取第一条回复时一起发送
+    std::vector<const char*> argv;
+    std::vector<size_t> argvlen;
+    for (const auto& command : commands) {
+        argv.clear();
+        argvlen.clear();
+        for (const auto& arg : command) {
+            argv.push_back(arg.data());
+            argvlen.push_back(arg.size());
+        }
+        if (redisAppendCommandArgv(context_, static_cast<int>(argv.size()), argv.data(), argvlen.data()) != REDIS_OK) {
+            throw RedisStorageException("Redis命令执行失败: " + std::string(context_->errstr));
+        }
+    }
+    
+    size_t succeeded = 0;
+    for (size_t i = 0; i < commands.size(); ++i) {
+        void* reply = nullptr;
+        if (redisGetReply(context_, &reply) != REDIS_OK || reply == nullptr) {
+            // 连接出错后剩余的回复无法读取
+            throw RedisStorageException("Redis命令执行失败: " + std::string(context_->errstr));
+        }
+        if (static_cast<redisReply*>(reply)->type != REDIS_REPLY_ERROR) {
+            ++succeeded;
+        }
+        freeReplyObject(reply);
+    }
+    return succeeded;
+}
+
 bool RedisConnection::IsValid() const {
     return context_ != nullptr && !context_->err;
 }
@@ -289,6 +326,14 @@ RedisStorage::~RedisStorage() {
     // 连接池由智能指针管理，会自动释放
 }
 
+size_t RedisStorage::Pipeline(const std::vector<std::vector<std::string>>& commands) {
+    if (commands.empty()) {
+        return 0;
+    }
+    auto conn = pool_->GetConnection();
+    return conn->ExecutePipeline(commands);
+}
+
 std::string RedisStorage::ExecuteCommand(std::function<redisReply*(RedisConnection*)> command) {
     // 如果在事务中，使用事务连接
     redisReply* reply = nullptr;
@@ -0,0 +1,196 @@
+// TcpServer 监听模式性能测试：单acceptor 与 SO_REUSEPORT 多acceptor 对比
+// 测试内容：
+//   1. 建连速率：多个线程同时发起大量连接（模拟处理器重启后的重连风暴）
+//   2. 消息延迟：每个连接发送一行消息并等待回显，统计往返延迟分位数
+//
+// 用法: acceptor_benchmark [IO线程数] [建连线程数] [每线程连接数] [每连接请求数]
+
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <string>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <algorithm>
+#include <mutex>
+#include <cstring>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include "xumj/network/tcp_server.h"
+
+using namespace xumj::network;
+using Clock = std::chrono::steady_clock;
+
+namespace {
+
+struct BenchmarkResult {
+    double connectionsPerSecond{0};
+    size_t failedConnections{0};
+    double p50Us{0};
+    double p99Us{0};
+    double maxUs{0};
+};
+
+int ConnectTo(uint16_t port) {
+    int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0) {
+        return -1;
+    }
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (::connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) {
+        ::close(fd);
+        return -1;
+    }
+    int one = 1;
+    ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    return fd;
+}
+
+// 发送一行并等待回显的一行
+bool RoundTrip(int fd, const std::string& line) {
+    if (::send(fd, line.data(), line.size(), 0) != static_cast<ssize_t>(line.size())) {
+        return false;
+    }
+    char buf[256];
+    size_t received = 0;
+    while (received < line.size()) {
+        ssize_t n = ::recv(fd, buf, sizeof(buf), 0);
+        if (n <= 0) {
+            return false;
+        }
+        received += static_cast<size_t>(n);
+    }
+    return true;
+}
+
+double Percentile(std::vector<double>& samples, double p) {
+    if (samples.empty()) {
+        return 0;
+    }
+    size_t idx = static_cast<size_t>(p * (samples.size() - 1));
+    std::nth_element(samples.begin(), samples.begin() + idx, samples.end());
+    return samples[idx];
+}
+
+BenchmarkResult RunBenchmark(bool reusePort, uint16_t port, size_t ioThreads,
+                             size_t clientThreads, size_t connsPerThread, size_t requestsPerConn) {
+    TcpServer server(reusePort ? "ReusePortBench" : "SingleAcceptorBench", "127.0.0.1", port, ioThreads);
+    server.SetReusePortAcceptors(reusePort);
+    server.SetLineDelimited(true);
+    server.SetMessageCallback([&server](uint64_t connId, const std::string& msg, muduo::Timestamp) {
+        server.Send(connId, msg + "\n");
+    });
+    server.SetConnectionCallback([](uint64_t, const std::string&, bool) {});
+    server.Start();
+
+    BenchmarkResult result;
+    std::vector<std::vector<int>> fds(clientThreads);
+    std::atomic<size_t> failed{0};
+
+    // 1. 重连风暴：所有线程同时建连
+    auto connectStart = Clock::now();
+    {
+        std::vector<std::thread> threads;
+        for (size_t t = 0; t < clientThreads; ++t) {
+            threads.emplace_back([&, t]() {
+                for (size_t i = 0; i < connsPerThread; ++i) {
+                    int fd = ConnectTo(port);
+                    if (fd < 0) {
+                        failed++;
+                        continue;
+                    }
+                    fds[t].push_back(fd);
+                }
+            });
+        }
+        for (auto& th : threads) {
+            th.join();
+        }
+    }
+    double connectSeconds = std::chrono::duration<double>(Clock::now() - connectStart).count();
+    size_t established = clientThreads * connsPerThread - failed;
+    result.connectionsPerSecond = connectSeconds > 0 ? established / connectSeconds : 0;
+    result.failedConnections = failed;
+
+    // 2. 往返延迟：每个连接串行发送请求
+    std::vector<double> latencies;
+    std::mutex latencyMutex;
+    {
+        std::vector<std::thread> threads;
+        for (size_t t = 0; t < clientThreads; ++t) {
+            threads.emplace_back([&, t]() {
+                std::vector<double> local;
+                local.reserve(fds[t].size() * requestsPerConn);
+                const std::string line = "ping-" + std::to_string(t) + "\n";
+                for (int fd : fds[t]) {
+                    for (size_t r = 0; r < requestsPerConn; ++r) {
+                        auto start = Clock::now();
+                        if (!RoundTrip(fd, line)) {
+                            break;
+                        }
+                        local.push_back(std::chrono::duration<double, std::micro>(Clock::now() - start).count());
+                    }
+                }
+                std::lock_guard<std::mutex> lock(latencyMutex);
+                latencies.insert(latencies.end(), local.begin(), local.end());
+            });
+        }
+        for (auto& th : threads) {
+            th.join();
+        }
+    }
+    result.p50Us = Percentile(latencies, 0.50);
+    result.p99Us = Percentile(latencies, 0.99);
+    result.maxUs = latencies.empty() ? 0 : *std::max_element(latencies.begin(), latencies.end());
+
+    for (auto& list : fds) {
+        for (int fd : list) {
+            ::close(fd);
+        }
+    }
+    server.Stop();
+    return result;
+}
+
+void PrintResult(const std::string& name, const BenchmarkResult& r) {
+    std::cout << std::left << std::setw(22) << name
+              << std::right << std::fixed << std::setprecision(0)
+              << std::setw(14) << r.connectionsPerSecond
+              << std::setw(10) << r.failedConnections
+              << std::setprecision(1)
+              << std::setw(12) << r.p50Us
+              << std::setw(12) << r.p99Us
+              << std::setw(12) << r.maxUs << std::endl;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    size_t ioThreads = argc > 1 ? std::stoul(argv[1]) : 4;
+    size_t clientThreads = argc > 2 ? std::stoul(argv[2]) : 8;
+    size_t connsPerThread = argc > 3 ? std::stoul(argv[3]) : 200;
+    size_t requestsPerConn = argc > 4 ? std::stoul(argv[4]) : 20;
+
+    std::cout << "IO线程: " << ioThreads << "，建连线程: " << clientThreads
+              << "，每线程连接: " << connsPerThread << "，每连接请求: " << requestsPerConn << std::endl;
+
+    BenchmarkResult single = RunBenchmark(false, 19101, ioThreads, clientThreads, connsPerThread, requestsPerConn);
+    BenchmarkResult multi = RunBenchmark(true, 19102, ioThreads, clientThreads, connsPerThread, requestsPerConn);
+
+    std::cout << "\n" << std::left << std::setw(22) << "模式"
+              << std::right << std::setw(14) << "建连/秒"
+              << std::setw(10) << "失败"
+              << std::setw(12) << "p50(us)"
+              << std::setw(12) << "p99(us)"
+              << std::setw(12) << "max(us)" << std::endl;
+    PrintResult("single-acceptor", single);
+    PrintResult("SO_REUSEPORT x" + std::to_string(ioThreads), multi);
+    return 0;
+}
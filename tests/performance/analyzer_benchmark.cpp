@@ -0,0 +1,479 @@
+// 分析器性能测试（Google Benchmark）：单条规则逐条评估与完整分析流程的吞吐
+// 测试内容：
+//   1. RegexAnalysisRule、KeywordAnalysisRule逐条评估（每条规则各自匹配，不经过分析器的合并匹配）
+//   2. LogAnalyzer完整流程：提交列式批次、按块切分、合并匹配、回调结果（不存储）
+//   3. 1、10、100、1000条规则；规则评估1、4、16个线程，分析器1、4、16个分析线程
+//   4. 每条记录的耗时、内存分配次数和命中规则数，可用--benchmark_out输出JSON长期跟踪
+//
+// 语料：内置两组（日志生成器格式、混合告警格式），--corpus=FILE 追加文件语料，
+// 例如tools/log_generator的输出文件或线上采集的日志样本，每行一条日志
+//
+// 用法: analyzer_benchmark [--corpus=FILE]... [--corpus_lines=N] [Google Benchmark参数]
+// 例如: analyzer_benchmark --corpus=logs/test_service.log --benchmark_out=analyzer.json --benchmark_out_format=json
+
+#include <benchmark/benchmark.h>
+#include <atomic>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+#include "xumj/analyzer/log_analyzer.h"
+
+using namespace xumj::analyzer;
+
+namespace {
+
+// ---------------- 内存分配计数 ----------------
+
+// 每个线程一个计数槽，分配时只写自己的槽，避免多线程测试中争用同一个计数器
+struct alignas(64) AllocSlot {
+    std::atomic<uint64_t> count{0};
+};
+
+constexpr size_t kAllocSlots = 256;
+AllocSlot gAllocSlots[kAllocSlots];
+std::atomic<size_t> gNextAllocSlot{0};
+thread_local AllocSlot* tAllocSlot = nullptr;
+
+AllocSlot& CurrentAllocSlot() {
+    if (!tAllocSlot) {
+        tAllocSlot = &gAllocSlots[gNextAllocSlot.fetch_add(1, std::memory_order_relaxed) % kAllocSlots];
+    }
+    return *tAllocSlot;
+}
+
+// 当前线程的分配次数
+uint64_t ThreadAllocations() {
+    return CurrentAllocSlot().count.load(std::memory_order_relaxed);
+}
+
+// 所有线程的分配次数
+uint64_t TotalAllocations() {
+    uint64_t total = 0;
+    for (const auto& slot : gAllocSlots) {
+        total += slot.count.load(std::memory_order_relaxed);
+    }
+    return total;
+}
+
+} // namespace
+
+void* operator new(std::size_t size) {
+    CurrentAllocSlot().count.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(size == 0 ? 1 : size)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+// 替换的operator new用malloc分配，GCC内联后会把这里的free误报为与new不匹配
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept {
+    std::free(p);
+}
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+
+namespace {
+
+// ---------------- 语料 ----------------
+
+struct Corpus {
+    std::string name;
+    std::vector<LogRecord> records;
+};
+
+const char* kLevels[] = {"info", "warn", "error"};
+const char* kModules[] = {"user", "order", "payment", "system"};
+
+// 与tools/log_generator默认格式一致："{time} [{level}] {module}: {msg}"，级别按70/20/10分布
+std::string GeneratorLine(std::mt19937& rng) {
+    static const char* names[] = {"张伟", "王芳", "李娜", "刘洋", "陈静", "John Smith", "Mary Johnson"};
+    static const char* companies[] = {"华信科技有限公司", "Acme Corp", "鼎盛贸易", "Globex Inc"};
+    static const char* actions[] = {"登录", "下单", "支付", "查询", "登出"};
+    static const char* sentences[] = {"操作成功", "参数错误", "权限不足", "系统异常", "网络超时"};
+    auto next = [&rng](unsigned mod) { return static_cast<unsigned>(rng() % mod); };
+    unsigned roll = next(100);
+    const char* level = roll < 70 ? kLevels[0] : (roll < 90 ? kLevels[1] : kLevels[2]);
+    const char* module = kModules[next(4)];
+    char head[64];
+    std::snprintf(head, sizeof(head), "2024-%02u-%02u %02u:%02u:%02u [%s] %s: ",
+                  1 + next(12), 1 + next(28), next(24), next(60), next(60), level, module);
+    return std::string(head) + "用户:" + names[next(7)] + " 手机:13" + std::to_string(100000000 + next(900000000)) +
+           " 公司:" + companies[next(4)] + " IP:" + std::to_string(next(256)) + "." + std::to_string(next(256)) +
+           "." + std::to_string(next(256)) + "." + std::to_string(next(256)) + " 模块:" + module +
+           " 操作:" + actions[next(5)] + " 内容:" + sentences[next(5)];
+}
+
+const char* kComponents[] = {"db", "cache", "auth", "order", "payment", "gateway", "search", "billing",
+                             "inventory", "notify"};
+
+// 服务告警行，对应下面的规则模板
+std::string AlertLine(std::mt19937& rng) {
+    auto next = [&rng](unsigned mod) { return std::to_string(rng() % mod); };
+    std::string c = kComponents[rng() % 10];
+    switch (rng() % 8) {
+        case 0: return c + ": connection refused to 10.0." + next(256) + "." + next(256) + ":" + next(65536);
+        case 1: return "GET /api/items " + c + " request took " + next(20000) + "ms";
+        case 2: return "[" + c + "] ERROR java.lang.IllegalStateException: bad state at line " + next(900);
+        case 3: return c + ": user=user" + next(100) + " failed login from 192.168.1." + next(256);
+        case 4: return c + " queue depth " + next(100000) + " exceeds limit 50000";
+        case 5: return c + ": disk /dev/sdb1 " + next(100) + "% full";
+        case 6: return c + " retry " + next(5) + "/5 for job 3fa85f64";
+        default: return c + ": UPDATE orders SET status=2 WHERE id=" + next(100000) + " slow query " + next(10) + ".5s";
+    }
+}
+
+// 按日志生成器格式拆出时间、级别和来源，其他格式整行作为消息
+LogRecord ToRecord(const std::string& line, size_t index) {
+    LogRecord record;
+    record.id = "bench-" + std::to_string(index);
+    record.level = "info";
+    record.message = line;
+    size_t open = line.find(" [");
+    size_t close = open == std::string::npos ? std::string::npos : line.find("] ", open);
+    if (close != std::string::npos && close - open <= 8) {
+        record.timestamp = line.substr(0, open);
+        record.level = line.substr(open + 2, close - open - 2);
+        size_t colon = line.find(": ", close + 2);
+        if (colon != std::string::npos && colon - close - 2 <= 32) {
+            record.source = line.substr(close + 2, colon - close - 2);
+        }
+    }
+    return record;
+}
+
+Corpus MakeCorpus(const std::string& name, size_t lines, unsigned alertPercent) {
+    std::mt19937 rng(42);
+    Corpus corpus{name, {}};
+    for (size_t i = 0; i < lines; ++i) {
+        std::string line = rng() % 100 < alertPercent
+                               ? "2024-06-01 12:00:00 [error] " + AlertLine(rng) : GeneratorLine(rng);
+        corpus.records.push_back(ToRecord(line, i));
+    }
+    return corpus;
+}
+
+bool LoadCorpus(const std::string& path, size_t maxLines, Corpus& corpus) {
+    std::ifstream in(path);
+    if (!in) {
+        std::cerr << "无法打开语料文件: " << path << std::endl;
+        return false;
+    }
+    size_t slash = path.find_last_of('/');
+    corpus.name = slash == std::string::npos ? path : path.substr(slash + 1);
+    std::string line;
+    while (corpus.records.size() < maxLines && std::getline(in, line)) {
+        if (!line.empty()) {
+            corpus.records.push_back(ToRecord(line, corpus.records.size()));
+        }
+    }
+    if (corpus.records.empty()) {
+        std::cerr << "语料文件为空: " << path << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// ---------------- 规则 ----------------
+
+// 规则模板，%s替换为组件名；第i条规则使用第i % 模板数个模板和第i / 模板数个组件，
+// 组件超出kComponents时为不出现在语料中的服务名，规则数越多未命中的规则比例越高
+struct RegexTemplate {
+    const char* pattern;
+    std::vector<std::string> fields;
+};
+
+const RegexTemplate kRegexTemplates[] = {
+    {"%s: connection (refused|reset|timed out) to ([0-9.]+):(\\d+)", {"reason", "host", "port"}},
+    {"%s request took (\\d{4,})ms", {"duration"}},
+    {"\\[%s\\] (ERROR|FATAL) .*[Ee]xception", {}},
+    {"%s: user=(\\w+) failed login from ([0-9.]+)", {"user", "ip"}},
+    {"%s queue depth (\\d+) exceeds limit", {"depth"}},
+    {"%s: disk /dev/sd[a-z]\\d? (\\d+)% full", {"usage"}},
+    {"%s retry (\\d+)/(\\d+) for job [a-f0-9]{8}", {"attempt", "max"}},
+    {"%s: (SELECT|UPDATE|DELETE) .* slow query (\\d+\\.\\d+)s", {"statement", "seconds"}},
+    {"模块:%s 操作:(支付|下单) 内容:(系统异常|网络超时)", {"action", "reason"}},
+    {"IP:(\\d+\\.\\d+\\.\\d+\\.\\d+) 模块:%s 操作:登录 内容:权限不足", {"ip"}},
+};
+
+const char* kKeywordTemplates[][2] = {
+    {"%s: connection refused", "%s: connection reset"},
+    {"[%s] ERROR", "[%s] FATAL"},
+    {"%s queue depth", "%s: disk"},
+    {"%s retry", "%s: UPDATE"},
+    {"模块:%s 操作:支付", "模块:%s 操作:下单"},
+};
+
+std::string Component(size_t index) {
+    return index < 10 ? kComponents[index] : "svc" + std::to_string(index);
+}
+
+std::string Format(const char* pattern, const std::string& component) {
+    std::string text(pattern);
+    size_t pos = text.find("%s");
+    return pos == std::string::npos ? text : text.replace(pos, 2, component);
+}
+
+std::vector<std::shared_ptr<AnalysisRule>> MakeRegexRules(size_t count) {
+    std::vector<std::shared_ptr<AnalysisRule>> rules;
+    for (size_t i = 0; i < count; ++i) {
+        const RegexTemplate& tpl = kRegexTemplates[i % 10];
+        // 最后两个模板匹配生成器格式的"模块:"，组件取生成器的模块名
+        std::string component = i % 10 >= 8 ? (i / 10 < 4 ? kModules[i / 10] : Component(i / 10))
+                                            : Component(i / 10);
+        rules.push_back(std::make_shared<RegexAnalysisRule>(
+            "regex-" + std::to_string(i), Format(tpl.pattern, component), tpl.fields));
+    }
+    return rules;
+}
+
+std::vector<std::shared_ptr<AnalysisRule>> MakeKeywordRules(size_t count) {
+    std::vector<std::shared_ptr<AnalysisRule>> rules;
+    for (size_t i = 0; i < count; ++i) {
+        const auto& tpl = kKeywordTemplates[i % 5];
+        std::string component = i % 5 == 4 ? (i / 5 < 4 ? kModules[i / 5] : Component(i / 5)) : Component(i / 5);
+        rules.push_back(std::make_shared<KeywordAnalysisRule>(
+            "keyword-" + std::to_string(i),
+            std::vector<std::string>{Format(tpl[0], component), Format(tpl[1], component)}, i % 2 == 0));
+    }
+    return rules;
+}
+
+// 分析器使用的规则：正则规则与关键字规则交替
+std::vector<std::shared_ptr<AnalysisRule>> MakeMixedRules(size_t count) {
+    auto regex = MakeRegexRules((count + 1) / 2);
+    auto keyword = MakeKeywordRules(count / 2);
+    std::vector<std::shared_ptr<AnalysisRule>> rules;
+    for (size_t i = 0; i < count; ++i) {
+        rules.push_back(i % 2 == 0 ? regex[i / 2] : keyword[i / 2]);
+    }
+    return rules;
+}
+
+const int64_t kRuleCounts[] = {1, 10, 100, 1000};
+const int kThreadCounts[] = {1, 4, 16};
+
+void SetRecordCounters(benchmark::State& state, uint64_t records, uint64_t matches, uint64_t allocations,
+                       benchmark::Counter::Flags averageFlag) {
+    double perRecord = records == 0 ? 0.0 : 1.0 / static_cast<double>(records);
+    state.SetItemsProcessed(static_cast<int64_t>(records));
+    state.counters["time_per_record"] = benchmark::Counter(static_cast<double>(records),
+                                                           benchmark::Counter::kIsRate | benchmark::Counter::kInvert);
+    state.counters["allocs_per_record"] = benchmark::Counter(static_cast<double>(allocations) * perRecord, averageFlag);
+    state.counters["matches_per_record"] = benchmark::Counter(static_cast<double>(matches) * perRecord, averageFlag);
+    state.counters["matches"] = benchmark::Counter(static_cast<double>(matches));
+}
+
+// ---------------- 单条规则逐条评估 ----------------
+
+// 每次迭代分析一条记录上的所有规则，各线程从不同位置开始轮流读取语料
+void BM_RuleEvaluate(benchmark::State& state, const Corpus* corpus,
+                     const std::vector<std::shared_ptr<AnalysisRule>>* allRules) {
+    const size_t ruleCount = static_cast<size_t>(state.range(0));
+    const auto& rules = *allRules;
+    const auto& records = corpus->records;
+    size_t index = records.size() * static_cast<size_t>(state.thread_index()) / static_cast<size_t>(state.threads());
+    RuleResult result;
+    uint64_t matches = 0;
+    uint64_t allocations = ThreadAllocations();
+    for (auto _ : state) {
+        const LogRecord& record = records[index];
+        index = index + 1 == records.size() ? 0 : index + 1;
+        result.Reset(ruleCount);
+        for (size_t r = 0; r < ruleCount; ++r) {
+            rules[r]->Evaluate(record, r, result);
+        }
+        matches += result.GetMatchedCount();
+        benchmark::DoNotOptimize(result);
+    }
+    allocations = ThreadAllocations() - allocations;
+    SetRecordCounters(state, static_cast<uint64_t>(state.iterations()), matches, allocations,
+                      benchmark::Counter::kAvgThreads);
+}
+
+// ---------------- 完整分析流程 ----------------
+
+// 分析器和结果计数。同一配置的多次调用复用分析器，合并规则集只在第一次分析前编译一次
+struct AnalyzerFixture {
+    const Corpus* corpus{nullptr};
+    size_t ruleCount{0};
+    size_t threads{0};
+    std::unique_ptr<LogAnalyzer> analyzer;
+    std::atomic<uint64_t> done{0};
+    std::atomic<uint64_t> matches{0};
+    std::atomic<uint64_t> expected{0};
+    std::mutex mutex;
+    std::condition_variable cond;
+
+    void Submit(xumj::common::RecordBatch&& batch, size_t rows) {
+        expected.fetch_add(rows, std::memory_order_relaxed);
+        analyzer->SubmitBatch(std::move(batch));
+    }
+
+    void Wait() {
+        std::unique_lock<std::mutex> lock(mutex);
+        cond.wait(lock, [this] {
+            return done.load(std::memory_order_relaxed) >= expected.load(std::memory_order_relaxed);
+        });
+    }
+};
+
+AnalyzerFixture& GetAnalyzer(const Corpus* corpus, size_t ruleCount, size_t threads,
+                             const xumj::common::RecordBatch& batch) {
+    static AnalyzerFixture fixture;
+    if (fixture.analyzer && fixture.corpus == corpus && fixture.ruleCount == ruleCount && fixture.threads == threads) {
+        return fixture;
+    }
+    fixture.analyzer.reset();
+    fixture.corpus = corpus;
+    fixture.ruleCount = ruleCount;
+    fixture.threads = threads;
+    fixture.done = 0;
+    fixture.matches = 0;
+    fixture.expected = 0;
+
+    AnalyzerConfig config;
+    config.threadPoolSize = threads;
+    config.storeResults = false;
+    fixture.analyzer = std::make_unique<LogAnalyzer>(config);
+    for (auto& rule : MakeMixedRules(ruleCount)) {
+        fixture.analyzer->AddRule(rule);
+    }
+    fixture.analyzer->SetResultCallback([](const LogRecord&, const RuleResult& result,
+                                           const std::vector<std::shared_ptr<AnalysisRule>>&) {
+        fixture.matches.fetch_add(result.GetMatchedCount(), std::memory_order_relaxed);
+        uint64_t done = fixture.done.fetch_add(1, std::memory_order_relaxed) + 1;
+        if (done >= fixture.expected.load(std::memory_order_relaxed)) {
+            std::lock_guard<std::mutex> lock(fixture.mutex);
+            fixture.cond.notify_one();
+        }
+    });
+    fixture.analyzer->Start();
+    // 预热：编译合并规则集，线程池和分析结果的缓冲区达到稳定大小
+    xumj::common::RecordBatch warmup = batch;
+    fixture.Submit(std::move(warmup), corpus->records.size());
+    fixture.Wait();
+    return fixture;
+}
+
+// 每次迭代把整个语料作为一个批次提交给分析器，等待所有记录的结果回调
+void BM_Analyzer(benchmark::State& state, const Corpus* corpus, const xumj::common::RecordBatch* batch) {
+    const size_t ruleCount = static_cast<size_t>(state.range(0));
+    const size_t threads = static_cast<size_t>(state.range(1));
+    AnalyzerFixture& fixture = GetAnalyzer(corpus, ruleCount, threads, *batch);
+    const size_t rows = corpus->records.size();
+
+    uint64_t matches = fixture.matches.load(std::memory_order_relaxed);
+    uint64_t allocations = 0;
+    for (auto _ : state) {
+        // 批次的复制不计入耗时和分配次数：处理器中批次由解析流程直接构建后移入分析器
+        state.PauseTiming();
+        xumj::common::RecordBatch copy = *batch;
+        state.ResumeTiming();
+        uint64_t before = TotalAllocations();
+        fixture.Submit(std::move(copy), rows);
+        fixture.Wait();
+        allocations += TotalAllocations() - before;
+    }
+    matches = fixture.matches.load(std::memory_order_relaxed) - matches;
+    SetRecordCounters(state, static_cast<uint64_t>(state.iterations()) * rows, matches, allocations,
+                      benchmark::Counter::kDefaults);
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    benchmark::Initialize(&argc, argv);
+
+    // Google Benchmark处理后剩余的参数
+    size_t corpusLines = 10000;
+    std::vector<std::string> corpusFiles;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg.rfind("--corpus=", 0) == 0) {
+            corpusFiles.push_back(arg.substr(9));
+        } else if (arg.rfind("--corpus_lines=", 0) == 0) {
+            corpusLines = std::stoul(arg.substr(15));
+        } else {
+            std::cerr << "未知参数: " << arg << std::endl;
+            std::cerr << "用法: " << argv[0] << " [--corpus=FILE]... [--corpus_lines=N] [Google Benchmark参数]"
+                      << std::endl;
+            return 1;
+        }
+    }
+
+    std::vector<std::unique_ptr<Corpus>> corpora;
+    corpora.push_back(std::make_unique<Corpus>(MakeCorpus("generator", corpusLines, 0)));
+    corpora.push_back(std::make_unique<Corpus>(MakeCorpus("mixed", corpusLines, 20)));
+    for (const auto& path : corpusFiles) {
+        auto corpus = std::make_unique<Corpus>();
+        if (!LoadCorpus(path, corpusLines, *corpus)) {
+            return 1;
+        }
+        corpora.push_back(std::move(corpus));
+    }
+
+    // 规则在所有测试之间共享，评估是只读的；每个测试使用前N条
+    auto regexRules = MakeRegexRules(1000);
+    auto keywordRules = MakeKeywordRules(1000);
+    const std::pair<const char*, const std::vector<std::shared_ptr<AnalysisRule>>*> ruleKinds[] = {
+        {"BM_RegexRule/", &regexRules},
+        {"BM_KeywordRule/", &keywordRules},
+    };
+    std::vector<std::unique_ptr<xumj::common::RecordBatch>> batches;
+
+    for (const auto& corpus : corpora) {
+        size_t bytes = 0;
+        auto batch = std::make_unique<xumj::common::RecordBatch>();
+        for (const auto& record : corpus->records) {
+            bytes += record.message.size();
+            AppendRecord(*batch, record);
+        }
+        benchmark::AddCustomContext("corpus." + corpus->name,
+                                    std::to_string(corpus->records.size()) + " lines, " +
+                                        std::to_string(bytes / corpus->records.size()) + " bytes/line");
+
+        for (const auto& [prefix, rules] : ruleKinds) {
+            auto* bench = benchmark::RegisterBenchmark((prefix + corpus->name).c_str(), BM_RuleEvaluate,
+                                                       corpus.get(), rules);
+            bench->ArgName("rules")->UseRealTime();
+            for (int64_t rules : kRuleCounts) {
+                bench->Arg(rules);
+            }
+            for (int threads : kThreadCounts) {
+                bench->Threads(threads);
+            }
+        }
+
+        auto* bench = benchmark::RegisterBenchmark(("BM_Analyzer/" + corpus->name).c_str(), BM_Analyzer,
+                                                   corpus.get(), batch.get());
+        bench->ArgNames({"rules", "threads"})->UseRealTime()->Unit(benchmark::kMillisecond);
+        for (int64_t rules : kRuleCounts) {
+            for (int threads : kThreadCounts) {
+                bench->Args({rules, threads});
+            }
+        }
+        batches.push_back(std::move(batch));
+    }
+
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+    return 0;
+}
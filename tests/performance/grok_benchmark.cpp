@@ -0,0 +1,226 @@
+// grok模式解析性能测试：对比GrokMatcher（多个模式合并为一个DFA）与逐个尝试std::regex
+// 测试内容：
+//   1. 两组语料：日志生成器格式（单一模式）、混合格式（三种模式并含10%无法匹配的行）
+//   2. 两种实现匹配到的模式和提取的字段必须一致，不一致时返回1
+//   3. 每行的耗时（纳秒）与吞吐（MB/秒）
+//
+// 用法: grok_benchmark [每组行数] [重复次数]
+
+#include <iostream>
+#include <iomanip>
+#include <cstdio>
+#include <vector>
+#include <string>
+#include <regex>
+#include <chrono>
+#include <random>
+#include <functional>
+#include "xumj/processor/grok_parser.h"
+
+using namespace xumj::processor;
+using Clock = std::chrono::steady_clock;
+
+namespace {
+
+// 同一组模式的grok写法与等价的正则表达式
+struct PatternPair {
+    std::string grok;
+    std::string regex;
+};
+
+const std::vector<PatternPair> kPatterns = {
+    {"%{TIMESTAMP:time} \\[%{LEVEL:level}\\] %{WORD:module}: %{GREEDY:msg}",
+     R"re((\d{4}-\d{2}-\d{2}[T ]\d{2}:\d{2}:\d{2}(?:[.,]\d*)?) \[([A-Za-z]+)\] (\w+): ([\s\S]*))re"},
+    {"%{IP:client} - %{DATA:user} [%{DATA:time}] \"%{WORD:method} %{NOTSPACE:path}\" %{INT:status} %{NUMBER:bytes}",
+     R"re(([0-9A-Fa-f:.]+) - ([\s\S]*?) \[([\s\S]*?)\] "(\w+) ([^\s"]+)" ([+-]?\d+) ([+-]?\d+(?:\.\d*)?))re"},
+    {"<%{INT:pri}>%{DATA:header}: %{GREEDY:msg}",
+     R"re(<([+-]?\d+)>([\s\S]*?): ([\s\S]*))re"},
+};
+
+// 匹配结果：模式下标和字段值
+struct Outcome {
+    int pattern{-1};
+    std::vector<std::string> values;
+    bool operator==(const Outcome& other) const {
+        return pattern == other.pattern && values == other.values;
+    }
+};
+
+std::string GeneratorLine(std::mt19937& rng) {
+    static const char* levels[] = {"info", "warn", "error"};
+    static const char* modules[] = {"user", "order", "payment", "system"};
+    static const char* actions[] = {"登录", "下单", "支付", "退款", "查询"};
+    char time[32];
+    auto next = [&rng](unsigned mod) { return static_cast<unsigned>(rng() % mod); };
+    std::snprintf(time, sizeof(time), "2024-%02u-%02u %02u:%02u:%02u",
+                  1 + next(12), 1 + next(28), next(24), next(60), next(60));
+    std::string module = modules[rng() % 4];
+    return std::string(time) + " [" + levels[rng() % 3] + "] " + module + ": 用户:张三" +
+           std::to_string(rng() % 1000) + " 手机:138" + std::to_string(10000000 + rng() % 89999999) +
+           " 公司:示例科技有限公司 IP:10.0." + std::to_string(rng() % 256) + "." + std::to_string(rng() % 256) +
+           " 模块:" + module + " 操作:" + actions[rng() % 5] + " 内容:request finished in " +
+           std::to_string(rng() % 900) + "ms";
+}
+
+std::string AccessLine(std::mt19937& rng) {
+    static const char* methods[] = {"GET", "POST", "PUT", "DELETE"};
+    return "192.168." + std::to_string(rng() % 256) + "." + std::to_string(rng() % 256) + " - user" +
+           std::to_string(rng() % 50) + " [01/Jan/2024:12:" + std::to_string(10 + rng() % 50) + ":00 +0800] \"" +
+           methods[rng() % 4] + " /api/v1/items/" + std::to_string(rng() % 10000) + "?page=" +
+           std::to_string(rng() % 20) + "\" " + std::to_string(200 + rng() % 4 * 100) + " " +
+           std::to_string(rng() % 50000) + "." + std::to_string(rng() % 10);
+}
+
+std::string SyslogLine(std::mt19937& rng) {
+    static const char* apps[] = {"sshd", "cron", "kernel", "nginx"};
+    return "<" + std::to_string(rng() % 192) + ">Jan  1 00:00:" + std::to_string(10 + rng() % 50) +
+           " host-" + std::to_string(rng() % 16) + " " + apps[rng() % 4] + ": session " +
+           std::to_string(rng() % 100000) + " opened";
+}
+
+std::vector<std::string> MakeCorpus(size_t count, bool mixed, std::mt19937& rng) {
+    std::vector<std::string> lines;
+    lines.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+        if (!mixed) {
+            lines.push_back(GeneratorLine(rng));
+            continue;
+        }
+        switch (i % 10) {
+            case 0:
+                lines.push_back("unstructured line " + std::to_string(rng()) + " without any known layout");
+                break;
+            case 1: case 2: case 3:
+                lines.push_back(AccessLine(rng));
+                break;
+            case 4: case 5:
+                lines.push_back(SyslogLine(rng));
+                break;
+            default:
+                lines.push_back(GeneratorLine(rng));
+                break;
+        }
+    }
+    return lines;
+}
+
+Outcome MatchRegex(const std::vector<std::regex>& regexes, const std::string& line) {
+    Outcome outcome;
+    std::smatch match;
+    for (size_t p = 0; p < regexes.size(); ++p) {
+        if (std::regex_match(line, match, regexes[p])) {
+            outcome.pattern = static_cast<int>(p);
+            for (size_t g = 1; g < match.size(); ++g) {
+                outcome.values.push_back(match[g].str());
+            }
+            break;
+        }
+    }
+    return outcome;
+}
+
+Outcome MatchGrok(const GrokMatcher& matcher, const std::string& line) {
+    Outcome outcome;
+    GrokMatcher::Result result;
+    if (matcher.Match(line, result)) {
+        outcome.pattern = result.pattern;
+        for (const auto& value : result.values) {
+            outcome.values.emplace_back(value);
+        }
+    }
+    return outcome;
+}
+
+// 返回每行的平均纳秒数
+double Measure(const std::vector<std::string>& lines, size_t repeat, const std::function<size_t(const std::string&)>& match) {
+    volatile size_t sink = 0;
+    auto start = Clock::now();
+    for (size_t r = 0; r < repeat; ++r) {
+        for (const auto& line : lines) {
+            sink = sink + match(line);
+        }
+    }
+    double ns = std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+    return ns / static_cast<double>(lines.size() * repeat);
+}
+
+void PrintRow(const std::string& name, double ns, double avgBytes) {
+    std::cout << "  " << std::left << std::setw(16) << name << std::right << std::fixed
+              << std::setw(12) << std::setprecision(0) << ns
+              << std::setw(12) << std::setprecision(1) << avgBytes / ns * 1000.0 << std::endl;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    size_t count = argc > 1 ? std::stoul(argv[1]) : 20000;
+    size_t repeat = argc > 2 ? std::stoul(argv[2]) : 5;
+    std::mt19937 rng(42);
+
+    GrokMatcher single;
+    GrokMatcher multi;
+    std::vector<std::regex> singleRegex;
+    std::vector<std::regex> multiRegex;
+    for (size_t p = 0; p < kPatterns.size(); ++p) {
+        if (p == 0) {
+            single.AddPattern(kPatterns[p].grok);
+            singleRegex.emplace_back(kPatterns[p].regex);
+        }
+        multi.AddPattern(kPatterns[p].grok);
+        multiRegex.emplace_back(kPatterns[p].regex);
+    }
+    if (!single.Compile() || !multi.Compile()) {
+        return 1;
+    }
+    std::cout << "DFA状态数: 单模式 " << single.GetStateCount() << "，三个模式 " << multi.GetStateCount() << std::endl;
+
+    struct Corpus {
+        std::string name;
+        bool mixed;
+        const GrokMatcher* matcher;
+        const std::vector<std::regex>* regexes;
+    };
+    const Corpus corpora[] = {
+        {"日志生成器格式（单一模式）", false, &single, &singleRegex},
+        {"混合格式（三个模式，10%不匹配）", true, &multi, &multiRegex},
+    };
+
+    size_t mismatches = 0;
+    for (const auto& corpus : corpora) {
+        std::vector<std::string> lines = MakeCorpus(count, corpus.mixed, rng);
+        double avgBytes = 0;
+        size_t matched = 0;
+        for (const auto& line : lines) {
+            avgBytes += static_cast<double>(line.size());
+            Outcome expected = MatchRegex(*corpus.regexes, line);
+            Outcome actual = MatchGrok(*corpus.matcher, line);
+            if (!(expected == actual) && ++mismatches <= 5) {
+                std::cerr << "结果不一致: " << line << std::endl;
+            }
+            matched += expected.pattern >= 0 ? 1 : 0;
+        }
+        avgBytes /= static_cast<double>(lines.size());
+
+        std::cout << "\n" << corpus.name << "：" << lines.size() << " 行，平均 " << std::fixed
+                  << std::setprecision(0) << avgBytes << " 字节，匹配 " << matched << " 行" << std::endl;
+        std::cout << "  " << std::left << std::setw(16) << "实现" << std::right
+                  << std::setw(12) << "纳秒/行" << std::setw(12) << "MB/秒" << std::endl;
+
+        double regexNs = Measure(lines, repeat, [&corpus](const std::string& line) {
+            return static_cast<size_t>(MatchRegex(*corpus.regexes, line).pattern + 1);
+        });
+        PrintRow("std::regex", regexNs, avgBytes);
+
+        GrokMatcher::Result result;
+        double grokNs = Measure(lines, repeat, [&corpus, &result](const std::string& line) {
+            return corpus.matcher->Match(line, result) ? result.values.size() : 0;
+        });
+        PrintRow("GrokMatcher", grokNs, avgBytes);
+        std::cout << "  加速比: " << std::setprecision(1) << regexNs / grokNs << "x" << std::endl;
+    }
+    if (mismatches > 0) {
+        std::cerr << "共 " << mismatches << " 行结果不一致" << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,174 @@
+// 日志ID生成器性能测试
+// 测试内容：
+//   1. 生成开销：随机UUID（libuuid，可选）与 IdGenerator 的128位ID，单线程和多线程
+//   2. MySQL插入吞吐（可选）：随机UUID主键与时间有序主键分别插入同样数量的行
+//
+// 用法: id_generator_benchmark [每线程生成数] [线程数] [--mysql HOST PORT USER PASSWORD DATABASE [行数]]
+
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <string>
+#include <thread>
+#include <chrono>
+#include <random>
+#include <functional>
+#include "xumj/common/id_generator.h"
+#include "xumj/storage/mysql_storage.h"
+#ifdef XUMJ_BENCH_WITH_LIBUUID
+#include <uuid/uuid.h>
+#endif
+
+using namespace xumj;
+using Clock = std::chrono::steady_clock;
+
+namespace {
+
+// 防止编译器优化掉生成结果
+volatile size_t gSink = 0;
+
+#ifdef XUMJ_BENCH_WITH_LIBUUID
+std::string LibUuid() {
+    uuid_t uuid;
+    uuid_generate(uuid);
+    char text[37];
+    uuid_unparse_lower(uuid, text);
+    return std::string(text);
+}
+#endif
+
+// 与libuuid的v4 UUID相同格式的随机ID，用于MySQL对比（不依赖libuuid）
+std::string RandomUuid(std::mt19937_64& rng) {
+    static const char hex[] = "0123456789abcdef";
+    std::string text(36, '-');
+    uint64_t bits[2] = {rng(), rng()};
+    int bit = 0;
+    for (size_t i = 0; i < text.size(); ++i) {
+        if (i == 8 || i == 13 || i == 18 || i == 23) {
+            continue;
+        }
+        text[i] = hex[(bits[bit / 64] >> (bit % 64)) & 0xF];
+        bit += 4;
+    }
+    return text;
+}
+
+// 返回每次生成的平均纳秒数
+double MeasureGeneration(const std::function<size_t()>& generate, size_t perThread, size_t threads) {
+    auto start = Clock::now();
+    std::vector<std::thread> workers;
+    for (size_t t = 0; t < threads; ++t) {
+        workers.emplace_back([&generate, perThread]() {
+            size_t local = 0;
+            for (size_t i = 0; i < perThread; ++i) {
+                local += generate();
+            }
+            gSink += local;
+        });
+    }
+    for (auto& w : workers) {
+        w.join();
+    }
+    double ns = std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+    // 多线程时按总生成数折算为吞吐意义下的单次开销
+    return ns / static_cast<double>(perThread * threads);
+}
+
+void PrintGeneration(const std::string& name, double singleNs, double multiNs) {
+    std::cout << std::left << std::setw(28) << name
+              << std::right << std::fixed << std::setprecision(1)
+              << std::setw(14) << singleNs
+              << std::setw(14) << multiNs
+              << std::setw(16) << std::setprecision(0) << (1e9 / multiNs) << std::endl;
+}
+
+// 以多行INSERT插入rows行，返回行/秒
+double MeasureInsert(storage::MySQLConnection& conn, const std::string& table,
+                     const std::function<std::string()>& nextId, size_t rows) {
+    conn.Execute("DROP TABLE IF EXISTS " + table);
+    conn.Execute("CREATE TABLE " + table + " (id VARCHAR(64) PRIMARY KEY, message VARCHAR(255)) ENGINE=InnoDB");
+
+    const size_t batch = 500;
+    auto start = Clock::now();
+    for (size_t done = 0; done < rows;) {
+        std::string sql = "INSERT INTO " + table + " (id, message) VALUES ";
+        size_t n = std::min(batch, rows - done);
+        for (size_t i = 0; i < n; ++i) {
+            if (i > 0) sql += ",";
+            sql += "('" + nextId() + "','id generator benchmark row " + std::to_string(done + i) + "')";
+        }
+        conn.Execute(sql);
+        done += n;
+    }
+    double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    conn.Execute("DROP TABLE " + table);
+    return seconds > 0 ? rows / seconds : 0;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    size_t perThread = argc > 1 ? std::stoul(argv[1]) : 1000000;
+    size_t threads = argc > 2 ? std::stoul(argv[2]) : 4;
+
+    common::IdGenerator& generator = common::IdGenerator::Instance();
+    std::cout << "每线程生成: " << perThread << "，线程数: " << threads
+              << "，节点ID: " << generator.GetNodeId() << std::endl;
+    std::cout << "\n" << std::left << std::setw(28) << "生成方式"
+              << std::right << std::setw(14) << "单线程ns/个"
+              << std::setw(14) << "多线程ns/个"
+              << std::setw(16) << "多线程个/秒" << std::endl;
+
+    struct Case {
+        std::string name;
+        std::function<size_t()> generate;
+    };
+    std::vector<Case> cases;
+#ifdef XUMJ_BENCH_WITH_LIBUUID
+    cases.push_back({"libuuid (36字符)", []() { return LibUuid().size(); }});
+#endif
+    cases.push_back({"IdGenerator 128位", [&generator]() { return static_cast<size_t>(generator.Next().lo); }});
+    cases.push_back({"IdGenerator 128位文本(26)", [&generator]() { return generator.NextString().size(); }});
+
+    for (const auto& c : cases) {
+        double single = MeasureGeneration(c.generate, perThread, 1);
+        double multi = MeasureGeneration(c.generate, perThread, threads);
+        PrintGeneration(c.name, single, multi);
+    }
+
+    // 可选：MySQL插入吞吐对比
+    for (int i = 3; i < argc; ++i) {
+        if (std::string(argv[i]) != "--mysql") {
+            continue;
+        }
+        if (i + 5 >= argc) {
+            std::cerr << "--mysql 需要 HOST PORT USER PASSWORD DATABASE" << std::endl;
+            return 1;
+        }
+        storage::MySQLConfig config;
+        config.host = argv[i + 1];
+        config.port = std::stoi(argv[i + 2]);
+        config.username = argv[i + 3];
+        config.password = argv[i + 4];
+        config.database = argv[i + 5];
+        size_t rows = i + 6 < argc ? std::stoul(argv[i + 6]) : 200000;
+
+        try {
+            storage::MySQLConnection conn(config);
+            std::mt19937_64 rng(std::random_device{}());
+            double randomRate = MeasureInsert(conn, "id_bench_random",
+                                              [&rng]() { return RandomUuid(rng); }, rows);
+            double orderedRate = MeasureInsert(conn, "id_bench_ordered",
+                                               [&generator]() { return generator.NextString(); }, rows);
+            std::cout << "\nMySQL插入 " << rows << " 行（每条INSERT 500行）:" << std::endl;
+            std::cout << std::fixed << std::setprecision(0)
+                      << "  随机UUID主键: " << randomRate << " 行/秒" << std::endl
+                      << "  有序ID主键:   " << orderedRate << " 行/秒" << std::endl;
+        } catch (const std::exception& e) {
+            std::cerr << "MySQL测试失败: " << e.what() << std::endl;
+            return 1;
+        }
+        break;
+    }
+    return 0;
+}
@@ -0,0 +1,130 @@
+// 单次解析性能测试：对比旧的"预解析写入metadata + 解析器再次解析"流程与ParsedFields单次解析流程
+// 测试内容：
+//   1. 每条消息的JSON解析次数
+//   2. 每条消息的CPU时间（线程CPU时钟）
+//   3. 经过LogProcessor::ProcessJsonString的端到端处理，读取处理器指标中的解析次数与CPU时间
+//
+// 用法: parse_once_benchmark [消息数]
+
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <string>
+#include <unordered_map>
+#include <ctime>
+#include <nlohmann/json.hpp>
+#include "xumj/processor/log_processor.h"
+
+using namespace xumj;
+
+namespace {
+
+uint64_t ThreadCpuNs() {
+    timespec ts{};
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return static_cast<uint64_t>(ts.tv_sec) * 1000000000ull + static_cast<uint64_t>(ts.tv_nsec);
+}
+
+std::vector<std::string> MakeMessages(size_t count) {
+    std::vector<std::string> messages;
+    messages.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+        nlohmann::json j = {
+            {"timestamp", "2024-01-01 12:00:00"},
+            {"level", i % 10 == 0 ? "ERROR" : "INFO"},
+            {"source", "service-" + std::to_string(i % 8)},
+            {"type", "app"},
+            {"message", "request " + std::to_string(i) + " finished in " + std::to_string(i % 300) + "ms"},
+            {"user_id", 1000 + i},
+            {"path", "/api/v1/resource/" + std::to_string(i % 50)}
+        };
+        messages.push_back(j.dump());
+    }
+    return messages;
+}
+
+// 旧流程：IO回调解析一次并把字段写入metadata字符串，解析器再解析一次
+size_t LegacyPath(const std::string& message, analyzer::LogRecord& record) {
+    std::unordered_map<std::string, std::string> metadata;
+    nlohmann::json first = nlohmann::json::parse(message);
+    for (const char* key : {"timestamp", "level", "message", "type", "source"}) {
+        if (first.contains(key) && first[key].is_string()) {
+            metadata[key] = first[key].get<std::string>();
+        }
+    }
+    metadata["is_json"] = "true";
+
+    if (metadata.count("level")) {
+        record.level = metadata.at("level");
+    }
+    nlohmann::json second = nlohmann::json::parse(message);
+    if (second.contains("timestamp") && second["timestamp"].is_string())
+        record.timestamp = second["timestamp"].get<std::string>();
+    if (second.contains("level") && second["level"].is_string())
+        record.level = second["level"].get<std::string>();
+    if (second.contains("message") && second["message"].is_string())
+        record.message = second["message"].get<std::string>();
+    if (second.contains("source") && second["source"].is_string())
+        record.source = second["source"].get<std::string>();
+    return 2;
+}
+
+// 新流程：解析一次得到ParsedFields，解析器直接使用
+size_t ParseOncePath(processor::JsonLogParser& parser, const std::string& message, analyzer::LogRecord& record) {
+    processor::LogData data;
+    data.message = message;
+    size_t parses = processor::ParseLogFields(data.message, data.fields) != processor::PayloadFormat::TEXT ? 1 : 0;
+    parser.Parse(data, record);
+    return parses;
+}
+
+void PrintRow(const std::string& name, size_t parses, uint64_t cpuNs, size_t count) {
+    std::cout << std::left << std::setw(26) << name << std::right << std::fixed
+              << std::setw(14) << std::setprecision(2) << static_cast<double>(parses) / count
+              << std::setw(16) << std::setprecision(0) << static_cast<double>(cpuNs) / count << std::endl;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    size_t count = argc > 1 ? std::stoul(argv[1]) : 200000;
+    std::vector<std::string> messages = MakeMessages(count);
+    std::cout << "消息数: " << count << "，平均长度: " << messages[0].size() << " 字节" << std::endl;
+
+    std::cout << "\n" << std::left << std::setw(26) << "流程"
+              << std::right << std::setw(14) << "解析次数/条"
+              << std::setw(16) << "CPU纳秒/条" << std::endl;
+
+    analyzer::LogRecord record;
+    size_t parses = 0;
+    uint64_t start = ThreadCpuNs();
+    for (const auto& message : messages) {
+        parses += LegacyPath(message, record);
+    }
+    PrintRow("旧流程(两次解析)", parses, ThreadCpuNs() - start, count);
+
+    processor::JsonLogParser parser;
+    parses = 0;
+    start = ThreadCpuNs();
+    for (const auto& message : messages) {
+        parses += ParseOncePath(parser, message, record);
+    }
+    PrintRow("ParsedFields(一次解析)", parses, ThreadCpuNs() - start, count);
+
+    // 端到端：经过LogProcessor的处理流程（无存储），读取处理器自身的指标
+    processor::LogProcessorConfig config;
+    config.workerThreads = 1;
+    config.enableMetrics = true;
+    processor::LogProcessor logProcessor(config);
+    logProcessor.AddLogParser(std::make_shared<processor::JsonLogParser>());
+
+    std::streambuf* coutBuf = std::cout.rdbuf(nullptr);   // ProcessJsonString每条都有输出
+    for (const auto& message : messages) {
+        logProcessor.ProcessJsonString(message);
+    }
+    std::cout.rdbuf(coutBuf);
+
+    const auto& metrics = logProcessor.GetMetrics();
+    PrintRow("LogProcessor端到端", metrics.jsonParses.load(), metrics.totalCpuTime.load(), count);
+    return 0;
+}
@@ -1,15 +1,26 @@
+// JSON解析后端性能测试：对比nlohmann::json（构建DOM）与按需字段提取器（标量/SSE2/AVX2扫描）
+// 测试内容：
+//   1. 三组语料：混合格式（含10%错误日志）、长消息（转义字符与堆栈）、宽对象（嵌套扩展字段）
+//   2. 每种后端的成功条数与提取结果必须一致，不一致时返回1
+//   3. 每条消息的耗时（纳秒）与吞吐（MB/秒）
+//
+// 用法: parser_benchmark [每组消息数] [重复次数]
+
 #include <iostream>
 #include <vector>
 #include <string>
-#include <fstream>
 #include <memory>
 #include <chrono>
 #include <random>
 #include <ctime>
 #include <iomanip>
 #include <sstream>
-#include "../../include/xumj/processor/json_log_parser.h"
-#include "../../include/xumj/common/log_entry.h"
+#include <functional>
+#include <nlohmann/json.hpp>
+#include "xumj/processor/json_field_extractor.h"
+
+using namespace xumj::processor;
+using Clock = std::chrono::steady_clock;
 
 // 生成随机UUID
 std::string GenerateUUID() {
@@ -174,7 +185,7 @@ std::vector<std::string> GenerateTestLogs(int count) {
         int errorCount = count * 0.1; // 10%的错误日志
         for (int i = 0; i < errorCount; ++i) {
             int index = i * 10; // 每10条放一个错误日志
-            if (index < logs.size()) {
+            if (static_cast<size_t>(index) < logs.size()) {
                 // 生成各种错误类型
                 switch (i % 5) {
                     case 0: // 缺少字段
@@ -202,154 +213,195 @@ std::vector<std::string> GenerateTestLogs(int count) {
     return logs;
 }
 
-// 简化版的JsonLogParser实现，用于测试
-class SimpleJsonLogParser {
-public:
-    std::shared_ptr<xumj::LogEntry> Parse(const std::string& jsonString) {
-        try {
-            // 这里假设jsonString是一个有效的JSON，并且包含所有必需字段
-            // 实际上，这是一个简化的实现，不包含错误处理
-            
-            // 解析JSON字符串
-            rapidjson::Document doc;
-            doc.Parse(jsonString.c_str());
-            
-            auto logEntry = std::make_shared<xumj::LogEntry>();
-            
-            // 假设所有字段都存在且格式正确
-            logEntry->SetId(doc["id"].GetString());
-            logEntry->SetTimestamp(doc["timestamp"].GetString());
-            logEntry->SetLevel(doc["level"].GetString());
-            logEntry->SetSource(doc["source"].GetString());
-            logEntry->SetMessage(doc["message"].GetString());
-            
-            return logEntry;
-        } catch (...) {
-            // 任何异常都返回nullptr
-            return nullptr;
+// 生成长消息日志：message中带有换行、引号、制表符和Unicode转义的堆栈信息
+std::vector<std::string> GenerateLongLogs(int count) {
+    std::vector<std::string> logs;
+    logs.reserve(count);
+    for (int i = 0; i < count; ++i) {
+        nlohmann::json j;
+        j["timestamp"] = GetCurrentTimestamp();
+        j["level"] = "ERROR";
+        j["source"] = "payment_service";
+        std::string message = "处理请求失败: \"txn-" + std::to_string(i) + "\"\n";
+        for (int frame = 0; frame < 12; ++frame) {
+            message += "\tat com.example.payment.Handler.step" + std::to_string(frame) +
+                       "(Handler.java:" + std::to_string(100 + frame * 7) + ")\n";
+        }
+        message += "Caused by: 连接超时 \\ 重试次数=3é";
+        j["message"] = message;
+        j["type"] = "exception";
+        logs.push_back(j.dump(-1, ' ', true));   // ensure_ascii，非ASCII字符全部输出为\uXXXX
+    }
+    return logs;
+}
+
+// 生成宽对象日志：大量不需要提取的扩展字段，包含嵌套对象、数组和数字
+std::vector<std::string> GenerateWideLogs(int count) {
+    std::vector<std::string> logs;
+    logs.reserve(count);
+    for (int i = 0; i < count; ++i) {
+        nlohmann::json j;
+        j["timestamp"] = GetCurrentTimestamp();
+        j["level"] = i % 10 == 0 ? "WARNING" : "INFO";
+        j["source"] = "api_gateway";
+        for (int k = 0; k < 20; ++k) {
+            j["attr_" + std::to_string(k)] = "value-" + std::to_string(i * 31 + k);
         }
+        j["http"] = {{"method", "GET"}, {"status", 200 + i % 5}, {"latency_ms", 12.5 + i % 100},
+                     {"headers", {{"user-agent", "curl/8.0"}, {"x-request-id", GenerateUUID()}}}};
+        j["tags"] = {"edge", "canary", i % 2 == 0, nullptr, -1.5e3};
+        j["message"] = "GET /api/v1/resource/" + std::to_string(i % 20) + " 200";
+        logs.push_back(j.dump());
     }
+    return logs;
+}
+
+// 需要提取的字段，与ParseLogFields一致
+const std::vector<std::string> kFields = {"timestamp", "level", "message", "source", "type"};
+
+// 一条消息的提取结果：是否合法，以及各字段的值（不存在时为空）
+struct Extracted {
+    bool ok = false;
+    std::vector<std::string> values;
 };
 
-// 增强版的JsonLogParser实现，用于测试
-class EnhancedJsonLogParser {
-public:
-    std::shared_ptr<xumj::LogEntry> Parse(const std::string& jsonString) {
-        try {
-            // 解析JSON字符串
-            rapidjson::Document doc;
-            doc.Parse(jsonString.c_str());
-            
-            if (doc.HasParseError()) {
-                std::cerr << "JSON parse error" << std::endl;
-                return nullptr;
-            }
-            
-            // 创建日志条目对象
-            auto logEntry = std::make_shared<xumj::LogEntry>();
-            
-            // 处理ID字段 - 支持多种格式或生成默认值
-            if (doc.HasMember("id") && doc["id"].IsString()) {
-                logEntry->SetId(doc["id"].GetString());
-            } else if (doc.HasMember("log_id") && doc["log_id"].IsString()) {
-                logEntry->SetId(doc["log_id"].GetString());
-            } else {
-                // 生成UUID作为默认ID
-                logEntry->SetId(GenerateUUID());
-            }
-            
-            // 处理时间戳 - 支持多种格式
-            if (doc.HasMember("timestamp") && doc["timestamp"].IsString()) {
-                logEntry->SetTimestamp(doc["timestamp"].GetString());
-            } else if (doc.HasMember("time") && doc["time"].IsString()) {
-                logEntry->SetTimestamp(doc["time"].GetString());
-            } else if (doc.HasMember("@timestamp") && doc["@timestamp"].IsString()) {
-                logEntry->SetTimestamp(doc["@timestamp"].GetString());
-            } else {
-                // 使用当前时间作为默认值
-                logEntry->SetTimestamp(GetCurrentTimestamp());
-            }
-            
-            // 处理日志级别
-            if (doc.HasMember("level") && doc["level"].IsString()) {
-                logEntry->SetLevel(doc["level"].GetString());
-            } else if (doc.HasMember("severity") && doc["severity"].IsString()) {
-                logEntry->SetLevel(doc["severity"].GetString());
-            } else {
-                logEntry->SetLevel("INFO");  // 默认级别
-            }
-            
-            // 处理来源
-            if (doc.HasMember("source") && doc["source"].IsString()) {
-                logEntry->SetSource(doc["source"].GetString());
-            } else if (doc.HasMember("service") && doc["service"].IsString()) {
-                logEntry->SetSource(doc["service"].GetString());
-            } else {
-                logEntry->SetSource("unknown");
-            }
-            
-            // 处理消息内容
-            if (doc.HasMember("message") && doc["message"].IsString()) {
-                logEntry->SetMessage(doc["message"].GetString());
-            } else if (doc.HasMember("msg") && doc["msg"].IsString()) {
-                logEntry->SetMessage(doc["msg"].GetString());
-            } else {
-                // 如果没有消息字段，将整个JSON作为消息
-                rapidjson::StringBuffer buffer;
-                rapidjson::Writer<rapidjson::StringBuffer> writer(buffer);
-                doc.Accept(writer);
-                logEntry->SetMessage(buffer.GetString());
+using ExtractFn = std::function<bool(const std::string&, Extracted*)>;
+
+// nlohmann后端：构建完整DOM后取字符串字段
+bool ExtractNlohmann(const std::string& log, Extracted* out) {
+    auto j = nlohmann::json::parse(log, nullptr, false);
+    if (!j.is_object()) {
+        return false;
+    }
+    if (out) {
+        out->values.assign(kFields.size(), std::string());
+        for (size_t i = 0; i < kFields.size(); ++i) {
+            auto it = j.find(kFields[i]);
+            if (it != j.end() && it->is_string()) {
+                out->values[i] = it->get<std::string>();
             }
-            
-            return logEntry;
-        } catch (const std::exception& e) {
-            std::cerr << "Exception in JSON parsing: " << e.what() << std::endl;
-            return nullptr;
         }
     }
+    return true;
+}
+
+// 按需提取后端：与ParseLogFields一样把视图复制为字符串
+bool ExtractOnDemand(const JsonFieldExtractor& extractor, JsonFieldExtractor::Result& result,
+                     const std::string& log, Extracted* out) {
+    if (!extractor.Extract(log, result)) {
+        return false;
+    }
+    std::string copies[5];
+    for (size_t i = 0; i < kFields.size(); ++i) {
+        if (result.Has(i)) {
+            copies[i].assign(result.values[i]);
+        }
+    }
+    if (out) {
+        out->values.assign(std::make_move_iterator(copies), std::make_move_iterator(copies + 5));
+    }
+    return true;
+}
+
+struct Backend {
+    std::string name;
+    ScanKernel kernel;     // 仅对按需提取有效
+    ExtractFn extract;
 };
 
-// 测量解析器成功率
-template <typename ParserType>
-void MeasureParserSuccessRate(const std::vector<std::string>& testLogs, const std::string& parserName) {
-    int totalLogs = testLogs.size();
-    int successfulParses = 0;
-    
-    // 创建解析器实例
-    ParserType parser;
-    
-    // 记录解析结果
-    for (const auto& log : testLogs) {
-        try {
-            auto result = parser.Parse(log);
-            if (result != nullptr) {
-                successfulParses++;
+// 计算每个后端在一组语料上的提取结果，检查与第一个后端一致
+bool VerifyAgreement(const std::vector<Backend>& backends, const std::vector<std::string>& logs) {
+    std::vector<Extracted> reference;
+    for (size_t b = 0; b < backends.size(); ++b) {
+        JsonFieldExtractor::SetScanKernel(backends[b].kernel);
+        for (size_t i = 0; i < logs.size(); ++i) {
+            Extracted e;
+            e.ok = backends[b].extract(logs[i], &e);
+            if (b == 0) {
+                reference.push_back(std::move(e));
+            } else if (e.ok != reference[i].ok || (e.ok && e.values != reference[i].values)) {
+                std::cerr << "结果不一致: " << backends[b].name << " 第" << i << "条: "
+                          << logs[i].substr(0, 80) << std::endl;
+                return false;
             }
-        } catch (...) {
-            // 解析失败，不增加成功计数
         }
     }
-    
-    // 计算成功率
-    double successRate = (double)successfulParses / totalLogs * 100.0;
-    std::cout << parserName << " 解析成功率: " << successRate << "% (" 
-              << successfulParses << "/" << totalLogs << ")" << std::endl;
+    return true;
+}
+
+void RunCorpus(const std::string& corpusName, const std::vector<std::string>& logs,
+               const std::vector<Backend>& backends, int repeats) {
+    size_t bytes = 0;
+    for (const auto& log : logs) {
+        bytes += log.size();
+    }
+    std::cout << "\n语料: " << corpusName << "，" << logs.size() << " 条，平均长度 "
+              << bytes / logs.size() << " 字节" << std::endl;
+    std::cout << std::left << std::setw(22) << "后端"
+              << std::right << std::setw(12) << "成功条数"
+              << std::setw(14) << "纳秒/条"
+              << std::setw(14) << "MB/秒" << std::endl;
+
+    for (const auto& backend : backends) {
+        JsonFieldExtractor::SetScanKernel(backend.kernel);
+        size_t success = 0;
+        auto start = Clock::now();
+        for (int r = 0; r < repeats; ++r) {
+            success = 0;
+            for (const auto& log : logs) {
+                success += backend.extract(log, nullptr) ? 1 : 0;
+            }
+        }
+        double ns = std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+        double perMessage = ns / (static_cast<double>(logs.size()) * repeats);
+        double mbPerSecond = static_cast<double>(bytes) * repeats / (ns / 1e9) / (1024.0 * 1024.0);
+        std::cout << std::left << std::setw(22) << backend.name << std::right << std::fixed
+                  << std::setw(12) << success
+                  << std::setw(14) << std::setprecision(1) << perMessage
+                  << std::setw(14) << std::setprecision(1) << mbPerSecond << std::endl;
+    }
 }
 
-int main() {
-    // 生成1000条测试日志
+int main(int argc, char* argv[]) {
+    int count = argc > 1 ? std::stoi(argv[1]) : 20000;
+    int repeats = argc > 2 ? std::stoi(argv[2]) : 5;
+
+    JsonFieldExtractor extractor(kFields);
+    JsonFieldExtractor::Result result;
+    auto onDemand = [&extractor, &result](const std::string& log, Extracted* out) {
+        return ExtractOnDemand(extractor, result, log, out);
+    };
+
+    std::vector<Backend> backends;
+    backends.push_back({"nlohmann (DOM)", ScanKernel::AUTO, ExtractNlohmann});
+    backends.push_back({"按需提取 scalar", ScanKernel::SCALAR, onDemand});
+#if defined(__x86_64__) || defined(__i386__)
+    backends.push_back({"按需提取 sse2", ScanKernel::SSE2, onDemand});
+    if (__builtin_cpu_supports("avx2")) {
+        backends.push_back({"按需提取 avx2", ScanKernel::AVX2, onDemand});
+    }
+#endif
+
     std::cout << "生成测试日志样本..." << std::endl;
-    std::vector<std::string> testLogs = GenerateTestLogs(1000);
-    
-    std::cout << "测试日志样本生成完成，共 " << testLogs.size() << " 条" << std::endl;
-    
-    // 测试简化版解析器
-    std::cout << "\n测试简化版解析器（无健壮性处理）..." << std::endl;
-    MeasureParserSuccessRate<SimpleJsonLogParser>(testLogs, "简化版解析器");
-    
-    // 测试增强版解析器
-    std::cout << "\n测试增强版解析器（有健壮性处理）..." << std::endl;
-    MeasureParserSuccessRate<EnhancedJsonLogParser>(testLogs, "增强版解析器");
-    
-    return 0;
-} 
\ No newline at end of file
+    std::vector<std::pair<std::string, std::vector<std::string>>> corpora;
+    corpora.emplace_back("混合格式(含10%错误)", GenerateTestLogs(count));
+    corpora.emplace_back("长消息(转义/堆栈)", GenerateLongLogs(count));
+    corpora.emplace_back("宽对象(嵌套扩展字段)", GenerateWideLogs(count));
+
+    bool agreed = true;
+    for (const auto& corpus : corpora) {
+        if (!VerifyAgreement(backends, corpus.second)) {
+            agreed = false;
+        }
+    }
+    std::cout << "各后端提取结果" << (agreed ? "一致" : "不一致") << std::endl;
+
+    for (const auto& corpus : corpora) {
+        RunCorpus(corpus.first, corpus.second, backends, repeats);
+    }
+
+    JsonFieldExtractor::SetScanKernel(ScanKernel::AUTO);
+    std::cout << "\n默认扫描实现: " << JsonFieldExtractor::ScanKernelName(JsonFieldExtractor::GetScanKernel())
+              << std::endl;
+    return agreed ? 0 : 1;
+}
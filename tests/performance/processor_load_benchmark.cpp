@@ -0,0 +1,415 @@
+// 处理器网络负载测试：多个TcpClient按批次协议向处理器发送日志，统计吞吐与端到端延迟
+// 测试内容：
+//   1. 吞吐：处理器确认（已存储）的日志条数/秒
+//   2. 延迟：批次发送到收到覆盖该批次的累计确认之间的时间，使用直方图统计分位数
+//   3. 回归检查：与基线文件比较，吞吐低于或p99高于容差范围时返回非0
+//
+// 默认在进程内启动一个LogProcessor（不连接Redis/MySQL，存储替换为内存计数），
+// 也可以通过 --external 指向本机已运行的 processor_server。
+//
+// 用法: processor_load_benchmark [选项]
+//   --connections N       连接数（默认4）
+//   --batch-size N        每批日志条数（默认100）
+//   --rate N              每个连接每秒发送的批次数，0表示不限速（默认0）
+//   --window N            每个连接允许未确认的批次数（默认32）
+//   --duration N          发送时长，秒（默认10）
+//   --port N              进程内处理器的监听端口（默认19201）
+//   --external HOST:PORT  连接外部处理器而不是启动进程内处理器
+//   --baseline FILE       与基线比较，退化时返回1
+//   --write-baseline FILE 将本次结果写为新基线
+//   --tolerance X         基线容差（默认0.2，即20%）
+
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <sstream>
+#include <vector>
+#include <map>
+#include <string>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <condition_variable>
+#include <memory>
+#include <cstdlib>
+#include <nlohmann/json.hpp>
+#include "xumj/common/latency_histogram.h"
+#include "xumj/network/tcp_client.h"
+#include "xumj/processor/log_processor.h"
+
+using namespace xumj;
+using Clock = std::chrono::steady_clock;
+
+namespace {
+
+struct BenchmarkOptions {
+    size_t connections{4};
+    size_t batchSize{100};
+    double rate{0};
+    size_t window{32};
+    int duration{10};
+    uint16_t port{19201};
+    std::string externalHost;
+    std::string baselineFile;
+    std::string writeBaselineFile;
+    double tolerance{0.2};
+};
+
+struct BenchmarkResult {
+    uint64_t sentBatches{0};
+    uint64_t ackedBatches{0};
+    uint64_t ackedMessages{0};
+    double elapsedSeconds{0};
+    double messagesPerSecond{0};
+    uint64_t storedRecords{0};
+};
+
+// 一个压测连接：发送线程按窗口和速率发批次，IO线程收到确认后记录延迟
+class LoadConnection {
+public:
+    LoadConnection(size_t index, const std::string& host, uint16_t port,
+                   const BenchmarkOptions& options, common::LatencyHistogram& histogram)
+        : options_(options),
+          histogram_(histogram),
+          stream_("loadgen-" + std::to_string(index) + "-" +
+                  std::to_string(Clock::now().time_since_epoch().count())),
+          client_("LoadGen-" + std::to_string(index), host, port, false) {
+        // 预先构造日志数组，发送时只拼接批次信封
+        nlohmann::json logs = nlohmann::json::array();
+        for (size_t i = 0; i < options_.batchSize; ++i) {
+            logs.push_back({
+                {"timestamp", "2024-01-01 12:00:00"},
+                {"level", i % 10 == 0 ? "ERROR" : "INFO"},
+                {"source", "loadgen"},
+                {"message", "load test message " + std::to_string(i) + " from connection " + std::to_string(index)}
+            });
+        }
+        logsJson_ = logs.dump();
+
+        client_.SetConnectionCallback([this](bool connected) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            connected_ = connected;
+            cv_.notify_all();
+        });
+        client_.SetMessageCallback([this](const std::string& message, muduo::Timestamp) {
+            OnAck(message);
+        });
+    }
+
+    bool Connect(std::chrono::seconds timeout) {
+        client_.Connect();
+        std::unique_lock<std::mutex> lock(mutex_);
+        return cv_.wait_for(lock, timeout, [this]() { return connected_; });
+    }
+
+    void Disconnect() { client_.Disconnect(); }
+
+    // 发送直到deadline，然后等待未确认批次（最多drainTimeout）
+    void Run(Clock::time_point start, Clock::time_point deadline, std::chrono::seconds drainTimeout) {
+        uint64_t seq = 0;
+        while (Clock::now() < deadline) {
+            if (options_.rate > 0) {
+                auto due = start + std::chrono::duration_cast<Clock::duration>(
+                    std::chrono::duration<double>(seq / options_.rate));
+                if (due > deadline) {
+                    break;
+                }
+                std::this_thread::sleep_until(due);
+            }
+
+            std::unique_lock<std::mutex> lock(mutex_);
+            if (!cv_.wait_until(lock, deadline, [this]() {
+                    return !connected_ || pending_.size() < options_.window;
+                })) {
+                break;
+            }
+            if (!connected_) {
+                break;
+            }
+            ++seq;
+            pending_[seq] = Clock::now();
+            lock.unlock();
+
+            std::string envelope;
+            envelope.reserve(logsJson_.size() + stream_.size() + 64);
+            envelope += "{\"logs\":";
+            envelope += logsJson_;
+            envelope += ",\"seq\":";
+            envelope += std::to_string(seq);
+            envelope += ",\"stream\":\"";
+            envelope += stream_;
+            envelope += "\",\"type\":\"batch\"}";
+            if (!client_.Send(envelope)) {
+                break;
+            }
+            sentBatches_.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        std::unique_lock<std::mutex> lock(mutex_);
+        cv_.wait_for(lock, drainTimeout, [this]() { return !connected_ || pending_.empty(); });
+    }
+
+    uint64_t GetSentBatches() const { return sentBatches_.load(std::memory_order_relaxed); }
+    uint64_t GetAckedBatches() const { return ackedBatches_.load(std::memory_order_relaxed); }
+    Clock::time_point GetLastAckTime() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return lastAck_;
+    }
+
+private:
+    void OnAck(const std::string& message) {
+        // 确认格式：{"seq":M,"stream":"...","type":"ack"}，只取seq，避免在IO线程完整解析
+        size_t pos = message.find("\"seq\":");
+        if (pos == std::string::npos || message.find("\"type\":\"ack\"") == std::string::npos) {
+            return;
+        }
+        uint64_t acked = std::strtoull(message.c_str() + pos + 6, nullptr, 10);
+
+        auto now = Clock::now();
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto end = pending_.upper_bound(acked);
+        for (auto it = pending_.begin(); it != end; ++it) {
+            histogram_.Record(static_cast<uint64_t>(
+                std::chrono::duration_cast<std::chrono::microseconds>(now - it->second).count()));
+            ackedBatches_.fetch_add(1, std::memory_order_relaxed);
+        }
+        if (pending_.begin() != end) {
+            pending_.erase(pending_.begin(), end);
+            lastAck_ = now;
+            cv_.notify_all();
+        }
+    }
+
+    const BenchmarkOptions& options_;
+    common::LatencyHistogram& histogram_;
+    std::string stream_;
+    std::string logsJson_;
+
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    bool connected_{false};
+    std::map<uint64_t, Clock::time_point> pending_;   // 未确认批次的发送时间
+    Clock::time_point lastAck_{};
+
+    std::atomic<uint64_t> sentBatches_{0};
+    std::atomic<uint64_t> ackedBatches_{0};
+
+    // 最后声明，析构时先停止客户端，回调不会访问已析构的成员
+    network::TcpClient client_;
+};
+
+bool ParseOptions(int argc, char* argv[], BenchmarkOptions& options) {
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        auto next = [&]() -> std::string {
+            if (i + 1 >= argc) {
+                throw std::invalid_argument("缺少参数值: " + arg);
+            }
+            return argv[++i];
+        };
+        if (arg == "--connections") options.connections = std::stoul(next());
+        else if (arg == "--batch-size") options.batchSize = std::stoul(next());
+        else if (arg == "--rate") options.rate = std::stod(next());
+        else if (arg == "--window") options.window = std::stoul(next());
+        else if (arg == "--duration") options.duration = std::stoi(next());
+        else if (arg == "--port") options.port = static_cast<uint16_t>(std::stoul(next()));
+        else if (arg == "--external") options.externalHost = next();
+        else if (arg == "--baseline") options.baselineFile = next();
+        else if (arg == "--write-baseline") options.writeBaselineFile = next();
+        else if (arg == "--tolerance") options.tolerance = std::stod(next());
+        else {
+            std::cerr << "未知参数: " << arg << std::endl;
+            return false;
+        }
+    }
+    return options.connections > 0 && options.batchSize > 0 && options.window > 0 && options.duration > 0;
+}
+
+nlohmann::json ToJson(const BenchmarkOptions& options, const BenchmarkResult& result,
+                      const common::LatencyHistogram& histogram) {
+    return {
+        {"connections", options.connections},
+        {"batch_size", options.batchSize},
+        {"rate", options.rate},
+        {"window", options.window},
+        {"messages_per_sec", result.messagesPerSecond},
+        {"p50_us", histogram.Percentile(50)},
+        {"p90_us", histogram.Percentile(90)},
+        {"p99_us", histogram.Percentile(99)},
+        {"p999_us", histogram.Percentile(99.9)},
+        {"max_us", histogram.Max()}
+    };
+}
+
+// 与基线比较：吞吐不得低于基线的(1-容差)，p99不得高于基线的(1+容差)
+bool CheckBaseline(const std::string& file, double tolerance, const nlohmann::json& current) {
+    std::ifstream in(file);
+    if (!in) {
+        std::cerr << "无法打开基线文件: " << file << std::endl;
+        return false;
+    }
+    nlohmann::json baseline = nlohmann::json::parse(in, nullptr, false);
+    if (baseline.is_discarded()) {
+        std::cerr << "基线文件格式错误: " << file << std::endl;
+        return false;
+    }
+
+    for (const char* key : {"connections", "batch_size", "rate", "window"}) {
+        if (baseline.contains(key) && baseline[key] != current[key]) {
+            std::cout << "警告: 基线参数 " << key << "=" << baseline[key].dump()
+                      << " 与本次 " << current[key].dump() << " 不一致，比较结果仅供参考" << std::endl;
+        }
+    }
+
+    bool ok = true;
+    double baseThroughput = baseline.value("messages_per_sec", 0.0);
+    double throughput = current["messages_per_sec"].get<double>();
+    if (baseThroughput > 0 && throughput < baseThroughput * (1.0 - tolerance)) {
+        std::cout << "退化: 吞吐 " << throughput << " 条/秒 低于基线 " << baseThroughput << std::endl;
+        ok = false;
+    }
+    double baseP99 = baseline.value("p99_us", 0.0);
+    double p99 = current["p99_us"].get<double>();
+    if (baseP99 > 0 && p99 > baseP99 * (1.0 + tolerance)) {
+        std::cout << "退化: p99延迟 " << p99 << "us 高于基线 " << baseP99 << "us" << std::endl;
+        ok = false;
+    }
+    std::cout << (ok ? "基线检查通过" : "基线检查失败") << " (容差 " << tolerance * 100 << "%)" << std::endl;
+    return ok;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    BenchmarkOptions options;
+    try {
+        if (!ParseOptions(argc, argv, options)) {
+            std::cerr << "参数错误，用法见源文件头部注释" << std::endl;
+            return 2;
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "参数错误: " << e.what() << std::endl;
+        return 2;
+    }
+
+    std::string host = "127.0.0.1";
+    uint16_t port = options.port;
+    if (!options.externalHost.empty()) {
+        size_t colon = options.externalHost.rfind(':');
+        if (colon == std::string::npos) {
+            std::cerr << "--external 格式应为 HOST:PORT" << std::endl;
+            return 2;
+        }
+        host = options.externalHost.substr(0, colon);
+        port = static_cast<uint16_t>(std::stoul(options.externalHost.substr(colon + 1)));
+    }
+
+    std::cout << "连接数: " << options.connections << "，批大小: " << options.batchSize
+              << "，速率: " << (options.rate > 0 ? std::to_string(options.rate) + " 批/秒/连接" : "不限")
+              << "，窗口: " << options.window << "，时长: " << options.duration << "秒"
+              << "，目标: " << (options.externalHost.empty() ? "进程内处理器" : options.externalHost) << std::endl;
+
+    // 网络库和处理器在每条消息上都有调试输出，压测期间关闭标准输出
+    std::streambuf* coutBuf = std::cout.rdbuf(nullptr);
+
+    // 进程内处理器：不启用Redis/MySQL，存储替换为内存计数
+    std::atomic<uint64_t> storedRecords{0};
+    std::unique_ptr<processor::LogProcessor> processor;
+    if (options.externalHost.empty()) {
+        processor::LogProcessorConfig config;
+        config.tcpPort = port;
+        config.workerThreads = 4;
+        config.queueSize = 1000000;
+        config.debug = false;
+        config.enableMetrics = false;
+        processor = std::make_unique<processor::LogProcessor>(config);
+        auto parser = std::make_shared<processor::JsonLogParser>();
+        parser->SetConfig(config);
+        processor->AddLogParser(parser);
+        processor->SetRecordSink([&storedRecords](const analyzer::LogRecord&) {
+            storedRecords.fetch_add(1, std::memory_order_relaxed);
+            return true;
+        });
+        if (!processor->Start()) {
+            std::cout.rdbuf(coutBuf);
+            std::cerr << "进程内处理器启动失败" << std::endl;
+            return 1;
+        }
+    }
+
+    common::LatencyHistogram histogram;
+    std::vector<std::unique_ptr<LoadConnection>> connections;
+    for (size_t i = 0; i < options.connections; ++i) {
+        connections.push_back(std::make_unique<LoadConnection>(i, host, port, options, histogram));
+        if (!connections.back()->Connect(std::chrono::seconds(5))) {
+            std::cout.rdbuf(coutBuf);
+            std::cerr << "连接 " << host << ":" << port << " 失败" << std::endl;
+            return 1;
+        }
+    }
+
+    auto start = Clock::now();
+    auto deadline = start + std::chrono::seconds(options.duration);
+    std::vector<std::thread> senders;
+    for (auto& conn : connections) {
+        senders.emplace_back([&conn, start, deadline]() {
+            conn->Run(start, deadline, std::chrono::seconds(10));
+        });
+    }
+    for (auto& t : senders) {
+        t.join();
+    }
+
+    BenchmarkResult result;
+    Clock::time_point lastAck = start;
+    for (auto& conn : connections) {
+        result.sentBatches += conn->GetSentBatches();
+        result.ackedBatches += conn->GetAckedBatches();
+        lastAck = std::max(lastAck, conn->GetLastAckTime());
+    }
+    result.ackedMessages = result.ackedBatches * options.batchSize;
+    result.elapsedSeconds = std::chrono::duration<double>(lastAck - start).count();
+    result.messagesPerSecond = result.elapsedSeconds > 0 ? result.ackedMessages / result.elapsedSeconds : 0;
+    result.storedRecords = storedRecords.load();
+
+    for (auto& conn : connections) {
+        conn->Disconnect();
+    }
+    if (processor) {
+        processor->Stop();
+    }
+    std::cout.rdbuf(coutBuf);
+
+    std::cout << "\n发送批次: " << result.sentBatches << "，确认批次: " << result.ackedBatches
+              << "，确认日志: " << result.ackedMessages;
+    if (options.externalHost.empty()) {
+        std::cout << "，内存存储: " << result.storedRecords;
+    }
+    std::cout << std::endl;
+    std::cout << std::fixed << std::setprecision(0)
+              << "吞吐: " << result.messagesPerSecond << " 条/秒（" << std::setprecision(2)
+              << result.elapsedSeconds << "秒）" << std::endl;
+    std::cout << "延迟(us): p50=" << histogram.Percentile(50)
+              << " p90=" << histogram.Percentile(90)
+              << " p99=" << histogram.Percentile(99)
+              << " p99.9=" << histogram.Percentile(99.9)
+              << " max=" << histogram.Max()
+              << " mean=" << std::setprecision(1) << histogram.Mean() << std::endl;
+
+    if (result.ackedBatches == 0) {
+        std::cerr << "没有收到任何确认" << std::endl;
+        return 1;
+    }
+
+    nlohmann::json current = ToJson(options, result, histogram);
+    if (!options.writeBaselineFile.empty()) {
+        std::ofstream out(options.writeBaselineFile);
+        out << current.dump(4) << std::endl;
+        std::cout << "基线已写入: " << options.writeBaselineFile << std::endl;
+    }
+    if (!options.baselineFile.empty() && !CheckBaseline(options.baselineFile, options.tolerance, current)) {
+        return 1;
+    }
+    return 0;
+}
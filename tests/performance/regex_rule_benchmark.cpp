@@ -0,0 +1,228 @@
+// 正则分析规则性能测试：对比RegexRuleSet（所有规则合并为DFA一遍扫描）与逐条规则调用std::regex_search
+// 测试内容：
+//   1. 10、50、100条规则，规则由10类常见告警模板和10个组件组合而成
+//   2. 语料约20%的行命中某条规则，其余为普通业务日志
+//   3. 两种实现匹配到的规则和提取的字段必须一致，不一致时返回1
+//   4. 每行的耗时（纳秒）、加速比和规则集编译耗时
+//
+// 用法: regex_rule_benchmark [行数] [重复次数]
+
+#include <iostream>
+#include <iomanip>
+#include <cstdio>
+#include <vector>
+#include <string>
+#include <regex>
+#include <chrono>
+#include <random>
+#include <functional>
+#include "xumj/analyzer/regex_rule_set.h"
+
+using namespace xumj::analyzer;
+using Clock = std::chrono::steady_clock;
+
+namespace {
+
+// 规则模板，%s替换为组件名；captures表示规则是否配置了字段名（需要提取匹配组）
+struct RuleTemplate {
+    const char* pattern;
+    bool captures;
+};
+
+const RuleTemplate kTemplates[] = {
+    {"%s: connection (refused|reset|timed out) to ([0-9.]+):(\\d+)", true},
+    {"%s request took (\\d{4,})ms", true},
+    {"\\[%s\\] (ERROR|FATAL) .*[Ee]xception", false},
+    {"%s: user=(\\w+) failed login from ([0-9.]+)", true},
+    {"%s queue depth (\\d+) exceeds limit", false},
+    {"^%s-\\d+ OOM killer invoked", false},
+    {"%s: disk /dev/sd[a-z]\\d? (\\d+)% full", true},
+    {"%s retry (\\d+)/(\\d+) for job [a-f0-9]{8}", true},
+    {"%s: (SELECT|UPDATE|DELETE) .* slow query (\\d+\\.\\d+)s", true},
+    {"%s certificate expires in (\\d) days?", false},
+};
+
+const char* kComponents[] = {
+    "db", "cache", "auth", "order", "payment", "gateway", "search", "billing", "inventory", "notify",
+    // 以下组件不出现在规则中，命中模板但不命中规则
+    "report", "audit",
+};
+
+struct Rule {
+    std::string pattern;
+    bool captures;
+};
+
+std::string Format(const char* pattern, const std::string& component) {
+    std::string text(pattern);
+    size_t pos = text.find("%s");
+    return text.replace(pos, 2, component);
+}
+
+// 第i条规则：先遍历模板再遍历组件，规则数较少时也覆盖所有模板
+std::vector<Rule> MakeRules(size_t count) {
+    std::vector<Rule> rules;
+    for (size_t i = 0; i < count; ++i) {
+        const RuleTemplate& tpl = kTemplates[i % 10];
+        rules.push_back({Format(tpl.pattern, kComponents[i / 10 % 10]), tpl.captures});
+    }
+    return rules;
+}
+
+std::string AlertLine(std::mt19937& rng) {
+    auto next = [&rng](unsigned mod) { return std::to_string(rng() % mod); };
+    std::string c = kComponents[rng() % 12];
+    switch (rng() % 10) {
+        case 0: return c + ": connection refused to 10.0." + next(256) + "." + next(256) + ":" + next(65536);
+        case 1: return "GET /api/items " + c + " request took " + next(20000) + "ms";
+        case 2: return "[" + c + "] ERROR java.lang.IllegalStateException: bad state at line " + next(900);
+        case 3: return c + ": user=user" + next(100) + " failed login from 192.168.1." + next(256);
+        case 4: return c + " queue depth " + next(100000) + " exceeds limit 50000";
+        case 5: return c + "-" + next(10) + " OOM killer invoked, killed pid " + next(65536);
+        case 6: return c + ": disk /dev/sdb1 " + next(100) + "% full";
+        case 7: return c + " retry " + next(5) + "/5 for job 3fa85f64";
+        case 8: return c + ": UPDATE orders SET status=2 WHERE id=" + next(100000) + " slow query " + next(10) + ".5s";
+        default: return c + " certificate expires in " + next(10) + " days";
+    }
+}
+
+std::string BusinessLine(std::mt19937& rng) {
+    static const char* modules[] = {"user", "order", "payment", "system"};
+    static const char* actions[] = {"登录", "下单", "支付", "退款", "查询"};
+    char time[32];
+    auto next = [&rng](unsigned mod) { return static_cast<unsigned>(rng() % mod); };
+    std::snprintf(time, sizeof(time), "2024-%02u-%02u %02u:%02u:%02u",
+                  1 + next(12), 1 + next(28), next(24), next(60), next(60));
+    return std::string(time) + " [info] " + modules[rng() % 4] + ": 用户:张三" + std::to_string(rng() % 1000) +
+           " IP:10.0." + std::to_string(rng() % 256) + "." + std::to_string(rng() % 256) + " 操作:" +
+           actions[rng() % 5] + " 内容:request finished in " + std::to_string(rng() % 900) + "ms, retry 0";
+}
+
+// 一行的分析结果：命中的规则及其匹配组
+struct Outcome {
+    std::vector<size_t> rules;
+    std::vector<std::string> values;
+    bool operator==(const Outcome& other) const {
+        return rules == other.rules && values == other.values;
+    }
+};
+
+void Extract(const std::smatch& match, Outcome& outcome) {
+    for (size_t g = 1; g < match.size(); ++g) {
+        outcome.values.push_back(match[g].str());
+    }
+}
+
+// 旧流程：每条规则对消息调用一次std::regex_search
+Outcome MatchEach(const std::vector<Rule>& rules, const std::vector<std::regex>& regexes, const std::string& line) {
+    Outcome outcome;
+    std::smatch match;
+    for (size_t r = 0; r < regexes.size(); ++r) {
+        if (std::regex_search(line, match, regexes[r])) {
+            outcome.rules.push_back(r);
+            if (rules[r].captures) {
+                Extract(match, outcome);
+            }
+        }
+    }
+    return outcome;
+}
+
+// 新流程：一遍扫描得到命中的规则，只对命中且需要字段的规则再用std::regex提取匹配组
+Outcome MatchSet(const RegexRuleSet& set, const std::vector<Rule>& rules, const std::vector<std::regex>& regexes,
+                 const std::string& line, std::vector<uint8_t>& matched) {
+    Outcome outcome;
+    if (set.Match(line, matched) == 0) {
+        return outcome;
+    }
+    std::smatch match;
+    for (size_t r = 0; r < matched.size(); ++r) {
+        if (!matched[r]) {
+            continue;
+        }
+        outcome.rules.push_back(r);
+        if (rules[r].captures && std::regex_search(line, match, regexes[r])) {
+            Extract(match, outcome);
+        }
+    }
+    return outcome;
+}
+
+// 返回每行的平均纳秒数
+double Measure(const std::vector<std::string>& lines, size_t repeat, const std::function<size_t(const std::string&)>& match) {
+    volatile size_t sink = 0;
+    auto start = Clock::now();
+    for (size_t r = 0; r < repeat; ++r) {
+        for (const auto& line : lines) {
+            sink = sink + match(line);
+        }
+    }
+    double ns = std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+    return ns / static_cast<double>(lines.size() * repeat);
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    size_t count = argc > 1 ? std::stoul(argv[1]) : 20000;
+    size_t repeat = argc > 2 ? std::stoul(argv[2]) : 3;
+    std::mt19937 rng(42);
+
+    std::vector<std::string> lines;
+    double avgBytes = 0;
+    for (size_t i = 0; i < count; ++i) {
+        lines.push_back(i % 5 == 0 ? AlertLine(rng) : BusinessLine(rng));
+        avgBytes += static_cast<double>(lines.back().size());
+    }
+    avgBytes /= static_cast<double>(lines.size());
+    std::cout << "语料: " << lines.size() << " 行，平均 " << std::fixed << std::setprecision(0) << avgBytes
+              << " 字节" << std::endl;
+    std::cout << std::left << std::setw(8) << "规则数" << std::right << std::setw(14) << "std::regex"
+              << std::setw(14) << "RegexRuleSet" << std::setw(10) << "加速比" << std::setw(10) << "DFA组"
+              << std::setw(10) << "状态数" << std::setw(14) << "编译毫秒" << std::setw(10) << "命中行" << std::endl;
+
+    size_t mismatches = 0;
+    for (size_t ruleCount : {10, 50, 100}) {
+        std::vector<Rule> rules = MakeRules(ruleCount);
+        std::vector<std::regex> regexes;
+        auto compileStart = Clock::now();
+        RegexRuleSet set;
+        for (const auto& rule : rules) {
+            regexes.emplace_back(rule.pattern);
+            set.Add(rule.pattern);
+        }
+        set.Compile();
+        double compileMs = std::chrono::duration<double, std::milli>(Clock::now() - compileStart).count();
+
+        std::vector<uint8_t> matched;
+        size_t hitLines = 0;
+        for (const auto& line : lines) {
+            Outcome expected = MatchEach(rules, regexes, line);
+            Outcome actual = MatchSet(set, rules, regexes, line, matched);
+            if (!(expected == actual) && ++mismatches <= 5) {
+                std::cerr << "结果不一致（" << ruleCount << "条规则）: " << line << std::endl;
+            }
+            hitLines += expected.rules.empty() ? 0 : 1;
+        }
+
+        double eachNs = Measure(lines, repeat, [&](const std::string& line) {
+            return MatchEach(rules, regexes, line).rules.size();
+        });
+        double setNs = Measure(lines, repeat, [&](const std::string& line) {
+            return MatchSet(set, rules, regexes, line, matched).rules.size();
+        });
+        std::cout << std::left << std::setw(8) << ruleCount << std::right << std::fixed
+                  << std::setw(14) << std::setprecision(0) << eachNs
+                  << std::setw(14) << setNs
+                  << std::setw(9) << std::setprecision(1) << eachNs / setNs << "x"
+                  << std::setw(10) << set.GetGroupCount()
+                  << std::setw(10) << set.GetStateCount()
+                  << std::setw(14) << compileMs
+                  << std::setw(10) << hitLines << std::endl;
+    }
+    if (mismatches > 0) {
+        std::cerr << "共 " << mismatches << " 行结果不一致" << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -8,7 +8,8 @@ mkdir -p build/tests
 
 # 编译测试程序
 echo "编译解析器基准测试程序..."
-g++ -std=c++17 tests/performance/parser_benchmark.cpp -I. -o build/tests/parser_benchmark
+g++ -std=c++17 -O2 tests/performance/parser_benchmark.cpp src/processor/json_field_extractor.cpp \
+    -Iinclude -o build/tests/parser_benchmark
 
 # 检查编译是否成功
 if [ $? -ne 0 ]; then
@@ -1,4 +1,8 @@
 #include <gtest/gtest.h>
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <thread>
 #include <string>
 #include <memory>
 #include <vector>
@@ -87,6 +91,53 @@ TEST(AnalyzerRuleTest, KeywordAnalysisRule) {
     EXPECT_TRUE(results2.size() > 0);
 }
 
+// 测试多关键字匹配与逐个转小写后查找的结果一致
+TEST(AnalyzerRuleTest, KeywordMatcherMatchesFind) {
+    // 少量首字母时走SIMD跳过，多种首字母时逐字节扫描
+    std::vector<std::vector<std::string>> keywordSets = {
+        {"he", "She", "HERS", "his", "she"},
+        {"CPU", "memory", "disk", "timeout", "Error", "exception", "", "a", "ab", "bc", "x%y", "cpu"},
+    };
+    std::vector<std::string> messages = {
+        "ushers", "USHERS and HIS", "", "nothing", "Disk I/O TIMEOUT, cpu at 99%",
+        "a long line with many words but only at the very end: sHe",
+        "NullPointerException while reading MEMORY x%y abc",
+        "\xe4\xb8\xad 错误 error 内存",
+    };
+    for (const auto& keywords : keywordSets) {
+        KeywordMatcher matcher;
+        std::vector<int> ids;
+        for (const auto& keyword : keywords) {
+            ids.push_back(matcher.Add(keyword));
+        }
+        matcher.Compile();
+        EXPECT_LT(matcher.GetKeywordCount(), keywords.size());
+        
+        std::vector<uint8_t> found;
+        for (const auto& message : messages) {
+            size_t count = matcher.Match(message, found);
+            std::string lowerMessage = AsciiLower(message);
+            std::vector<uint8_t> expected(matcher.GetKeywordCount(), 0);
+            for (size_t i = 0; i < keywords.size(); ++i) {
+                bool present = lowerMessage.find(AsciiLower(keywords[i])) != std::string::npos;
+                EXPECT_EQ(found[ids[i]] != 0, present) << keywords[i] << " / " << message;
+                expected[ids[i]] = present ? 1 : 0;
+            }
+            EXPECT_EQ(count, static_cast<size_t>(std::count(expected.begin(), expected.end(), 1)));
+        }
+    }
+    
+    // 规则结果：关键字按规则中的顺序和原始写法列出
+    KeywordAnalysisRule rule("Rule", {"Disk", "CPU", "missing"}, true);
+    LogRecord record;
+    record.message = "cpu and DISK are busy";
+    auto results = rule.Analyze(record);
+    EXPECT_EQ(results["matched"], "true");
+    EXPECT_EQ(results["match_count"], "2");
+    EXPECT_EQ(results["score"], "66");
+    EXPECT_EQ(results["matched_keywords"], "Disk, CPU");
+}
+
 // 测试日志分析器功能
 TEST(AnalyzerRuleTest, LogAnalyzerFunctionality) {
     // 创建分析器配置
@@ -153,4 +204,549 @@ TEST(AnalyzerRuleTest, LogAnalyzerFunctionality) {
     EXPECT_TRUE(callbackInvoked);
     EXPECT_EQ(callbackRecordId, "log-1");
     EXPECT_TRUE(callbackResults.size() > 0);
-} 
\ No newline at end of file
+} 
+// 测试列式批次提交和按级别过滤
+TEST(AnalyzerRuleTest, SubmitBatchFiltersByLevel) {
+    AnalyzerConfig config;
+    config.threadPoolSize = 2;
+    config.batchSize = 4;
+    config.storeResults = false;
+    config.analyzeInterval = std::chrono::seconds(0);
+    config.minLevel = xumj::common::LogLevel::WARN;
+    
+    LogAnalyzer analyzer(config);
+    analyzer.AddRule(std::make_shared<KeywordAnalysisRule>(
+        "KeywordRule", std::vector<std::string>{"disk"}, true));
+    
+    std::mutex mutex;
+    std::vector<std::string> analyzedIds;
+    analyzer.SetAnalysisCallback([&](const std::string& recordId,
+                                     const std::unordered_map<std::string, std::string>&) {
+        std::lock_guard<std::mutex> lock(mutex);
+        analyzedIds.push_back(recordId);
+    });
+    EXPECT_TRUE(analyzer.Start());
+    
+    // 每4条中只有WARN、ERROR和无法识别的级别需要分析
+    xumj::common::RecordBatch batch;
+    const char* levels[] = {"DEBUG", "WARN", "ERROR", "unknown"};
+    for (int i = 0; i < 20; ++i) {
+        LogRecord record;
+        record.id = "log-" + std::to_string(i);
+        record.timestamp = "2023-01-01 10:00:00";
+        record.level = levels[i % 4];
+        record.source = "server1";
+        record.message = "disk usage high";
+        record.fields["host"] = "node-" + std::to_string(i);
+        AppendRecord(batch, record);
+    }
+    EXPECT_EQ(analyzer.SubmitBatch(std::move(batch)), 20U);
+    
+    for (int i = 0; i < 100; ++i) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (analyzedIds.size() >= 15U) {
+                break;
+            }
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    analyzer.Stop();
+    
+    std::lock_guard<std::mutex> lock(mutex);
+    EXPECT_EQ(analyzedIds.size(), 15U);
+    EXPECT_EQ(std::count(analyzedIds.begin(), analyzedIds.end(), "log-0"), 0);
+    EXPECT_EQ(std::count(analyzedIds.begin(), analyzedIds.end(), "log-3"), 1);
+    
+    // 批次读出的记录与写入的一致
+    xumj::common::RecordBatch roundTrip;
+    LogRecord original;
+    original.id = "log-x";
+    original.timestamp = "not a time";
+    original.level = "warning";
+    original.source = "server2";
+    original.message = "message";
+    original.fields["k"] = "v";
+    AppendRecord(roundTrip, original);
+    LogRecord copy;
+    ReadRecord(roundTrip, 0, copy);
+    EXPECT_EQ(copy.id, original.id);
+    EXPECT_EQ(copy.timestamp, original.timestamp);
+    EXPECT_EQ(copy.level, original.level);
+    EXPECT_EQ(roundTrip.Level(0), xumj::common::LogLevel::WARN);
+    EXPECT_EQ(copy.source, original.source);
+    EXPECT_EQ(copy.message, original.message);
+    EXPECT_EQ(copy.fields, original.fields);
+}
+
+// 测试重复日志的汇总记录按repeat_count计入规则命中数
+TEST(AnalyzerRuleTest, RepeatCountWeightsRuleHits) {
+    AnalyzerConfig config;
+    config.threadPoolSize = 1;
+    config.batchSize = 4;
+    config.storeResults = false;
+    config.analyzeInterval = std::chrono::seconds(0);
+    
+    LogAnalyzer analyzer(config);
+    analyzer.AddRule(std::make_shared<KeywordAnalysisRule>(
+        "KeywordRule", std::vector<std::string>{"timeout"}, true));
+    
+    std::atomic<int> analyzed{0};
+    analyzer.SetAnalysisCallback([&](const std::string&,
+                                     const std::unordered_map<std::string, std::string>&) {
+        ++analyzed;
+    });
+    EXPECT_TRUE(analyzer.Start());
+    
+    // 一条普通记录、一条代表5条日志的汇总记录和一条不命中的汇总记录
+    std::vector<LogRecord> records(3);
+    for (size_t i = 0; i < records.size(); ++i) {
+        records[i].id = "log-" + std::to_string(i);
+        records[i].level = "ERROR";
+        records[i].source = "server1";
+        records[i].message = i < 2 ? "connect timeout" : "connected";
+    }
+    records[1].fields["repeat_count"] = "5";
+    records[2].fields["repeat_count"] = "3";
+    EXPECT_EQ(analyzer.SubmitRecords(records), 3U);
+    
+    for (int i = 0; i < 100 && analyzed.load() < 3; ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    analyzer.Stop();
+    
+    const auto& metrics = analyzer.GetMetrics();
+    EXPECT_EQ(metrics.totalRecords.load(), 3U);
+    EXPECT_EQ(metrics.totalLogs.load(), 9U);
+    EXPECT_EQ(metrics.ruleMetrics.at("KeywordRule").hitLogs.load(), 6U);
+}
+
+// 测试多个正则合并匹配与逐个std::regex_search结果一致
+TEST(AnalyzerRuleTest, RegexRuleSetMatchesStdRegex) {
+    std::vector<std::string> patterns = {
+        "timeout after (\\d+)ms",
+        "^\\[(ERROR|FATAL)\\]",
+        "user=(\\w+) action=login",
+        "disk [a-z]+ ([0-9]{2,3})%$",
+        "(a|ab)(c|bcd)d",
+        "conn(ection)? (refused|reset)",
+        "x*",
+        "(\\w+)@\\1",          // 反向引用，改用std::regex
+        "[",                   // 无法编译
+    };
+    RegexRuleSet set;
+    for (const auto& pattern : patterns) {
+        set.Add(pattern);
+    }
+    set.Compile();
+    ASSERT_EQ(set.GetPatternCount(), patterns.size() - 1);
+    EXPECT_EQ(set.GetRequiredLiteral(0), "timeout after ");
+    EXPECT_EQ(set.GetRequiredLiteral(2), " action=login");
+    EXPECT_TRUE(set.IsAccelerated(0));
+    EXPECT_FALSE(set.IsAccelerated(7));
+    EXPECT_EQ(set.GetFallbackCount(), 1U);
+    
+    std::vector<std::string> messages = {
+        "[ERROR] request timeout after 350ms",
+        "[WARN] user=alice action=login",
+        "disk sda1 95%",
+        "disk sda1 95% full",
+        "abcdd connection reset",
+        "conn refused by bob@bob",
+        "",
+    };
+    std::vector<uint8_t> matched;
+    for (const auto& message : messages) {
+        size_t count = set.Match(message, matched);
+        size_t expectedCount = 0;
+        for (size_t i = 0; i < set.GetPatternCount(); ++i) {
+            bool expected = std::regex_search(message, std::regex(patterns[i]));
+            expectedCount += expected ? 1 : 0;
+            EXPECT_EQ(matched[i] != 0, expected) << patterns[i] << " / " << message;
+        }
+        EXPECT_EQ(count, expectedCount);
+    }
+}
+
+// 测试分析器合并匹配正则规则后，结果与逐条调用Analyze相同
+TEST(AnalyzerRuleTest, LogAnalyzerRegexRulesMatchAnalyze) {
+    AnalyzerConfig config;
+    config.threadPoolSize = 1;
+    config.storeResults = false;
+    config.analyzeInterval = std::chrono::seconds(0);
+    LogAnalyzer analyzer(config);
+    
+    std::vector<std::shared_ptr<AnalysisRule>> rules = {
+        std::make_shared<RegexAnalysisRule>("Timeout", "timeout after (\\d+)ms",
+                                            std::vector<std::string>{"timeout_ms"}),
+        std::make_shared<RegexAnalysisRule>("Failed", "(\\w+) failed", std::vector<std::string>{}),
+        std::make_shared<RegexAnalysisRule>("Backref", "(\\w+)=\\1", std::vector<std::string>{"value"}),
+        std::make_shared<KeywordAnalysisRule>("Keyword", std::vector<std::string>{"disk"}),
+    };
+    rules[1]->Disable();
+    for (const auto& rule : rules) {
+        analyzer.AddRule(rule);
+    }
+    
+    std::mutex mutex;
+    std::vector<std::unordered_map<std::string, std::string>> actual;
+    analyzer.SetAnalysisCallback([&](const std::string&,
+                                     const std::unordered_map<std::string, std::string>& results) {
+        std::lock_guard<std::mutex> lock(mutex);
+        actual.push_back(results);
+    });
+    EXPECT_TRUE(analyzer.Start());
+    
+    std::vector<std::string> messages = {
+        "request timeout after 350ms", "write failed on disk", "a=a", "nothing here"};
+    std::vector<std::unordered_map<std::string, std::string>> expected;
+    for (size_t i = 0; i < messages.size(); ++i) {
+        LogRecord record;
+        record.id = "log-" + std::to_string(i);
+        record.level = "ERROR";
+        record.message = messages[i];
+        for (const auto& rule : rules) {
+            if (rule->IsEnabled()) {
+                expected.push_back(rule->Analyze(record));
+            }
+        }
+        EXPECT_TRUE(analyzer.SubmitRecord(record));
+    }
+    
+    for (int i = 0; i < 100; ++i) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (actual.size() >= expected.size()) {
+                break;
+            }
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    analyzer.Stop();
+    
+    // 单线程按提交顺序处理，结果顺序与逐条调用一致
+    std::lock_guard<std::mutex> lock(mutex);
+    EXPECT_EQ(actual, expected);
+    EXPECT_EQ(expected[0].at("timeout_ms"), "350");
+}
+
+// 统计AnalyzeBatch调用的测试规则
+class CountingBatchRule : public AnalysisRule {
+public:
+    std::unordered_map<std::string, std::string> Analyze(const LogRecord& record) const override {
+        return {{"matched", "true"}, {"rule", "Counting"}, {"length", std::to_string(record.message.size())}};
+    }
+    void AnalyzeBatch(const LogRecord* records, size_t count, size_t rule, RuleResult* results) const override {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            chunkSizes_.push_back(count);
+        }
+        AnalysisRule::AnalyzeBatch(records, count, rule, results);
+    }
+    std::string GetName() const override { return "Counting"; }
+    const RuleConfig& GetConfig() const override { return config_; }
+    void SetConfig(const RuleConfig& config) override { config_ = config; }
+    void Enable() override { config_.enabled = true; }
+    void Disable() override { config_.enabled = false; }
+    bool IsEnabled() const override { return config_.enabled; }
+    
+    std::vector<size_t> GetChunkSizes() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return chunkSizes_;
+    }
+    
+private:
+    RuleConfig config_;
+    mutable std::mutex mutex_;
+    mutable std::vector<size_t> chunkSizes_;
+};
+
+// 测试批次按行数和字节数切块、每块调用一次AnalyzeBatch，提交后立即唤醒分析线程
+TEST(AnalyzerRuleTest, AnalyzeBatchPerChunk) {
+    AnalyzerConfig config;
+    config.threadPoolSize = 2;
+    config.batchSize = 8;
+    config.chunkBytes = 700;
+    config.storeResults = false;
+    config.analyzeInterval = std::chrono::seconds(10);
+    LogAnalyzer analyzer(config);
+    auto rule = std::make_shared<CountingBatchRule>();
+    analyzer.AddRule(rule);
+    
+    std::mutex mutex;
+    size_t analyzed = 0;
+    analyzer.SetAnalysisCallback([&](const std::string&, const std::unordered_map<std::string, std::string>& results) {
+        std::lock_guard<std::mutex> lock(mutex);
+        analyzed += results.count("length");
+    });
+    EXPECT_TRUE(analyzer.Start());
+    
+    // 20条短消息按行数切为8+8+4，3条400字节的长消息按字节数切为2+1
+    xumj::common::RecordBatch shortBatch;
+    xumj::common::RecordBatch longBatch;
+    for (int i = 0; i < 20; ++i) {
+        AppendRecord(shortBatch, LogRecord{"s" + std::to_string(i), "", "INFO", "src", "short", {}});
+    }
+    for (int i = 0; i < 3; ++i) {
+        AppendRecord(longBatch, LogRecord{"l" + std::to_string(i), "", "INFO", "src", std::string(400, 'x'), {}});
+    }
+    auto start = std::chrono::steady_clock::now();
+    EXPECT_EQ(analyzer.SubmitBatch(std::move(shortBatch)), 20U);
+    EXPECT_EQ(analyzer.SubmitBatch(std::move(longBatch)), 3U);
+    
+    for (int i = 0; i < 200; ++i) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (analyzed >= 23U) {
+                break;
+            }
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    analyzer.Stop();
+    
+    // 等待间隔为10秒，提交后立即处理说明是被唤醒的
+    EXPECT_LT(elapsed, std::chrono::seconds(2));
+    std::lock_guard<std::mutex> lock(mutex);
+    EXPECT_EQ(analyzed, 23U);
+    auto sizes = rule->GetChunkSizes();
+    std::sort(sizes.begin(), sizes.end());
+    EXPECT_EQ(sizes, (std::vector<size_t>{1, 2, 4, 8, 8}));
+}
+
+// 测试紧凑分析结果：未命中的规则不写入内容，字段值指向消息，按需生成键值对
+TEST(AnalyzerRuleTest, CompactRuleResults) {
+    RegexAnalysisRule timeout("Timeout", "timeout after (\\d+)ms", {"timeout_ms"});
+    KeywordAnalysisRule disk("Disk", {"disk", "full"}, true);
+    LogRecord record;
+    record.message = "request timeout after 350ms";
+    
+    RuleResult result;
+    result.Reset(2);
+    timeout.Evaluate(record, 0, result);
+    disk.Evaluate(record, 1, result);
+    EXPECT_TRUE(result.IsMatched(0));
+    EXPECT_FALSE(result.IsMatched(1));
+    EXPECT_EQ(result.GetMatchedCount(), 1U);
+    ASSERT_EQ(result.GetFields().size(), 1U);
+    EXPECT_EQ(result.GetFields()[0].value, "350");
+    EXPECT_EQ(result.GetFields()[0].value.data(), record.message.data() + 22);
+    EXPECT_EQ(result.GetArenaBytes(), 0U);
+    EXPECT_EQ(result.ToMap(0, "Timeout", "default"), timeout.Analyze(record));
+    EXPECT_EQ(result.ToMap(1, "Disk", "default"), disk.Analyze(record));
+    
+    // 缓冲区跨块复制，Reset后复用
+    std::string large(5000, 'x');
+    EXPECT_EQ(result.CopyString(large), large);
+    EXPECT_EQ(result.CopyString("abc"), "abc");
+    result.Reset(2);
+    EXPECT_EQ(result.GetFields().size(), 0U);
+    EXPECT_EQ(result.GetArenaBytes(), 0U);
+    
+    // 分析器只设置紧凑回调时每条记录调用一次
+    AnalyzerConfig config;
+    config.threadPoolSize = 1;
+    config.storeResults = false;
+    LogAnalyzer analyzer(config);
+    analyzer.AddRule(std::make_shared<RegexAnalysisRule>("Timeout", "timeout after (\\d+)ms",
+                                                         std::vector<std::string>{"timeout_ms"}));
+    analyzer.AddRule(std::make_shared<KeywordAnalysisRule>("Disk", std::vector<std::string>{"disk"}));
+    std::mutex mutex;
+    std::vector<std::pair<std::string, size_t>> seen;
+    analyzer.SetResultCallback([&](const LogRecord& analyzed, const RuleResult& compact,
+                                   const std::vector<std::shared_ptr<AnalysisRule>>& rules) {
+        EXPECT_EQ(rules.size(), 2U);
+        std::lock_guard<std::mutex> lock(mutex);
+        seen.emplace_back(analyzed.id, compact.GetMatchedCount());
+    });
+    EXPECT_TRUE(analyzer.Start());
+    EXPECT_TRUE(analyzer.SubmitRecord(LogRecord{"a", "", "ERROR", "src", "disk timeout after 5ms", {}}));
+    EXPECT_TRUE(analyzer.SubmitRecord(LogRecord{"b", "", "ERROR", "src", "all good", {}}));
+    for (int i = 0; i < 100; ++i) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (seen.size() >= 2U) {
+                break;
+            }
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    analyzer.Stop();
+    std::lock_guard<std::mutex> lock(mutex);
+    EXPECT_EQ(seen, (std::vector<std::pair<std::string, size_t>>{{"a", 2}, {"b", 0}}));
+}
+
+// 测试结果写入线程：满一批立即写入，不满一批时按最长等待时间写入，停止时写完剩余结果
+TEST(AnalyzerRuleTest, ResultWriterFlushesBySizeAndInterval) {
+    std::mutex mutex;
+    std::vector<std::vector<std::string>> flushes;
+    ResultWriter writer([&](const std::vector<StoredResult>& results) {
+        std::vector<std::string> ids;
+        for (const auto& result : results) {
+            ids.push_back(result.recordId);
+        }
+        std::lock_guard<std::mutex> lock(mutex);
+        flushes.push_back(ids);
+        return ids.size() - (ids.front() == "r0" ? 1 : 0);   // 模拟r0写入失败
+    }, 3, std::chrono::milliseconds(100), 100);
+    
+    auto submit = [&writer](const std::string& id) {
+        StoredResult result;
+        result.recordId = id;
+        result.rules.push_back({"rule", {{"matched", "true"}}});
+        return writer.Submit(std::move(result));
+    };
+    auto flushCount = [&]() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return flushes.size();
+    };
+    EXPECT_FALSE(submit("before-start"));
+    writer.Start();
+    
+    // 满3条立即写入，远早于最长等待时间
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < 3; ++i) {
+        EXPECT_TRUE(submit("r" + std::to_string(i)));
+    }
+    while (flushCount() < 1 && std::chrono::steady_clock::now() - start < std::chrono::seconds(2)) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    EXPECT_EQ(flushCount(), 1U);
+    EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::milliseconds(90));
+    
+    // 不满一批的结果等待约100毫秒后写入
+    start = std::chrono::steady_clock::now();
+    EXPECT_TRUE(submit("r3"));
+    while (flushCount() < 2 && std::chrono::steady_clock::now() - start < std::chrono::seconds(2)) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    auto waited = std::chrono::steady_clock::now() - start;
+    EXPECT_EQ(flushCount(), 2U);
+    EXPECT_GE(waited, std::chrono::milliseconds(90));
+    EXPECT_LT(waited, std::chrono::seconds(1));
+    
+    // 停止时不等待，直接写完剩余结果
+    EXPECT_TRUE(submit("r4"));
+    writer.Stop();
+    EXPECT_FALSE(submit("after-stop"));
+    
+    std::lock_guard<std::mutex> lock(mutex);
+    EXPECT_EQ(flushes, (std::vector<std::vector<std::string>>{{"r0", "r1", "r2"}, {"r3"}, {"r4"}}));
+    EXPECT_EQ(writer.GetWrittenCount(), 4U);
+    EXPECT_EQ(writer.GetFailedCount(), 1U);
+    EXPECT_EQ(writer.GetDroppedCount(), 2U);
+    EXPECT_EQ(writer.GetFlushCount(), 3U);
+}
+
+// 总是命中、耗时约200微秒的规则，记录调用次数
+class SlowMatchRule : public AnalysisRule {
+public:
+    std::unordered_map<std::string, std::string> Analyze(const LogRecord&) const override {
+        calls_.fetch_add(1);
+        auto until = std::chrono::steady_clock::now() + std::chrono::microseconds(200);
+        while (std::chrono::steady_clock::now() < until) {
+        }
+        return {{"matched", "true"}};
+    }
+    std::string GetName() const override { return "Slow"; }
+    const RuleConfig& GetConfig() const override { return config_; }
+    void SetConfig(const RuleConfig& config) override { config_ = config; }
+    void Enable() override { config_.enabled = true; }
+    void Disable() override { config_.enabled = false; }
+    bool IsEnabled() const override { return config_.enabled; }
+    
+    size_t GetCalls() const { return calls_.load(); }
+    
+private:
+    RuleConfig config_;
+    mutable std::atomic<size_t> calls_{0};
+};
+
+// 测试自适应评估顺序和短路组：便宜且常命中的规则排到前面，命中后组内其余规则不再分析；病态正则按步数限制中止
+TEST(AnalyzerRuleTest, AdaptiveOrderShortCircuitAndStepLimit) {
+    AnalyzerConfig config;
+    config.threadPoolSize = 1;
+    config.storeResults = false;
+    config.ruleReorderInterval = std::chrono::milliseconds(10);
+    LogAnalyzer analyzer(config);
+    
+    RuleConfig sc;
+    sc.group = "sc";
+    auto slow = std::make_shared<SlowMatchRule>();
+    slow->SetConfig(sc);
+    auto fast = std::make_shared<RegexAnalysisRule>("Fast", "disk (\\w+)", std::vector<std::string>{"state"});
+    fast->SetConfig(sc);
+    RuleConfig limited;
+    limited.maxMatchSteps = 10000;
+    auto backtrack = std::make_shared<RegexAnalysisRule>("Backtrack", "(a+)+b(?=x)", std::vector<std::string>{});
+    backtrack->SetConfig(limited);
+    analyzer.AddRule(slow);
+    analyzer.AddRule(fast);
+    analyzer.AddRule(backtrack);
+    analyzer.SetGroupShortCircuit("sc", true);
+    EXPECT_TRUE(analyzer.IsGroupShortCircuit("sc"));
+    EXPECT_FALSE(analyzer.IsGroupShortCircuit("default"));
+    
+    std::mutex mutex;
+    size_t analyzed = 0;
+    std::vector<size_t> groupMatches;
+    analyzer.SetResultCallback([&](const LogRecord&, const RuleResult& result,
+                                   const std::vector<std::shared_ptr<AnalysisRule>>& rules) {
+        size_t matches = 0;
+        for (size_t i = 0; i < rules.size(); ++i) {
+            matches += rules[i]->GetConfig().group == "sc" && result.IsMatched(i) ? 1 : 0;
+            EXPECT_EQ(result.IsTimedOut(i), rules[i]->GetName() == "Backtrack");
+        }
+        std::lock_guard<std::mutex> lock(mutex);
+        groupMatches.push_back(matches);
+        ++analyzed;
+    });
+    EXPECT_TRUE(analyzer.Start());
+    
+    auto submitAndWait = [&](size_t count) {
+        size_t target = 0;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            target = analyzed + count;
+        }
+        std::vector<LogRecord> records(count, LogRecord{"", "", "ERROR", "src",
+                                                        "disk full " + std::string(28, 'a'), {}});
+        EXPECT_EQ(analyzer.SubmitRecords(records), count);
+        for (int i = 0; i < 500; ++i) {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                if (analyzed >= target) {
+                    return;
+                }
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        }
+        ADD_FAILURE() << "分析超时";
+    };
+    
+    // 几个调整周期后两条规则都有了统计，便宜的正则规则排在前面
+    for (int round = 0; round < 5; ++round) {
+        submitAndWait(10);
+        std::this_thread::sleep_for(std::chrono::milliseconds(15));
+    }
+    auto order = analyzer.GetEvaluationOrder();
+    ASSERT_EQ(order.size(), 3U);
+    auto position = [&order](const std::string& name) {
+        return std::find_if(order.begin(), order.end(), [&name](const auto& rule) { return rule->GetName() == name; });
+    };
+    EXPECT_LT(position("Fast"), position("Slow"));
+    
+    // 正则规则命中后短路，慢规则不再被调用
+    size_t slowCalls = slow->GetCalls();
+    submitAndWait(20);
+    EXPECT_EQ(slow->GetCalls(), slowCalls);
+    analyzer.Stop();
+    
+    std::lock_guard<std::mutex> lock(mutex);
+    EXPECT_EQ(groupMatches, std::vector<size_t>(analyzed, 1));
+    const auto& metrics = analyzer.GetMetrics().ruleMetrics;
+    EXPECT_EQ(metrics.at("Backtrack").timeoutCount.load(), analyzed);
+    EXPECT_EQ(metrics.at("Backtrack").errorCount.load(), analyzed);
+    EXPECT_EQ(metrics.at("Fast").timeoutCount.load(), 0U);
+}
@@ -0,0 +1,316 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <vector>
+#include "xumj/common/concurrency_controller.h"
+#include "xumj/common/id_generator.h"
+#include "xumj/common/prometheus_writer.h"
+#include "xumj/common/record_batch.h"
+#include "xumj/common/thread_pool.h"
+
+using namespace xumj::common;
+
+// 测试128位ID在线程内严格递增，文本形式定长且保持顺序
+TEST(IdGeneratorTest, MonotonicWithinThread) {
+    IdGenerator& generator = IdGenerator::Instance();
+    LogId previous = generator.Next();
+    std::string previousText = IdGenerator::Encode(previous);
+    EXPECT_EQ(previousText.size(), IdGenerator::kTextLength);
+
+    for (int i = 0; i < 10000; ++i) {
+        LogId id = generator.Next();
+        std::string text = IdGenerator::Encode(id);
+        EXPECT_TRUE(previous < id);
+        EXPECT_LT(previousText, text);
+        EXPECT_EQ(id.NodeId(), generator.GetNodeId());
+        previous = id;
+        previousText = text;
+    }
+}
+
+// 测试线程退出后槽位被复用，复用的线程从退出线程的状态继续递增
+TEST(IdGeneratorTest, ThreadSlotRecycled) {
+    IdGenerator& generator = IdGenerator::Instance();
+    LogId first;
+    LogId second;
+    std::thread([&]() {
+        generator.Next();
+        first = generator.Next();
+    }).join();
+    std::thread([&]() { second = generator.Next(); }).join();
+
+    EXPECT_EQ(second.lo >> 48, first.lo >> 48);
+    EXPECT_TRUE(first < second);
+}
+
+// 测试文本编码与解码互逆
+TEST(IdGeneratorTest, EncodeDecodeRoundTrip) {
+    LogId id;
+    id.hi = 0xFEDCBA9876543210ull;
+    id.lo = 0x0123456789ABCDEFull;
+    std::string text = IdGenerator::Encode(id);
+
+    LogId decoded;
+    ASSERT_TRUE(IdGenerator::Decode(text, decoded));
+    EXPECT_EQ(decoded, id);
+
+    // 小写同样可以解析
+    std::string lower = text;
+    std::transform(lower.begin(), lower.end(), lower.begin(), ::tolower);
+    ASSERT_TRUE(IdGenerator::Decode(lower, decoded));
+    EXPECT_EQ(decoded, id);
+
+    EXPECT_FALSE(IdGenerator::Decode("too-short", decoded));
+    EXPECT_FALSE(IdGenerator::Decode(std::string(IdGenerator::kTextLength, 'U'), decoded));
+    // 最高字符只能编码3位
+    EXPECT_FALSE(IdGenerator::Decode("8" + std::string(IdGenerator::kTextLength - 1, '0'), decoded));
+}
+
+// 测试多线程并发生成的ID全局唯一，同一线程内递增
+TEST(IdGeneratorTest, UniqueAcrossThreads) {
+    IdGenerator& generator = IdGenerator::Instance();
+    const int threadCount = 4;
+    const int perThread = 20000;
+
+    std::mutex mutex;
+    std::set<std::string> ids;
+    std::vector<std::thread> threads;
+    for (int t = 0; t < threadCount; ++t) {
+        threads.emplace_back([&]() {
+            std::vector<std::string> local;
+            for (int i = 0; i < perThread; ++i) {
+                local.push_back(generator.NextString());
+            }
+            // 文本字典序与生成顺序一致
+            EXPECT_TRUE(std::is_sorted(local.begin(), local.end()));
+            std::lock_guard<std::mutex> lock(mutex);
+            ids.insert(local.begin(), local.end());
+        });
+    }
+    for (auto& t : threads) {
+        t.join();
+    }
+
+    EXPECT_EQ(ids.size(), static_cast<size_t>(threadCount * perThread));
+}
+
+// 列式批次：按行写入再读出，时间戳、级别和字段保持原文
+TEST(RecordBatchTest, AppendAndReadBack) {
+    RecordBatch batch;
+    batch.Append("id-1", "2024-03-01 12:00:00", "ERROR", "web", "disk full");
+    batch.SetField("host", "node-1");
+    batch.Append("id-2", "2024-03-01 12:00:01.250", "info", "web", "ok");
+    batch.Append("id-3", "01/Mar/2024:12:00:02", "notice", "db", "");
+    batch.SetField("host", "node-2");
+    batch.SetField("host", "node-3");   // 覆盖同一行的值
+
+    ASSERT_EQ(batch.Size(), 3U);
+    EXPECT_EQ(batch.Id(1), "id-2");
+    EXPECT_EQ(batch.Message(0), "disk full");
+    EXPECT_EQ(batch.Message(2), "");
+    EXPECT_EQ(batch.SourceDictionary().size(), 2U);
+    EXPECT_EQ(batch.Source(2), "db");
+
+    EXPECT_EQ(batch.Level(0), LogLevel::ERROR);
+    EXPECT_EQ(batch.Level(1), LogLevel::INFO);
+    EXPECT_EQ(batch.Level(2), LogLevel::OTHER);
+    EXPECT_EQ(batch.LevelText(0), "ERROR");
+    EXPECT_EQ(batch.LevelText(1), "info");
+    EXPECT_EQ(batch.LevelText(2), "notice");
+
+    EXPECT_EQ(batch.TimestampText(0), "2024-03-01 12:00:00");
+    EXPECT_EQ(batch.TimestampText(1), "2024-03-01 12:00:01.250");
+    EXPECT_EQ(batch.Timestamp(1) - batch.Timestamp(0), 1250);
+    EXPECT_EQ(batch.Timestamp(2), RecordBatch::kNoTimestamp);
+    EXPECT_EQ(batch.TimestampText(2), "01/Mar/2024:12:00:02");
+
+    std::string_view value;
+    EXPECT_TRUE(batch.Field(0, "host", value));
+    EXPECT_EQ(value, "node-1");
+    EXPECT_FALSE(batch.Field(1, "host", value));
+    EXPECT_TRUE(batch.Field(2, "host", value));
+    EXPECT_EQ(value, "node-3");
+
+    // 内部保存的原文不作为字段输出
+    size_t fields = 0;
+    batch.ForEachField(2, [&fields](std::string_view name, std::string_view) {
+        EXPECT_EQ(name, "host");
+        ++fields;
+    });
+    EXPECT_EQ(fields, 1U);
+
+    batch.Clear();
+    EXPECT_TRUE(batch.Empty());
+    EXPECT_FALSE(batch.Field(0, "host", value));
+}
+
+TEST(RecordBatchTest, TimestampCodec) {
+    EXPECT_EQ(RecordBatch::ParseTimestamp("1970-01-01 00:00:00"), 0);
+    EXPECT_EQ(RecordBatch::ParseTimestamp("1969-12-31 23:59:59"), -1000);
+    EXPECT_EQ(RecordBatch::ParseTimestamp("2024-02-30 00:00:00"), RecordBatch::kNoTimestamp);
+    EXPECT_EQ(RecordBatch::ParseTimestamp("2024-01-01T00:00:00"), RecordBatch::kNoTimestamp);
+    EXPECT_EQ(RecordBatch::ParseTimestamp("2024-01-01 00:00:00.000"), RecordBatch::kNoTimestamp);
+    for (const char* text : {"2000-02-29 23:59:59", "2024-12-31 00:00:00.001", "1900-01-01 08:30:00"}) {
+        EXPECT_EQ(RecordBatch::FormatTimestamp(RecordBatch::ParseTimestamp(text)), text);
+    }
+}
+
+// 按列过滤：结果是按行号递增的选择向量
+TEST(RecordBatchTest, SelectRows) {
+    RecordBatch batch;
+    const char* levels[] = {"DEBUG", "INFO", "WARN", "ERROR", "FATAL", "custom"};
+    for (int i = 0; i < 60; ++i) {
+        std::string time = "2024-01-01 00:00:" + std::string(i < 10 ? "0" : "") + std::to_string(i);
+        batch.Append("id-" + std::to_string(i), time, levels[i % 6], i % 3 == 0 ? "a" : "b", "m");
+    }
+
+    std::vector<uint32_t> selection;
+    EXPECT_EQ(batch.SelectLevelAtLeast(LogLevel::WARN, selection), 40U);
+    EXPECT_TRUE(std::is_sorted(selection.begin(), selection.end()));
+    for (uint32_t row : selection) {
+        EXPECT_GE(row % 6, 2U);
+    }
+
+    int64_t begin = RecordBatch::ParseTimestamp("2024-01-01 00:00:10");
+    int64_t end = RecordBatch::ParseTimestamp("2024-01-01 00:00:20");
+    EXPECT_EQ(batch.SelectTimeRange(begin, end, selection), 10U);
+    EXPECT_EQ(selection.front(), 10U);
+    EXPECT_EQ(selection.back(), 19U);
+
+    EXPECT_EQ(batch.SelectSource("a", selection), 20U);
+    EXPECT_EQ(selection[1], 3U);
+    EXPECT_EQ(batch.SelectSource("missing", selection), 0U);
+}
+
+// Prometheus文本：同名指标只输出一次HELP/TYPE，标签值转义
+TEST(PrometheusWriterTest, CountersAndLabels) {
+    PrometheusWriter writer;
+    writer.Counter("xumj_calls_total", "调用次数", 3, {{"parser", "json"}});
+    writer.Counter("xumj_calls_total", "调用次数", 1, {{"parser", "a\"b\\c"}});
+    writer.Gauge("xumj_queue_depth", "队列深度", 0.5);
+
+    const std::string& text = writer.Text();
+    EXPECT_EQ(text,
+              "# HELP xumj_calls_total 调用次数\n"
+              "# TYPE xumj_calls_total counter\n"
+              "xumj_calls_total{parser=\"json\"} 3\n"
+              "xumj_calls_total{parser=\"a\\\"b\\\\c\"} 1\n"
+              "# HELP xumj_queue_depth 队列深度\n"
+              "# TYPE xumj_queue_depth gauge\n"
+              "xumj_queue_depth 0.5\n");
+}
+
+// 直方图按秒输出累计桶，+Inf桶与_count一致
+TEST(PrometheusWriterTest, HistogramBuckets) {
+    LatencyHistogram histogram;
+    histogram.Record(5);        // 5微秒
+    histogram.Record(800);      // 0.8毫秒
+    histogram.Record(20000);    // 20毫秒
+    histogram.Record(10000000); // 10秒，超过最大分界
+
+    PrometheusWriter writer;
+    writer.Histogram("xumj_latency_seconds", "延迟", histogram, {{"stage", "parse"}});
+    const std::string& text = writer.Text();
+
+    EXPECT_NE(text.find("# TYPE xumj_latency_seconds histogram\n"), std::string::npos);
+    EXPECT_NE(text.find("xumj_latency_seconds_bucket{stage=\"parse\",le=\"1e-05\"} 1\n"), std::string::npos);
+    EXPECT_NE(text.find("xumj_latency_seconds_bucket{stage=\"parse\",le=\"0.001\"} 2\n"), std::string::npos);
+    EXPECT_NE(text.find("xumj_latency_seconds_bucket{stage=\"parse\",le=\"0.025\"} 3\n"), std::string::npos);
+    EXPECT_NE(text.find("xumj_latency_seconds_bucket{stage=\"parse\",le=\"5\"} 3\n"), std::string::npos);
+    EXPECT_NE(text.find("xumj_latency_seconds_bucket{stage=\"parse\",le=\"+Inf\"} 4\n"), std::string::npos);
+    EXPECT_NE(text.find("xumj_latency_seconds_count{stage=\"parse\"} 4\n"), std::string::npos);
+    EXPECT_NE(text.find("xumj_latency_seconds_sum{stage=\"parse\"} 10.0208"), std::string::npos);
+}
+
+// 常驻内存从/proc读取
+TEST(PrometheusWriterTest, ResidentMemory) {
+    EXPECT_GT(ReadResidentMemoryBytes(), 0U);
+}
+
+// 运行时调整线程数不丢任务，多余线程空闲后退出
+TEST(ThreadPoolTest, ResizeKeepsTasks) {
+    ThreadPool pool(2);
+    std::atomic<int> done{0};
+    auto submit = [&pool, &done](int count) {
+        for (int i = 0; i < count; ++i) {
+            pool.Submit([&done]() {
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                done++;
+            });
+        }
+    };
+
+    submit(50);
+    pool.Resize(6);
+    EXPECT_EQ(pool.GetThreadCount(), 6U);
+    submit(50);
+    pool.Resize(1);
+    submit(50);
+    ASSERT_TRUE(pool.WaitForTasks(5000));
+    EXPECT_EQ(done.load(), 150);
+
+    // 多余的线程空闲后退出
+    for (int i = 0; i < 100 && pool.GetThreadCount() != 1; ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    EXPECT_EQ(pool.GetThreadCount(), 1U);
+    pool.Resize(3);
+    EXPECT_EQ(pool.GetThreadCount(), 3U);
+    submit(10);
+    ASSERT_TRUE(pool.WaitForTasks(5000));
+    EXPECT_EQ(done.load(), 160);
+}
+
+// 自适应并发：排队时间超标加性扩容，CPU饱和或空闲时乘性缩容
+TEST(ConcurrencyControllerTest, AimdDecisions) {
+    ConcurrencyConfig config;
+    config.minThreads = 2;
+    config.maxThreads = 8;
+    config.targetQueueDelay = std::chrono::milliseconds(50);
+    config.cooldownTicks = 0;
+    std::vector<size_t> applied;
+    ConcurrencyController controller(config, 4, nullptr,
+                                                    [&applied](size_t n) { applied.push_back(n); });
+    const std::chrono::microseconds second(1000000);
+
+    // 第一次采样只作为基线
+    ConcurrencySample sample;
+    EXPECT_EQ(controller.Evaluate(sample, 0.2, second), 4U);
+
+    // 每条1毫秒、积压1000条、4线程：估计排队250毫秒，加性扩容
+    sample.completed += 4000;
+    sample.busyMicros += 4000000;
+    sample.queueDepth = 1000;
+    EXPECT_EQ(controller.Evaluate(sample, 0.5, second), 5U);
+
+    // CPU饱和时不扩容，按比例缩容
+    sample.completed += 4000;
+    sample.busyMicros += 4000000;
+    EXPECT_EQ(controller.Evaluate(sample, 0.95, second), 3U);
+
+    // 积压清空且线程大多空闲：缩容，但不低于下限
+    sample.completed += 100;
+    sample.busyMicros += 100000;
+    sample.queueDepth = 0;
+    EXPECT_EQ(controller.Evaluate(sample, 0.1, second), 2U);
+    sample.completed += 100;
+    sample.busyMicros += 100000;
+    EXPECT_EQ(controller.Evaluate(sample, 0.1, second), 2U);
+
+    // 有积压但整个周期没有完成：至少排队了一个周期，扩容到上限为止
+    for (int i = 0; i < 10; ++i) {
+        sample.queueDepth = 10;
+        controller.Evaluate(sample, 0.1, second);
+    }
+    EXPECT_EQ(controller.GetLimit(), 8U);
+    EXPECT_EQ(applied.front(), 5U);
+    EXPECT_EQ(applied.back(), 8U);
+
+    PrometheusWriter writer;
+    controller.WritePrometheusMetrics(writer, "xumj_test_workers");
+    EXPECT_NE(writer.Text().find("xumj_test_workers_limit 8\n"), std::string::npos);
+    EXPECT_NE(writer.Text().find("xumj_test_workers_adjustments_total{direction=\"down\"} 2\n"),
+              std::string::npos);
+}
@@ -85,4 +85,89 @@ TEST(LogCollectorTest, BatchLogSubmission) {
     
     // 手动刷新
     collector.Flush();
-} 
\ No newline at end of file
+} 
+// 测试确认投递：窗口、累计确认与重连后重传
+TEST(LogCollectorTest, AckedDelivery) {
+    CollectorConfig config;
+    config.collectorId = "test-collector";
+    config.batchSize = 1;
+    config.flushInterval = std::chrono::milliseconds(50);
+    config.enableAck = true;
+    config.maxInFlightBatches = 2;
+
+    LogCollector collector(config);
+
+    std::mutex mutex;
+    std::vector<uint64_t> sent;
+    std::vector<uint64_t> retransmitted;
+    std::vector<uint64_t> bases;
+    bool connected = true;
+    size_t ackedLogs = 0;
+    collector.SetSendCallback([&](size_t count) {
+        std::lock_guard<std::mutex> lock(mutex);
+        ackedLogs += count;
+    });
+    collector.SetBatchPushCallback([&](uint64_t seq, uint64_t base, const std::vector<LogEntry>&, bool retransmit) {
+        std::lock_guard<std::mutex> lock(mutex);
+        (retransmit ? retransmitted : sent).push_back(seq);
+        bases.push_back(base);
+        return connected;
+    });
+
+    EXPECT_EQ(collector.GetStreamId().rfind("test-collector-", 0), 0U);
+
+    for (int i = 0; i < 4; ++i) {
+        collector.SubmitLog("log " + std::to_string(i), LogLevel::INFO);
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(400));
+
+    // 窗口为2，未确认前最多发出2个批次
+    EXPECT_EQ(collector.GetInFlightBatchCount(), 2U);
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        EXPECT_EQ(sent, (std::vector<uint64_t>{1, 2}));
+        EXPECT_EQ(ackedLogs, 0U);
+    }
+
+    // 累计确认释放窗口，剩余批次继续发送
+    collector.HandleAck(2);
+    std::this_thread::sleep_for(std::chrono::milliseconds(400));
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        EXPECT_EQ(sent, (std::vector<uint64_t>{1, 2, 3, 4}));
+        EXPECT_EQ(bases, (std::vector<uint64_t>{0, 0, 2, 2}));
+        EXPECT_EQ(ackedLogs, 2U);
+    }
+    EXPECT_EQ(collector.GetAckedSequence(), 2U);
+
+    // 过期确认被忽略；重连后只重传未确认的批次
+    collector.HandleAck(1);
+    EXPECT_EQ(collector.RetransmitUnacked(), 2U);
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        EXPECT_EQ(retransmitted, (std::vector<uint64_t>{3, 4}));
+    }
+
+    collector.HandleAck(4);
+    EXPECT_EQ(collector.GetInFlightBatchCount(), 0U);
+
+    // 断开后新批次留在窗口中，重传完成前不会先于旧批次发出
+    collector.HandleDisconnect();
+    collector.SubmitLog("log 4", LogLevel::INFO);
+    std::this_thread::sleep_for(std::chrono::milliseconds(400));
+    EXPECT_EQ(collector.GetInFlightBatchCount(), 1U);
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        EXPECT_EQ(sent.size(), 4U);
+    }
+    EXPECT_EQ(collector.RetransmitUnacked(), 1U);
+    collector.SubmitLog("log 5", LogLevel::INFO);
+    std::this_thread::sleep_for(std::chrono::milliseconds(400));
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        EXPECT_EQ(retransmitted, (std::vector<uint64_t>{3, 4, 5}));
+        EXPECT_EQ(sent, (std::vector<uint64_t>{1, 2, 3, 4, 6}));
+        EXPECT_EQ(bases.back(), 4U);
+    }
+    collector.Shutdown();
+}
@@ -5,8 +5,15 @@
 #include <mutex>
 #include <atomic>
 #include <vector>
+#include <algorithm>
+#include <nlohmann/json.hpp>
 
 #include "xumj/processor/log_processor.h"
+#include "xumj/processor/ack_tracker.h"
+#include "xumj/processor/json_field_extractor.h"
+#include "xumj/processor/grok_parser.h"
+#include "xumj/processor/metrics_server.h"
+#include "xumj/processor/raw_archiver.h"
 #include "xumj/analyzer/log_analyzer.h"
 
 using namespace xumj::processor;
@@ -238,7 +245,1069 @@ TEST(LogProcessorTest_ConfigUpdate, UpdateConfiguration) {
     EXPECT_EQ(processor.GetConfig().queueSize, 100);
 }
 
+// 确认投递测试：累计确认与重复批次丢弃
+TEST(LogProcessorTest_AckTracker, CumulativeAckAndDuplicates) {
+    std::vector<std::pair<uint64_t, uint64_t>> acks;  // (连接ID, 确认序号)
+    AckTracker tracker([&acks](uint64_t connId, const std::string&, uint64_t seq) {
+        acks.emplace_back(connId, seq);
+    });
+
+    auto t1 = tracker.Begin(7, "stream-a", 1, 0, 2);
+    auto t2 = tracker.Begin(7, "stream-a", 2, 0, 1);
+    ASSERT_NE(t1, nullptr);
+    ASSERT_NE(t2, nullptr);
+
+    // 批次2先完成，但批次1未完成前不能确认
+    t2->Complete(true);
+    EXPECT_TRUE(acks.empty());
+
+    t1->Complete(true);
+    EXPECT_TRUE(acks.empty());
+    t1->Complete(true);
+    ASSERT_EQ(acks.size(), 1U);
+    EXPECT_EQ(acks.back().second, 2U);
+
+    // 重连后重传已存储的批次：丢弃并在新连接上重发确认
+    EXPECT_EQ(tracker.Begin(9, "stream-a", 2, 0, 1), nullptr);
+    EXPECT_EQ(tracker.GetDuplicateCount(), 1U);
+    ASSERT_EQ(acks.size(), 2U);
+    EXPECT_EQ(acks.back(), std::make_pair(uint64_t(9), uint64_t(2)));
+
+    // 存储失败的批次不确认，之后的重传可以被重新接受
+    auto t3 = tracker.Begin(9, "stream-a", 3, 2, 1);
+    ASSERT_NE(t3, nullptr);
+    t3->Complete(false);
+    EXPECT_EQ(tracker.GetFailedCount(), 1U);
+    EXPECT_EQ(tracker.GetAckedSequence("stream-a"), 2U);
+    auto t3retry = tracker.Begin(9, "stream-a", 3, 2, 1);
+    ASSERT_NE(t3retry, nullptr);
+    t3retry->Complete(true);
+    EXPECT_EQ(tracker.GetAckedSequence("stream-a"), 3U);
+}
+
+// 确认投递测试：处理器重启后新批次N+1先于批次N的重传到达，N既不能被确认也不能被丢弃
+TEST(LogProcessorTest_AckTracker, NewBatchBeforeRetransmit) {
+    std::vector<uint64_t> acks;
+    AckTracker tracker([&acks](uint64_t, const std::string&, uint64_t seq) {
+        acks.push_back(seq);
+    });
+
+    // 采集器已收到确认4，批次5未确认；重连后批次6先到达
+    auto t6 = tracker.Begin(3, "stream-b", 6, 4, 1);
+    ASSERT_NE(t6, nullptr);
+    t6->Complete(true);
+    EXPECT_TRUE(acks.empty());
+    EXPECT_EQ(tracker.GetAckedSequence("stream-b"), 4U);
+
+    // 批次5的重传被接受，完成后累计确认推进到6
+    auto t5 = tracker.Begin(3, "stream-b", 5, 4, 1);
+    ASSERT_NE(t5, nullptr);
+    EXPECT_EQ(tracker.GetDuplicateCount(), 0U);
+    t5->Complete(true);
+    ASSERT_EQ(acks.size(), 1U);
+    EXPECT_EQ(acks.back(), 6U);
+}
+
+// 确认投递测试：连接关闭或空闲超时且没有处理中批次的流被淘汰
+TEST(LogProcessorTest_AckTracker, EvictsClosedAndIdleStreams) {
+    AckTracker tracker(nullptr, std::chrono::seconds(60), std::chrono::seconds(5));
+    auto now = std::chrono::steady_clock::now();
+
+    auto closed = tracker.Begin(1, "closed", 1, 0, 1);
+    auto busy = tracker.Begin(1, "busy", 1, 0, 1);
+    auto idle = tracker.Begin(2, "idle", 1, 0, 1);
+    ASSERT_NE(closed, nullptr);
+    ASSERT_NE(busy, nullptr);
+    ASSERT_NE(idle, nullptr);
+    closed->Complete(true);
+    idle->Complete(true);
+    tracker.OnConnectionClosed(1);
+    EXPECT_EQ(tracker.GetStreamCount(), 3U);
+
+    // 关闭的连接过了宽限期才淘汰，处理中的流保留到批次完成
+    EXPECT_EQ(tracker.Sweep(now), 0U);
+    EXPECT_EQ(tracker.Sweep(now + std::chrono::seconds(10)), 1U);
+    EXPECT_EQ(tracker.GetAckedSequence("closed"), 0U);
+    EXPECT_EQ(tracker.Sweep(now + std::chrono::seconds(120)), 1U);
+    EXPECT_EQ(tracker.GetStreamCount(), 1U);
+
+    busy->Complete(true);
+    EXPECT_EQ(tracker.Sweep(now + std::chrono::seconds(120)), 1U);
+    EXPECT_EQ(tracker.GetStreamCount(), 0U);
+    EXPECT_EQ(tracker.GetEvictedCount(), 3U);
+}
+
+// 测试消息体只解析一次：解析器直接使用预解析的字段
+TEST(LogProcessorTest_ParseOnce, ParsedFieldsConsumedByParser) {
+    LogData data;
+    data.id = "parse-once-1";
+    data.timestamp = std::chrono::system_clock::now();
+    data.source = "conn-1";
+    data.message = "  {\"timestamp\":\"2024-01-01 00:00:00\",\"level\":\"ERROR\",\"message\":\"disk full\",\"type\":\"sys\"} ";
+
+    EXPECT_EQ(ParseLogFields(data.message, data.fields), PayloadFormat::JSON);
+    EXPECT_EQ(data.fields.level.value_or(""), "ERROR");
+    EXPECT_EQ(data.fields.type.value_or(""), "sys");
+    EXPECT_FALSE(data.fields.source.has_value());
+    EXPECT_EQ(data.RawPayload().front(), '{');
+    EXPECT_EQ(data.RawPayload().back(), '}');
+
+    // 修改预解析的字段，解析器应使用它而不是重新解析消息体
+    data.fields.message = "from fields";
+    JsonLogParser parser;
+    LogRecord record;
+    ASSERT_TRUE(parser.Parse(data, record));
+    EXPECT_EQ(record.message, "from fields");
+    EXPECT_EQ(record.level, "ERROR");
+    EXPECT_EQ(record.source, "conn-1");
+    EXPECT_EQ(record.timestamp, "2024-01-01 00:00:00");
+
+    // 形似JSON但解析失败的消息由JSON解析器拒绝
+    LogData broken;
+    broken.message = "{\"level\":\"ERROR\",\"message\":";
+    broken.message += "}";
+    EXPECT_EQ(ParseLogFields(broken.message, broken.fields), PayloadFormat::INVALID_JSON);
+    EXPECT_FALSE(parser.Parse(broken, record));
+
+    // 普通文本保留已有的字段
+    LogData text;
+    text.message = "plain text line";
+    text.fields.level = "WARN";
+    EXPECT_EQ(ParseLogFields(text.message, text.fields), PayloadFormat::TEXT);
+    ASSERT_TRUE(parser.Parse(text, record));
+    EXPECT_EQ(record.level, "WARN");
+    EXPECT_EQ(record.message, "plain text line");
+}
+
+// 测试处理器对每条JSON消息只解析一次
+TEST(LogProcessorTest_ParseOnce, OneParsePerMessage) {
+    LogProcessorConfig config;
+    config.workerThreads = 1;
+    config.enableMetrics = true;
+    LogProcessor processor(config);
+    processor.AddLogParser(std::make_shared<JsonLogParser>());
+
+    std::atomic<int> stored{0};
+    processor.SetRecordSink([&stored](const LogRecord& record) {
+        EXPECT_EQ(record.level, "INFO");
+        stored++;
+        return true;
+    });
+
+    const int count = 10;
+    for (int i = 0; i < count; ++i) {
+        EXPECT_TRUE(processor.ProcessJsonString(
+            "{\"level\":\"INFO\",\"message\":\"m" + std::to_string(i) + "\"}"));
+    }
+    EXPECT_FALSE(processor.ProcessJsonString("not json"));
+
+    EXPECT_EQ(stored.load(), count);
+    EXPECT_EQ(processor.GetMetrics().jsonParses.load(), static_cast<uint64_t>(count));
+}
+
+// 测试批量提交：队列满时未入队的条目按顺序留给调用方，工作线程按批取出后全部处理
+TEST(LogProcessorTest_Batch, SubmitBatchAndDrain) {
+    LogProcessorConfig config;
+    config.workerThreads = 2;
+    config.queueSize = 100;
+    config.dequeueBatchSize = 16;
+    LogProcessor processor(config);
+    processor.AddLogParser(std::make_shared<JsonLogParser>());
+
+    std::atomic<int> stored{0};
+    processor.SetRecordSink([&stored](const LogRecord&) {
+        stored++;
+        return true;
+    });
+
+    std::vector<LogData> batch;
+    for (int i = 0; i < 150; ++i) {
+        LogData data;
+        data.id = "batch-" + std::to_string(i);
+        data.message = "{\"level\":\"INFO\",\"message\":\"m" + std::to_string(i) + "\"}";
+        batch.push_back(std::move(data));
+    }
+    EXPECT_EQ(processor.SubmitLogDataBatch(batch), 0U);   // 未启动时不接收
+    EXPECT_EQ(batch.size(), 150U);
+
+    ASSERT_TRUE(processor.Start());
+    EXPECT_EQ(processor.SubmitLogDataBatch(batch), 100U);
+    ASSERT_EQ(batch.size(), 50U);
+    EXPECT_EQ(batch.front().id, "batch-100");
+
+    for (int i = 0; i < 100 && stored.load() < 100; ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    }
+    EXPECT_EQ(stored.load(), 100);
+    EXPECT_EQ(processor.GetPendingCount(), 0UL);
+
+    // 剩余部分再次提交
+    EXPECT_EQ(processor.SubmitLogDataBatch(batch), 50U);
+    EXPECT_TRUE(batch.empty());
+    for (int i = 0; i < 100 && stored.load() < 150; ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    }
+    EXPECT_EQ(stored.load(), 150);
+    processor.Stop();
+}
+
+// 测试按source分片：多个工作线程并发处理（含窃取）时同一来源的日志保持提交顺序
+TEST(LogProcessorTest_Shards, PerSourceOrdering) {
+    LogProcessorConfig config;
+    config.workerThreads = 4;
+    config.queueSize = 100000;
+    config.queueShards = 8;
+    config.dequeueBatchSize = 4;
+    config.enableWorkStealing = true;
+    config.stealThreshold = 8;
+    LogProcessor processor(config);
+    processor.AddLogParser(std::make_shared<JsonLogParser>());
+
+    std::mutex mutex;
+    std::unordered_map<std::string, std::vector<int>> seen;
+    std::atomic<int> stored{0};
+    processor.SetRecordSink([&](const LogRecord& record) {
+        std::lock_guard<std::mutex> lock(mutex);
+        seen[record.source].push_back(std::stoi(record.message));
+        stored++;
+        return true;
+    });
+    ASSERT_TRUE(processor.Start());
+
+    const int sources = 6;
+    const int perSource = 500;
+    for (int i = 0; i < perSource; i += 50) {
+        for (int s = 0; s < sources; ++s) {
+            std::vector<LogData> batch;
+            for (int k = i; k < i + 50; ++k) {
+                LogData data;
+                data.source = "source-" + std::to_string(s);
+                data.message = "{\"message\":\"" + std::to_string(k) + "\"}";
+                batch.push_back(std::move(data));
+            }
+            ASSERT_EQ(processor.SubmitLogDataBatch(batch), 50U);
+        }
+    }
+
+    const int total = sources * perSource;
+    for (int i = 0; i < 200 && stored.load() < total; ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    }
+    ASSERT_EQ(stored.load(), total);
+    processor.Stop();
+
+    ASSERT_EQ(seen.size(), static_cast<size_t>(sources));
+    for (const auto& [source, order] : seen) {
+        ASSERT_EQ(order.size(), static_cast<size_t>(perSource)) << source;
+        for (int k = 0; k < perSource; ++k) {
+            EXPECT_EQ(order[k], k) << source;
+        }
+    }
+
+    auto shards = processor.GetShardStats();
+    ASSERT_EQ(shards.size(), 8U);
+    uint64_t processed = 0;
+    for (const auto& shard : shards) {
+        processed += shard.processed;
+        EXPECT_EQ(shard.depth, 0U);
+    }
+    EXPECT_EQ(processed, static_cast<uint64_t>(total));
+}
+
+// 计数解析器：只声明支持一种格式，按消息内容决定是否解析成功
+class CountingParser : public LogParser {
+public:
+    CountingParser(std::string name, LogFormat format, std::string accept)
+        : name_(std::move(name)), format_(format), accept_(std::move(accept)) {}
+
+    std::string GetType() const override { return name_; }
+    bool SupportsFormat(LogFormat format) const override { return format == format_; }
+    bool Parse(const LogData& logData, LogRecord& record) override {
+        attempts++;
+        if (logData.message.find(accept_) == std::string::npos) {
+            return false;
+        }
+        record.id = logData.id;
+        record.source = logData.source;
+        record.message = logData.message;
+        return true;
+    }
+
+    std::atomic<int> attempts{0};
+
+private:
+    std::string name_;
+    LogFormat format_;
+    std::string accept_;
+};
+
+class CountingJsonParser : public JsonLogParser {
+public:
+    bool Parse(const LogData& logData, LogRecord& record) override {
+        attempts++;
+        return JsonLogParser::Parse(logData, record);
+    }
+
+    std::atomic<int> attempts{0};
+};
+
+// 测试格式嗅探
+TEST(LogProcessorTest_Dispatch, SniffFormat) {
+    EXPECT_EQ(SniffLogFormat("{\"a\":1}", PayloadFormat::JSON), LogFormat::JSON);
+    EXPECT_EQ(SniffLogFormat("{bad", PayloadFormat::INVALID_JSON), LogFormat::JSON);
+    EXPECT_EQ(SniffLogFormat("<13>Jan  1 00:00:00 host app: hi", PayloadFormat::TEXT), LogFormat::SYSLOG);
+    EXPECT_EQ(SniffLogFormat("  <191>x", PayloadFormat::TEXT), LogFormat::SYSLOG);
+    EXPECT_EQ(SniffLogFormat("<html>", PayloadFormat::TEXT), LogFormat::PLAIN);
+    EXPECT_EQ(SniffLogFormat("<1234>x", PayloadFormat::TEXT), LogFormat::PLAIN);
+    EXPECT_EQ(SniffLogFormat("level=INFO msg=ok", PayloadFormat::TEXT), LogFormat::KEY_VALUE);
+    EXPECT_EQ(SniffLogFormat("a b=c", PayloadFormat::TEXT), LogFormat::PLAIN);
+    EXPECT_EQ(SniffLogFormat("=x", PayloadFormat::TEXT), LogFormat::PLAIN);
+    EXPECT_EQ(SniffLogFormat("", PayloadFormat::TEXT), LogFormat::PLAIN);
+}
+
+// 测试按格式直接分派，以及同一来源记住上次成功的解析器
+TEST(LogProcessorTest_Dispatch, RoutesByFormatAndAffinity) {
+    LogProcessorConfig config;
+    config.workerThreads = 1;
+    config.enableMetrics = true;
+    LogProcessor processor(config);
+
+    auto json = std::make_shared<CountingJsonParser>();
+    auto kvA = std::make_shared<CountingParser>("kv-a", LogFormat::KEY_VALUE, "app=a");
+    auto kvB = std::make_shared<CountingParser>("kv-b", LogFormat::KEY_VALUE, "app=");
+    auto syslog = std::make_shared<CountingParser>("syslog", LogFormat::SYSLOG, ">");
+    processor.AddLogParser(json);
+    processor.AddLogParser(kvA);
+    processor.AddLogParser(kvB);
+    processor.AddLogParser(syslog);
+
+    std::atomic<int> stored{0};
+    processor.SetRecordSink([&stored](const LogRecord&) {
+        stored++;
+        return true;
+    });
+    ASSERT_TRUE(processor.Start());
+
+    auto submit = [&processor](const std::string& source, const std::string& message) {
+        LogData data;
+        data.id = GenerateLogId();
+        data.source = source;
+        data.message = message;
+        ASSERT_TRUE(processor.SubmitLogData(std::move(data)));
+    };
+    submit("host", "<13>Jan  1 00:00:00 host app: hi");
+    submit("svc", "{\"level\":\"INFO\",\"message\":\"ok\"}");
+    submit("svc", "plain text");
+    for (int i = 0; i < 10; ++i) {
+        submit("b", "app=b seq=" + std::to_string(i));
+    }
+
+    for (int i = 0; i < 100 && stored.load() < 13; ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    }
+    processor.Stop();
+    ASSERT_EQ(stored.load(), 13);
+
+    // syslog和JSON消息不会尝试其他格式的解析器
+    EXPECT_EQ(syslog->attempts.load(), 1);
+    EXPECT_EQ(json->attempts.load(), 2);
+    // 来源b第一条先试kv-a失败，之后直接使用kv-b
+    EXPECT_EQ(kvA->attempts.load(), 1);
+    EXPECT_EQ(kvB->attempts.load(), 10);
+    EXPECT_EQ(processor.GetMetrics().parserAttempts.load(), 14U);
+}
+
+// 测试没有解析器声明的格式仍然按添加顺序尝试全部解析器
+TEST(LogProcessorTest_Dispatch, FallbackWhenNoParserClaimsFormat) {
+    LogProcessorConfig config;
+    LogProcessor processor(config);
+    auto json = std::make_shared<CountingJsonParser>();
+    processor.AddLogParser(json);
+
+    std::atomic<int> stored{0};
+    processor.SetRecordSink([&stored](const LogRecord& record) {
+        EXPECT_EQ(record.message, "<13>no syslog parser");
+        stored++;
+        return true;
+    });
+
+    ASSERT_TRUE(processor.Start());
+
+    LogData data;
+    data.id = GenerateLogId();
+    data.message = "<13>no syslog parser";
+    ASSERT_TRUE(processor.SubmitLogData(std::move(data)));
+    for (int i = 0; i < 100 && stored.load() < 1; ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    }
+    processor.Stop();
+    EXPECT_EQ(stored.load(), 1);
+    EXPECT_EQ(json->attempts.load(), 1);
+}
+
+// 测试grok模式：一遍扫描提取字段，多个模式按添加顺序优先
+TEST(LogProcessorTest_Grok, MatchesPatternsInOnePass) {
+    GrokMatcher matcher;
+    ASSERT_TRUE(matcher.AddPattern("%{TIMESTAMP:ts} \\[%{LEVEL:level}\\] %{WORD:module}: %{GREEDY:msg}"));
+    ASSERT_TRUE(matcher.AddPattern("%{IP:client} - %{DATA:user} [%{DATA:time}] \"%{WORD:method} %{NOTSPACE:path}\" %{INT:status}"));
+    ASSERT_TRUE(matcher.AddPattern("%{DATA:head}::%{GREEDY:tail}"));
+    ASSERT_TRUE(matcher.Compile());
+
+    GrokMatcher::Result result;
+    ASSERT_TRUE(matcher.Match("2024-01-01 12:00:00,123 [info] user: login ok: id=1", result));
+    EXPECT_EQ(result.pattern, 0);
+    ASSERT_EQ(result.values.size(), 4U);
+    EXPECT_EQ(result.values[0], "2024-01-01 12:00:00,123");
+    EXPECT_EQ(result.values[1], "info");
+    EXPECT_EQ(result.values[2], "user");
+    EXPECT_EQ(result.values[3], "login ok: id=1");
+
+    ASSERT_TRUE(matcher.Match("10.0.0.1 - bob smith [01/Jan/2024:12:00:00 +0800] \"GET /a?b=c\" 404", result));
+    EXPECT_EQ(result.pattern, 1);
+    EXPECT_EQ(result.values[1], "bob smith");
+    EXPECT_EQ(result.values[2], "01/Jan/2024:12:00:00 +0800");
+    EXPECT_EQ(result.values[4], "/a?b=c");
+    EXPECT_EQ(result.values[5], "404");
+
+    // DATA在分隔符第一次出现处结束，分隔符部分匹配后能正确回退
+    ASSERT_TRUE(matcher.Match("a:b:::c", result));
+    EXPECT_EQ(result.pattern, 2);
+    EXPECT_EQ(result.values[0], "a:b");
+    EXPECT_EQ(result.values[1], ":c");
+
+    EXPECT_FALSE(matcher.Match("2024-01-01 12:00:00 [info] user without colon", result));
+    EXPECT_EQ(result.pattern, -1);
+    EXPECT_FALSE(matcher.Match("", result));
+
+    GrokMatcher invalid;
+    EXPECT_FALSE(invalid.AddPattern("%{UNKNOWN:x}"));
+    EXPECT_FALSE(invalid.AddPattern("%{GREEDY:a} %{WORD:b}"));
+    EXPECT_FALSE(invalid.AddPattern("%{DATA:a}%{WORD:b}"));
+    EXPECT_FALSE(invalid.AddPattern("%{WORD:a"));
+}
+
+// 测试GrokLogParser：新模式使DFA超过状态上限时被撤销，已有模式仍能匹配
+TEST(LogProcessorTest_Grok, RejectedPatternKeepsExistingOnes) {
+    // 每个模式有6段DATA，分隔符各不相同，同时跟踪的组合使状态数成倍增长
+    auto makePattern = [](int i) {
+        const char* letters = "abcdefghijklmnopqrstuvwxyz";
+        std::string pattern;
+        for (int k = 0; k < 6; ++k) {
+            pattern += "%{DATA:f" + std::to_string(k) + "}";
+            pattern += letters[(i + k * 7) % 26];
+            pattern += letters[(i * 3 + k) % 26];
+        }
+        return pattern + "%{GREEDY:rest}";
+    };
+    GrokLogParser grok;
+    ASSERT_TRUE(grok.AddPattern(makePattern(0)));
+    ASSERT_TRUE(grok.AddPattern(makePattern(1)));
+    bool rejected = false;
+    for (int i = 2; i < 26 && !rejected; ++i) {
+        rejected = !grok.AddPattern(makePattern(i));
+    }
+    ASSERT_TRUE(rejected);
+
+    LogData data;
+    data.source = "app";
+    data.message = "1aa2hb3oc4vd5ce6jfdone";
+    LogRecord record;
+    ASSERT_TRUE(grok.Parse(data, record));
+    EXPECT_EQ(record.fields.at("f0"), "1");
+    EXPECT_EQ(record.fields.at("f5"), "6");
+    EXPECT_EQ(record.fields.at("rest"), "done");
+}
+
+// 测试GrokLogParser：来源专用模式优先，未匹配时交给后面的解析器
+TEST(LogProcessorTest_Grok, ParserFillsRecordAndFallsBack) {
+    LogProcessorConfig config;
+    config.workerThreads = 1;
+    LogProcessor processor(config);
+
+    auto grok = std::make_shared<GrokLogParser>();
+    ASSERT_TRUE(grok->AddPattern("%{TIMESTAMP:timestamp} \\[%{LEVEL:level}\\] %{WORD:module}: %{GREEDY:message}"));
+    ASSERT_TRUE(grok->AddPattern("%{WORD:module}|%{LEVEL:level}|%{GREEDY:message}", "legacy"));
+    EXPECT_FALSE(grok->AddPattern("%{BAD}"));
+    processor.AddLogParser(grok);
+    processor.AddLogParser(std::make_shared<JsonLogParser>());
+
+    std::mutex mutex;
+    std::vector<LogRecord> records;
+    processor.SetRecordSink([&](const LogRecord& record) {
+        std::lock_guard<std::mutex> lock(mutex);
+        records.push_back(record);
+        return true;
+    });
+    ASSERT_TRUE(processor.Start());
+
+    std::vector<std::string> ids;
+    auto submit = [&processor, &ids](const std::string& source, const std::string& message) {
+        LogData data;
+        data.id = GenerateLogId();
+        data.source = source;
+        data.message = message;
+        ids.push_back(data.id);
+        ASSERT_TRUE(processor.SubmitLogData(std::move(data)));
+    };
+    submit("app", "2024-05-01 08:00:00 [ERROR] payment: card declined\n");
+    submit("legacy", "order|WARN|slow query");
+    submit("app", "order|WARN|slow query");   // 其他来源不使用legacy的模式
+    for (int i = 0; i < 100; ++i) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (records.size() >= 3) break;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    }
+    processor.Stop();
+
+    ASSERT_EQ(records.size(), 3U);
+    // 工作线程完成顺序不固定，按提交的ID排列
+    std::sort(records.begin(), records.end(), [&ids](const LogRecord& a, const LogRecord& b) {
+        return std::find(ids.begin(), ids.end(), a.id) < std::find(ids.begin(), ids.end(), b.id);
+    });
+    EXPECT_EQ(records[0].timestamp, "2024-05-01 08:00:00");
+    EXPECT_EQ(records[0].level, "ERROR");
+    EXPECT_EQ(records[0].message, "card declined");
+    EXPECT_EQ(records[0].fields.at("module"), "payment");
+    EXPECT_EQ(records[1].level, "WARN");
+    EXPECT_EQ(records[1].message, "slow query");
+    EXPECT_EQ(records[1].fields.at("module"), "order");
+    EXPECT_EQ(records[2].message, "order|WARN|slow query");
+    EXPECT_EQ(records[2].fields.count("module"), 0U);
+}
+
+// 测试原始消息归档：提交不阻塞，队列满时丢弃计数，停止时写完剩余条目
+TEST(LogProcessorTest_RawArchiver, AsyncBatchedWrites) {
+    std::mutex mutex;
+    std::condition_variable cv;
+    bool release = false;
+    std::vector<std::string> written;
+    RawArchiver archiver([&](const std::vector<RawArchiveEntry>& entries) {
+        std::unique_lock<std::mutex> lock(mutex);
+        cv.wait(lock, [&] { return release; });   // 模拟慢速存储
+        size_t ok = 0;
+        for (const auto& entry : entries) {
+            written.push_back(entry.id);
+            ok += entry.id == "e1" ? 0 : 1;   // e1模拟写入失败
+        }
+        return ok;
+    }, 4, 2);
+
+    RawArchiveEntry entry;
+    entry.id = "before-start";
+    EXPECT_FALSE(archiver.Submit(entry));
+    archiver.Start();
+
+    // 写入线程阻塞时提交方不受影响，超出容量的条目被丢弃
+    int accepted = 0;
+    for (int i = 0; i < 10; ++i) {
+        entry.id = "e" + std::to_string(i);
+        accepted += archiver.Submit(entry) ? 1 : 0;
+    }
+    EXPECT_GE(accepted, 4);
+    EXPECT_LE(accepted, 6);   // 写入线程可能已取走一批
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        release = true;
+    }
+    cv.notify_all();
+    archiver.Stop();
+
+    EXPECT_EQ(written.size(), static_cast<size_t>(accepted));
+    EXPECT_EQ(written.front(), "e0");
+    EXPECT_EQ(archiver.GetArchivedCount(), static_cast<uint64_t>(accepted - 1));
+    EXPECT_EQ(archiver.GetFailedCount(), 1U);
+    EXPECT_EQ(archiver.GetDroppedCount(), static_cast<uint64_t>(1 + 10 - accepted));
+}
+
+// 测试按需提取：转义解码、嵌套值跳过、重复键与非字符串值
+TEST(LogProcessorTest_JsonExtractor, ExtractsTopLevelStrings) {
+    JsonFieldExtractor extractor({"level", "message", "source"});
+    JsonFieldExtractor::Result result;
+
+    std::string json = "{\"ctx\":{\"level\":\"NESTED\",\"list\":[1,-2.5e3,true,null,{\"a\":[]}]},"
+                       "\"level\":\"WARN\",\"message\":\"line1\\nline2 \\\"q\\\" \\u4e2d \\ud83d\\ude00\","
+                       "\"source\":42,\"level\":\"ERROR\"}";
+    ASSERT_TRUE(extractor.Extract(json, result));
+    ASSERT_TRUE(result.Has(0));
+    EXPECT_EQ(result.values[0], "ERROR");   // 重复键以最后一次为准，嵌套的同名键不影响
+    ASSERT_TRUE(result.Has(1));
+    EXPECT_EQ(result.values[1], "line1\nline2 \"q\" \xE4\xB8\xAD \xF0\x9F\x98\x80");
+    EXPECT_FALSE(result.Has(2));            // 数字不是字符串字段
+
+    // 无转义的值直接指向输入缓冲区
+    std::string plain = " { \"level\" : \"INFO\" } ";
+    ASSERT_TRUE(extractor.Extract(plain, result));
+    EXPECT_GE(result.values[0].data(), plain.data());
+    EXPECT_LT(result.values[0].data(), plain.data() + plain.size());
+}
+
+// 测试按需提取与nlohmann对非法输入的判定一致
+TEST(LogProcessorTest_JsonExtractor, RejectsInvalidJson) {
+    JsonFieldExtractor extractor({"level"});
+    JsonFieldExtractor::Result result;
+    const std::vector<std::string> invalid = {
+        "{\"level\":\"ERROR\"",            // 未闭合
+        "{\"level\":\"ERROR\",}",          // 尾随逗号
+        "{\"level\" \"ERROR\"}",           // 缺少冒号
+        "{\"level\":\"a\tb\"}",            // 未转义的控制字符
+        "{\"level\":\"\\x\"}",             // 非法转义
+        "{\"level\":\"\\udc00\"}",         // 单独的低位代理
+        "{\"n\":01}",                      // 前导零
+        "{\"n\":1.}",                      // 小数点后无数字
+        "{\"n\":tru}",                     // 残缺字面量
+        "{\"a\":[1,2}",                    // 括号不匹配
+        "{\"level\":\"x\"} {}",            // 根对象后有多余内容
+        "[\"level\"]"                      // 根不是对象
+    };
+    for (const auto& json : invalid) {
+        EXPECT_FALSE(extractor.Extract(json, result)) << json;
+        EXPECT_TRUE(nlohmann::json::parse(json, nullptr, false).is_discarded()
+                    || !nlohmann::json::parse(json, nullptr, false).is_object()) << json;
+    }
+
+    std::string deep(300, '[');
+    deep = "{\"a\":" + deep + std::string(300, ']') + "}";
+    EXPECT_FALSE(extractor.Extract(deep, result));   // 超过嵌套深度上限
+}
+
+// 测试各扫描实现与两种后端得到相同的字段
+TEST(LogProcessorTest_JsonExtractor, KernelsAndBackendsAgree) {
+    std::string longValue;
+    for (int i = 0; i < 100; ++i) {
+        longValue += "segment-" + std::to_string(i) + (i % 7 == 0 ? "\\t\\\"" : " ");
+    }
+    const std::vector<std::string> messages = {
+        "{\"timestamp\":\"2024-01-01 00:00:00\",\"level\":\"INFO\",\"message\":\"" + longValue + "\"}",
+        "{\"level\":\"DEBUG\",\"type\":\"app\",\"extra\":{\"k\":[\"" + longValue + "\"]},\"source\":\"svc\"}",
+        "{\"message\":\"" + longValue + "\u0001\"}",
+        "{}",
+        // 合法的多字节字符，以及截断、超长编码、代理区和跳过的值中的非法UTF-8
+        "{\"message\":\"" + longValue + "\xE6\x97\xA5\xE5\xBF\x97 \xF0\x9F\x98\x80\"}",
+        "{\"message\":\"" + longValue + "\xE6\x97\"}",
+        "{\"level\":\"INFO\",\"message\":\"\xC0\xAF\"}",
+        "{\"message\":\"\xED\xA0\x80" + longValue + "\"}",
+        "{\"level\":\"INFO\",\"extra\":[\"" + longValue + "\xFF\"]}"
+    };
+
+    for (ScanKernel kernel : {ScanKernel::SCALAR, ScanKernel::SSE2, ScanKernel::AVX2}) {
+        JsonFieldExtractor::SetScanKernel(kernel);
+        for (const auto& message : messages) {
+            ParsedFields onDemand;
+            ParsedFields dom;
+            PayloadFormat a = ParseLogFields(message, onDemand, JsonBackend::ON_DEMAND);
+            PayloadFormat b = ParseLogFields(message, dom, JsonBackend::NLOHMANN);
+            EXPECT_EQ(a, b) << message;
+            EXPECT_EQ(onDemand.timestamp, dom.timestamp);
+            EXPECT_EQ(onDemand.level, dom.level);
+            EXPECT_EQ(onDemand.message, dom.message);
+            EXPECT_EQ(onDemand.source, dom.source);
+            EXPECT_EQ(onDemand.type, dom.type);
+        }
+    }
+    JsonFieldExtractor::SetScanKernel(ScanKernel::AUTO);
+}
+
+// 指标测试：Prometheus文本导出和/metrics请求处理
+TEST(LogProcessorTest_Metrics, PrometheusExport) {
+    LogProcessorConfig config;
+    config.workerThreads = 1;
+    config.enableMetrics = true;
+    LogProcessor processor(config);
+    processor.AddLogParser(std::make_shared<CountingJsonParser>());
+
+    std::atomic<int> stored{0};
+    processor.SetRecordSink([&stored](const LogRecord&) {
+        stored++;
+        return true;
+    });
+    ASSERT_TRUE(processor.Start());
+    for (int i = 0; i < 5; ++i) {
+        LogData data;
+        data.id = GenerateLogId();
+        data.source = "svc";
+        data.message = "{\"level\":\"INFO\",\"message\":\"m" + std::to_string(i) + "\"}";
+        ASSERT_TRUE(processor.SubmitLogData(std::move(data)));
+    }
+    for (int i = 0; i < 100 && stored.load() < 5; ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    }
+    processor.Stop();
+    ASSERT_EQ(stored.load(), 5);
+
+    MetricsServer::Provider provider = [&processor]() {
+        xumj::common::PrometheusWriter writer;
+        processor.WritePrometheusMetrics(writer);
+        return writer.Text();
+    };
+    std::string text = provider();
+    EXPECT_NE(text.find("# TYPE xumj_processor_parser_calls_total counter"), std::string::npos);
+    EXPECT_NE(text.find("xumj_processor_parser_calls_total{parser=\"JsonParser\",result=\"success\"} 5"),
+              std::string::npos);
+    EXPECT_NE(text.find("xumj_processor_stage_latency_seconds_count{stage=\"parse\"} 5"), std::string::npos);
+    EXPECT_NE(text.find("xumj_processor_stage_latency_seconds_bucket{stage=\"batch\",le=\"+Inf\"}"),
+              std::string::npos);
+
+    std::string response;
+    ASSERT_TRUE(MetricsServer::HandleRequestLine("GET /metrics?x=1 HTTP/1.1", provider, response));
+    EXPECT_EQ(response.rfind("HTTP/1.1 200 OK\r\n", 0), 0U);
+    EXPECT_NE(response.find("Content-Length: " + std::to_string(text.size()) + "\r\n"), std::string::npos);
+    ASSERT_TRUE(MetricsServer::HandleRequestLine("GET / HTTP/1.1", provider, response));
+    EXPECT_EQ(response.rfind("HTTP/1.1 404", 0), 0U);
+    ASSERT_TRUE(MetricsServer::HandleRequestLine("POST /metrics HTTP/1.1", provider, response));
+    EXPECT_EQ(response.rfind("HTTP/1.1 405", 0), 0U);
+    EXPECT_FALSE(MetricsServer::HandleRequestLine("Host: localhost:9101", provider, response));
+    EXPECT_FALSE(MetricsServer::HandleRequestLine("", provider, response));
+}
+
+// 运行时调整工作线程数：不丢日志，同一来源仍按顺序处理
+TEST(LogProcessorTest_Workers, ResizeKeepsOrdering) {
+    LogProcessorConfig config;
+    config.workerThreads = 4;
+    config.queueSize = 100000;
+    config.queueShards = 8;
+    config.dequeueBatchSize = 4;
+    config.adaptiveWorkers = true;
+    config.workerConcurrency.maxThreads = 6;
+    config.workerConcurrency.interval = std::chrono::hours(1);  // 只测试手动调整
+    LogProcessor processor(config);
+    processor.AddLogParser(std::make_shared<JsonLogParser>());
+
+    std::mutex mutex;
+    std::unordered_map<std::string, std::vector<int>> seen;
+    std::atomic<int> stored{0};
+    processor.SetRecordSink([&](const LogRecord& record) {
+        std::lock_guard<std::mutex> lock(mutex);
+        seen[record.source].push_back(std::stoi(record.message));
+        stored++;
+        return true;
+    });
+    ASSERT_TRUE(processor.Start());
+    EXPECT_EQ(processor.GetWorkerCount(), 4U);
+
+    const int sources = 6;
+    const int perSource = 400;
+    const size_t counts[] = {1, 6, 2, 5, 3, 100};
+    for (int i = 0; i < perSource; i += 50) {
+        for (int s = 0; s < sources; ++s) {
+            std::vector<LogData> batch;
+            for (int k = i; k < i + 50; ++k) {
+                LogData data;
+                data.source = "source-" + std::to_string(s);
+                data.message = "{\"message\":\"" + std::to_string(k) + "\"}";
+                batch.push_back(std::move(data));
+            }
+            ASSERT_EQ(processor.SubmitLogDataBatch(batch), 50U);
+        }
+        processor.SetWorkerCount(counts[(i / 50) % 6]);
+    }
+    // 超过最大值时限制为最大工作线程数
+    EXPECT_EQ(processor.GetWorkerCount(), 6U);
+
+    const int total = sources * perSource;
+    for (int i = 0; i < 200 && stored.load() < total; ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    }
+    ASSERT_EQ(stored.load(), total);
+    processor.Stop();
+
+    for (const auto& [source, order] : seen) {
+        ASSERT_EQ(order.size(), static_cast<size_t>(perSource)) << source;
+        for (int k = 0; k < perSource; ++k) {
+            EXPECT_EQ(order[k], k) << source;
+        }
+    }
+
+    xumj::common::PrometheusWriter writer;
+    processor.WritePrometheusMetrics(writer);
+    EXPECT_NE(writer.Text().find("xumj_processor_worker_threads 6\n"), std::string::npos);
+    EXPECT_NE(writer.Text().find("# TYPE xumj_processor_workers_limit gauge"), std::string::npos);
+}
+
+// 准入控制：从消息开头判断级别
+TEST(LogProcessorTest_Admission, SniffLevel) {
+    using xumj::common::LogLevel;
+    EXPECT_EQ(SniffLogLevel("<11>Jan  1 00:00:00 host app: failed"), LogLevel::ERROR);
+    EXPECT_EQ(SniffLogLevel("<134>Jan  1 00:00:00 host app: ok"), LogLevel::INFO);
+    EXPECT_EQ(SniffLogLevel("{\"ts\":1,\"level\" : \"warning\",\"message\":\"x\"}"), LogLevel::WARN);
+    EXPECT_EQ(SniffLogLevel("{\"message\":\"ERROR in text\"}"), LogLevel::OTHER);
+    EXPECT_EQ(SniffLogLevel("2024-03-01 12:00:00 [CRITICAL] db: down"), LogLevel::FATAL);
+    EXPECT_EQ(SniffLogLevel("2024-03-01 12:00:00 DEBUG cache miss"), LogLevel::DEBUG);
+    EXPECT_EQ(SniffLogLevel("Error opening file"), LogLevel::OTHER);
+    EXPECT_EQ(SniffLogLevel("   "), LogLevel::OTHER);
+}
+
+namespace {
+
+// 第一条记录阻塞工作线程（最多5秒），使后续日志留在队列中
+struct BlockingSink {
+    std::mutex mutex;
+    std::condition_variable cv;
+    bool entered{false};
+    bool released{false};
+
+    bool operator()(const LogRecord&) {
+        std::unique_lock<std::mutex> lock(mutex);
+        if (!entered) {
+            entered = true;
+            cv.notify_all();
+            cv.wait_for(lock, std::chrono::seconds(5), [this] { return released; });
+        }
+        return true;
+    }
+    void WaitEntered() {
+        std::unique_lock<std::mutex> lock(mutex);
+        cv.wait(lock, [this] { return entered; });
+    }
+    void Release() {
+        std::lock_guard<std::mutex> lock(mutex);
+        released = true;
+        cv.notify_all();
+    }
+};
+
+LogData LevelLog(const std::string& source, const std::string& level) {
+    LogData data;
+    data.id = GenerateLogId();
+    data.source = source;
+    data.message = "{\"level\":\"" + level + "\",\"message\":\"m\"}";
+    return data;
+}
+
+} // namespace
+
+// 准入控制：低级别先丢弃，ERROR使用保留容量，队列全满时才拒绝
+TEST(LogProcessorTest_Admission, ShedsLowSeverityFirst) {
+    LogProcessorConfig config;
+    config.workerThreads = 1;
+    config.queueSize = 100;
+    config.dequeueBatchSize = 1;
+    config.admission.enabled = true;
+    config.admission.reservedHeadroom = 0.2;  // 低于ERROR的级别最多占用80
+    config.admission.sheddingStart = 1.0;     // 关闭概率丢弃，结果可预期
+    config.admission.levelQuota[static_cast<size_t>(xumj::common::LogLevel::DEBUG)] = 0.5;
+    LogProcessor processor(config);
+    processor.AddLogParser(std::make_shared<JsonLogParser>());
+    auto sink = std::make_shared<BlockingSink>();
+    processor.SetRecordSink([sink](const LogRecord& record) { return (*sink)(record); });
+    ASSERT_TRUE(processor.Start());
+
+    ASSERT_TRUE(processor.SubmitLogData(LevelLog("blocker", "INFO")));
+    sink->WaitEntered();
+
+    int admitted = 0;
+    for (int i = 0; i < 60; ++i) {
+        admitted += processor.SubmitLogData(LevelLog("noisy", "DEBUG")) ? 1 : 0;
+    }
+    EXPECT_EQ(admitted, 50);
+    admitted = 0;
+    for (int i = 0; i < 40; ++i) {
+        admitted += processor.SubmitLogData(LevelLog("noisy", "INFO")) ? 1 : 0;
+    }
+    EXPECT_EQ(admitted, 30);
+
+    // 批量提交：ERROR用完保留容量后队列全满，剩余条目留给调用方重传；被丢弃的INFO按失败确认
+    std::vector<LogData> batch;
+    std::atomic<int> shedAcks{0};
+    std::atomic<int> shedFailures{0};
+    for (int i = 0; i < 50; ++i) {
+        batch.push_back(LevelLog("app", i % 2 ? "ERROR" : "INFO"));
+        batch.back().onComplete = [&shedAcks, &shedFailures](bool stored) {
+            (stored ? shedAcks : shedFailures) += 1;
+        };
+    }
+    EXPECT_EQ(processor.SubmitLogDataBatch(batch), 20U);
+    EXPECT_EQ(shedAcks.load(), 0);
+    EXPECT_EQ(shedFailures.load(), 21);  // 第21条ERROR之前的21条INFO
+    ASSERT_EQ(batch.size(), 9U);
+    EXPECT_NE(batch.front().message.find("ERROR"), std::string::npos);
+
+    const AdmissionController* admission = processor.GetAdmissionController();
+    ASSERT_NE(admission, nullptr);
+    using xumj::common::LogLevel;
+    EXPECT_EQ(admission->GetShedCount(LogLevel::DEBUG), 10U);
+    EXPECT_EQ(admission->GetShedCount(LogLevel::INFO), 31U);
+    EXPECT_EQ(admission->GetAdmittedCount(LogLevel::ERROR), 20U);
+    EXPECT_EQ(admission->GetRejectedCount(LogLevel::ERROR), 1U);
+    auto stats = admission->GetShedStats();
+    ASSERT_EQ(stats.size(), 3U);
+    EXPECT_EQ(stats[0].source, "app");
+    EXPECT_EQ(stats[0].count, 21U);
+    EXPECT_EQ(stats[1].source, "noisy");
+    EXPECT_EQ(stats[1].level, LogLevel::DEBUG);
+
+    xumj::common::PrometheusWriter writer;
+    processor.WritePrometheusMetrics(writer);
+    EXPECT_NE(writer.Text().find("xumj_processor_shed_total{source=\"noisy\",level=\"INFO\"} 10\n"),
+              std::string::npos);
+
+    sink->Release();
+    processor.Stop();
+}
+
+// 准入控制：单个来源的低级别日志不能占满队列，其他来源和ERROR不受影响
+TEST(LogProcessorTest_Admission, SourceQuota) {
+    LogProcessorConfig config;
+    config.workerThreads = 1;
+    config.queueSize = 100;
+    config.dequeueBatchSize = 1;
+    config.admission.enabled = true;
+    config.admission.sheddingStart = 1.0;
+    config.admission.sourceQuota = 0.3;
+    LogProcessor processor(config);
+    processor.AddLogParser(std::make_shared<JsonLogParser>());
+    auto sink = std::make_shared<BlockingSink>();
+    processor.SetRecordSink([sink](const LogRecord& record) { return (*sink)(record); });
+    ASSERT_TRUE(processor.Start());
+
+    ASSERT_TRUE(processor.SubmitLogData(LevelLog("blocker", "INFO")));
+    sink->WaitEntered();
+
+    int noisy = 0;
+    for (int i = 0; i < 40; ++i) {
+        noisy += processor.SubmitLogData(LevelLog("noisy", "WARN")) ? 1 : 0;
+    }
+    EXPECT_EQ(noisy, 30);
+    EXPECT_TRUE(processor.SubmitLogData(LevelLog("noisy", "ERROR")));
+    EXPECT_TRUE(processor.SubmitLogData(LevelLog("quiet", "INFO")));
+
+    sink->Release();
+    for (int i = 0; i < 100 && processor.GetPendingCount() > 0; ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    // 出队后来源配额恢复
+    EXPECT_TRUE(processor.SubmitLogData(LevelLog("noisy", "WARN")));
+    processor.Stop();
+}
+
+// 重复日志合并：数字和空白的差别不影响消息哈希
+TEST(LogProcessorTest_Dedup, NormalizedHash) {
+    EXPECT_EQ(NormalizedMessageHash("重试 3 次后连接失败  id=42", true),
+              NormalizedMessageHash("重试 12 次后连接失败 id=7", true));
+    EXPECT_NE(NormalizedMessageHash("重试 3 次后连接失败", false),
+              NormalizedMessageHash("重试 12 次后连接失败", false));
+    EXPECT_NE(NormalizedMessageHash("连接失败", true), NormalizedMessageHash("连接成功", true));
+}
+
+namespace {
+
+LogData RepeatLog(const std::string& source, const std::string& message, int second) {
+    LogData data;
+    data.id = GenerateLogId();
+    data.source = source;
+    data.message = "{\"timestamp\":\"2024-03-01 12:00:0" + std::to_string(second) +
+                   "\",\"level\":\"ERROR\",\"message\":\"" + message + "\"}";
+    return data;
+}
+
+} // namespace
+
+// 重复日志合并：第一条照常存储，窗口内的重复合并为一条汇总记录，确认在汇总存储后发出
+TEST(LogProcessorTest_Dedup, CollapsesRepeats) {
+    LogProcessorConfig config;
+    config.workerThreads = 2;
+    config.dedup.enabled = true;
+    config.dedup.window = std::chrono::milliseconds(200);
+    LogProcessor processor(config);
+    processor.AddLogParser(std::make_shared<JsonLogParser>());
+
+    std::mutex mutex;
+    std::vector<LogRecord> stored;
+    processor.SetRecordSink([&](const LogRecord& record) {
+        std::lock_guard<std::mutex> lock(mutex);
+        stored.push_back(record);
+        return true;
+    });
+    ASSERT_TRUE(processor.Start());
+
+    std::atomic<int> acks{0};
+    std::vector<LogData> batch;
+    for (int i = 1; i <= 6; ++i) {
+        batch.push_back(RepeatLog("db", "数据库连接失败，重试" + std::to_string(i), i));
+    }
+    batch.push_back(RepeatLog("db", "磁盘空间不足", 7));
+    for (auto& data : batch) {
+        data.onComplete = [&acks](bool ok) { acks += ok ? 1 : 0; };
+    }
+    ASSERT_EQ(processor.SubmitLogDataBatch(batch), 7U);
+
+    auto storedCount = [&] {
+        std::lock_guard<std::mutex> lock(mutex);
+        return stored.size();
+    };
+    for (int i = 0; i < 100 && storedCount() < 2; ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    EXPECT_EQ(storedCount(), 2U);
+    EXPECT_EQ(acks.load(), 2);
+
+    for (int i = 0; i < 200 && storedCount() < 3; ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    ASSERT_EQ(storedCount(), 3U);
+    EXPECT_EQ(acks.load(), 7);
+
+    std::lock_guard<std::mutex> lock(mutex);
+    EXPECT_EQ(stored[0].fields.count("repeat_count"), 0U);
+    const LogRecord& summary = stored[2];
+    EXPECT_EQ(summary.message, "数据库连接失败，重试2");
+    EXPECT_EQ(summary.fields.at("repeat_count"), "5");
+    EXPECT_EQ(summary.fields.at("first_seen"), "2024-03-01 12:00:02");
+    EXPECT_EQ(summary.fields.at("last_seen"), "2024-03-01 12:00:06");
+
+    const DedupStage* dedup = processor.GetDedupStage();
+    ASSERT_NE(dedup, nullptr);
+    EXPECT_EQ(dedup->GetAbsorbedCount(), 5U);
+    EXPECT_EQ(dedup->GetSummaryCount(), 1U);
+}
+
+// 重复日志合并：停止时存储未结束窗口的汇总；合并表内存用完后不再合并
+TEST(LogProcessorTest_Dedup, FlushOnStopAndMemoryBound) {
+    LogProcessorConfig config;
+    config.workerThreads = 1;
+    config.dedup.enabled = true;
+    config.dedup.window = std::chrono::hours(1);
+    config.dedup.maxMemoryBytes = 4096;
+    LogProcessor processor(config);
+    processor.AddLogParser(std::make_shared<JsonLogParser>());
+
+    std::atomic<int> stored{0};
+    std::atomic<int> repeats{0};
+    processor.SetRecordSink([&](const LogRecord& record) {
+        auto it = record.fields.find("repeat_count");
+        repeats += it == record.fields.end() ? 1 : std::stoi(it->second);
+        stored++;
+        return true;
+    });
+    ASSERT_TRUE(processor.Start());
+
+    std::vector<LogData> batch;
+    for (int i = 0; i < 3; ++i) {
+        batch.push_back(RepeatLog("app", "timeout", 1));
+    }
+    for (int i = 0; i < 100; ++i) {
+        batch.push_back(RepeatLog("app", "unique-" + std::string(1, static_cast<char>('a' + i % 26)) +
+                                             std::string(static_cast<size_t>(i / 26 + 1), 'x'), 2));
+    }
+    ASSERT_EQ(processor.SubmitLogDataBatch(batch), 103U);
+    for (int i = 0; i < 200 && processor.GetPendingCount() > 0; ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+
+    const DedupStage* dedup = processor.GetDedupStage();
+    ASSERT_NE(dedup, nullptr);
+    EXPECT_LE(dedup->GetMemoryBytes(), 4096U);
+    EXPECT_GT(dedup->GetUntrackedCount(), 0U);
+
+    processor.Stop();
+    EXPECT_EQ(stored.load(), 102);
+    EXPECT_EQ(repeats.load(), 103);
+    EXPECT_EQ(dedup->GetSummaryCount(), 1U);
+}
+
 int main(int argc, char **argv) {
     ::testing::InitGoogleTest(&argc, argv);
     return RUN_ALL_TESTS();
-} 
\ No newline at end of file
+} 
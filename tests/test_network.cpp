@@ -0,0 +1,437 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+#include "xumj/network/connection_registry.h"
+#include "xumj/network/tcp_server.h"
+
+using namespace xumj::network;
+
+namespace {
+
+// rcvBuf不为0时缩小接收缓冲区，用于模拟慢消费者
+int ConnectTo(uint16_t port, int rcvBuf = 0) {
+    int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0) {
+        return -1;
+    }
+    if (rcvBuf > 0) {
+        ::setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &rcvBuf, sizeof(rcvBuf));
+    }
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (::connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) {
+        ::close(fd);
+        return -1;
+    }
+    // 读超时，避免服务端异常时测试挂住
+    timeval timeout{2, 0};
+    ::setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    return fd;
+}
+
+std::string LocalAddr(int fd) {
+    sockaddr_in addr{};
+    socklen_t len = sizeof(addr);
+    ::getsockname(fd, reinterpret_cast<sockaddr*>(&addr), &len);
+    char ip[INET_ADDRSTRLEN] = {0};
+    ::inet_ntop(AF_INET, &addr.sin_addr, ip, sizeof(ip));
+    return std::string(ip) + ":" + std::to_string(ntohs(addr.sin_port));
+}
+
+bool SendAll(int fd, const std::string& data) {
+    size_t sent = 0;
+    while (sent < data.size()) {
+        ssize_t n = ::send(fd, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+        if (n <= 0) {
+            return false;
+        }
+        sent += static_cast<size_t>(n);
+    }
+    return true;
+}
+
+// 读到对端关闭为止；读超时返回false
+bool ReadUntilClosed(int fd, std::string* received = nullptr) {
+    char buf[4096];
+    for (;;) {
+        ssize_t n = ::recv(fd, buf, sizeof(buf), 0);
+        if (n == 0 || (n < 0 && errno == ECONNRESET)) {
+            return true;
+        }
+        if (n < 0) {
+            return false;
+        }
+        if (received) {
+            received->append(buf, static_cast<size_t>(n));
+        }
+    }
+}
+
+bool WaitUntil(const std::function<bool()>& condition,
+               std::chrono::milliseconds timeout = std::chrono::milliseconds(2000)) {
+    auto deadline = std::chrono::steady_clock::now() + timeout;
+    while (!condition()) {
+        if (std::chrono::steady_clock::now() >= deadline) {
+            return false;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    return true;
+}
+
+// 读取恰好n字节；超时或对端关闭返回false
+bool RecvExactly(int fd, size_t n, std::string* received = nullptr) {
+    char buf[4096];
+    size_t total = 0;
+    while (total < n) {
+        ssize_t got = ::recv(fd, buf, std::min(sizeof(buf), n - total), 0);
+        if (got <= 0) {
+            return false;
+        }
+        if (received) {
+            received->append(buf, static_cast<size_t>(got));
+        }
+        total += static_cast<size_t>(got);
+    }
+    return true;
+}
+
+// 按客户端地址记录服务端分配的连接ID
+class ConnectionTracker {
+public:
+    void Attach(TcpServer& server) {
+        server.SetConnectionCallback([this](uint64_t id, const std::string& addr, bool connected) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (connected) {
+                ids_[addr] = id;
+            } else {
+                ids_.erase(addr);
+            }
+        });
+    }
+
+    // 等待客户端套接字对应的连接建立，超时返回0
+    uint64_t WaitFor(int fd) {
+        std::string addr = LocalAddr(fd);
+        uint64_t id = 0;
+        WaitUntil([&]() {
+            std::lock_guard<std::mutex> lock(mutex_);
+            auto it = ids_.find(addr);
+            id = it != ids_.end() ? it->second : 0;
+            return id != 0;
+        });
+        return id;
+    }
+
+private:
+    std::mutex mutex_;
+    std::map<std::string, uint64_t> ids_;
+};
+
+const int kSlowRcvBuf = 4096;                 // 慢消费者的接收缓冲区
+const size_t kPayloadSize = 1024 * 1024;      // 广播消息体大小
+const size_t kHighWaterMark = 4 * kPayloadSize;
+
+} // namespace
+
+// 测试连接注册、查找与注销
+TEST(ConnectionRegistryTest, RegisterFindUnregister) {
+    ConnectionRegistry registry(4);
+    EXPECT_EQ(registry.GetShardCount(), 4u);
+
+    registry.BindCurrentThread(2);
+    EXPECT_EQ(registry.CurrentShard(), 2);
+
+    uint64_t id = registry.Register(nullptr, nullptr);
+    ASSERT_NE(id, 0u);
+    EXPECT_EQ(ConnectionRegistry::ShardOf(id), 2u);
+    EXPECT_EQ(registry.Size(), 1u);
+
+    auto entry = registry.Find(id);
+    ASSERT_NE(entry, nullptr);
+    EXPECT_EQ(entry->id, id);
+
+    EXPECT_TRUE(registry.Unregister(id));
+    EXPECT_EQ(registry.Find(id), nullptr);
+    EXPECT_FALSE(registry.Unregister(id));
+    EXPECT_EQ(registry.Size(), 0u);
+}
+
+// 测试槽位复用后旧ID不会命中新连接
+TEST(ConnectionRegistryTest, StaleIdAfterSlotReuse) {
+    ConnectionRegistry registry(1);
+    registry.BindCurrentThread(0);
+
+    uint64_t first = registry.Register(nullptr, nullptr);
+    ASSERT_TRUE(registry.Unregister(first));
+    uint64_t second = registry.Register(nullptr, nullptr);
+
+    EXPECT_NE(first, second);
+    EXPECT_EQ(registry.Find(first), nullptr);
+    EXPECT_NE(registry.Find(second), nullptr);
+}
+
+// 测试多个IO线程并发注册，读者无锁遍历
+TEST(ConnectionRegistryTest, ConcurrentShards) {
+    const size_t shardCount = 4;
+    const size_t perShard = 3000;
+    ConnectionRegistry registry(shardCount);
+
+    std::vector<std::vector<uint64_t>> ids(shardCount);
+    std::vector<std::thread> writers;
+    for (size_t shard = 0; shard < shardCount; ++shard) {
+        writers.emplace_back([&registry, &ids, shard, perShard]() {
+            registry.BindCurrentThread(shard);
+            for (size_t i = 0; i < perShard; ++i) {
+                ids[shard].push_back(registry.Register(nullptr, nullptr));
+            }
+        });
+    }
+    for (auto& t : writers) {
+        t.join();
+    }
+
+    EXPECT_EQ(registry.Size(), shardCount * perShard);
+
+    std::set<uint64_t> seen;
+    registry.ForEach([&seen](const ConnectionEntryPtr& entry) {
+        seen.insert(entry->id);
+    });
+    EXPECT_EQ(seen.size(), shardCount * perShard);
+
+    for (size_t shard = 0; shard < shardCount; ++shard) {
+        for (uint64_t id : ids[shard]) {
+            EXPECT_EQ(ConnectionRegistry::ShardOf(id), shard);
+            ASSERT_NE(registry.Find(id), nullptr);
+        }
+    }
+
+    registry.Clear();
+    EXPECT_EQ(registry.Size(), 0u);
+    EXPECT_EQ(registry.Find(ids[0][0]), nullptr);
+}
+
+// 测试共享消息体在多个持有者之间不复制内容
+TEST(SharedPayloadTest, SharedAcrossHolders) {
+    SharedPayload payload(std::string("hello\n"));
+    EXPECT_EQ(payload.Size(), 6u);
+    EXPECT_EQ(payload.UseCount(), 1);
+
+    OutboundQueue first;
+    OutboundQueue second;
+    first.pending.push_back(payload);
+    second.pending.push_back(payload);
+    EXPECT_EQ(payload.UseCount(), 3);
+    EXPECT_EQ(first.pending.front().Data(), second.pending.front().Data());
+
+    first.pending.clear();
+    second.pending.clear();
+    EXPECT_EQ(payload.UseCount(), 1);
+
+    SharedPayload empty;
+    EXPECT_TRUE(empty.Empty());
+    EXPECT_EQ(empty.Str(), "");
+}
+
+// 测试按行分帧时单行超过上限断开连接并计数
+TEST(TcpServerTest, OversizedLineClosesConnection) {
+    const uint16_t port = 19311;
+    TcpServer server("LineLimitTest", "127.0.0.1", port, 1);
+    server.SetLineDelimited(true);
+    server.SetMaxLineLength(64);
+    std::mutex mutex;
+    std::vector<std::string> lines;
+    server.SetMessageCallback([&](uint64_t, const std::string& line, muduo::Timestamp) {
+        std::lock_guard<std::mutex> lock(mutex);
+        lines.push_back(line);
+    });
+    server.SetConnectionCallback([](uint64_t, const std::string&, bool) {});
+    server.Start();
+
+    int fd = ConnectTo(port);
+    ASSERT_GE(fd, 0);
+    ASSERT_TRUE(SendAll(fd, "short line\r\n"));
+    EXPECT_TRUE(WaitUntil([&]() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return lines.size() == 1;
+    }));
+
+    // 不带换行符的超长数据不会一直留在缓冲区里等待
+    ASSERT_TRUE(SendAll(fd, std::string(200, 'x')));
+    EXPECT_TRUE(ReadUntilClosed(fd));
+    EXPECT_EQ(server.GetOversizedLineCount(), 1u);
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        EXPECT_EQ(lines, (std::vector<std::string>{"short line"}));
+    }
+    ::close(fd);
+    server.Stop();
+}
+
+// 测试广播与多播：只投递给目标连接，返回投递数
+TEST(TcpServerTest, BroadcastAndMulticast) {
+    const uint16_t port = 19312;
+    TcpServer server("MulticastTest", "127.0.0.1", port, 2);
+    ConnectionTracker tracker;
+    tracker.Attach(server);
+    server.Start();
+
+    std::vector<int> fds;
+    std::vector<uint64_t> ids;
+    for (int i = 0; i < 3; ++i) {
+        int fd = ConnectTo(port);
+        ASSERT_GE(fd, 0);
+        fds.push_back(fd);
+        ids.push_back(tracker.WaitFor(fd));
+        ASSERT_NE(ids.back(), 0u);
+    }
+
+    EXPECT_EQ(server.Broadcast("all\n"), 3u);
+    for (int fd : fds) {
+        std::string received;
+        EXPECT_TRUE(RecvExactly(fd, 4, &received));
+        EXPECT_EQ(received, "all\n");
+    }
+
+    // 不存在的连接ID被跳过；未选中的连接收不到消息
+    SharedPayload payload(std::string("some\n"));
+    EXPECT_EQ(server.Multicast({ids[0], ids[2], ids[2] + 1000}, payload), 2u);
+    for (int i : {0, 2}) {
+        std::string received;
+        EXPECT_TRUE(RecvExactly(fds[i], 5, &received));
+        EXPECT_EQ(received, "some\n");
+    }
+    timeval shortTimeout{0, 200 * 1000};
+    ::setsockopt(fds[1], SOL_SOCKET, SO_RCVTIMEO, &shortTimeout, sizeof(shortTimeout));
+    EXPECT_FALSE(RecvExactly(fds[1], 1));
+    EXPECT_TRUE(WaitUntil([&]() { return payload.UseCount() == 1; }));
+
+    for (int fd : fds) {
+        ::close(fd);
+    }
+    server.Stop();
+}
+
+// 测试DROP策略：慢消费者积压超过高水位后丢弃新消息，排队期间所有接收方共享同一份消息体，
+// 对端开始读取后写完成回调把待发送队列排空
+TEST(TcpServerTest, SlowConsumerDropSharesPayloadAndDrains) {
+    const uint16_t port = 19313;
+    const size_t kClients = 3;
+    const size_t kRounds = 16;
+    TcpServer server("SlowDropTest", "127.0.0.1", port, 1);
+    server.SetSlowConsumerPolicy(SlowConsumerPolicy::DROP, kHighWaterMark);
+    ConnectionTracker tracker;
+    tracker.Attach(server);
+    server.Start();
+
+    std::vector<int> fds;
+    for (size_t i = 0; i < kClients; ++i) {
+        int fd = ConnectTo(port, kSlowRcvBuf);
+        ASSERT_GE(fd, 0);
+        ASSERT_NE(tracker.WaitFor(fd), 0u);
+        fds.push_back(fd);
+    }
+
+    // 客户端暂不读取
+    SharedPayload payload(std::string(kPayloadSize, 'x'));
+    for (size_t round = 0; round < kRounds; ++round) {
+        EXPECT_EQ(server.Broadcast(payload), kClients);
+    }
+    // 超过高水位的消息在所有连接上都会被丢弃；它被释放说明之前的投递任务都已执行
+    SharedPayload marker(std::string(2 * kHighWaterMark, 'm'));
+    EXPECT_EQ(server.Broadcast(marker), kClients);
+    ASSERT_TRUE(WaitUntil([&]() { return marker.UseCount() == 1; }));
+
+    uint64_t dropped = server.GetDroppedMessageCount();
+    EXPECT_GT(dropped, kClients);
+    EXPECT_EQ(server.GetSlowConsumerDisconnectCount(), 0u);
+    // 每个连接的待发送队列里都有这条消息，引用的是同一份数据
+    EXPECT_GE(payload.UseCount(), static_cast<long>(1 + kClients));
+    EXPECT_LE(payload.UseCount(), static_cast<long>(1 + kClients * (kHighWaterMark / kPayloadSize)));
+
+    // 开始读取：队列排空后不再持有消息体，收到的字节数等于未丢弃的消息
+    std::atomic<size_t> received{0};
+    std::atomic<bool> stop{false};
+    std::vector<std::thread> readers;
+    for (int fd : fds) {
+        readers.emplace_back([fd, &received, &stop]() {
+            char buf[65536];
+            while (!stop) {
+                ssize_t n = ::recv(fd, buf, sizeof(buf), 0);
+                if (n > 0) {
+                    received += static_cast<size_t>(n);
+                } else if (n == 0) {
+                    break;
+                }
+            }
+        });
+    }
+    size_t expected = (kRounds * kClients - (dropped - kClients)) * kPayloadSize;
+    EXPECT_TRUE(WaitUntil([&]() { return payload.UseCount() == 1; }, std::chrono::milliseconds(10000)));
+    EXPECT_TRUE(WaitUntil([&]() { return received == expected; }, std::chrono::milliseconds(10000)));
+    stop = true;
+    for (auto& t : readers) {
+        t.join();
+    }
+
+    for (int fd : fds) {
+        ::close(fd);
+    }
+    server.Stop();
+}
+
+// 测试DISCONNECT策略：只断开积压超过高水位的慢连接，正常读取的连接收到全部消息
+TEST(TcpServerTest, SlowConsumerDisconnect) {
+    const uint16_t port = 19314;
+    const size_t kRounds = 16;
+    TcpServer server("SlowDisconnectTest", "127.0.0.1", port, 1);
+    server.SetSlowConsumerPolicy(SlowConsumerPolicy::DISCONNECT, kHighWaterMark);
+    ConnectionTracker tracker;
+    tracker.Attach(server);
+    server.Start();
+
+    int slow = ConnectTo(port, kSlowRcvBuf);
+    int fast = ConnectTo(port);
+    ASSERT_GE(slow, 0);
+    ASSERT_GE(fast, 0);
+    ASSERT_NE(tracker.WaitFor(slow), 0u);
+    ASSERT_NE(tracker.WaitFor(fast), 0u);
+
+    // 每轮等正常连接收完再广播，正常连接始终没有积压
+    SharedPayload payload(std::string(kPayloadSize, 'x'));
+    size_t fastReceived = 0;
+    for (size_t round = 0; round < kRounds; ++round) {
+        EXPECT_GE(server.Broadcast(payload), 1u);
+        ASSERT_TRUE(RecvExactly(fast, kPayloadSize));
+        fastReceived += kPayloadSize;
+    }
+    EXPECT_EQ(fastReceived, kRounds * kPayloadSize);
+    EXPECT_EQ(server.GetSlowConsumerDisconnectCount(), 1u);
+    EXPECT_EQ(server.GetDroppedMessageCount(), 0u);
+
+    // 慢连接读完内核中已有的数据后看到连接关闭，断开时排队的消息体已释放
+    EXPECT_TRUE(ReadUntilClosed(slow));
+    EXPECT_TRUE(WaitUntil([&]() { return payload.UseCount() == 1; }));
+    EXPECT_EQ(server.Broadcast(payload), 1u);
+    EXPECT_TRUE(RecvExactly(fast, kPayloadSize));
+
+    ::close(slow);
+    ::close(fast);
+    server.Stop();
+}